@@ -29,6 +29,7 @@
 #include "plib/color/color.h"
 #include "plib/gnw/debug.h"
 #include "plib/gnw/input.h"
+#include "plib/gnw/profile.h"
 #include "plib/gnw/rect.h"
 #include "plib/gnw/svga.h"
 #include "plib/gnw/vcr.h"
@@ -2776,6 +2777,8 @@ void object_animate()
         return;
     }
 
+    profile_begin(PROFILE_ZONE_ANIMATE);
+
     anim_in_bk = 1;
 
     for (int index = 0; index < curr_sad; index++) {
@@ -2936,6 +2939,8 @@ void object_animate()
     anim_in_bk = 0;
 
     object_anim_compact();
+
+    profile_end(PROFILE_ZONE_ANIMATE);
 }
 
 // 0x417880
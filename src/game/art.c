@@ -8,11 +8,13 @@
 #include "game/artload.h"
 #include "game/game.h"
 #include "game/gconfig.h"
+#include "game/lstfile.h"
 #include "game/object.h"
 #include "game/proto.h"
 #include "plib/gnw/debug.h"
 #include "plib/gnw/grbuf.h"
 #include "plib/gnw/memory.h"
+#include "plib/gnw/thread.h"
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
@@ -24,6 +26,14 @@ typedef struct ArtListDescription {
     int fileNamesLength; // number of entries in list
 } ArtListDescription;
 
+typedef struct ArtPin {
+    int fid;
+    Art* art;
+    CacheEntry* handle;
+} ArtPin;
+
+static bool art_pin_find(int fid, int* indexPtr);
+
 // 0x4FEAB4
 static ArtListDescription art[OBJ_TYPE_COUNT] = {
     { 0, "items", NULL, 0 },
@@ -70,6 +80,17 @@ HeadDescription* head_info;
 // 0x56B85C
 static int* anon_alias;
 
+// Art locked up front for multithreaded rendering, sorted by fid. While pins
+// are active `art_ptr_lock` serves pinned fids without touching the cache, so
+// render threads never modify it.
+static ArtPin* art_pins = NULL;
+static int art_pins_length = 0;
+static int art_pins_capacity = 0;
+static bool art_pins_active = false;
+
+// Serializes cache access for fids which were not pinned.
+static Mutex* art_pins_mutex = NULL;
+
 // 0x418170
 int art_init()
 {
@@ -255,6 +276,19 @@ void art_reset()
 // 0x418688
 void art_exit()
 {
+    art_unpin_all();
+
+    if (art_pins != NULL) {
+        mem_free(art_pins);
+        art_pins = NULL;
+        art_pins_capacity = 0;
+    }
+
+    if (art_pins_mutex != NULL) {
+        mutex_free(art_pins_mutex);
+        art_pins_mutex = NULL;
+    }
+
     cache_exit(&art_cache);
 
     mem_free(anon_alias);
@@ -382,6 +416,20 @@ Art* art_ptr_lock(int fid, CacheEntry** handlePtr)
     }
 
     Art* art = NULL;
+
+    if (art_pins_active) {
+        int index;
+        if (art_pin_find(fid, &index)) {
+            *handlePtr = NULL;
+            return art_pins[index].art;
+        }
+
+        mutex_lock(art_pins_mutex);
+        cache_lock(&art_cache, fid, (void**)&art, handlePtr);
+        mutex_unlock(art_pins_mutex);
+        return art;
+    }
+
     cache_lock(&art_cache, fid, (void**)&art, handlePtr);
     return art;
 }
@@ -439,9 +487,112 @@ unsigned char* art_lock(int fid, CacheEntry** handlePtr, int* widthPtr, int* hei
 // 0x418A2C
 int art_ptr_unlock(CacheEntry* handle)
 {
+    int rc;
+
+    if (art_pins_active) {
+        // Pinned art is handed out without handle.
+        if (handle == NULL) {
+            return 0;
+        }
+
+        mutex_lock(art_pins_mutex);
+        rc = cache_unlock(&art_cache, handle);
+        mutex_unlock(art_pins_mutex);
+        return rc;
+    }
+
     return cache_unlock(&art_cache, handle);
 }
 
+// Locks art and keeps it locked until `art_unpin_all`. Should only be called
+// from the main thread while pins are not active.
+int art_pin(int fid)
+{
+    int index;
+    Art* art;
+    CacheEntry* handle;
+
+    if (art_pins_active) {
+        return -1;
+    }
+
+    if (art_pin_find(fid, &index)) {
+        return 0;
+    }
+
+    if (art_pins_length == art_pins_capacity) {
+        int capacity = art_pins_capacity != 0 ? art_pins_capacity * 2 : 256;
+        ArtPin* pins = (ArtPin*)mem_realloc(art_pins, sizeof(*pins) * capacity);
+        if (pins == NULL) {
+            return -1;
+        }
+
+        art_pins = pins;
+        art_pins_capacity = capacity;
+    }
+
+    art = NULL;
+    if (!cache_lock(&art_cache, fid, (void**)&art, &handle)) {
+        return -1;
+    }
+
+    memmove(&(art_pins[index + 1]), &(art_pins[index]), sizeof(*art_pins) * (art_pins_length - index));
+    art_pins[index].fid = fid;
+    art_pins[index].art = art;
+    art_pins[index].handle = handle;
+    art_pins_length++;
+
+    return 0;
+}
+
+// Switches `art_ptr_lock` and `art_ptr_unlock` into mode safe to be called
+// from several threads at once.
+void art_pin_activate(bool active)
+{
+    if (active && art_pins_mutex == NULL) {
+        art_pins_mutex = mutex_create();
+        if (art_pins_mutex == NULL) {
+            return;
+        }
+    }
+
+    art_pins_active = active;
+}
+
+void art_unpin_all()
+{
+    art_pins_active = false;
+
+    for (int index = 0; index < art_pins_length; index++) {
+        cache_unlock(&art_cache, art_pins[index].handle);
+    }
+
+    art_pins_length = 0;
+}
+
+static bool art_pin_find(int fid, int* indexPtr)
+{
+    int low = 0;
+    int high = art_pins_length - 1;
+
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (fid == art_pins[mid].fid) {
+            *indexPtr = mid;
+            return true;
+        }
+
+        if (fid < art_pins[mid].fid) {
+            high = mid - 1;
+        } else {
+            low = mid + 1;
+        }
+    }
+
+    *indexPtr = low;
+    return false;
+}
+
 // 0x418A48
 int art_flush()
 {
@@ -648,29 +799,27 @@ char* art_get_name(int fid)
 // 0x418E38
 int art_read_lst(const char* path, char** artListPtr, int* artListSizePtr)
 {
-    DB_FILE* stream = db_fopen(path, "rt");
-    if (stream == NULL) {
+    LstFile lst;
+    if (lst_load(&lst, path) == -1) {
         return -1;
     }
 
-    int count = 0;
-    char string[200];
-    while (db_fgets(string, sizeof(string), stream)) {
-        count++;
-    }
-
-    db_fseek(stream, 0, SEEK_SET);
+    int count = lst.length;
 
     *artListSizePtr = count;
 
     char* artList = (char*)mem_malloc(13 * count);
     *artListPtr = artList;
     if (artList == NULL) {
-        db_fclose(stream);
+        lst_free(&lst);
         return -1;
     }
 
-    while (db_fgets(string, sizeof(string), stream)) {
+    char string[200];
+    for (int index = 0; index < count; index++) {
+        strncpy(string, lst_get(&lst, index), sizeof(string) - 1);
+        string[sizeof(string) - 1] = '\0';
+
         char* brk = strpbrk(string, " ,;\t\n");
         if (brk != NULL) {
             *brk = '\0';
@@ -682,7 +831,7 @@ int art_read_lst(const char* path, char** artListPtr, int* artListSizePtr)
         artList += 13;
     }
 
-    db_fclose(stream);
+    lst_free(&lst);
 
     return 0;
 }
@@ -128,6 +128,9 @@ Art* art_ptr_lock(int fid, CacheEntry** cache_entry);
 unsigned char* art_ptr_lock_data(int fid, int frame, int direction, CacheEntry** out_cache_entry);
 unsigned char* art_lock(int fid, CacheEntry** out_cache_entry, int* widthPtr, int* heightPtr);
 int art_ptr_unlock(CacheEntry* cache_entry);
+int art_pin(int fid);
+void art_pin_activate(bool active);
+void art_unpin_all();
 int art_discard(int fid);
 int art_flush();
 int art_get_base_name(int objectType, int a2, char* a3);
@@ -24,6 +24,12 @@
 
 #define AUTOMAP_OFFSET_COUNT (AUTOMAP_MAP_COUNT * ELEVATION_COUNT)
 
+// Size of automap.db header (version, data size and offsets).
+#define AUTOMAP_HEADER_SIZE (1 + 4 + 4 * AUTOMAP_OFFSET_COUNT)
+
+// Size of automap entry header (data size and compression flag).
+#define AUTOMAP_ENTRY_HEADER_SIZE 5
+
 #define AUTOMAP_WINDOW_X 75
 #define AUTOMAP_WINDOW_Y 0
 #define AUTOMAP_WINDOW_WIDTH 519
@@ -57,6 +63,15 @@ typedef enum AutomapFrm {
     AUTOMAP_FRM_COUNT,
 } AutomapFrm;
 
+// Automap data of map elevation, see `amcache`.
+typedef struct AutomapCacheEntry {
+    // Uncompressed automap data, `NULL` if it was never needed.
+    unsigned char* data;
+
+    // Data is newer than what is stored in automap.db.
+    bool dirty;
+} AutomapCacheEntry;
+
 static void draw_top_down_map(int window, int elevation, unsigned char* backgroundData, int flags);
 static int WriteAM_Entry(DB_FILE* stream);
 static int AM_ReadEntry(int map, int elevation);
@@ -65,6 +80,9 @@ static int AM_ReadMainHeader(DB_FILE* stream);
 static void decode_map_data(int elevation);
 static int am_pip_init();
 static int copy_file_data(DB_FILE* stream1, DB_FILE* stream2, int length);
+static int am_load_index();
+static int am_compact();
+static void am_cache_reset();
 
 // 0x41A420
 static const int defam[AUTOMAP_MAP_COUNT][ELEVATION_COUNT] = {
@@ -151,6 +169,27 @@ static unsigned char* cmpbuf;
 // 0x56BBA4
 static unsigned char* ambuf;
 
+// Automap data of every map elevation read or saved during this session.
+//
+// Saving automap only updates this cache, dirty entries are written to
+// automap.db when the database itself is needed (see `automap_flush`). They
+// are appended to the end of the database and replaced entries are left in
+// place until there are enough of them to compact the file.
+static AutomapCacheEntry amcache[AUTOMAP_MAP_COUNT][ELEVATION_COUNT];
+
+// Number of dirty entries in `amcache`.
+static int amcache_dirty = 0;
+
+// Sizes of entries in automap.db (including entry header), valid when
+// `amdbloaded` is set along with `amdbhead`.
+static int amdbsizes[AUTOMAP_MAP_COUNT][ELEVATION_COUNT];
+
+// Number of bytes in automap.db taken by replaced entries.
+static int amdbgarbage = 0;
+
+// Specifies that `amdbhead` and `amdbsizes` match automap.db.
+static bool amdbloaded = false;
+
 // 0x41A74C
 int automap_init()
 {
@@ -170,6 +209,8 @@ int automap_reset()
 // 0x41A774
 void automap_exit()
 {
+    am_cache_reset();
+
     char* masterPatchesPath;
     if (config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MASTER_PATCHES_KEY, &masterPatchesPath)) {
         char path[MAX_PATH];
@@ -552,213 +593,28 @@ int automap_pip_save()
     int map = map_get_index_number();
     int elevation = map_elevation;
 
-    int entryOffset = amdbhead.offsets[map][elevation];
-    if (entryOffset < 0) {
+    if (!YesWriteIndex(map, elevation)) {
         return 0;
     }
 
     debug_printf("\nAUTOMAP: Saving AutoMap DB index %d, level %d\n", map, elevation);
 
-    bool dataBuffersAllocated = false;
-    ambuf = (unsigned char*)mem_malloc(11024);
-    if (ambuf != NULL) {
-        cmpbuf = (unsigned char*)mem_malloc(11024);
-        if (cmpbuf != NULL) {
-            dataBuffersAllocated = true;
+    AutomapCacheEntry* entry = &(amcache[map][elevation]);
+    if (entry->data == NULL) {
+        entry->data = (unsigned char*)mem_malloc(SQUARE_GRID_SIZE);
+        if (entry->data == NULL) {
+            debug_printf("\nAUTOMAP: Error allocating data buffers!\n");
+            return -1;
         }
     }
 
-    if (!dataBuffersAllocated) {
-        // FIXME: Leaking ambuf.
-        debug_printf("\nAUTOMAP: Error allocating data buffers!\n");
-        return -1;
-    }
-
-    // NOTE: Not sure about the size.
-    char path[256];
-    sprintf(path, "%s\\%s", "MAPS", AUTOMAP_DB);
-
-    DB_FILE* stream1 = db_fopen(path, "r+b");
-    if (stream1 == NULL) {
-        debug_printf("\nAUTOMAP: Error opening automap database file!\n");
-        debug_printf("Error continued: automap_pip_save: path: %s", path);
-        mem_free(ambuf);
-        mem_free(cmpbuf);
-        return -1;
-    }
-
-    if (AM_ReadMainHeader(stream1) == -1) {
-        debug_printf("\nAUTOMAP: Error reading automap database file header!\n");
-        mem_free(ambuf);
-        mem_free(cmpbuf);
-        db_fclose(stream1);
-        return -1;
-    }
-
+    ambuf = entry->data;
     decode_map_data(elevation);
+    ambuf = NULL;
 
-    int compressedDataSize = CompLZS(ambuf, cmpbuf, 10000);
-    if (compressedDataSize == -1) {
-        amdbsubhead.dataSize = 10000;
-        amdbsubhead.isCompressed = 0;
-    } else {
-        amdbsubhead.dataSize = compressedDataSize;
-        amdbsubhead.isCompressed = 1;
-    }
-
-    if (entryOffset != 0) {
-        sprintf(path, "%s\\%s", "MAPS", AUTOMAP_TMP);
-
-        DB_FILE* stream2 = db_fopen(path, "wb");
-        if (stream2 == NULL) {
-            debug_printf("\nAUTOMAP: Error creating temp file!\n");
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            db_fclose(stream1);
-            return -1;
-        }
-
-        db_rewind(stream1);
-
-        if (copy_file_data(stream1, stream2, entryOffset) == -1) {
-            debug_printf("\nAUTOMAP: Error copying file data!\n");
-            db_fclose(stream1);
-            db_fclose(stream2);
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            return -1;
-        }
-
-        if (WriteAM_Entry(stream2) == -1) {
-            db_fclose(stream1);
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            return -1;
-        }
-
-        int nextEntryDataSize;
-        if (db_freadLong(stream1, &nextEntryDataSize) == -1) {
-            debug_printf("\nAUTOMAP: Error reading database #1!\n");
-            db_fclose(stream1);
-            db_fclose(stream2);
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            return -1;
-        }
-
-        int automapDataSize = db_filelength(stream1);
-        if (automapDataSize == -1) {
-            debug_printf("\nAUTOMAP: Error reading database #2!\n");
-            db_fclose(stream1);
-            db_fclose(stream2);
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            return -1;
-        }
-
-        int nextEntryOffset = entryOffset + nextEntryDataSize + 5;
-        if (automapDataSize != nextEntryOffset) {
-            if (db_fseek(stream1, nextEntryOffset, SEEK_SET) == -1) {
-                debug_printf("\nAUTOMAP: Error writing temp data!\n");
-                db_fclose(stream1);
-                db_fclose(stream2);
-                mem_free(ambuf);
-                mem_free(cmpbuf);
-                return -1;
-            }
-
-            if (copy_file_data(stream1, stream2, automapDataSize - nextEntryOffset) == -1) {
-                debug_printf("\nAUTOMAP: Error copying file data!\n");
-                db_fclose(stream1);
-                db_fclose(stream2);
-                mem_free(ambuf);
-                mem_free(cmpbuf);
-                return -1;
-            }
-        }
-
-        int diff = amdbsubhead.dataSize - nextEntryDataSize;
-        for (int map = 0; map < AUTOMAP_MAP_COUNT; map++) {
-            for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
-                if (amdbhead.offsets[map][elevation] > entryOffset) {
-                    amdbhead.offsets[map][elevation] += diff;
-                }
-            }
-        }
-
-        amdbhead.dataSize += diff;
-
-        if (WriteAM_Header(stream2) == -1) {
-            db_fclose(stream1);
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            return -1;
-        }
-
-        db_fseek(stream2, 0, SEEK_END);
-        db_fclose(stream2);
-        db_fclose(stream1);
-        mem_free(ambuf);
-        mem_free(cmpbuf);
-
-        char* masterPatchesPath;
-        if (!config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MASTER_PATCHES_KEY, &masterPatchesPath)) {
-            debug_printf("\nAUTOMAP: Error reading config info!\n");
-            return -1;
-        }
-
-        // NOTE: Not sure about the size.
-        char automapDbPath[512];
-        sprintf(automapDbPath, "%s\\%s\\%s", masterPatchesPath, "MAPS", AUTOMAP_DB);
-        if (remove(automapDbPath) != 0) {
-            debug_printf("\nAUTOMAP: Error removing database!\n");
-            return -1;
-        }
-
-        // NOTE: Not sure about the size.
-        char automapTmpPath[512];
-        sprintf(automapTmpPath, "%s\\%s\\%s", masterPatchesPath, "MAPS", AUTOMAP_TMP);
-        if (rename(automapTmpPath, automapDbPath) != 0) {
-            debug_printf("\nAUTOMAP: Error renaming database!\n");
-            return -1;
-        }
-    } else {
-        bool proceed = true;
-        if (db_fseek(stream1, 0, SEEK_END) != -1) {
-            if (db_ftell(stream1) != amdbhead.dataSize) {
-                proceed = false;
-            }
-        } else {
-            proceed = false;
-        }
-
-        if (!proceed) {
-            debug_printf("\nAUTOMAP: Error reading automap database file header!\n");
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            db_fclose(stream1);
-            return -1;
-        }
-
-        if (WriteAM_Entry(stream1) == -1) {
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            return -1;
-        }
-
-        amdbhead.offsets[map][elevation] = amdbhead.dataSize;
-        amdbhead.dataSize += amdbsubhead.dataSize + 5;
-
-        if (WriteAM_Header(stream1) == -1) {
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            return -1;
-        }
-
-        db_fseek(stream1, 0, SEEK_END);
-        db_fclose(stream1);
-        mem_free(ambuf);
-        mem_free(cmpbuf);
+    if (!entry->dirty) {
+        entry->dirty = true;
+        amcache_dirty++;
     }
 
     return 1;
@@ -803,24 +659,29 @@ static int AM_ReadEntry(int map, int elevation)
 {
     cmpbuf = NULL;
 
+    AutomapCacheEntry* entry = &(amcache[map][elevation]);
+    if (entry->data != NULL) {
+        memcpy(ambuf, entry->data, SQUARE_GRID_SIZE);
+        return 0;
+    }
+
+    if (am_load_index() == -1) {
+        debug_printf("\nAUTOMAP: Error reading automap database header!\n");
+        return -1;
+    }
+
     char path[MAX_PATH];
     sprintf(path, "%s\\%s", "MAPS", AUTOMAP_DB);
 
     bool success = true;
 
-    DB_FILE* stream = db_fopen(path, "r+b");
+    DB_FILE* stream = db_fopen(path, "rb");
     if (stream == NULL) {
         debug_printf("\nAUTOMAP: Error opening automap database file!\n");
         debug_printf("Error continued: AM_ReadEntry: path: %s", path);
         return -1;
     }
 
-    if (AM_ReadMainHeader(stream) == -1) {
-        debug_printf("\nAUTOMAP: Error reading automap database header!\n");
-        db_fclose(stream);
-        return -1;
-    }
-
     if (amdbhead.offsets[map][elevation] <= 0) {
         success = false;
         goto out;
@@ -880,6 +741,12 @@ out:
         mem_free(cmpbuf);
     }
 
+    // Keep it around, pipboy is likely to show it again.
+    entry->data = (unsigned char*)mem_malloc(SQUARE_GRID_SIZE);
+    if (entry->data != NULL) {
+        memcpy(entry->data, ambuf, SQUARE_GRID_SIZE);
+    }
+
     return 0;
 }
 
@@ -974,10 +841,16 @@ static void decode_map_data(int elevation)
 // 0x41BBEC
 static int am_pip_init()
 {
+    am_cache_reset();
+
     amdbhead.version = 1;
     amdbhead.dataSize = 797;
     memcpy(amdbhead.offsets, defam, sizeof(defam));
 
+    memset(amdbsizes, 0, sizeof(amdbsizes));
+    amdbgarbage = 0;
+    amdbloaded = true;
+
     char path[MAX_PATH];
     sprintf(path, "%s\\%s", "MAPS", AUTOMAP_DB);
 
@@ -1043,25 +916,287 @@ static int copy_file_data(DB_FILE* stream1, DB_FILE* stream2, int length)
 // 0x41BDC8
 int ReadAMList(AutomapHeader** automapHeaderPtr)
 {
+    // Entries saved during this session should be listed as well.
+    if (automap_flush() == -1) {
+        return -1;
+    }
+
+    if (am_load_index() == -1) {
+        debug_printf("\nAUTOMAP: Error reading automap database header pt2!\n");
+        return -1;
+    }
+
+    *automapHeaderPtr = &amdbhead;
+
+    return 0;
+}
+
+// Writes automap data saved since the last flush to automap.db. Should be
+// called before automap.db is read by anything but this module.
+int automap_flush()
+{
+    if (amcache_dirty == 0) {
+        return 0;
+    }
+
+    if (am_load_index() == -1) {
+        debug_printf("\nAUTOMAP: Error reading automap database file header!\n");
+        return -1;
+    }
+
+    unsigned char* compressed = (unsigned char*)mem_malloc(11024);
+    if (compressed == NULL) {
+        debug_printf("\nAUTOMAP: Error allocating data buffers!\n");
+        return -1;
+    }
+
+    char path[MAX_PATH];
+    sprintf(path, "%s\\%s", "MAPS", AUTOMAP_DB);
+
+    DB_FILE* stream = db_fopen(path, "r+b");
+    if (stream == NULL) {
+        debug_printf("\nAUTOMAP: Error opening automap database file!\n");
+        debug_printf("Error continued: automap_flush: path: %s", path);
+        mem_free(compressed);
+        return -1;
+    }
+
+    if (db_fseek(stream, 0, SEEK_END) == -1 || db_ftell(stream) != amdbhead.dataSize) {
+        debug_printf("\nAUTOMAP: Error reading automap database file header!\n");
+        db_fclose(stream);
+        mem_free(compressed);
+        return -1;
+    }
+
+    for (int map = 0; map < AUTOMAP_MAP_COUNT; map++) {
+        for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
+            AutomapCacheEntry* entry = &(amcache[map][elevation]);
+            if (!entry->dirty) {
+                continue;
+            }
+
+            ambuf = entry->data;
+            cmpbuf = compressed;
+
+            int compressedDataSize = CompLZS(ambuf, cmpbuf, 10000);
+            if (compressedDataSize == -1) {
+                amdbsubhead.dataSize = 10000;
+                amdbsubhead.isCompressed = 0;
+            } else {
+                amdbsubhead.dataSize = compressedDataSize;
+                amdbsubhead.isCompressed = 1;
+            }
+
+            // Entries are only ever appended, previous version of this one
+            // (if any) becomes garbage.
+            if (db_fseek(stream, amdbhead.dataSize, SEEK_SET) == -1
+                || WriteAM_Entry(stream) == -1) {
+                // NOTE: `WriteAM_Entry` closes stream on error.
+                ambuf = NULL;
+                cmpbuf = NULL;
+                mem_free(compressed);
+                amdbloaded = false;
+                return -1;
+            }
+
+            if (amdbhead.offsets[map][elevation] > 0) {
+                amdbgarbage += amdbsizes[map][elevation];
+            }
+
+            amdbhead.offsets[map][elevation] = amdbhead.dataSize;
+            amdbsizes[map][elevation] = amdbsubhead.dataSize + AUTOMAP_ENTRY_HEADER_SIZE;
+            amdbhead.dataSize += amdbsizes[map][elevation];
+        }
+    }
+
+    ambuf = NULL;
+    cmpbuf = NULL;
+    mem_free(compressed);
+
+    if (WriteAM_Header(stream) == -1) {
+        amdbloaded = false;
+        return -1;
+    }
+
+    db_fclose(stream);
+
+    // Entries only count as written once header references them, so a
+    // failed flush is retried in full.
+    for (int map = 0; map < AUTOMAP_MAP_COUNT; map++) {
+        for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
+            amcache[map][elevation].dirty = false;
+        }
+    }
+    amcache_dirty = 0;
+
+    if (amdbgarbage > amdbhead.dataSize - AUTOMAP_HEADER_SIZE - amdbgarbage) {
+        if (am_compact() == -1) {
+            debug_printf("\nAUTOMAP: Error compacting database!\n");
+        }
+    }
+
+    return 0;
+}
+
+// Specifies that automap.db was replaced (by loading a game), so cached
+// automap data and database index are no longer valid.
+void automap_invalidate()
+{
+    am_cache_reset();
+    amdbloaded = false;
+}
+
+// Reads automap.db header and sizes of its entries, unless they are known
+// already.
+static int am_load_index()
+{
+    if (amdbloaded) {
+        return 0;
+    }
+
     char path[MAX_PATH];
     sprintf(path, "%s\\%s", "MAPS", AUTOMAP_DB);
 
     DB_FILE* stream = db_fopen(path, "rb");
     if (stream == NULL) {
         debug_printf("\nAUTOMAP: Error opening database file for reading!\n");
-        debug_printf("Error continued: ReadAMList: path: %s", path);
+        debug_printf("Error continued: am_load_index: path: %s", path);
         return -1;
     }
 
     if (AM_ReadMainHeader(stream) == -1) {
-        debug_printf("\nAUTOMAP: Error reading automap database header pt2!\n");
         db_fclose(stream);
         return -1;
     }
 
+    int used = AUTOMAP_HEADER_SIZE;
+    for (int map = 0; map < AUTOMAP_MAP_COUNT; map++) {
+        for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
+            amdbsizes[map][elevation] = 0;
+
+            if (amdbhead.offsets[map][elevation] > 0) {
+                int dataSize;
+                if (db_fseek(stream, amdbhead.offsets[map][elevation], SEEK_SET) == -1
+                    || db_freadLong(stream, &dataSize) == -1) {
+                    db_fclose(stream);
+                    return -1;
+                }
+
+                amdbsizes[map][elevation] = dataSize + AUTOMAP_ENTRY_HEADER_SIZE;
+                used += amdbsizes[map][elevation];
+            }
+        }
+    }
+
     db_fclose(stream);
 
-    *automapHeaderPtr = &amdbhead;
+    amdbgarbage = amdbhead.dataSize > used ? amdbhead.dataSize - used : 0;
+    amdbloaded = true;
+
+    return 0;
+}
+
+// Rewrites automap.db without replaced entries.
+static int am_compact()
+{
+    char path[MAX_PATH];
+    sprintf(path, "%s\\%s", "MAPS", AUTOMAP_DB);
+
+    DB_FILE* stream1 = db_fopen(path, "rb");
+    if (stream1 == NULL) {
+        return -1;
+    }
+
+    sprintf(path, "%s\\%s", "MAPS", AUTOMAP_TMP);
+
+    DB_FILE* stream2 = db_fopen(path, "wb");
+    if (stream2 == NULL) {
+        db_fclose(stream1);
+        return -1;
+    }
+
+    AutomapHeader header = amdbhead;
+    header.dataSize = AUTOMAP_HEADER_SIZE;
+
+    if (db_fseek(stream2, AUTOMAP_HEADER_SIZE, SEEK_SET) == -1) {
+        db_fclose(stream1);
+        db_fclose(stream2);
+        return -1;
+    }
+
+    for (int map = 0; map < AUTOMAP_MAP_COUNT; map++) {
+        for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
+            if (amdbhead.offsets[map][elevation] <= 0) {
+                continue;
+            }
+
+            if (db_fseek(stream1, amdbhead.offsets[map][elevation], SEEK_SET) == -1
+                || copy_file_data(stream1, stream2, amdbsizes[map][elevation]) == -1) {
+                db_fclose(stream1);
+                db_fclose(stream2);
+                return -1;
+            }
+
+            header.offsets[map][elevation] = header.dataSize;
+            header.dataSize += amdbsizes[map][elevation];
+        }
+    }
+
+    db_fclose(stream1);
+
+    AutomapHeader oldHeader = amdbhead;
+    amdbhead = header;
+
+    // NOTE: `WriteAM_Header` closes stream on error.
+    if (WriteAM_Header(stream2) == -1) {
+        amdbhead = oldHeader;
+        return -1;
+    }
+
+    db_fclose(stream2);
+
+    char* masterPatchesPath;
+    if (!config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MASTER_PATCHES_KEY, &masterPatchesPath)) {
+        amdbhead = oldHeader;
+        return -1;
+    }
+
+    char automapDbPath[512];
+    sprintf(automapDbPath, "%s\\%s\\%s", masterPatchesPath, "MAPS", AUTOMAP_DB);
+
+    char automapTmpPath[512];
+    sprintf(automapTmpPath, "%s\\%s\\%s", masterPatchesPath, "MAPS", AUTOMAP_TMP);
+
+    if (remove(automapDbPath) != 0) {
+        amdbhead = oldHeader;
+        return -1;
+    }
+
+    if (rename(automapTmpPath, automapDbPath) != 0) {
+        // Database is gone, nothing to fall back to.
+        amdbloaded = false;
+        return -1;
+    }
+
+    debug_printf("\nAUTOMAP: Compacted database, %d bytes freed.\n", amdbgarbage);
+
+    amdbgarbage = 0;
 
     return 0;
 }
+
+static void am_cache_reset()
+{
+    for (int map = 0; map < AUTOMAP_MAP_COUNT; map++) {
+        for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
+            AutomapCacheEntry* entry = &(amcache[map][elevation]);
+            if (entry->data != NULL) {
+                mem_free(entry->data);
+                entry->data = NULL;
+            }
+            entry->dirty = false;
+        }
+    }
+
+    amcache_dirty = 0;
+}
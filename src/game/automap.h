@@ -42,5 +42,7 @@ int draw_top_down_map_pipboy(int win, int map, int elevation);
 int automap_pip_save();
 int YesWriteIndex(int mapIndex, int elevation);
 int ReadAMList(AutomapHeader** automapHeaderPtr);
+int automap_flush();
+void automap_invalidate();
 
 #endif /* FALLOUT_GAME_AUTOMAP_H_ */
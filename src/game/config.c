@@ -1,6 +1,7 @@
 #include "game/config.h"
 
 #include <ctype.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,10 +14,42 @@
 // The initial number of sections (or key-value) pairs in the config.
 #define CONFIG_INITIAL_CAPACITY 10
 
+// The number of slots in [config_cache], must be a power of two.
+#define CONFIG_CACHE_SIZE 512
+
+#define CONFIG_CACHE_INT 0x01
+#define CONFIG_CACHE_DOUBLE 0x02
+
+// Result of looking up a key in a config, along with the value parsed by typed
+// getters.
+//
+// Section and key names, as well as the value, are owned by config. The whole
+// cache is cleared whenever any config is modified, so they are always valid.
+typedef struct ConfigCacheEntry {
+    Config* config;
+    unsigned int hash;
+    const char* sectionKey;
+    const char* key;
+    char** value;
+    int flags;
+    int intValue;
+    double doubleValue;
+} ConfigCacheEntry;
+
 static bool config_parse_line(Config* config, char* string);
 static bool config_split_line(char* string, char* key, char* value);
 static bool config_add_section(Config* config, const char* sectionKey);
 static bool config_strip_white_space(char* string);
+static unsigned int config_cache_hash(Config* config, const char* sectionKey, const char* key);
+static ConfigCacheEntry* config_cache_find(Config* config, const char* sectionKey, const char* key);
+static void config_cache_clear();
+
+// Open addressing hash table of looked up keys, settings are read all the
+// time and it saves two binary searches per lookup.
+static ConfigCacheEntry config_cache[CONFIG_CACHE_SIZE];
+
+// The number of used slots in [config_cache].
+static int config_cache_length = 0;
 
 // 0x426540
 bool config_init(Config* config)
@@ -39,6 +72,8 @@ void config_exit(Config* config)
         return;
     }
 
+    config_cache_clear();
+
     for (int sectionIndex = 0; sectionIndex < config->size; sectionIndex++) {
         assoc_pair* sectionEntry = &(config->list[sectionIndex]);
 
@@ -110,25 +145,16 @@ bool config_cmd_line_parse(Config* config, int argc, char** argv)
 // 0x4266E0
 bool config_get_string(Config* config, const char* sectionKey, const char* key, char** valuePtr)
 {
-    if (config == NULL || sectionKey == NULL || key == NULL || valuePtr == NULL) {
-        return false;
-    }
-
-    int sectionIndex = assoc_search(config, sectionKey);
-    if (sectionIndex == -1) {
+    if (valuePtr == NULL) {
         return false;
     }
 
-    assoc_pair* sectionEntry = &(config->list[sectionIndex]);
-    ConfigSection* section = (ConfigSection*)sectionEntry->data;
-
-    int index = assoc_search(section, key);
-    if (index == -1) {
+    ConfigCacheEntry* entry = config_cache_find(config, sectionKey, key);
+    if (entry == NULL) {
         return false;
     }
 
-    assoc_pair* keyValueEntry = &(section->list[index]);
-    *valuePtr = *(char**)keyValueEntry->data;
+    *valuePtr = *(entry->value);
 
     return true;
 }
@@ -140,6 +166,8 @@ bool config_set_string(Config* config, const char* sectionKey, const char* key,
         return false;
     }
 
+    config_cache_clear();
+
     int sectionIndex = assoc_search(config, sectionKey);
     if (sectionIndex == -1) {
         // FIXME: Looks like a bug, this function never returns -1, which will
@@ -184,12 +212,17 @@ bool config_get_value(Config* config, const char* sectionKey, const char* key, i
         return false;
     }
 
-    char* stringValue;
-    if (!config_get_string(config, sectionKey, key, &stringValue)) {
+    ConfigCacheEntry* entry = config_cache_find(config, sectionKey, key);
+    if (entry == NULL) {
         return false;
     }
 
-    *valuePtr = atoi(stringValue);
+    if ((entry->flags & CONFIG_CACHE_INT) == 0) {
+        entry->intValue = atoi(*(entry->value));
+        entry->flags |= CONFIG_CACHE_INT;
+    }
+
+    *valuePtr = entry->intValue;
 
     return true;
 }
@@ -488,12 +521,17 @@ bool config_get_double(Config* config, const char* sectionKey, const char* key,
         return false;
     }
 
-    char* stringValue;
-    if (!config_get_string(config, sectionKey, key, &stringValue)) {
+    ConfigCacheEntry* entry = config_cache_find(config, sectionKey, key);
+    if (entry == NULL) {
         return false;
     }
 
-    *valuePtr = strtod(stringValue, NULL);
+    if ((entry->flags & CONFIG_CACHE_DOUBLE) == 0) {
+        entry->doubleValue = strtod(*(entry->value), NULL);
+        entry->flags |= CONFIG_CACHE_DOUBLE;
+    }
+
+    *valuePtr = entry->doubleValue;
 
     return true;
 }
@@ -529,3 +567,89 @@ bool configSetBool(Config* config, const char* sectionKey, const char* key, bool
 {
     return config_set_value(config, sectionKey, key, value ? 1 : 0);
 }
+
+// Case-insensitive FNV-1a of section and key names, mixed with config address
+// since several configs are loaded at the same time.
+static unsigned int config_cache_hash(Config* config, const char* sectionKey, const char* key)
+{
+    unsigned int hash = 2166136261U ^ (unsigned int)(uintptr_t)config;
+
+    for (const char* pch = sectionKey; *pch != '\0'; pch++) {
+        hash ^= (unsigned char)tolower(*pch);
+        hash *= 16777619U;
+    }
+
+    hash ^= ']';
+    hash *= 16777619U;
+
+    for (const char* pch = key; *pch != '\0'; pch++) {
+        hash ^= (unsigned char)tolower(*pch);
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+// Finds value of the key in the config, looking it up in the config itself
+// (and remembering the result) if it's not in the cache yet.
+static ConfigCacheEntry* config_cache_find(Config* config, const char* sectionKey, const char* key)
+{
+    if (config == NULL || sectionKey == NULL || key == NULL) {
+        return NULL;
+    }
+
+    unsigned int hash = config_cache_hash(config, sectionKey, key);
+
+    int slot = hash & (CONFIG_CACHE_SIZE - 1);
+    while (config_cache[slot].config != NULL) {
+        ConfigCacheEntry* entry = &(config_cache[slot]);
+        if (entry->hash == hash
+            && entry->config == config
+            && stricmp(entry->sectionKey, sectionKey) == 0
+            && stricmp(entry->key, key) == 0) {
+            return entry;
+        }
+
+        slot = (slot + 1) & (CONFIG_CACHE_SIZE - 1);
+    }
+
+    int sectionIndex = assoc_search(config, sectionKey);
+    if (sectionIndex == -1) {
+        return NULL;
+    }
+
+    assoc_pair* sectionEntry = &(config->list[sectionIndex]);
+    ConfigSection* section = (ConfigSection*)sectionEntry->data;
+
+    int index = assoc_search(section, key);
+    if (index == -1) {
+        return NULL;
+    }
+
+    assoc_pair* keyValueEntry = &(section->list[index]);
+
+    // Keep the table at most half full so probe sequences stay short.
+    if (config_cache_length >= CONFIG_CACHE_SIZE / 2) {
+        config_cache_clear();
+        slot = hash & (CONFIG_CACHE_SIZE - 1);
+    }
+
+    ConfigCacheEntry* entry = &(config_cache[slot]);
+    entry->config = config;
+    entry->hash = hash;
+    entry->sectionKey = sectionEntry->name;
+    entry->key = keyValueEntry->name;
+    entry->value = (char**)keyValueEntry->data;
+    entry->flags = 0;
+    config_cache_length++;
+
+    return entry;
+}
+
+static void config_cache_clear()
+{
+    if (config_cache_length != 0) {
+        memset(config_cache, 0, sizeof(config_cache));
+        config_cache_length = 0;
+    }
+}
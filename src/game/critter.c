@@ -82,6 +82,17 @@ int rad_bonus[RADIATION_LEVEL_COUNT][RADIATION_EFFECT_COUNT] = {
     // clang-format on
 };
 
+// Layout of critter data in .pro files and saves.
+static const DBRecordField critter_data_fields[] = {
+    DB_RECORD_INT(CritterProtoData, flags),
+    DB_RECORD_INTS(CritterProtoData, baseStats, SAVEABLE_STAT_COUNT),
+    DB_RECORD_INTS(CritterProtoData, bonusStats, SAVEABLE_STAT_COUNT),
+    DB_RECORD_INTS(CritterProtoData, skills, SKILL_COUNT),
+    DB_RECORD_INT(CritterProtoData, bodyType),
+    DB_RECORD_INT(CritterProtoData, experience),
+    DB_RECORD_INT(CritterProtoData, killType),
+};
+
 // scrname.msg
 //
 // 0x56BEF4
@@ -947,13 +958,7 @@ int pc_load_data(const char* path)
 // 0x4286DC
 int critter_read_data(DB_FILE* stream, CritterProtoData* critterData)
 {
-    if (db_freadInt(stream, &(critterData->flags)) == -1) return -1;
-    if (db_freadIntCount(stream, critterData->baseStats, SAVEABLE_STAT_COUNT) == -1) return -1;
-    if (db_freadIntCount(stream, critterData->bonusStats, SAVEABLE_STAT_COUNT) == -1) return -1;
-    if (db_freadIntCount(stream, critterData->skills, SKILL_COUNT) == -1) return -1;
-    if (db_freadInt(stream, &(critterData->bodyType)) == -1) return -1;
-    if (db_freadInt(stream, &(critterData->experience)) == -1) return -1;
-    if (db_freadInt(stream, &(critterData->killType)) == -1) return -1;
+    if (db_freadRecord(stream, critterData, critter_data_fields, DB_RECORD_LENGTH(critter_data_fields)) == -1) return -1;
 
     return 0;
 }
@@ -1017,13 +1022,7 @@ int pc_save_data(const char* path)
 // 0x4288BC
 int critter_write_data(DB_FILE* stream, CritterProtoData* critterData)
 {
-    if (db_fwriteInt(stream, critterData->flags) == -1) return -1;
-    if (db_fwriteIntCount(stream, critterData->baseStats, SAVEABLE_STAT_COUNT) == -1) return -1;
-    if (db_fwriteIntCount(stream, critterData->bonusStats, SAVEABLE_STAT_COUNT) == -1) return -1;
-    if (db_fwriteIntCount(stream, critterData->skills, SKILL_COUNT) == -1) return -1;
-    if (db_fwriteInt(stream, critterData->bodyType) == -1) return -1;
-    if (db_fwriteInt(stream, critterData->experience) == -1) return -1;
-    if (db_fwriteInt(stream, critterData->killType) == -1) return -1;
+    if (db_fwriteRecord(stream, critterData, critter_data_fields, DB_RECORD_LENGTH(critter_data_fields)) == -1) return -1;
 
     return 0;
 }
@@ -10,7 +10,13 @@
 #define COLOR_CYCLE_PERIOD_FAST 100U
 #define COLOR_CYCLE_PERIOD_VERY_FAST 33U
 
-static void cycle_colors();
+// Maximum number of missed steps caught up in one frame.
+#define COLOR_CYCLE_MAX_CATCH_UP 8U
+
+static bool cycle_colors(unsigned char* palette, unsigned int time);
+static int cycle_steps(unsigned int time, unsigned int* lastPtr, unsigned int period);
+static void cycle_copy(unsigned char* dest, unsigned char* colors, int length, int start);
+static int cycle_advance(int start, int length, int steps);
 
 // 0x504E3C
 static int cycle_speed_factor = 1;
@@ -127,7 +133,7 @@ void cycle_init()
         monitors[index] >>= 2;
     }
 
-    add_bk_process(cycle_colors);
+    palette_add_track(cycle_colors, 229, 255);
 
     cycle_initialized = true;
     cycle_enabled = true;
@@ -147,7 +153,7 @@ void cycle_reset()
         last_cycle_medium = 0;
         last_cycle_fast = 0;
         last_cycle_very_fast = 0;
-        add_bk_process(cycle_colors);
+        palette_add_track(cycle_colors, 229, 255);
         cycle_enabled = true;
     }
 }
@@ -156,7 +162,7 @@ void cycle_reset()
 void cycle_exit()
 {
     if (cycle_initialized) {
-        remove_bk_process(cycle_colors);
+        palette_remove_track(cycle_colors);
         cycle_initialized = false;
         cycle_enabled = false;
     }
@@ -180,8 +186,14 @@ bool cycle_is_enabled()
     return cycle_enabled;
 }
 
+// Palette track animating color cycled entries 229-255.
+//
+// NOTE: The original was a background process stepping every cycle at most
+// once per call, so cycles slowed down together with frame rate. Now steps
+// missed since the last frame are caught up.
+//
 // 0x428F5C
-static void cycle_colors()
+static bool cycle_colors(unsigned char* palette, unsigned int time)
 {
     // 0x504E94
     static int slime_start = 0;
@@ -204,125 +216,107 @@ static void cycle_colors()
     // 0x504EA9
     static signed char bobber_diff = -4;
 
+    int steps;
+
     if (!cycle_enabled) {
-        return;
+        return false;
     }
 
     bool changed = false;
 
-    unsigned char* palette = getSystemPalette();
-    unsigned int time = get_time();
-
-    if (elapsed_tocks(time, last_cycle_slow) >= COLOR_CYCLE_PERIOD_SLOW * cycle_speed_factor) {
+    // When several steps are due, colors are shown as of the last one.
+    steps = cycle_steps(time, &last_cycle_slow, COLOR_CYCLE_PERIOD_SLOW * cycle_speed_factor);
+    if (steps != 0) {
         changed = true;
-        last_cycle_slow = time;
-
-        int paletteIndex = 229 * 3;
-
-        for (int index = slime_start; index < 12; index++) {
-            palette[paletteIndex++] = slime[index];
-        }
-
-        for (int index = 0; index < slime_start; index++) {
-            palette[paletteIndex++] = slime[index];
-        }
-
-        slime_start -= 3;
-        if (slime_start < 0) {
-            slime_start = 9;
-        }
-
-        paletteIndex = 248 * 3;
-
-        for (int index = shoreline_start; index < 18; index++) {
-            palette[paletteIndex++] = shoreline[index];
-        }
-
-        for (int index = 0; index < shoreline_start; index++) {
-            palette[paletteIndex++] = shoreline[index];
-        }
 
-        shoreline_start -= 3;
-        if (shoreline_start < 0) {
-            shoreline_start = 15;
-        }
+        cycle_copy(palette + 229 * 3, slime, 12, cycle_advance(slime_start, 12, steps - 1));
+        slime_start = cycle_advance(slime_start, 12, steps);
 
-        paletteIndex = 238 * 3;
+        cycle_copy(palette + 248 * 3, shoreline, 18, cycle_advance(shoreline_start, 18, steps - 1));
+        shoreline_start = cycle_advance(shoreline_start, 18, steps);
 
-        for (int index = fire_slow_start; index < 15; index++) {
-            palette[paletteIndex++] = fire_slow[index];
-        }
-
-        for (int index = 0; index < fire_slow_start; index++) {
-            palette[paletteIndex++] = fire_slow[index];
-        }
-
-        fire_slow_start -= 3;
-        if (fire_slow_start < 0) {
-            fire_slow_start = 12;
-        }
+        cycle_copy(palette + 238 * 3, fire_slow, 15, cycle_advance(fire_slow_start, 15, steps - 1));
+        fire_slow_start = cycle_advance(fire_slow_start, 15, steps);
     }
 
-    if (elapsed_tocks(time, last_cycle_medium) >= COLOR_CYCLE_PERIOD_MEDIUM * cycle_speed_factor) {
+    steps = cycle_steps(time, &last_cycle_medium, COLOR_CYCLE_PERIOD_MEDIUM * cycle_speed_factor);
+    if (steps != 0) {
         changed = true;
-        last_cycle_medium = time;
-
-        int paletteIndex = 243 * 3;
 
-        for (int index = fire_fast_start; index < 15; index++) {
-            palette[paletteIndex++] = fire_fast[index];
-        }
+        cycle_copy(palette + 243 * 3, fire_fast, 15, cycle_advance(fire_fast_start, 15, steps - 1));
+        fire_fast_start = cycle_advance(fire_fast_start, 15, steps);
+    }
 
-        for (int index = 0; index < fire_fast_start; index++) {
-            palette[paletteIndex++] = fire_fast[index];
-        }
+    steps = cycle_steps(time, &last_cycle_fast, COLOR_CYCLE_PERIOD_FAST * cycle_speed_factor);
+    if (steps != 0) {
+        changed = true;
 
-        fire_fast_start -= 3;
-        if (fire_fast_start < 0) {
-            fire_fast_start = 12;
-        }
+        cycle_copy(palette + 233 * 3, monitors, 15, cycle_advance(monitors_start, 15, steps - 1));
+        monitors_start = cycle_advance(monitors_start, 15, steps);
     }
 
-    if (elapsed_tocks(time, last_cycle_fast) >= COLOR_CYCLE_PERIOD_FAST * cycle_speed_factor) {
+    steps = cycle_steps(time, &last_cycle_very_fast, COLOR_CYCLE_PERIOD_VERY_FAST * cycle_speed_factor);
+    if (steps != 0) {
         changed = true;
-        last_cycle_fast = time;
 
-        int paletteIndex = 233 * 3;
+        while (steps-- > 0) {
+            if (bobber_red == 0 || bobber_red == 60) {
+                bobber_diff = -bobber_diff;
+            }
 
-        for (int index = monitors_start; index < 15; index++) {
-            palette[paletteIndex++] = monitors[index];
+            bobber_red += bobber_diff;
         }
 
-        for (int index = 0; index < monitors_start; index++) {
-            palette[paletteIndex++] = monitors[index];
-        }
+        int paletteIndex = 254 * 3;
+        palette[paletteIndex++] = bobber_red;
+        palette[paletteIndex++] = 0;
+        palette[paletteIndex++] = 0;
+    }
 
-        monitors_start -= 3;
+    return changed;
+}
 
-        if (monitors_start < 0) {
-            monitors_start = 12;
-        }
+// Returns number of steps of cycle with given period which are due at
+// `time` and advances cycle timestamp accordingly.
+static int cycle_steps(unsigned int time, unsigned int* lastPtr, unsigned int period)
+{
+    unsigned int elapsed = elapsed_tocks(time, *lastPtr);
+    if (elapsed < period) {
+        return 0;
     }
 
-    if (elapsed_tocks(time, last_cycle_very_fast) >= COLOR_CYCLE_PERIOD_VERY_FAST * cycle_speed_factor) {
-        changed = true;
-        last_cycle_very_fast = time;
+    // Do not replay long pauses (cycling disabled, first frame after reset).
+    if (elapsed >= period * COLOR_CYCLE_MAX_CATCH_UP) {
+        *lastPtr = time;
+        return 1;
+    }
 
-        if (bobber_red == 0 || bobber_red == 60) {
-            bobber_diff = -bobber_diff;
-        }
+    *lastPtr += period * (elapsed / period);
 
-        bobber_red += bobber_diff;
+    return elapsed / period;
+}
 
-        int paletteIndex = 254 * 3;
-        palette[paletteIndex++] = bobber_red;
-        palette[paletteIndex++] = 0;
-        palette[paletteIndex++] = 0;
+// Copies `colors` to `dest` rotated to begin at `start`.
+static void cycle_copy(unsigned char* dest, unsigned char* colors, int length, int start)
+{
+    for (int index = start; index < length; index++) {
+        *dest++ = colors[index];
+    }
+
+    for (int index = 0; index < start; index++) {
+        *dest++ = colors[index];
     }
+}
 
-    if (changed) {
-        palette_set_entries(palette + 229 * 3, 229, 255);
+// Moves rotation start back by given number of colors.
+static int cycle_advance(int start, int length, int steps)
+{
+    start = (start - 3 * steps) % length;
+    if (start < 0) {
+        start += length;
     }
+
+    return start;
 }
 
 // 0x428F30
@@ -1,5 +1,6 @@
 #include "game/game.h"
 
+#include <direct.h>
 #include <io.h>
 #include <stdio.h>
 #include <string.h>
@@ -56,8 +57,10 @@
 #include "plib/gnw/debug.h"
 #include "plib/gnw/gnw.h"
 #include "plib/gnw/grbuf.h"
+#include "plib/gnw/headless.h"
 #include "plib/gnw/input.h"
 #include "plib/gnw/memory.h"
+#include "plib/gnw/profile.h"
 #include "plib/gnw/svga.h"
 #include "plib/gnw/text.h"
 
@@ -68,9 +71,19 @@
 #define SPLASH_HEIGHT 480
 #define SPLASH_COUNT 10
 
+// Variables section of .GAM file parsed by `game_parse_info_vars`.
+typedef struct GameInfoVars {
+    char path[MAX_PATH];
+    char section[32];
+    int* values;
+    int length;
+} GameInfoVars;
+
 static void game_display_counter(double value);
 static int game_screendump(int width, int height, unsigned char* buffer, unsigned char* palette);
 static void game_unload_info();
+static GameInfoVars* game_parse_info_vars(const char* path, const char* section);
+static void game_free_info_vars();
 static void game_help();
 static int game_init_databases();
 static int game_check_disk_space();
@@ -116,6 +129,11 @@ const char* msg_path = "game\\";
 // 0x504FD4
 int game_user_wants_to_quit = 0;
 
+// .GAM files are parsed only once, after that variables are copied from here
+// on every map load.
+static GameInfoVars* game_info_vars = NULL;
+static int game_info_vars_length = 0;
+
 // misc.msg
 //
 // 0x58CC10
@@ -165,9 +183,46 @@ int game_init(const char* windowTitle, bool isMapper, int font, int a4, int argc
     if (scale > 4) scale = 4;
     GNW95_WindowScale = scale;
 
+    // Headless mode renders into an offscreen framebuffer instead of a window.
+    int headless = 0;
+    config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_HEADLESS_KEY, &headless);
+    if (headless != 0) {
+        int dumpInterval = 0;
+        config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_HEADLESS_DUMP_INTERVAL_KEY, &dumpInterval);
+        headless_set_dump_interval(dumpInterval);
+
+        char* dumpFormat;
+        if (config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_HEADLESS_DUMP_FORMAT_KEY, &dumpFormat)) {
+            headless_set_dump_format(dumpFormat);
+        }
+
+        svga_set_backend(&headless_video_backend);
+    }
+
+    int profile = 0;
+    config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_PROFILE_KEY, &profile);
+    profile_enable(profile != 0);
+
+    // Intensity, mix and blend tables are persisted next to patches so
+    // subsequent starts do not regenerate them.
+    int colorTableCache = 1;
+    config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_COLOR_TABLE_CACHE_KEY, &colorTableCache);
+    if (colorTableCache != 0) {
+        char* masterPatches;
+        if (config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MASTER_PATCHES_KEY, &masterPatches)) {
+            sprintf(path, "%s\\colortbl", masterPatches);
+            mkdir(path);
+            colorSetTableCacheDir(path);
+        }
+    }
+
     initWindow(1, a4);
     palette_init();
 
+    int colorTableBenchmarkIterations = 0;
+    config_get_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_COLOR_TABLE_BENCHMARK_KEY, &colorTableBenchmarkIterations);
+    colorTableBenchmark(colorTableBenchmarkIterations);
+
     if (!game_in_mapper) {
         game_splash_screen();
     }
@@ -205,6 +260,14 @@ int game_init(const char* windowTitle, bool isMapper, int font, int a4, int argc
 
     debug_printf(">gsound_init\t");
 
+    int soundDecoderBenchmarkIterations = 0;
+    config_get_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_SOUND_DECODER_BENCHMARK_KEY, &soundDecoderBenchmarkIterations);
+    gsound_decoder_benchmark(soundDecoderBenchmarkIterations);
+
+    int soundMixerBenchmarkSeconds = 0;
+    config_get_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_SOUND_MIXER_BENCHMARK_KEY, &soundMixerBenchmarkSeconds);
+    gsound_mixer_benchmark(soundMixerBenchmarkSeconds);
+
     initMovie();
     debug_printf(">initMovie\t\t");
 
@@ -215,6 +278,10 @@ int game_init(const char* windowTitle, bool isMapper, int font, int a4, int argc
 
     debug_printf(">gmovie_init\t");
 
+    int movieBenchmarkIterations = 0;
+    config_get_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_MOVIE_BENCHMARK_KEY, &movieBenchmarkIterations);
+    gmovie_benchmark(movieBenchmarkIterations);
+
     if (moviefx_init() != 0) {
         debug_printf("Failed on moviefx_init\n");
         return -1;
@@ -378,6 +445,8 @@ void game_reset()
 // 0x43B654
 void game_exit()
 {
+    WaitForSave();
+
     tile_disable_refresh();
     message_exit(&misc_message_file);
     combat_exit();
@@ -418,12 +487,15 @@ void game_exit()
 // 0x43B748
 int game_handle_input(int eventCode, bool isInCombatMode)
 {
+    profile_begin(PROFILE_ZONE_INPUT);
+
     // NOTE: Uninline.
     if (game_state() == GAME_STATE_5) {
         dialogue_system_enter();
     }
 
     if (eventCode == -1) {
+        profile_end(PROFILE_ZONE_INPUT);
         return 0;
     }
 
@@ -449,10 +521,12 @@ int game_handle_input(int eventCode, bool isInCombatMode)
         }
 
         gmouse_handle_event(mouseX, mouseY, mouseState);
+        profile_end(PROFILE_ZONE_INPUT);
         return 0;
     }
 
     if (gmouse_is_scrolling()) {
+        profile_end(PROFILE_ZONE_INPUT);
         return 0;
     }
 
@@ -840,6 +914,20 @@ int game_handle_input(int eventCode, bool isInCombatMode)
             display_print(version_build_time);
         }
         break;
+    case KEY_CTRL_F:
+        if (profile_is_enabled()) {
+            profile_overlay_enable(!profile_overlay_is_enabled());
+        }
+        break;
+    case KEY_CTRL_T:
+        if (profile_is_enabled()) {
+            if (profile_export_csv("profile.csv") == 0 && profile_export_trace("profile.json") == 0) {
+                display_print("Profile saved to profile.csv and profile.json.");
+            } else {
+                display_print("Error saving profile.");
+            }
+        }
+        break;
     case KEY_ARROW_LEFT:
         map_scroll(-1, 0);
         break;
@@ -854,6 +942,8 @@ int game_handle_input(int eventCode, bool isInCombatMode)
         break;
     }
 
+    profile_end(PROFILE_ZONE_INPUT);
+
     return 0;
 }
 
@@ -922,9 +1012,20 @@ int game_load_info_vars(const char* path, const char* section, int* variablesLis
 {
     inven_reset_dude();
 
-    DB_FILE* stream = db_fopen(path, "rt");
-    if (stream == NULL) {
-        return -1;
+    GameInfoVars* info = NULL;
+    for (int index = 0; index < game_info_vars_length; index++) {
+        if (stricmp(game_info_vars[index].path, path) == 0
+            && strcmp(game_info_vars[index].section, section != NULL ? section : "") == 0) {
+            info = &(game_info_vars[index]);
+            break;
+        }
+    }
+
+    if (info == NULL) {
+        info = game_parse_info_vars(path, section);
+        if (info == NULL) {
+            return -1;
+        }
     }
 
     if (*variablesListLengthPtr != 0) {
@@ -933,6 +1034,47 @@ int game_load_info_vars(const char* path, const char* section, int* variablesLis
         *variablesListLengthPtr = 0;
     }
 
+    if (info->length != 0) {
+        *variablesListPtr = (int*)mem_malloc(sizeof(int) * info->length);
+        if (*variablesListPtr == NULL) {
+            exit(1);
+        }
+
+        memcpy(*variablesListPtr, info->values, sizeof(int) * info->length);
+        *variablesListLengthPtr = info->length;
+    }
+
+    return 0;
+}
+
+// Reads initial values of variables in `section` of .GAM file at `path` and
+// adds them to `game_info_vars`.
+static GameInfoVars* game_parse_info_vars(const char* path, const char* section)
+{
+    if (strlen(path) >= sizeof(game_info_vars->path)
+        || (section != NULL && strlen(section) >= sizeof(game_info_vars->section))) {
+        return NULL;
+    }
+
+    DB_FILE* stream = db_fopen(path, "rt");
+    if (stream == NULL) {
+        return NULL;
+    }
+
+    GameInfoVars* infoVars = (GameInfoVars*)mem_realloc(game_info_vars, sizeof(*game_info_vars) * (game_info_vars_length + 1));
+    if (infoVars == NULL) {
+        db_fclose(stream);
+        return NULL;
+    }
+
+    game_info_vars = infoVars;
+
+    GameInfoVars* info = &(game_info_vars[game_info_vars_length++]);
+    strcpy(info->path, path);
+    strcpy(info->section, section != NULL ? section : "");
+    info->values = NULL;
+    info->length = 0;
+
     char string[260];
     if (section != NULL) {
         while (db_fgets(string, 258, stream)) {
@@ -956,24 +1098,40 @@ int game_load_info_vars(const char* path, const char* section, int* variablesLis
             *semicolon = '\0';
         }
 
-        *variablesListLengthPtr = *variablesListLengthPtr + 1;
-        *variablesListPtr = (int*)mem_realloc(*variablesListPtr, sizeof(int) * *variablesListLengthPtr);
+        info->length++;
+        info->values = (int*)mem_realloc(info->values, sizeof(int) * info->length);
 
-        if (*variablesListPtr == NULL) {
+        if (info->values == NULL) {
             exit(1);
         }
 
         char* equals = strchr(string, '=');
         if (equals != NULL) {
-            sscanf(equals + 1, "%d", *variablesListPtr + *variablesListLengthPtr - 1);
+            sscanf(equals + 1, "%d", info->values + info->length - 1);
         } else {
-            (*variablesListPtr)[*variablesListLengthPtr - 1] = 0;
+            info->values[info->length - 1] = 0;
         }
     }
 
     db_fclose(stream);
 
-    return 0;
+    return info;
+}
+
+static void game_free_info_vars()
+{
+    for (int index = 0; index < game_info_vars_length; index++) {
+        if (game_info_vars[index].values != NULL) {
+            mem_free(game_info_vars[index].values);
+        }
+    }
+
+    if (game_info_vars != NULL) {
+        mem_free(game_info_vars);
+        game_info_vars = NULL;
+    }
+
+    game_info_vars_length = 0;
 }
 
 // 0x43C7AC
@@ -1062,6 +1220,8 @@ static void game_unload_info()
         mem_free(game_global_vars);
         game_global_vars = NULL;
     }
+
+    game_free_info_vars();
 }
 
 // 0x43D130
@@ -62,7 +62,18 @@ bool gconfig_init(bool isMapper, int argc, char** argv)
     config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_COLOR_CYCLING_KEY, 1);
     config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_WINDOWED_KEY, 1);
     config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_SCALE_KEY, 1);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_HEADLESS_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_HEADLESS_DUMP_INTERVAL_KEY, 0);
+    config_set_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_HEADLESS_DUMP_FORMAT_KEY, "ppm");
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_PROFILE_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_COLOR_TABLE_CACHE_KEY, 1);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_COMPOSITOR_THREADS_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MOVIE_THREADS_KEY, 0);
     config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_HASHING_KEY, 1);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_PRELOAD_PROTOS_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MAP_CACHE_SIZE_KEY, 4);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_SAVE_THREAD_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_SAVE_CONTAINER_KEY, 0);
     config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_SPLASH_KEY, 0);
     config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_FREE_SPACE_KEY, 20480);
     config_set_value(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_GAME_DIFFICULTY_KEY, 1);
@@ -95,6 +106,12 @@ bool gconfig_init(bool isMapper, int argc, char** argv)
     config_set_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_SNDFX_VOLUME_KEY, 22281);
     config_set_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_SPEECH_VOLUME_KEY, 22281);
     config_set_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_CACHE_SIZE_KEY, 448);
+    config_set_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_SFX_DECODED_CACHE_LIMIT_KEY, 32);
+    config_set_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_SOUND_THREAD_KEY, 0);
+    config_set_string(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_MIXER_KEY, "directsound");
+    config_set_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_MIXER_RATE_KEY, 44100);
+    config_set_string(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_MIXER_WAV_PATH_KEY, "mixer.wav");
+    config_set_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_MUSIC_PREFETCH_KEY, 0);
     config_set_string(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_MUSIC_PATH1_KEY, "sound\\music\\");
     config_set_string(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_MUSIC_PATH2_KEY, "sound\\music\\");
     config_set_string(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_MODE_KEY, "environment");
@@ -102,6 +119,10 @@ bool gconfig_init(bool isMapper, int argc, char** argv)
     config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_SHOW_SCRIPT_MESSAGES_KEY, 0);
     config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_SHOW_LOAD_INFO_KEY, 0);
     config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_OUTPUT_MAP_DATA_INFO_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_COLOR_TABLE_BENCHMARK_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_SOUND_DECODER_BENCHMARK_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_SOUND_MIXER_BENCHMARK_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_MOVIE_BENCHMARK_KEY, 0);
 
     if (isMapper) {
         config_set_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_EXECUTABLE_KEY, "mapper");
@@ -28,7 +28,18 @@
 #define GAME_CONFIG_CYCLE_SPEED_FACTOR_KEY "cycle_speed_factor"
 #define GAME_CONFIG_WINDOWED_KEY "windowed"
 #define GAME_CONFIG_SCALE_KEY "scale"
+#define GAME_CONFIG_HEADLESS_KEY "headless"
+#define GAME_CONFIG_HEADLESS_DUMP_INTERVAL_KEY "headless_dump_interval"
+#define GAME_CONFIG_HEADLESS_DUMP_FORMAT_KEY "headless_dump_format"
+#define GAME_CONFIG_PROFILE_KEY "profile"
+#define GAME_CONFIG_COLOR_TABLE_CACHE_KEY "color_table_cache"
+#define GAME_CONFIG_COMPOSITOR_THREADS_KEY "compositor_threads"
+#define GAME_CONFIG_MOVIE_THREADS_KEY "movie_threads"
 #define GAME_CONFIG_HASHING_KEY "hashing"
+#define GAME_CONFIG_PRELOAD_PROTOS_KEY "preload_protos"
+#define GAME_CONFIG_MAP_CACHE_SIZE_KEY "map_cache_size"
+#define GAME_CONFIG_SAVE_THREAD_KEY "save_thread"
+#define GAME_CONFIG_SAVE_CONTAINER_KEY "save_container"
 #define GAME_CONFIG_SPLASH_KEY "splash"
 #define GAME_CONFIG_FREE_SPACE_KEY "free_space"
 #define GAME_CONFIG_TIMES_RUN_KEY "times_run"
@@ -66,11 +77,21 @@
 #define GAME_CONFIG_MUSIC_PATH1_KEY "music_path1"
 #define GAME_CONFIG_MUSIC_PATH2_KEY "music_path2"
 #define GAME_CONFIG_DEBUG_SFXC_KEY "debug_sfxc"
+#define GAME_CONFIG_SFX_DECODED_CACHE_LIMIT_KEY "sfx_decoded_cache_limit"
+#define GAME_CONFIG_SOUND_THREAD_KEY "sound_thread"
+#define GAME_CONFIG_MIXER_KEY "mixer"
+#define GAME_CONFIG_MIXER_RATE_KEY "mixer_rate"
+#define GAME_CONFIG_MIXER_WAV_PATH_KEY "mixer_wav_path"
+#define GAME_CONFIG_MUSIC_PREFETCH_KEY "music_prefetch"
 #define GAME_CONFIG_MODE_KEY "mode"
 #define GAME_CONFIG_SHOW_TILE_NUM_KEY "show_tile_num"
 #define GAME_CONFIG_SHOW_SCRIPT_MESSAGES_KEY "show_script_messages"
 #define GAME_CONFIG_SHOW_LOAD_INFO_KEY "show_load_info"
 #define GAME_CONFIG_OUTPUT_MAP_DATA_INFO_KEY "output_map_data_info"
+#define GAME_CONFIG_COLOR_TABLE_BENCHMARK_KEY "color_table_benchmark"
+#define GAME_CONFIG_SOUND_DECODER_BENCHMARK_KEY "sound_decoder_benchmark"
+#define GAME_CONFIG_SOUND_MIXER_BENCHMARK_KEY "sound_mixer_benchmark"
+#define GAME_CONFIG_MOVIE_BENCHMARK_KEY "movie_benchmark"
 #define GAME_CONFIG_EXECUTABLE_KEY "executable"
 #define GAME_CONFIG_OVERRIDE_LIBRARIAN_KEY "override_librarian"
 #define GAME_CONFIG_USE_ART_NOT_PROTOS_KEY "use_art_not_protos"
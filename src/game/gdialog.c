@@ -28,6 +28,7 @@
 #include "game/textobj.h"
 #include "game/tile.h"
 #include "int/dialog.h"
+#include "int/support/intextra.h"
 #include "int/window.h"
 #include "plib/color/color.h"
 #include "plib/gnw/button.h"
@@ -65,6 +66,9 @@
 
 #define DIALOG_OPTION_ENTRIES_CAPACITY 30
 
+// Number of head frames the dialog can queue for prefetching.
+#define DIALOG_PREFETCH_FIDS_CAPACITY 32
+
 typedef enum GameDialogReviewWindowButton {
     GAME_DIALOG_REVIEW_WINDOW_BUTTON_SCROLL_UP,
     GAME_DIALOG_REVIEW_WINDOW_BUTTON_SCROLL_DOWN,
@@ -155,6 +159,11 @@ static void demo_copy_title(int win);
 static void demo_copy_options(int win);
 static void gDialogRefreshOptionsRect(int win, Rect* drawRect);
 static void head_bk();
+static void gdialog_prefetch_options();
+static void gdialog_prefetch_reaction(int reaction);
+static void gdialog_prefetch_mood(int mood);
+static void gdialog_prefetch_fid(int fid);
+static void gdialog_prefetch_update();
 static void talk_to_scroll_subwin(int win, int a2, unsigned char* a3, unsigned char* a4, unsigned char* a5, int a6, int a7);
 static int gdialog_review();
 static int gdialog_review_init(int* win);
@@ -558,6 +567,14 @@ static int oldFont;
 // 0x5951D0
 static int fidgetAnim;
 
+// Head frames which are going to be needed when one of current options is
+// chosen. They are loaded into art cache one per `head_bk` call.
+static int gdPrefetchFids[DIALOG_PREFETCH_FIDS_CAPACITY];
+
+static int gdPrefetchFidsLength;
+
+static int gdPrefetchFidsNext;
+
 // 0x5951D4
 static unsigned int fidgetTocksPerFrame;
 
@@ -584,6 +601,7 @@ int gdialog_reset()
 int gdialog_exit()
 {
     gdialog_free_speech();
+    lips_cache_flush();
     return 0;
 }
 
@@ -850,6 +868,10 @@ int scr_dialogue_exit()
     gdReviewFree();
     remove_bk_process(head_bk);
 
+    gdPrefetchFidsLength = 0;
+    gdPrefetchFidsNext = 0;
+    lips_prefetch_reset(true);
+
     if (PID_TYPE(dialog_target->pid) != OBJ_TYPE_ITEM) {
         if (gdPlayerTile != obj_dude->tile) {
             gdCenterTile = obj_dude->tile;
@@ -1864,6 +1886,8 @@ static void gDialogProcessUpdate()
 
     win_draw(gReplyWin);
     win_draw(gOptionWin);
+
+    gdialog_prefetch_options();
 }
 
 // 0x43F8D4
@@ -2041,6 +2065,8 @@ static void head_bk()
         break;
     }
 
+    gdialog_prefetch_update();
+
     if (fidgetFp == NULL) {
         return;
     }
@@ -2085,6 +2111,157 @@ static void head_bk()
     }
 }
 
+// Queues speech, lip tracks and head frames of the replies current options
+// lead to, so whichever option is chosen its reply starts without waiting
+// for disk. Replies are found by looking through option procedures, only
+// replies given with literal message ids are recognized.
+static void gdialog_prefetch_options()
+{
+    char name[16];
+    int messageListId;
+    int messageId;
+    MessageList* messageList;
+    MessageListItem messageListItem;
+
+    gdPrefetchFidsLength = 0;
+    gdPrefetchFidsNext = 0;
+    lips_prefetch_reset(false);
+
+    if (FID_TYPE(dialogue_head) != OBJ_TYPE_HEAD) {
+        return;
+    }
+
+    if (art_get_base_name(OBJ_TYPE_HEAD, dialogue_head & 0xFFF, name) == -1) {
+        return;
+    }
+
+    for (int index = 0; index < gdNumOptions; index++) {
+        GameDialogOptionEntry* dialogOptionEntry = &(dialogBlock.options[index]);
+
+        gdialog_prefetch_reaction(dialogOptionEntry->reaction);
+
+        if (dialogOptionEntry->proc == 0) {
+            continue;
+        }
+
+        if (intExtraFindReply(dialogBlock.program, dialogOptionEntry->proc, &messageListId, &messageId) == -1) {
+            continue;
+        }
+
+        if (scr_get_dialog_msg_file(messageListId, &messageList) == -1) {
+            continue;
+        }
+
+        messageListItem.num = messageId;
+        if (message_search(messageList, &messageListItem)) {
+            if (messageListItem.audio != NULL && messageListItem.audio[0] != '\0') {
+                lips_prefetch(messageListItem.audio, name);
+            }
+        }
+    }
+}
+
+// Queues head frames `talk_to_critter_reacts` is going to use for given
+// option reaction.
+static void gdialog_prefetch_reaction(int reaction)
+{
+    switch (reaction) {
+    case GAME_DIALOG_REACTION_GOOD:
+        switch (fidgetAnim) {
+        case FIDGET_GOOD:
+            gdialog_prefetch_fid(art_id(OBJ_TYPE_HEAD, dialogue_head, HEAD_ANIMATION_VERY_GOOD_REACTION, 0, 0));
+            gdialog_prefetch_mood(FIDGET_GOOD);
+            break;
+        case FIDGET_NEUTRAL:
+            gdialog_prefetch_fid(art_id(OBJ_TYPE_HEAD, dialogue_head, HEAD_ANIMATION_NEUTRAL_TO_GOOD, 0, 0));
+            gdialog_prefetch_mood(FIDGET_GOOD);
+            break;
+        case FIDGET_BAD:
+            gdialog_prefetch_fid(art_id(OBJ_TYPE_HEAD, dialogue_head, HEAD_ANIMATION_BAD_TO_NEUTRAL, 0, 0));
+            gdialog_prefetch_mood(FIDGET_NEUTRAL);
+            break;
+        }
+        break;
+    case GAME_DIALOG_REACTION_BAD:
+        switch (fidgetAnim) {
+        case FIDGET_GOOD:
+            gdialog_prefetch_fid(art_id(OBJ_TYPE_HEAD, dialogue_head, HEAD_ANIMATION_GOOD_TO_NEUTRAL, 0, 0));
+            gdialog_prefetch_mood(FIDGET_NEUTRAL);
+            break;
+        case FIDGET_NEUTRAL:
+            gdialog_prefetch_fid(art_id(OBJ_TYPE_HEAD, dialogue_head, HEAD_ANIMATION_NEUTRAL_TO_BAD, 0, 0));
+            gdialog_prefetch_mood(FIDGET_BAD);
+            break;
+        case FIDGET_BAD:
+            gdialog_prefetch_fid(art_id(OBJ_TYPE_HEAD, dialogue_head, HEAD_ANIMATION_VERY_BAD_REACTION, 0, 0));
+            gdialog_prefetch_mood(FIDGET_BAD);
+            break;
+        }
+        break;
+    }
+}
+
+// Queues phonemes and fidgets `talk_to_set_up_fidget` is going to use for
+// given mood.
+static void gdialog_prefetch_mood(int mood)
+{
+    int anim;
+    int fidgetCount;
+
+    if (mood == fidgetAnim) {
+        return;
+    }
+
+    switch (mood) {
+    case FIDGET_GOOD:
+        anim = HEAD_ANIMATION_GOOD_PHONEMES;
+        break;
+    case FIDGET_BAD:
+        anim = HEAD_ANIMATION_BAD_PHONEMES;
+        break;
+    default:
+        anim = HEAD_ANIMATION_NEUTRAL_PHONEMES;
+        break;
+    }
+
+    gdialog_prefetch_fid(art_id(OBJ_TYPE_HEAD, dialogue_head, anim, 0, 0));
+
+    fidgetCount = art_head_fidgets(art_id(OBJ_TYPE_HEAD, dialogue_head, mood, 0, 0));
+    for (int fidget = 1; fidget <= fidgetCount; fidget++) {
+        gdialog_prefetch_fid(art_id(OBJ_TYPE_HEAD, dialogue_head, mood, fidget, 0));
+    }
+}
+
+static void gdialog_prefetch_fid(int fid)
+{
+    if (gdPrefetchFidsLength == DIALOG_PREFETCH_FIDS_CAPACITY) {
+        return;
+    }
+
+    for (int index = 0; index < gdPrefetchFidsLength; index++) {
+        if (gdPrefetchFids[index] == fid) {
+            return;
+        }
+    }
+
+    gdPrefetchFids[gdPrefetchFidsLength++] = fid;
+}
+
+// Loads next queued head frame into art cache and does next piece of speech
+// prefetching.
+static void gdialog_prefetch_update()
+{
+    CacheEntry* cacheEntry;
+
+    if (gdPrefetchFidsNext < gdPrefetchFidsLength) {
+        if (art_ptr_lock(gdPrefetchFids[gdPrefetchFidsNext++], &cacheEntry) != NULL) {
+            art_ptr_unlock(cacheEntry);
+        }
+    }
+
+    lips_prefetch_update();
+}
+
 // FIXME: Due to the bug in `gDialogProcessChoice` this function can receive invalid
 // reaction value (50 instead of expected -1, 0, 1). It's handled gracefully by
 // the game.
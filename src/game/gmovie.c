@@ -61,6 +61,11 @@ int gmovie_init()
 
     movieSetSubtitleFunc(gmovie_subtitle_func);
 
+    int movieThreads;
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MOVIE_THREADS_KEY, &movieThreads)) {
+        movieSetThreads(movieThreads);
+    }
+
     memset(gmovie_played_list, 0, sizeof(gmovie_played_list));
 
     return 0;
@@ -75,6 +80,7 @@ void gmovie_reset()
 // 0x446064
 void gmovie_exit()
 {
+    movieSetThreads(0);
 }
 
 // 0x44E638
@@ -249,6 +255,62 @@ bool gmovie_has_been_played(int movie)
     return gmovie_played_list[movie] == 1;
 }
 
+// Decodes every movie in `art\cuts` `iterations` times without playing it
+// and logs decoding and scaling throughput along with hash of scaled frames.
+void gmovie_benchmark(int iterations)
+{
+    char path[MAX_PATH];
+    char** fileList;
+    int fileListLength;
+    unsigned int hash = 2166136261U;
+    unsigned long long decodeTime = 0;
+    unsigned long long scaleTime = 0;
+    int files = 0;
+    int frames = 0;
+    int fileFrames;
+
+    if (iterations <= 0) {
+        return;
+    }
+
+    fileListLength = db_get_file_list("art\\cuts\\*.MVE", &fileList, NULL, 0);
+    if (fileListLength <= 0) {
+        return;
+    }
+
+    for (int index = 0; index < fileListLength; index++) {
+        sprintf(path, "art\\cuts\\%s", fileList[index]);
+
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            fileFrames = movieBenchmark(path, &hash, &decodeTime, &scaleTime);
+            if (fileFrames == -1) {
+                debug_printf("gmovie: unable to decode %s\n", path);
+                break;
+            }
+
+            frames += fileFrames;
+        }
+
+        if (fileFrames != -1) {
+            files++;
+        }
+    }
+
+    db_free_file_list(&fileList, NULL);
+
+    if (decodeTime == 0) {
+        decodeTime = 1;
+    }
+
+    debug_printf("gmovie: decoded %d files, %d frames in %.3f ms (%.1f fps), scaled in %.3f ms, hash %08x\n",
+        files,
+        frames,
+        decodeTime / 1000.0,
+        frames * 1000000.0 / decodeTime,
+        scaleTime / 1000.0,
+        hash);
+}
+
 // 0x44EB1C
 static char* gmovie_subtitle_func(char* movie_file_path)
 {
@@ -37,5 +37,6 @@ int gmovie_load(DB_FILE* stream);
 int gmovie_save(DB_FILE* stream);
 int gmovie_play(int game_movie, int game_movie_flags);
 bool gmovie_has_been_played(int game_movie);
+void gmovie_benchmark(int iterations);
 
 #endif /* FALLOUT_GAME_GMOVIE_H_ */
@@ -1,6 +1,7 @@
 #include "game/gsound.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define WIN32_LEAN_AND_MEAN
@@ -11,6 +12,7 @@
 #include "game/gconfig.h"
 #include "game/item.h"
 #include "game/map.h"
+#include "game/mprefetch.h"
 #include "game/object.h"
 #include "game/proto.h"
 #include "game/queue.h"
@@ -26,6 +28,54 @@
 #include "plib/gnw/gnw.h"
 #include "plib/gnw/input.h"
 #include "plib/gnw/memory.h"
+#include "plib/gnw/mixer.h"
+#include "plib/gnw/profile.h"
+#include "sound_decoder.h"
+
+typedef struct DecoderBenchmarkBuffer {
+    unsigned char* data;
+    unsigned int size;
+    unsigned int position;
+} DecoderBenchmarkBuffer;
+
+#define GSOUND_MIXER_BENCHMARK_VOICES 16
+#define GSOUND_MIXER_BENCHMARK_RATE 44100
+
+// Number of sound effects which can be loaded at the same time. It matches
+// the number of files sfx cache can keep open.
+#define GSOUND_SFX_VOICES SOUND_EFFECTS_MAX_COUNT
+
+// Interval between volume updates of positional sound effects (in ms).
+#define GSOUND_SFX_UPDATE_INTERVAL 100
+
+// Sound effect categories, from least to most important. Category always
+// wins over distance when effects compete for a voice.
+typedef enum GSoundSfxCategory {
+    // Effects of scenery, walls and items lying on the ground.
+    GSOUND_SFX_CATEGORY_AMBIENT,
+    GSOUND_SFX_CATEGORY_CRITTER,
+    GSOUND_SFX_CATEGORY_DUDE,
+    // Effects without source object (mostly interface).
+    GSOUND_SFX_CATEGORY_INTERFACE,
+} GSoundSfxCategory;
+
+// Slot for one sound effect. Sound objects are allocated once and reused by
+// later effects instead of being deleted when effect is over.
+typedef struct GSoundSfxVoice {
+    Sound* sound;
+
+    // Effect source, its volume follows it as it (or dude) moves. NULL for
+    // interface effects, and when source object was destroyed.
+    Object* object;
+
+    int category;
+
+    // Relative volume (see `gsound_compute_relative_volume`).
+    int volume;
+
+    // Effect is loaded, playing or both.
+    bool busy;
+} GSoundSfxVoice;
 
 static void gsound_bkg_proc();
 static int gsound_open(const char* fname, int access, ...);
@@ -34,6 +84,12 @@ static int gsound_write(int handle, const void* buf, unsigned int size);
 static int gsound_close(int handle);
 static int gsound_read(int handle, void* buf, unsigned int size);
 static long gsound_seek(int handle, long offset, int origin);
+static int gsound_sfx_category(Object* object);
+static int gsound_sfx_priority(int category, int volume);
+static GSoundSfxVoice* gsound_sfx_find_voice(Sound* sound);
+static GSoundSfxVoice* gsound_sfx_acquire_voice(Object* object);
+static void gsound_sfx_release_voice(GSoundSfxVoice* voice);
+static void gsound_sfx_update();
 static long gsound_tell(int handle);
 static long gsound_filesize(int handle);
 static bool gsound_compressed_query(char* filePath);
@@ -43,6 +99,7 @@ static void gsound_internal_effect_callback(void* userData, int a2);
 static int gsound_background_allocate(Sound** out_s, int a2, int a3);
 static int gsound_background_find_with_copy(char* dest, const char* src);
 static int gsound_background_find_dont_copy(char* dest, const char* src);
+static int gsound_background_find_prefetched(char* dest, const char* src);
 static int gsound_speech_find_dont_copy(char* dest, const char* src);
 static void gsound_background_remove_last_copy();
 static int gsound_background_start();
@@ -53,6 +110,30 @@ static Sound* gsound_get_sound_ready_for_effect();
 static bool gsound_file_exists_f(const char* fname);
 static int gsound_file_exists_db(const char* path);
 static int gsound_setup_paths();
+static int gsound_decoder_benchmark_dir(const char* dir, int iterations, unsigned int* hashPtr, unsigned long long* samplesPtr, unsigned long long* timePtr);
+static int gsound_decoder_benchmark_reader(void* data, void* buffer, unsigned int size);
+static LPDIRECTSOUNDBUFFER gsound_mixer_benchmark_voice(LPDIRECTSOUND directSound, int voice);
+static int gsound_mixer_benchmark_open(int rate);
+static void gsound_mixer_benchmark_write(short* samples, int frames);
+static void gsound_mixer_benchmark_close();
+
+// Hashes mixed audio in `gsound_mixer_benchmark`.
+static MixerSink gsound_mixer_benchmark_sink = {
+    "benchmark",
+    gsound_mixer_benchmark_open,
+    gsound_mixer_benchmark_write,
+    gsound_mixer_benchmark_close,
+};
+
+static unsigned int gsound_mixer_benchmark_hash;
+
+static GSoundSfxVoice gsound_sfx_voices[GSOUND_SFX_VOICES];
+
+static unsigned int gsound_sfx_last_update;
+
+// Music is read into memory by prefetch threads instead of being copied
+// down to `sound_music_path1`, see `gsound_background_prefetch`.
+static bool gsound_background_prefetching = false;
 
 // TODO: Remove.
 // 0x4F2C54
@@ -208,6 +289,24 @@ int gsound_init()
 
     soundRegisterAlloc(mem_malloc, mem_realloc, mem_free);
 
+    // Software mixer replaces DirectSound when one of its sinks is named in
+    // config, so the whole audio path can run without a sound card.
+    char* mixerName;
+    if (config_get_string(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_MIXER_KEY, &mixerName)) {
+        MixerSink* sink = mixer_find_sink(mixerName);
+        if (sink != NULL) {
+            int mixerRate;
+            char* wavPath;
+
+            config_get_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_MIXER_RATE_KEY, &mixerRate);
+            if (config_get_string(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_MIXER_WAV_PATH_KEY, &wavPath)) {
+                mixer_set_wav_path(wavPath);
+            }
+
+            soundSetMixer(sink, mixerRate);
+        }
+    }
+
     // initialize direct sound
     if (soundInit(detectDevices, 24, 0x8000, 0x8000, 22050) != 0) {
         if (gsound_debug) {
@@ -221,9 +320,25 @@ int gsound_init()
         debug_printf("success.\n");
     }
 
+    // Music and speech are decoded on sound thread, see
+    // `gsound_background_play` and `gsound_speech_play`.
+    int soundThread;
+    config_get_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_SOUND_THREAD_KEY, &soundThread);
+    if (soundThread != 0) {
+        if (soundStartThread() != 0) {
+            debug_printf("Unable to start sound thread.\n");
+        }
+    }
+
     initAudiof(gsound_compressed_query);
     initAudio(gsound_compressed_query);
 
+    int musicPrefetch = 0;
+    config_get_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_MUSIC_PREFETCH_KEY, &musicPrefetch);
+    if (musicPrefetch != 0) {
+        gsound_background_prefetching = mprefetch_init() == 0;
+    }
+
     int cacheSize;
     config_get_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_CACHE_SIZE_KEY, &cacheSize);
     if (cacheSize >= 0x40000) {
@@ -359,6 +474,8 @@ void gsound_reset()
 
     sfxc_flush();
 
+    // Voice sounds were deleted along with others.
+    memset(gsound_sfx_voices, 0, sizeof(gsound_sfx_voices));
     gsound_active_effect_counter = 0;
 
     if (gsound_debug) {
@@ -383,6 +500,9 @@ int gsound_exit()
     gsound_background_stop();
     gsound_background_remove_last_copy();
     soundClose();
+    memset(gsound_sfx_voices, 0, sizeof(gsound_sfx_voices));
+    mprefetch_exit();
+    gsound_background_prefetching = false;
     sfxc_exit();
     audiofClose();
     audioClose();
@@ -661,7 +781,11 @@ int gsound_background_play(const char* fileName, int a2, int a3, int a4)
         return -1;
     }
 
-    rc = soundSetFileIO(gsound_background_tag, audiofOpen, audiofCloseFile, audiofRead, NULL, audiofSeek, gsound_compressed_tell, audiofFileSize);
+    if (a3 == 14 && gsound_background_prefetching) {
+        rc = soundSetFileIO(gsound_background_tag, mprefetch_open, mprefetch_close, mprefetch_read, NULL, mprefetch_seek, gsound_compressed_tell, mprefetch_file_size);
+    } else {
+        rc = soundSetFileIO(gsound_background_tag, audiofOpen, audiofCloseFile, audiofRead, NULL, audiofSeek, gsound_compressed_tell, audiofFileSize);
+    }
     if (rc != 0) {
         if (gsound_debug) {
             debug_printf("failed because file IO could not be set for compression.\n");
@@ -673,6 +797,10 @@ int gsound_background_play(const char* fileName, int a2, int a3, int a4)
         return -1;
     }
 
+    // Music files are read with stdio or from prefetched memory, both are
+    // fine to use from sound thread.
+    soundSetThreaded(gsound_background_tag, true);
+
     rc = soundSetChannel(gsound_background_tag, 3);
     if (rc != 0) {
         if (gsound_debug) {
@@ -689,7 +817,11 @@ int gsound_background_play(const char* fileName, int a2, int a3, int a4)
     if (a3 == 13) {
         rc = gsound_background_find_dont_copy(path, fileName);
     } else if (a3 == 14) {
-        rc = gsound_background_find_with_copy(path, fileName);
+        if (gsound_background_prefetching) {
+            rc = gsound_background_find_prefetched(path, fileName);
+        } else {
+            rc = gsound_background_find_with_copy(path, fileName);
+        }
     }
 
     if (rc != SOUND_NO_ERROR) {
@@ -783,6 +915,32 @@ int gsound_background_play_level_music(const char* a1, int a2)
     return gsound_background_play(a1, a2, 14, 16);
 }
 
+// Starts reading music file into memory in background, so that subsequent
+// `gsound_background_play_level_music` with the same file does not wait
+// for the disc. [fileName] is base file name, without path and extension.
+int gsound_background_prefetch(const char* fileName)
+{
+    char path[MAX_PATH + 1];
+
+    if (!gsound_initialized || !gsound_background_enabled || !gsound_background_prefetching) {
+        return -1;
+    }
+
+    if (gsound_background_find_dont_copy(path, fileName) != 0) {
+        return -1;
+    }
+
+    if (mprefetch_start(path) != 0) {
+        if (gsound_debug) {
+            debug_printf("Unable to prefetch music file %s.\n", fileName);
+        }
+
+        return -1;
+    }
+
+    return 0;
+}
+
 // 0x44834C
 int gsound_background_play_preloaded()
 {
@@ -995,6 +1153,9 @@ int gsound_speech_play(const char* fname, int a2, int a3, int a4)
         return -1;
     }
 
+    // Speech files are read in memory on open, see `audioOpen`.
+    soundSetThreaded(gsound_speech_tag, true);
+
     if (gsound_speech_find_dont_copy(path, fname)) {
         if (gsound_debug) {
             debug_printf("failed because the file could not be found.\n");
@@ -1168,16 +1329,8 @@ Sound* gsound_load_sound(const char* name, Object* object)
         debug_printf("Loading sound file %s%s...", name, ".ACM");
     }
 
-    if (gsound_active_effect_counter >= SOUND_EFFECTS_MAX_COUNT) {
-        if (gsound_debug) {
-            debug_printf("failed because there are already %d active effects.\n", gsound_active_effect_counter);
-        }
-
-        return NULL;
-    }
-
-    Sound* sound = gsound_get_sound_ready_for_effect();
-    if (sound == NULL) {
+    GSoundSfxVoice* voice = gsound_sfx_acquire_voice(object);
+    if (voice == NULL) {
         if (gsound_debug) {
             debug_printf("failed.\n");
         }
@@ -1185,7 +1338,7 @@ Sound* gsound_load_sound(const char* name, Object* object)
         return NULL;
     }
 
-    ++gsound_active_effect_counter;
+    Sound* sound = voice->sound;
 
     char path[MAX_PATH];
     sprintf(path, "%s%s%s", sound_sfx_path, name, ".ACM");
@@ -1259,9 +1412,7 @@ Sound* gsound_load_sound(const char* name, Object* object)
         }
     }
 
-    --gsound_active_effect_counter;
-
-    soundDelete(sound);
+    gsound_sfx_release_voice(voice);
 
     if (gsound_debug) {
         debug_printf("failed.\n");
@@ -1276,6 +1427,11 @@ Sound* gsound_load_sound_volume(const char* name, Object* object, int volume)
     Sound* sound = gsound_load_sound(name, object);
 
     if (sound != NULL) {
+        GSoundSfxVoice* voice = gsound_sfx_find_voice(sound);
+        if (voice != NULL) {
+            voice->volume = volume;
+        }
+
         soundVolume(sound, (volume * sndfx_volume) / VOLUME_MAX);
     }
 
@@ -1300,14 +1456,15 @@ void gsound_delete_sfx(Sound* sound)
         return;
     }
 
-    if (soundDelete(sound) != 0) {
+    GSoundSfxVoice* voice = gsound_sfx_find_voice(sound);
+    if (voice == NULL) {
         if (gsound_debug) {
             debug_printf("Unable to delete sound effect -- active effect counter may get out of sync.\n");
         }
         return;
     }
 
-    --gsound_active_effect_counter;
+    gsound_sfx_release_voice(voice);
 }
 
 // 0x448E20
@@ -1629,6 +1786,7 @@ int gsound_play_sfx_file(const char* name)
 static void gsound_bkg_proc()
 {
     soundUpdate();
+    gsound_sfx_update();
 }
 
 // 0x449334
@@ -1746,7 +1904,12 @@ static void gsound_internal_background_callback(void* userData, int a2)
 static void gsound_internal_effect_callback(void* userData, int a2)
 {
     if (a2 == 1) {
-        --gsound_active_effect_counter;
+        GSoundSfxVoice* voice = (GSoundSfxVoice*)userData;
+        if (voice != NULL && voice->busy) {
+            voice->busy = false;
+            voice->object = NULL;
+            --gsound_active_effect_counter;
+        }
     }
 }
 
@@ -1920,6 +2083,30 @@ static int gsound_background_find_dont_copy(char* dest, const char* src)
     return -1;
 }
 
+// Finds background sound like `gsound_background_find_dont_copy`, and starts
+// prefetching it (if it's not already). The file should be opened with
+// `mprefetch_open`, which reads it from memory as it arrives instead of
+// waiting for the whole file to be copied down.
+static int gsound_background_find_prefetched(char* dest, const char* src)
+{
+    if (gsound_background_find_dont_copy(dest, src) != 0) {
+        return -1;
+    }
+
+    if (gsound_debug) {
+        debug_printf("by prefetch ");
+    }
+
+    if (mprefetch_start(dest) != 0) {
+        // `mprefetch_open` falls back to reading directly from `dest`.
+        if (gsound_debug) {
+            debug_printf("(failed) ");
+        }
+    }
+
+    return 0;
+}
+
 // 0x4498C0
 static int gsound_speech_find_dont_copy(char* dest, const char* src)
 {
@@ -2083,7 +2270,8 @@ static Sound* gsound_get_sound_ready_for_effect()
 {
     int rc;
 
-    Sound* sound = soundAllocate(5, 10);
+    // Effect sounds are not deleted when they are done, voices reuse them.
+    Sound* sound = soundAllocate(1, 10);
     if (sound == NULL) {
         if (gsound_debug) {
             debug_printf(" Can't allocate sound for effect. ");
@@ -2116,7 +2304,112 @@ static Sound* gsound_get_sound_ready_for_effect()
         return NULL;
     }
 
-    rc = soundSetCallback(sound, gsound_internal_effect_callback, NULL);
+    return sound;
+}
+
+static int gsound_sfx_category(Object* object)
+{
+    Object* owner;
+
+    if (object == NULL) {
+        return GSOUND_SFX_CATEGORY_INTERFACE;
+    }
+
+    owner = obj_top_environment(object);
+    if (owner == NULL) {
+        owner = object;
+    }
+
+    if (owner == obj_dude) {
+        return GSOUND_SFX_CATEGORY_DUDE;
+    }
+
+    if (FID_TYPE(owner->fid) == OBJ_TYPE_CRITTER) {
+        return GSOUND_SFX_CATEGORY_CRITTER;
+    }
+
+    return GSOUND_SFX_CATEGORY_AMBIENT;
+}
+
+// Effects with higher priority are more important. Relative volume (which
+// reflects distance to the dude) only matters between effects of the same
+// category.
+static int gsound_sfx_priority(int category, int volume)
+{
+    return (category << 16) | (volume & 0xFFFF);
+}
+
+static GSoundSfxVoice* gsound_sfx_find_voice(Sound* sound)
+{
+    for (int index = 0; index < GSOUND_SFX_VOICES; index++) {
+        GSoundSfxVoice* voice = &(gsound_sfx_voices[index]);
+        if (voice->busy && voice->sound == sound) {
+            return voice;
+        }
+    }
+
+    return NULL;
+}
+
+// Finds voice for the new effect. When every voice is taken, the least
+// important effect which is playing is stopped to make room, provided it is
+// less important than the new one. Effects which are loaded but not started
+// yet are never stopped, since their owners still hold them.
+static GSoundSfxVoice* gsound_sfx_acquire_voice(Object* object)
+{
+    GSoundSfxVoice* voice = NULL;
+    GSoundSfxVoice* victim = NULL;
+    int victimPriority = 0;
+    int category = gsound_sfx_category(object);
+    int volume = gsound_compute_relative_volume(object);
+    int priority = gsound_sfx_priority(category, volume);
+    int rc;
+
+    for (int index = 0; index < GSOUND_SFX_VOICES; index++) {
+        GSoundSfxVoice* candidate = &(gsound_sfx_voices[index]);
+        if (!candidate->busy) {
+            voice = candidate;
+            break;
+        }
+
+        if (soundPlaying(candidate->sound)) {
+            int candidatePriority = gsound_sfx_priority(candidate->category, candidate->volume);
+            if (candidatePriority < priority && (victim == NULL || candidatePriority < victimPriority)) {
+                victim = candidate;
+                victimPriority = candidatePriority;
+            }
+        }
+    }
+
+    if (voice == NULL) {
+        if (victim == NULL) {
+            if (gsound_debug) {
+                debug_printf("failed because there are already %d active effects.\n", gsound_active_effect_counter);
+            }
+
+            return NULL;
+        }
+
+        if (gsound_debug) {
+            debug_printf("stopping less important effect... ");
+        }
+
+        gsound_sfx_release_voice(victim);
+        voice = victim;
+    }
+
+    if (voice->sound == NULL) {
+        voice->sound = gsound_get_sound_ready_for_effect();
+        if (voice->sound == NULL) {
+            return NULL;
+        }
+    } else {
+        // Drop data of the previous effect.
+        soundUnload(voice->sound);
+    }
+
+    // Callback is cleared when effect is over, so it's set for every effect.
+    rc = soundSetCallback(voice->sound, gsound_internal_effect_callback, voice);
     if (rc != 0) {
         if (gsound_debug) {
             debug_printf("failed because the callback could not be set.\n");
@@ -2126,14 +2419,71 @@ static Sound* gsound_get_sound_ready_for_effect()
             debug_printf("soundSetCallback returned: %d, %s\n", rc, soundError(rc));
         }
 
-        soundDelete(sound);
-
         return NULL;
     }
 
-    soundVolume(sound, sndfx_volume);
+    soundVolume(voice->sound, sndfx_volume);
 
-    return sound;
+    voice->object = object;
+    voice->category = category;
+    voice->volume = volume;
+    voice->busy = true;
+
+    ++gsound_active_effect_counter;
+
+    return voice;
+}
+
+// Stops effect and makes its voice available. Sound object stays with the
+// voice.
+static void gsound_sfx_release_voice(GSoundSfxVoice* voice)
+{
+    if (!voice->busy) {
+        return;
+    }
+
+    soundSetCallback(voice->sound, NULL, NULL);
+    soundUnload(voice->sound);
+
+    voice->busy = false;
+    voice->object = NULL;
+
+    --gsound_active_effect_counter;
+}
+
+// Updates volume of playing positional effects as their sources and the dude
+// move around.
+static void gsound_sfx_update()
+{
+    if (elapsed_time(gsound_sfx_last_update) < GSOUND_SFX_UPDATE_INTERVAL) {
+        return;
+    }
+
+    gsound_sfx_last_update = get_time();
+
+    for (int index = 0; index < GSOUND_SFX_VOICES; index++) {
+        GSoundSfxVoice* voice = &(gsound_sfx_voices[index]);
+        if (!voice->busy || voice->object == NULL) {
+            continue;
+        }
+
+        int volume = gsound_compute_relative_volume(voice->object);
+        if (volume != voice->volume) {
+            voice->volume = volume;
+            soundVolume(voice->sound, (volume * sndfx_volume) / VOLUME_MAX);
+        }
+    }
+}
+
+// Forgets object which is about to be destroyed, effects it was playing keep
+// their current volume.
+void gsound_sfx_remove_object_references(Object* object)
+{
+    for (int index = 0; index < GSOUND_SFX_VOICES; index++) {
+        if (gsound_sfx_voices[index].object == object) {
+            gsound_sfx_voices[index].object = NULL;
+        }
+    }
 }
 
 // 0x449E08
@@ -2163,3 +2513,289 @@ static int gsound_setup_paths()
 
     return 0;
 }
+
+// Decodes every ACM in sound effects and music directories `iterations`
+// times and logs decoding throughput. Hashes of decoded PCM are logged as
+// well, so decoder changes can be checked to be bit-exact by comparing logs.
+void gsound_decoder_benchmark(int iterations)
+{
+    unsigned int hash = 2166136261U;
+    unsigned long long samples = 0;
+    unsigned long long time = 0;
+    int files;
+
+    if (iterations <= 0) {
+        return;
+    }
+
+    files = gsound_decoder_benchmark_dir(sound_sfx_path, iterations, &hash, &samples, &time);
+    if (sound_music_path1 != NULL) {
+        files += gsound_decoder_benchmark_dir(sound_music_path1, iterations, &hash, &samples, &time);
+    }
+
+    if (time == 0) {
+        time = 1;
+    }
+
+    debug_printf("gsound: decoded %d files, %llu samples in %.3f ms (%.2f Msamples/s), hash %08x\n",
+        files,
+        samples,
+        time / 1000.0,
+        samples / (double)time,
+        hash);
+}
+
+static int gsound_decoder_benchmark_dir(const char* dir, int iterations, unsigned int* hashPtr, unsigned long long* samplesPtr, unsigned long long* timePtr)
+{
+    char path[MAX_PATH];
+    char** fileList;
+    int fileListLength;
+    dir_entry de;
+    unsigned char* data;
+    unsigned char* pcm;
+    DecoderBenchmarkBuffer buffer;
+    AudioDecoder* ad;
+    int channels;
+    int sampleRate;
+    int sampleCount;
+    unsigned long long start;
+    int files = 0;
+
+    sprintf(path, "%s*.ACM", dir);
+    fileListLength = db_get_file_list(path, &fileList, NULL, 0);
+    if (fileListLength <= 0) {
+        return 0;
+    }
+
+    for (int index = 0; index < fileListLength; index++) {
+        sprintf(path, "%s%s", dir, fileList[index]);
+
+        if (db_dir_entry(path, &de) != 0 || de.length <= 0) {
+            continue;
+        }
+
+        data = (unsigned char*)mem_malloc(de.length);
+        if (data == NULL) {
+            continue;
+        }
+
+        if (db_read_to_buf(path, data) != 0) {
+            mem_free(data);
+            continue;
+        }
+
+        pcm = NULL;
+
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            buffer.data = data;
+            buffer.size = de.length;
+            buffer.position = 0;
+
+            start = profile_get_time();
+
+            ad = Create_AudioDecoder(gsound_decoder_benchmark_reader, &buffer, &channels, &sampleRate, &sampleCount);
+            if (ad == NULL) {
+                break;
+            }
+
+            if (pcm == NULL) {
+                pcm = (unsigned char*)mem_malloc(sampleCount * 2);
+                if (pcm == NULL) {
+                    AudioDecoder_Close(ad);
+                    break;
+                }
+            }
+
+            AudioDecoder_Read(ad, pcm, sampleCount * 2);
+            AudioDecoder_Close(ad);
+
+            *timePtr += profile_get_time() - start;
+            *samplesPtr += sampleCount;
+        }
+
+        if (pcm != NULL) {
+            unsigned int fileHash = 2166136261U;
+            for (int offset = 0; offset < sampleCount * 2; offset++) {
+                fileHash = (fileHash ^ pcm[offset]) * 16777619U;
+            }
+
+            *hashPtr = (*hashPtr ^ fileHash) * 16777619U;
+
+            if (gsound_debug) {
+                debug_printf("gsound: %s %08x\n", path, fileHash);
+            }
+
+            mem_free(pcm);
+            files++;
+        }
+
+        mem_free(data);
+    }
+
+    db_free_file_list(&fileList, NULL);
+
+    return files;
+}
+
+static int gsound_decoder_benchmark_reader(void* data, void* buffer, unsigned int size)
+{
+    DecoderBenchmarkBuffer* decoderBuffer = (DecoderBenchmarkBuffer*)data;
+    unsigned int remaining = decoderBuffer->size - decoderBuffer->position;
+
+    if (size > remaining) {
+        size = remaining;
+    }
+
+    memcpy(buffer, decoderBuffer->data + decoderBuffer->position, size);
+    decoderBuffer->position += size;
+
+    return size;
+}
+
+// Mixes `seconds` of synthesized voices with software mixer and logs mixing
+// throughput. The mixer is driven without its thread, so the hash of mixed
+// audio only depends on the code and can be compared between runs.
+void gsound_mixer_benchmark(int seconds)
+{
+    LPDIRECTSOUND directSound;
+    LPDIRECTSOUNDBUFFER buffers[GSOUND_MIXER_BENCHMARK_VOICES];
+    MixerStats stats;
+    DWORD status;
+
+    if (seconds <= 0) {
+        return;
+    }
+
+    gsound_mixer_benchmark_hash = 2166136261U;
+
+    if (mixer_create(&gsound_mixer_benchmark_sink, GSOUND_MIXER_BENCHMARK_RATE, false, &directSound) != DS_OK) {
+        debug_printf("gsound: unable to create mixer\n");
+        return;
+    }
+
+    for (int voice = 0; voice < GSOUND_MIXER_BENCHMARK_VOICES; voice++) {
+        buffers[voice] = gsound_mixer_benchmark_voice(directSound, voice);
+    }
+
+    // Mix in 10 ms steps. Every voice fades in and out and sweeps from left
+    // to right, every fourth voice is one-shot and is restarted when done.
+    for (int tick = 0; tick < seconds * 100; tick++) {
+        for (int voice = 0; voice < GSOUND_MIXER_BENCHMARK_VOICES; voice++) {
+            LPDIRECTSOUNDBUFFER buffer = buffers[voice];
+            if (buffer == NULL) {
+                continue;
+            }
+
+            int phase = (tick + voice * 37) % 200;
+            IDirectSoundBuffer_SetVolume(buffer, -abs(phase - 100) * 100);
+            IDirectSoundBuffer_SetPan(buffer, (tick * 50 + voice * 1000) % 20001 - 10000);
+
+            if (voice % 4 == 3) {
+                if (IDirectSoundBuffer_GetStatus(buffer, &status) == DS_OK && (status & DSBSTATUS_PLAYING) == 0) {
+                    IDirectSoundBuffer_SetCurrentPosition(buffer, 0);
+                    IDirectSoundBuffer_Play(buffer, 0, 0, 0);
+                }
+            }
+        }
+
+        mixer_render(directSound, GSOUND_MIXER_BENCHMARK_RATE / 100);
+    }
+
+    mixer_get_stats(directSound, &stats);
+
+    for (int voice = 0; voice < GSOUND_MIXER_BENCHMARK_VOICES; voice++) {
+        if (buffers[voice] != NULL) {
+            IDirectSoundBuffer_Release(buffers[voice]);
+        }
+    }
+
+    IDirectSound_Release(directSound);
+
+    if (stats.totalRenderTime == 0) {
+        stats.totalRenderTime = 1;
+    }
+
+    debug_printf("gsound: mixed %d s of %d voices in %.3f ms (%.1fx realtime), hash %08x\n",
+        seconds,
+        GSOUND_MIXER_BENCHMARK_VOICES,
+        stats.totalRenderTime / 1000.0,
+        seconds * 1000000.0 / stats.totalRenderTime,
+        gsound_mixer_benchmark_hash);
+}
+
+// Creates one second looping buffer with a sawtooth and a bit of noise.
+// Formats cycle through 8-bit and 16-bit mono at 22 kHz and 16-bit stereo at
+// 44 kHz, so both resampling and direct paths are covered.
+static LPDIRECTSOUNDBUFFER gsound_mixer_benchmark_voice(LPDIRECTSOUND directSound, int voice)
+{
+    DSBUFFERDESC desc;
+    WAVEFORMATEX format;
+    LPDIRECTSOUNDBUFFER buffer;
+    void* audioPtr1;
+    void* audioPtr2;
+    DWORD audioBytes1;
+    DWORD audioBytes2;
+    unsigned int seed = voice + 1;
+
+    memset(&format, 0, sizeof(format));
+    format.wFormatTag = WAVE_FORMAT_PCM;
+    format.nChannels = voice % 3 == 2 ? 2 : 1;
+    format.nSamplesPerSec = voice % 3 == 2 ? 44100 : 22050;
+    format.wBitsPerSample = voice % 3 == 0 ? 8 : 16;
+    format.nBlockAlign = format.nChannels * format.wBitsPerSample / 8;
+    format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
+
+    memset(&desc, 0, sizeof(desc));
+    desc.dwSize = sizeof(desc);
+    desc.dwFlags = DSBCAPS_CTRLVOLUME | DSBCAPS_CTRLPAN | DSBCAPS_GETCURRENTPOSITION2;
+    desc.dwBufferBytes = format.nAvgBytesPerSec;
+    desc.lpwfxFormat = &format;
+
+    if (IDirectSound_CreateSoundBuffer(directSound, &desc, &buffer, NULL) != DS_OK) {
+        return NULL;
+    }
+
+    if (IDirectSoundBuffer_Lock(buffer, 0, desc.dwBufferBytes, &audioPtr1, &audioBytes1, &audioPtr2, &audioBytes2, 0) != DS_OK) {
+        IDirectSoundBuffer_Release(buffer);
+        return NULL;
+    }
+
+    int period = format.nSamplesPerSec / (110 * (voice + 1));
+    int samples = audioBytes1 * 8 / format.wBitsPerSample;
+    for (int index = 0; index < samples; index++) {
+        seed = seed * 1103515245 + 12345;
+
+        int frame = index / format.nChannels;
+        int value = (frame % period) * 32768 / period - 16384 + (int)((seed >> 16) & 0x7FF) - 1024;
+
+        if (format.wBitsPerSample == 8) {
+            ((unsigned char*)audioPtr1)[index] = (unsigned char)((value >> 8) + 128);
+        } else {
+            ((short*)audioPtr1)[index] = (short)value;
+        }
+    }
+
+    IDirectSoundBuffer_Unlock(buffer, audioPtr1, audioBytes1, audioPtr2, audioBytes2);
+
+    IDirectSoundBuffer_Play(buffer, 0, 0, voice % 4 == 3 ? 0 : DSBPLAY_LOOPING);
+
+    return buffer;
+}
+
+static int gsound_mixer_benchmark_open(int rate)
+{
+    return 0;
+}
+
+static void gsound_mixer_benchmark_write(short* samples, int frames)
+{
+    unsigned char* bytes = (unsigned char*)samples;
+
+    for (int index = 0; index < frames * 4; index++) {
+        gsound_mixer_benchmark_hash = (gsound_mixer_benchmark_hash ^ bytes[index]) * 16777619U;
+    }
+}
+
+static void gsound_mixer_benchmark_close()
+{
+}
@@ -64,6 +64,7 @@ SoundEndCallback* gsound_background_callback_get_set(SoundEndCallback* callback)
 int gsound_background_length_get();
 int gsound_background_play(const char* fileName, int a2, int a3, int a4);
 int gsound_background_play_level_music(const char* a1, int a2);
+int gsound_background_prefetch(const char* fileName);
 int gsound_background_play_preloaded();
 void gsound_background_stop();
 void gsound_background_restart_last(int value);
@@ -106,5 +107,8 @@ void gsound_med_butt_release(int btn, int keyCode);
 void gsound_lrg_butt_press(int btn, int keyCode);
 void gsound_lrg_butt_release(int btn, int keyCode);
 int gsound_play_sfx_file(const char* name);
+void gsound_sfx_remove_object_references(Object* object);
+void gsound_decoder_benchmark(int iterations);
+void gsound_mixer_benchmark(int seconds);
 
 #endif /* FALLOUT_GAME_GSOUND_H_ */
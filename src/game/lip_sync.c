@@ -10,12 +10,39 @@
 #include "plib/gnw/input.h"
 #include "plib/gnw/memory.h"
 
+// Number of parsed lip tracks kept in memory, so replies heard again (or
+// prefetched before they are heard) are not parsed again.
+#define LIPS_CACHE_CAPACITY 16
+
+// Number of tracks `lips_prefetch` can queue.
+#define LIPS_PREFETCH_QUEUE_CAPACITY 8
+
+// Number of speech bytes read per `lips_prefetch_update` call.
+#define LIPS_PREFETCH_CHUNK_SIZE 0x8000
+
+typedef struct LipsTrack {
+    char path[MAX_PATH];
+
+    // Header fields as read from file, owns `phonemes` and `markers`.
+    LipsData data;
+
+    unsigned int stamp;
+} LipsTrack;
+
+typedef struct LipsPrefetch {
+    char path[MAX_PATH];
+    char head[14];
+} LipsPrefetch;
+
 static char* lips_fix_string(const char* fileName, size_t length);
 static int lips_stop_speech();
 static int lips_read_phoneme_type(unsigned char* phoneme_type, DB_FILE* stream);
 static int lips_read_marker_type(SpeechMarker* marker_type, DB_FILE* stream);
 static int lips_read_lipsynch_info(LipsData* a1, DB_FILE* stream);
 static int lips_make_speech();
+static int lips_read_track(DB_FILE* stream, LipsData* lipsData);
+static void lips_free_track(LipsTrack* track);
+static int lips_cache_get(const char* path, LipsTrack** trackPtr);
 
 // 0x5057E4
 unsigned char head_phoneme_current = 0;
@@ -63,6 +90,14 @@ int speechStartTime = 0;
 // 0x612220
 static char lips_subdir_name[14];
 
+static LipsTrack lips_cache[LIPS_CACHE_CAPACITY];
+
+static unsigned int lips_cache_stamp;
+
+static LipsPrefetch lips_prefetch_queue[LIPS_PREFETCH_QUEUE_CAPACITY];
+
+static int lips_prefetch_queue_length;
+
 // 0x46CC30
 static char* lips_fix_string(const char* fileName, size_t length)
 {
@@ -257,11 +292,8 @@ static int lips_read_lipsynch_info(LipsData* lipsData, DB_FILE* stream)
 int lips_load_file(const char* audioFileName, const char* headFileName)
 {
     char* sep;
-    int i;
     char v60[16];
-
-    SpeechMarker* speech_marker;
-    SpeechMarker* prev_speech_marker;
+    LipsTrack* track;
 
     char path[260];
     strcpy(path, "SOUND\\SPEECH\\");
@@ -292,38 +324,23 @@ int lips_load_file(const char* audioFileName, const char* headFileName)
 
     lips_free_speech();
 
-    // FIXME: stream is not closed if any error is encountered during reading.
-    DB_FILE* stream = db_fopen(path, "rb");
-    if (stream != NULL) {
-        if (db_freadLong(stream, &(lip_info.version)) == -1) {
-            return -1;
-        }
-
-        if (lip_info.version == 1) {
-            debug_printf("\nLoading old save-file version (1)");
-
-            if (db_fseek(stream, 0, SEEK_SET) != 0) {
-                return -1;
-            }
+    if (lips_cache_get(path, &track) != 0) {
+        return -1;
+    }
 
-            if (lips_read_lipsynch_info(&lip_info, stream) != 0) {
-                return -1;
-            }
-        } else if (lip_info.version == 2) {
-            debug_printf("\nLoading current save-file version (2)");
-
-            if (db_freadLong(stream, &(lip_info.field_4)) == -1) return -1;
-            if (db_freadLong(stream, &(lip_info.flags)) == -1) return -1;
-            if (db_freadLong(stream, &(lip_info.field_10)) == -1) return -1;
-            if (db_freadLong(stream, &(lip_info.field_1C)) == -1) return -1;
-            if (db_freadLong(stream, &(lip_info.phoneme_count)) == -1) return -1;
-            if (db_freadLong(stream, &(lip_info.field_28)) == -1) return -1;
-            if (db_freadLong(stream, &(lip_info.marker_count)) == -1) return -1;
-            if (db_freadByteCount(stream, lip_info.field_50, 8) == -1) return -1;
-            if (db_freadByteCount(stream, lip_info.field_58, 4) == -1) return -1;
-        } else {
-            debug_printf("\nError: Lips file WRONG version!");
-        }
+    if (track != NULL) {
+        lip_info.version = track->data.version;
+        lip_info.field_4 = track->data.field_4;
+        lip_info.flags = track->data.flags;
+        lip_info.field_10 = track->data.field_10;
+        lip_info.field_1C = track->data.field_1C;
+        lip_info.phoneme_count = track->data.phoneme_count;
+        lip_info.field_28 = track->data.field_28;
+        lip_info.marker_count = track->data.marker_count;
+        lip_info.field_44 = track->data.field_44;
+        lip_info.field_4C = track->data.field_4C;
+        memcpy(lip_info.field_50, track->data.field_50, sizeof(lip_info.field_50));
+        memcpy(lip_info.field_58, track->data.field_58, sizeof(lip_info.field_58));
     }
 
     lip_info.phonemes = (unsigned char*)mem_malloc(lip_info.phoneme_count);
@@ -332,63 +349,18 @@ int lips_load_file(const char* audioFileName, const char* headFileName)
         return -1;
     }
 
-    if (stream != NULL) {
-        for (i = 0; i < lip_info.phoneme_count; i++) {
-            if (lips_read_phoneme_type(&(lip_info.phonemes[i]), stream) != 0) {
-                debug_printf("lips_load_file: Error reading phoneme type.\n");
-                return -1;
-            }
-        }
-
-        for (i = 0; i < lip_info.phoneme_count; i++) {
-            unsigned char phoneme = lip_info.phonemes[i];
-            if (phoneme >= PHONEME_COUNT) {
-                debug_printf("\nLoad error: Speech phoneme %d is invalid (%d)!", i, phoneme);
-            }
-        }
+    if (track != NULL) {
+        memcpy(lip_info.phonemes, track->data.phonemes, lip_info.phoneme_count);
     }
 
-    lip_info.markers = (SpeechMarker*)mem_malloc(sizeof(*speech_marker) * lip_info.marker_count);
+    lip_info.markers = (SpeechMarker*)mem_malloc(sizeof(*lip_info.markers) * lip_info.marker_count);
     if (lip_info.markers == NULL) {
         debug_printf("Out of memory in lips_load_file.'\n");
         return -1;
     }
 
-    if (stream != NULL) {
-        for (i = 0; i < lip_info.marker_count; i++) {
-            // NOTE: Uninline.
-            if (lips_read_marker_type(&(lip_info.markers[i]), stream) != 0) {
-                debug_printf("lips_load_file: Error reading marker type.");
-                return -1;
-            }
-        }
-
-        speech_marker = &(lip_info.markers[0]);
-
-        if (speech_marker->marker != 1 && speech_marker->marker != 0) {
-            debug_printf("\nLoad error: Speech marker 0 is invalid (%d)!", speech_marker->marker);
-        }
-
-        if (speech_marker->position != 0) {
-            debug_printf("Load error: Speech marker 0 has invalid position(%d)!", speech_marker->position);
-        }
-
-        for (i = 1; i < lip_info.marker_count; i++) {
-            speech_marker = &(lip_info.markers[i]);
-            prev_speech_marker = &(lip_info.markers[i - 1]);
-
-            if (speech_marker->marker != 1 && speech_marker->marker != 0) {
-                debug_printf("\nLoad error: Speech marker %d is invalid (%d)!", i, speech_marker->marker);
-            }
-
-            if (speech_marker->position < prev_speech_marker->position) {
-                debug_printf("Load error: Speech marker %d has invalid position(%d)!", i, speech_marker->position);
-            }
-        }
-    }
-
-    if (stream != NULL) {
-        db_fclose(stream);
+    if (track != NULL) {
+        memcpy(lip_info.markers, track->data.markers, sizeof(*lip_info.markers) * lip_info.marker_count);
     }
 
     lip_info.field_38 = 0;
@@ -432,6 +404,10 @@ static int lips_make_speech()
         lip_info.sound = NULL;
     }
 
+    // Reuses speech read ahead by `lips_prefetch`, or keeps this one around
+    // in case reply is repeated.
+    audioPreload(path);
+
     lip_info.sound = soundAllocate(1, 8);
     if (lip_info.sound == NULL) {
         debug_printf("\nsoundAllocate falied in lips_make_speech!");
@@ -486,3 +462,254 @@ int lips_free_speech()
 
     return 0;
 }
+
+// Reads lip track from file into `lipsData`, allocating its phonemes and
+// markers.
+static int lips_read_track(DB_FILE* stream, LipsData* lipsData)
+{
+    int i;
+    SpeechMarker* speech_marker;
+    SpeechMarker* prev_speech_marker;
+
+    if (db_freadLong(stream, &(lipsData->version)) == -1) {
+        return -1;
+    }
+
+    if (lipsData->version == 1) {
+        debug_printf("\nLoading old save-file version (1)");
+
+        if (db_fseek(stream, 0, SEEK_SET) != 0) {
+            return -1;
+        }
+
+        if (lips_read_lipsynch_info(lipsData, stream) != 0) {
+            return -1;
+        }
+
+        lipsData->sound = NULL;
+        lipsData->field_14 = NULL;
+        lipsData->phonemes = NULL;
+        lipsData->markers = NULL;
+    } else if (lipsData->version == 2) {
+        debug_printf("\nLoading current save-file version (2)");
+
+        if (db_freadLong(stream, &(lipsData->field_4)) == -1) return -1;
+        if (db_freadLong(stream, &(lipsData->flags)) == -1) return -1;
+        if (db_freadLong(stream, &(lipsData->field_10)) == -1) return -1;
+        if (db_freadLong(stream, &(lipsData->field_1C)) == -1) return -1;
+        if (db_freadLong(stream, &(lipsData->phoneme_count)) == -1) return -1;
+        if (db_freadLong(stream, &(lipsData->field_28)) == -1) return -1;
+        if (db_freadLong(stream, &(lipsData->marker_count)) == -1) return -1;
+        if (db_freadByteCount(stream, lipsData->field_50, 8) == -1) return -1;
+        if (db_freadByteCount(stream, lipsData->field_58, 4) == -1) return -1;
+    } else {
+        debug_printf("\nError: Lips file WRONG version!");
+        return -1;
+    }
+
+    if (lipsData->phoneme_count <= 0 || lipsData->marker_count <= 0) {
+        debug_printf("\nLoad error: Speech has no phonemes or markers!");
+        return -1;
+    }
+
+    lipsData->phonemes = (unsigned char*)mem_malloc(lipsData->phoneme_count);
+    if (lipsData->phonemes == NULL) {
+        debug_printf("Out of memory in lips_load_file.'\n");
+        return -1;
+    }
+
+    for (i = 0; i < lipsData->phoneme_count; i++) {
+        if (lips_read_phoneme_type(&(lipsData->phonemes[i]), stream) != 0) {
+            debug_printf("lips_load_file: Error reading phoneme type.\n");
+            return -1;
+        }
+    }
+
+    for (i = 0; i < lipsData->phoneme_count; i++) {
+        unsigned char phoneme = lipsData->phonemes[i];
+        if (phoneme >= PHONEME_COUNT) {
+            debug_printf("\nLoad error: Speech phoneme %d is invalid (%d)!", i, phoneme);
+        }
+    }
+
+    lipsData->markers = (SpeechMarker*)mem_malloc(sizeof(*speech_marker) * lipsData->marker_count);
+    if (lipsData->markers == NULL) {
+        debug_printf("Out of memory in lips_load_file.'\n");
+        return -1;
+    }
+
+    for (i = 0; i < lipsData->marker_count; i++) {
+        // NOTE: Uninline.
+        if (lips_read_marker_type(&(lipsData->markers[i]), stream) != 0) {
+            debug_printf("lips_load_file: Error reading marker type.");
+            return -1;
+        }
+    }
+
+    speech_marker = &(lipsData->markers[0]);
+
+    if (speech_marker->marker != 1 && speech_marker->marker != 0) {
+        debug_printf("\nLoad error: Speech marker 0 is invalid (%d)!", speech_marker->marker);
+    }
+
+    if (speech_marker->position != 0) {
+        debug_printf("Load error: Speech marker 0 has invalid position(%d)!", speech_marker->position);
+    }
+
+    for (i = 1; i < lipsData->marker_count; i++) {
+        speech_marker = &(lipsData->markers[i]);
+        prev_speech_marker = &(lipsData->markers[i - 1]);
+
+        if (speech_marker->marker != 1 && speech_marker->marker != 0) {
+            debug_printf("\nLoad error: Speech marker %d is invalid (%d)!", i, speech_marker->marker);
+        }
+
+        if (speech_marker->position < prev_speech_marker->position) {
+            debug_printf("Load error: Speech marker %d has invalid position(%d)!", i, speech_marker->position);
+        }
+    }
+
+    return 0;
+}
+
+static void lips_free_track(LipsTrack* track)
+{
+    if (track->data.phonemes != NULL) {
+        mem_free(track->data.phonemes);
+    }
+
+    if (track->data.markers != NULL) {
+        mem_free(track->data.markers);
+    }
+
+    memset(track, 0, sizeof(*track));
+}
+
+// Finds lip track in cache, reading it from file if needed. Missing file is
+// not an error, `trackPtr` is set to NULL in this case.
+static int lips_cache_get(const char* path, LipsTrack** trackPtr)
+{
+    LipsTrack* track = NULL;
+    DB_FILE* stream;
+    int rc;
+
+    *trackPtr = NULL;
+
+    for (int index = 0; index < LIPS_CACHE_CAPACITY; index++) {
+        LipsTrack* candidate = &(lips_cache[index]);
+        if (candidate->path[0] != '\0' && stricmp(candidate->path, path) == 0) {
+            candidate->stamp = ++lips_cache_stamp;
+            *trackPtr = candidate;
+            return 0;
+        }
+
+        if (track == NULL || candidate->stamp < track->stamp) {
+            track = candidate;
+        }
+    }
+
+    stream = db_fopen(path, "rb");
+    if (stream == NULL) {
+        return 0;
+    }
+
+    lips_free_track(track);
+
+    rc = lips_read_track(stream, &(track->data));
+    db_fclose(stream);
+
+    if (rc != 0) {
+        lips_free_track(track);
+        return -1;
+    }
+
+    strcpy(track->path, path);
+    track->stamp = ++lips_cache_stamp;
+    *trackPtr = track;
+
+    return 0;
+}
+
+void lips_cache_flush()
+{
+    for (int index = 0; index < LIPS_CACHE_CAPACITY; index++) {
+        lips_free_track(&(lips_cache[index]));
+    }
+}
+
+// Queues lip track and speech of the reply which might be spoken next. They
+// are read piece by piece in `lips_prefetch_update`, so by the time reply is
+// chosen `lips_load_file` finds everything in memory.
+void lips_prefetch(const char* audioFileName, const char* headFileName)
+{
+    char name[16];
+    char* sep;
+    LipsPrefetch* prefetch;
+
+    if (lips_prefetch_queue_length == LIPS_PREFETCH_QUEUE_CAPACITY) {
+        return;
+    }
+
+    snprintf(name, sizeof(name), "%s", audioFileName);
+    sep = strchr(name, '.');
+    if (sep != NULL) {
+        *sep = '\0';
+    }
+
+    prefetch = &(lips_prefetch_queue[lips_prefetch_queue_length]);
+    snprintf(prefetch->path, sizeof(prefetch->path), "SOUND\\SPEECH\\%s\\%.8s.LIP", headFileName, name);
+    snprintf(prefetch->head, sizeof(prefetch->head), "%s", headFileName);
+
+    for (int index = 0; index < lips_prefetch_queue_length; index++) {
+        if (stricmp(lips_prefetch_queue[index].path, prefetch->path) == 0) {
+            return;
+        }
+    }
+
+    lips_prefetch_queue_length++;
+}
+
+// Does one piece of queued prefetch work: reads next queued lip track or next
+// chunk of speech. Returns `true` if there is more work to do.
+bool lips_prefetch_update()
+{
+    while (lips_prefetch_queue_length > 0) {
+        LipsPrefetch prefetch = lips_prefetch_queue[0];
+        LipsTrack* track;
+        bool cached = false;
+        char path[MAX_PATH];
+
+        lips_prefetch_queue_length--;
+        memmove(&(lips_prefetch_queue[0]), &(lips_prefetch_queue[1]), sizeof(*lips_prefetch_queue) * lips_prefetch_queue_length);
+
+        for (int index = 0; index < LIPS_CACHE_CAPACITY; index++) {
+            if (stricmp(lips_cache[index].path, prefetch.path) == 0) {
+                cached = true;
+                break;
+            }
+        }
+
+        if (lips_cache_get(prefetch.path, &track) == 0 && track != NULL) {
+            // Speech name comes from the track, not from reply.
+            snprintf(path, sizeof(path), "SOUND\\SPEECH\\%s\\%.8s.ACM", prefetch.head, track->data.field_50);
+            audioPreload(path);
+
+            if (!cached) {
+                return true;
+            }
+        }
+    }
+
+    return audioPreloadUpdate(LIPS_PREFETCH_CHUNK_SIZE);
+}
+
+// Drops queued prefetches, optionally freeing speech which was read ahead
+// but is not playing. Parsed lip tracks are kept.
+void lips_prefetch_reset(bool freeSpeech)
+{
+    lips_prefetch_queue_length = 0;
+
+    if (freeSpeech) {
+        audioPreloadFlush();
+    }
+}
@@ -58,5 +58,9 @@ void lips_bkg_proc();
 int lips_play_speech();
 int lips_load_file(const char* audioFileName, const char* headFileName);
 int lips_free_speech();
+void lips_cache_flush();
+void lips_prefetch(const char* audioFileName, const char* headFileName);
+bool lips_prefetch_update();
+void lips_prefetch_reset(bool freeSpeech);
 
 #endif /* FALLOUT_GAME_LIP_SYNC_H_ */
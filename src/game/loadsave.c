@@ -29,6 +29,7 @@
 #include "game/proto.h"
 #include "game/queue.h"
 #include "game/roll.h"
+#include "game/savepak.h"
 #include "game/scripts.h"
 #include "game/skill.h"
 #include "game/stat.h"
@@ -45,6 +46,7 @@
 #include "plib/gnw/input.h"
 #include "plib/gnw/memory.h"
 #include "plib/gnw/text.h"
+#include "plib/gnw/thread.h"
 
 #define LOAD_SAVE_SIGNATURE "FALLOUT SAVE FILE"
 #define LOAD_SAVE_DESCRIPTION_LENGTH 30
@@ -122,6 +124,53 @@ typedef enum LoadSaveFrm {
     LOAD_SAVE_FRM_COUNT,
 } LoadSaveFrm;
 
+// Tracks map file in MAPS directory, so that saving does not have to copy
+// maps which did not change since they were last written to the slot.
+typedef struct MapDirEntry {
+    char name[16];
+
+    // Bit per save slot holding the same copy of the map as MAPS directory.
+    unsigned int slots;
+} MapDirEntry;
+
+// Map file of loaded slot which is not copied to MAPS directory until it's
+// needed, see `SlotMap2Game`.
+typedef struct MapPendingEntry {
+    char name[16];
+
+    // Length of the file in slot directory when slot was loaded, or -1 when
+    // it comes from container (chunks are checksummed anyway).
+    int length;
+} MapPendingEntry;
+
+// Save game being written to disk (in background when enabled), see
+// `SaveSlot`.
+typedef struct SaveJob {
+    Thread* thread;
+    int slot;
+    char path[MAX_PATH];
+    unsigned char* data;
+    int size;
+
+    // Slot is written as single SAVE.PAK container (see savepak.c) instead
+    // of SAVE.DAT and map files. The first `ownedChunksLength` chunks are
+    // map files read by `GameMap2Slot`, the rest point into `data`.
+    bool container;
+    char tmpPath[MAX_PATH];
+    SavePakChunk chunks[MAP_COUNT + LOAD_SAVE_HANDLER_COUNT + 2];
+    int chunksLength;
+    int ownedChunksLength;
+
+    // Set by writer thread when it's done, `rc` is valid afterwards.
+    volatile int done;
+    int rc;
+
+    // Messages to display upon completion, lsgame.msg is usually closed by
+    // then.
+    char successMessage[80];
+    char failureMessage[80];
+} SaveJob;
+
 static int QuickSnapShot();
 static int LSGameStart(int windowType);
 static int LSGameEnd(int windowType);
@@ -148,6 +197,27 @@ static int RestoreSave();
 static int LoadObjDudeCid(DB_FILE* stream);
 static int SaveObjDudeCid(DB_FILE* stream);
 static int EraseSave();
+static int link_file(const char* src, const char* dest);
+static bool same_file_length(const char* a1, const char* a2);
+static MapDirEntry* MapDirFind(const char* name, bool create);
+static void MapDirReset();
+static void MapDirMarkClean(const char* name, int slot);
+static bool MapDirIsClean(const char* name, int slot);
+static void MapDirForgetSlot(int slot);
+static int MapDirAddPending(const char* name, int length);
+static void MapDirDropPending(const char* name);
+static void MapDirResetPending();
+static int MapDirRestoreAll();
+static int SaveJobStart(DB_FILE* stream, long* handlerOffsets, bool async);
+static int SaveJobProc(void* data);
+static void SaveJobPoll();
+static int SaveJobFinish();
+static int SaveJobAddChunk(const char* name, unsigned char* data, int length);
+static int SaveJobAddFile(const char* path, const char* name);
+static void SaveJobFreeChunks();
+static DB_FILE* SlotOpen(int slot, bool headerOnly);
+static void SlotClose();
+static int SlotCopyFile(SavePak* pak, int slot, const char* name, const char* dest);
 
 // 0x46D930
 static const int lsgrphs[LOAD_SAVE_FRM_COUNT] = {
@@ -180,6 +250,25 @@ static int automap_db_flag = 0;
 // 0x505970
 static char* patches = NULL;
 
+// Map files written to MAPS directory during this session, see
+// `MapDirEntry`. Unknown maps are always copied.
+static MapDirEntry map_dir_entries[MAP_COUNT];
+static int map_dir_entries_length = 0;
+
+// Maps of the slot `map_pending_slot` to be restored on first access, see
+// `MapDirRestore`. When slot is a container it's kept open in
+// `map_pending_pak`.
+static MapPendingEntry map_pending_entries[MAP_COUNT];
+static int map_pending_entries_length = 0;
+static int map_pending_slot = -1;
+static SavePak* map_pending_pak = NULL;
+
+// Save in progress, `thread` is `NULL` when there is none.
+static SaveJob save_job;
+
+// Container of the slot being loaded, see `SlotOpen`.
+static SavePak* load_pak = NULL;
+
 // 0x505974
 static char emgpath[] = "\\FALLOUT\\CD\\DATA\\SAVEGAME";
 
@@ -335,6 +424,8 @@ int SaveGame(int mode)
 {
     MessageListItem messageListItem;
 
+    WaitForSave();
+
     ls_error_code = 0;
 
     if (!config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MASTER_PATCHES_KEY, &patches)) {
@@ -343,10 +434,7 @@ int SaveGame(int mode)
     }
 
     if (mode == LOAD_SAVE_MODE_QUICK && quick_done) {
-        sprintf(gmpath, "%s\\%s%.2d\\", "SAVEGAME", "SLOT", slot_cursor + 1);
-        strcat(gmpath, "SAVE.DAT");
-
-        flptr = db_fopen(gmpath, "rb");
+        flptr = SlotOpen(slot_cursor, true);
         if (flptr != NULL) {
             LoadHeader(slot_cursor);
             db_fclose(flptr);
@@ -824,6 +912,8 @@ int LoadGame(int mode)
         str2,
     };
 
+    WaitForSave();
+
     ls_error_code = 0;
 
     if (!config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MASTER_PATCHES_KEY, &patches)) {
@@ -1456,6 +1546,15 @@ static int SaveSlot()
 
     gsound_background_pause();
 
+    // Saving needs every map in MAPS directory, and source slot might be
+    // the one being overwritten. Nothing is backed up yet, so there is
+    // nothing to restore either.
+    if (MapDirRestoreAll() == -1) {
+        debug_printf("\nLOADSAVE: ** Error restoring saved maps! **\n");
+        gsound_background_unpause();
+        return -1;
+    }
+
     sprintf(gmpath, "%s\\%s", patches, "SAVEGAME");
     mkdir(gmpath);
 
@@ -1471,7 +1570,28 @@ static int SaveSlot()
 
     debug_printf("\nLOADSAVE: Save name: %s\n", gmpath);
 
-    flptr = db_fopen(gmpath, "wb");
+    int saveThread;
+    if (!config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_SAVE_THREAD_KEY, &saveThread)) {
+        saveThread = 0;
+    }
+
+    int saveContainer;
+    if (!config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_SAVE_CONTAINER_KEY, &saveContainer)) {
+        saveContainer = 0;
+    }
+
+    save_job.container = saveContainer != 0;
+    save_job.chunksLength = 0;
+    save_job.ownedChunksLength = 0;
+
+    // Serialize into memory and let `SaveJobProc` write it out, so the game
+    // can continue right away.
+    if (saveThread != 0 || saveContainer != 0) {
+        flptr = db_fopen_mem_write(0x10000);
+    } else {
+        flptr = db_fopen(gmpath, "wb");
+    }
+
     if (flptr == NULL) {
         debug_printf("\nLOADSAVE: ** Error opening save game for writing! **\n");
         RestoreSave();
@@ -1482,6 +1602,7 @@ static int SaveSlot()
         return -1;
     }
 
+    long handlerOffsets[LOAD_SAVE_HANDLER_COUNT + 1];
     long pos = db_ftell(flptr);
     if (SaveHeader(slot_cursor) == -1) {
         debug_printf("\nLOADSAVE: ** Error writing save game header! **\n");
@@ -1495,12 +1616,15 @@ static int SaveSlot()
         return -1;
     }
 
+    handlerOffsets[0] = db_ftell(flptr);
+
     for (int index = 0; index < LOAD_SAVE_HANDLER_COUNT; index++) {
         long pos = db_ftell(flptr);
         SaveGameHandler* handler = master_save_list[index];
         if (handler(flptr) == -1) {
             debug_printf("\nLOADSAVE: ** Error writing save function #%d data! **\n", index);
             db_fclose(flptr);
+            SaveJobFreeChunks();
             RestoreSave();
             sprintf(gmpath, "%s\\%s%.2d\\", "SAVEGAME", "SLOT", slot_cursor + 1);
             MapDirErase(gmpath, "BAK");
@@ -1510,15 +1634,40 @@ static int SaveSlot()
         }
 
         debug_printf("LOADSAVE: Save function #%d data size written: %d bytes.\n", index, db_ftell(flptr) - pos);
+        handlerOffsets[index + 1] = db_ftell(flptr);
     }
 
     debug_printf("LOADSAVE: Total save data written: %ld bytes.\n", db_ftell(flptr));
 
+    if (saveThread != 0 || saveContainer != 0) {
+        if (SaveJobStart(flptr, handlerOffsets, saveThread != 0) == -1) {
+            debug_printf("\nLOADSAVE: ** Error starting save game writer! **\n");
+            SaveJobFreeChunks();
+            RestoreSave();
+            sprintf(gmpath, "%s\\%s%.2d\\", "SAVEGAME", "SLOT", slot_cursor + 1);
+            MapDirErase(gmpath, "BAK");
+            gsound_background_unpause();
+            return -1;
+        }
+
+        // Without writer thread the job is already complete.
+        if (saveThread == 0 && SaveJobFinish() == -1) {
+            gsound_background_unpause();
+            return -1;
+        }
+
+        gsound_background_unpause();
+        return 0;
+    }
+
     db_fclose(flptr);
 
     sprintf(gmpath, "%s\\%s%.2d\\", "SAVEGAME", "SLOT", slot_cursor + 1);
     MapDirErase(gmpath, "BAK");
 
+    sprintf(gmpath, "%s\\%s\\%s%.2d\\%s", patches, "SAVEGAME", "SLOT", slot_cursor + 1, "SAVE.PAK");
+    remove(gmpath);
+
     lsgmesg.num = 140;
     if (message_search(&lsgame_msgfl, &lsgmesg)) {
         display_print(lsgmesg.text);
@@ -1556,7 +1705,7 @@ static int LoadSlot(int slot)
     LoadSaveSlotData* ptr = &(LSData[slot]);
     debug_printf("\nLOADSAVE: Load name: %s\n", ptr->description);
 
-    flptr = db_fopen(gmpath, "rb");
+    flptr = SlotOpen(slot, false);
     if (flptr == NULL) {
         debug_printf("\nLOADSAVE: ** Error opening load game file for reading! **\n");
         loadingGame = 0;
@@ -1567,6 +1716,7 @@ static int LoadSlot(int slot)
     if (LoadHeader(slot) == -1) {
         debug_printf("\nLOADSAVE: ** Error reading save  game header! **\n");
         db_fclose(flptr);
+        SlotClose();
         game_reset();
         loadingGame = 0;
         return -1;
@@ -1582,6 +1732,7 @@ static int LoadSlot(int slot)
             int v12 = db_ftell(flptr);
             debug_printf("LOADSAVE: Load function #%d data size read: %d bytes.\n", index, db_ftell(flptr) - pos);
             db_fclose(flptr);
+            SlotClose();
             game_reset();
             loadingGame = 0;
             return -1;
@@ -1592,6 +1743,7 @@ static int LoadSlot(int slot)
 
     debug_printf("LOADSAVE: Total load data read: %ld bytes.\n", db_ftell(flptr));
     db_fclose(flptr);
+    SlotClose();
 
     sprintf(str, "%s\\", "MAPS");
     MapDirErase(str, "BAK");
@@ -1825,11 +1977,12 @@ static int GetSlotList()
     int index = 0;
     for (; index < 10; index += 1) {
         sprintf(str, "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", index + 1, "SAVE.DAT");
+        sprintf(str0, "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", index + 1, "SAVE.PAK");
 
-        if (db_dir_entry(str, &de) != 0) {
+        if (db_dir_entry(str, &de) != 0 && db_dir_entry(str0, &de) != 0) {
             LSstatus[index] = SLOT_STATE_EMPTY;
         } else {
-            flptr = db_fopen(str, "rb");
+            flptr = SlotOpen(index, true);
 
             if (flptr == NULL) {
                 debug_printf("\nLOADSAVE: ** Error opening save  game for reading! **\n");
@@ -1976,7 +2129,7 @@ static int LoadTumbSlot(int a1)
         sprintf(str, "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot_cursor + 1, "SAVE.DAT");
         debug_printf(" Filename %s\n", str);
 
-        stream = db_fopen(str, "rb");
+        stream = SlotOpen(slot_cursor, true);
         if (stream == NULL) {
             debug_printf("\nLOADSAVE: ** (A) Error reading thumbnail #%d! **\n", a1);
             return -1;
@@ -2284,6 +2437,11 @@ static int GameMap2Slot(DB_FILE* stream)
     strcat(gmpath, str0);
     remove(gmpath);
 
+    // Slot directory is not going to hold any maps.
+    if (save_job.container) {
+        MapDirForgetSlot(slot_cursor);
+    }
+
     for (int index = 0; index < fileNameListLength; index += 1) {
         char* string = fileNameList[index];
         if (db_fwrite(string, strlen(string) + 1, 1, stream) == -1) {
@@ -2293,20 +2451,53 @@ static int GameMap2Slot(DB_FILE* stream)
 
         sprintf(str0, "%s\\%s", "MAPS", string);
         sprintf(str1, "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot_cursor + 1, string);
+
+        if (save_job.container) {
+            if (SaveJobAddFile(str0, string) == -1) {
+                db_free_file_list(&fileNameList, NULL);
+                return -1;
+            }
+            continue;
+        }
+
+        // Map has not changed since it was last written to this slot, so
+        // the backup made by `SaveBackup` is still current - reuse it.
+        if (MapDirIsClean(string, slot_cursor)) {
+            char backupName[16];
+            strmfe(backupName, string, "BAK");
+            sprintf(str2, "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot_cursor + 1, backupName);
+            if (same_file_length(str0, str2) && link_file(str2, str1) == 0) {
+                continue;
+            }
+        }
+
         if (copy_file(str0, str1) == -1) {
             db_free_file_list(&fileNameList, NULL);
             return -1;
         }
+
+        MapDirMarkClean(string, slot_cursor);
     }
 
     db_free_file_list(&fileNameList, NULL);
 
+    if (automap_flush() == -1) {
+        return -1;
+    }
+
     strmfe(str0, "AUTOMAP.DB", "SAV");
     sprintf(str1, "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot_cursor + 1, str0);
     sprintf(str0, "%s\\%s", "MAPS", "AUTOMAP.DB");
 
-    if (copy_file(str0, str1) == -1) {
-        return -1;
+    if (save_job.container) {
+        strmfe(str2, "AUTOMAP.DB", "SAV");
+        if (SaveJobAddFile(str0, str2) == -1) {
+            return -1;
+        }
+    } else {
+        if (copy_file(str0, str1) == -1) {
+            return -1;
+        }
     }
 
     sprintf(str0, "%s\\%s", "MAPS", "AUTOMAP.DB");
@@ -2354,28 +2545,63 @@ static int SlotMap2Game(DB_FILE* stream)
     sprintf(str0, "%s\\%s\\%s", patches, "MAPS", "AUTOMAP.DB");
     remove(str0);
 
+    // Only the map player is on is needed right away, the rest are copied
+    // when entered (see `MapDirRestore`).
+    char currentFileName[16];
+    strmfe(currentFileName, LSData[slot_cursor].fileName, "SAV");
+
+    map_pending_slot = slot_cursor;
+
     for (int index = 0; index < fileNameListLength; index += 1) {
         char fileName[MAX_PATH];
         if (mygets(fileName, stream) == -1) {
             break;
         }
 
-        sprintf(str0, "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot_cursor + 1, fileName);
+        if (stricmp(fileName, currentFileName) != 0) {
+            int length = -1;
+            if (load_pak == NULL) {
+                dir_entry de;
+                sprintf(str0, "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot_cursor + 1, fileName);
+                if (db_dir_entry(str0, &de) != 0) {
+                    debug_printf("LOADSAVE: returning 7\n");
+                    return -1;
+                }
+                length = de.length;
+            }
+
+            if (MapDirAddPending(fileName, length) == 0) {
+                continue;
+            }
+        }
+
         sprintf(str1, "%s\\%s", "MAPS", fileName);
 
-        if (copy_file(str0, str1) == -1) {
+        if (SlotCopyFile(load_pak, slot_cursor, fileName, str1) == -1) {
             debug_printf("LOADSAVE: returning 7\n");
             return -1;
         }
+
+        // Maps read from container do not exist in slot directory.
+        if (load_pak == NULL) {
+            MapDirMarkClean(fileName, slot_cursor);
+        }
     }
 
-    const char* automapFileName = strmfe(str1, "AUTOMAP.DB", "SAV");
-    sprintf(str0, "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot_cursor + 1, automapFileName);
+    const char* automapFileName = strmfe(str2, "AUTOMAP.DB", "SAV");
     sprintf(str1, "%s\\%s", "MAPS", "AUTOMAP.DB");
-    if (copy_file(str0, str1) == -1) {
+    if (SlotCopyFile(load_pak, slot_cursor, automapFileName, str1) == -1) {
         return -1;
     }
 
+    automap_invalidate();
+
+    // Keep container open for pending maps.
+    if (map_pending_entries_length != 0 && load_pak != NULL) {
+        map_pending_pak = load_pak;
+        load_pak = NULL;
+    }
+
     int saved_automap_size;
     if (db_freadInt(stream, &saved_automap_size) == -1) {
         return -1;
@@ -2515,6 +2741,12 @@ void KillOldMaps()
 int MapDirErase(const char* relativePath, const char* extension)
 {
     char path[MAX_PATH];
+
+    if (stricmp(relativePath, "MAPS\\") == 0 && stricmp(extension, "SAV") == 0) {
+        MapDirReset();
+        MapDirResetPending();
+    }
+
     sprintf(path, "%s*.%s", relativePath, extension);
 
     char** fileList;
@@ -2540,6 +2772,10 @@ int MapDirEraseFile(const char* a1, const char* a2)
 {
     char path[MAX_PATH];
 
+    if (stricmp(a1, "MAPS\\") == 0) {
+        MapDirMarkDirty(a2);
+    }
+
     sprintf(path, "%s\\%s%s", patches, a1, a2);
     if (remove(path) != 0) {
         return -1;
@@ -2633,8 +2869,14 @@ static int RestoreSave()
     remove(str0);
 
     if (rename(str1, str0) != 0) {
-        EraseSave();
-        return -1;
+        // Container is only replaced once the new one is complete, so the
+        // slot is still intact.
+        dir_entry de;
+        sprintf(str2, "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot_cursor + 1, "SAVE.PAK");
+        if (db_dir_entry(str2, &de) != 0) {
+            EraseSave();
+            return -1;
+        }
     }
 
     sprintf(gmpath, "%s\\%s%.2d\\", "SAVEGAME", "SLOT", slot_cursor + 1);
@@ -2714,11 +2956,17 @@ static int EraseSave()
 {
     debug_printf("\nLOADSAVE: Erasing save(bad) slot...\n");
 
+    MapDirForgetSlot(slot_cursor);
+
     sprintf(gmpath, "%s\\%s\\%s%.2d\\", patches, "SAVEGAME", "SLOT", slot_cursor + 1);
     strcpy(str0, gmpath);
     strcat(str0, "SAVE.DAT");
     remove(str0);
 
+    // NOTE: SAVE.PAK is left alone. It's never written in place, so when it
+    // exists it's the last good save of the slot and `RestoreSave` falls
+    // back to it.
+
     sprintf(gmpath, "%s\\%s%.2d\\", "SAVEGAME", "SLOT", slot_cursor + 1);
     sprintf(str0, "%s*.%s", gmpath, "SAV");
 
@@ -2747,3 +2995,574 @@ static int EraseSave()
 
     return 0;
 }
+
+// Makes `dest` a hard link to `src` (both relative to patches directory), or
+// copies it when file system does not support links.
+static int link_file(const char* src, const char* dest)
+{
+    char srcPath[MAX_PATH];
+    char destPath[MAX_PATH];
+
+    sprintf(srcPath, "%s\\%s", patches, src);
+    sprintf(destPath, "%s\\%s", patches, dest);
+
+    remove(destPath);
+
+    if (CreateHardLinkA(destPath, srcPath, NULL)) {
+        db_add_hash_entry(destPath, '\\');
+        return 0;
+    }
+
+    return copy_file(src, dest);
+}
+
+static bool same_file_length(const char* a1, const char* a2)
+{
+    dir_entry de1;
+    dir_entry de2;
+
+    if (db_dir_entry(a1, &de1) != 0 || db_dir_entry(a2, &de2) != 0) {
+        return false;
+    }
+
+    return de1.length == de2.length;
+}
+
+static MapDirEntry* MapDirFind(const char* name, bool create)
+{
+    for (int index = 0; index < map_dir_entries_length; index++) {
+        if (stricmp(map_dir_entries[index].name, name) == 0) {
+            return &(map_dir_entries[index]);
+        }
+    }
+
+    if (!create || strlen(name) >= sizeof(map_dir_entries->name)) {
+        return NULL;
+    }
+
+    if (map_dir_entries_length == MAP_COUNT) {
+        return NULL;
+    }
+
+    strcpy(map_dir_entries[map_dir_entries_length].name, name);
+    map_dir_entries[map_dir_entries_length].slots = 0;
+
+    return &(map_dir_entries[map_dir_entries_length++]);
+}
+
+static void MapDirReset()
+{
+    map_dir_entries_length = 0;
+}
+
+// Should be called whenever map file `name` in MAPS directory is rewritten
+// or removed.
+void MapDirMarkDirty(const char* name)
+{
+    MapDirEntry* entry = MapDirFind(name, false);
+    if (entry != NULL) {
+        entry->slots = 0;
+    }
+
+    MapDirDropPending(name);
+}
+
+static void MapDirMarkClean(const char* name, int slot)
+{
+    MapDirEntry* entry = MapDirFind(name, true);
+    if (entry != NULL) {
+        entry->slots |= 1 << slot;
+    }
+}
+
+static bool MapDirIsClean(const char* name, int slot)
+{
+    MapDirEntry* entry = MapDirFind(name, false);
+    return entry != NULL && (entry->slots & (1 << slot)) != 0;
+}
+
+static void MapDirForgetSlot(int slot)
+{
+    for (int index = 0; index < map_dir_entries_length; index++) {
+        map_dir_entries[index].slots &= ~(1 << slot);
+    }
+}
+
+// Takes data serialized into memory `stream` and starts writing current slot
+// on a separate thread, or writes it right away when `async` is not set.
+// Completion is handled by `SaveJobFinish` on the main thread.
+//
+// `handlerOffsets` are stream positions where header and every save handler
+// data ends, used to split data into container chunks.
+static int SaveJobStart(DB_FILE* stream, long* handlerOffsets, bool async)
+{
+    MessageListItem messageListItem;
+    char name[SAVEPAK_NAME_LENGTH];
+
+    save_job.data = db_fclose_mem(stream, &(save_job.size));
+    if (save_job.data == NULL) {
+        return -1;
+    }
+
+    save_job.slot = slot_cursor;
+    save_job.done = 0;
+    save_job.rc = -1;
+
+    if (save_job.container) {
+        for (int index = -1; index < LOAD_SAVE_HANDLER_COUNT; index++) {
+            long start = index == -1 ? 0 : handlerOffsets[index];
+            if (index == -1) {
+                strcpy(name, "HEADER");
+            } else {
+                sprintf(name, "STATE.%.2d", index);
+            }
+
+            if (SaveJobAddChunk(name, save_job.data + start, handlerOffsets[index + 1] - start) == -1) {
+                db_free_mem(save_job.data);
+                save_job.data = NULL;
+                return -1;
+            }
+        }
+
+        sprintf(save_job.path, "%s\\%s\\%s%.2d\\%s", patches, "SAVEGAME", "SLOT", slot_cursor + 1, "SAVE.PAK");
+        sprintf(save_job.tmpPath, "%s\\%s\\%s%.2d\\%s", patches, "SAVEGAME", "SLOT", slot_cursor + 1, "SAVE.TMP");
+    } else {
+        sprintf(save_job.path, "%s\\%s\\%s%.2d\\%s", patches, "SAVEGAME", "SLOT", slot_cursor + 1, "SAVE.DAT");
+    }
+
+    save_job.successMessage[0] = '\0';
+    messageListItem.num = 140;
+    if (message_search(&lsgame_msgfl, &messageListItem)) {
+        snprintf(save_job.successMessage, sizeof(save_job.successMessage), "%s", messageListItem.text);
+    }
+
+    save_job.failureMessage[0] = '\0';
+    messageListItem.num = 132;
+    if (message_search(&lsgame_msgfl, &messageListItem)) {
+        snprintf(save_job.failureMessage, sizeof(save_job.failureMessage), "%s", messageListItem.text);
+    }
+
+    // Writer thread uses stdio directly, db is not thread-safe.
+    db_add_hash_entry(save_job.path, '\\');
+
+    if (!async) {
+        SaveJobProc(&save_job);
+        return 0;
+    }
+
+    save_job.thread = thread_create(SaveJobProc, &save_job);
+    if (save_job.thread == NULL) {
+        db_free_mem(save_job.data);
+        save_job.data = NULL;
+        return -1;
+    }
+
+    add_bk_process(SaveJobPoll);
+
+    return 0;
+}
+
+static int SaveJobProc(void* data)
+{
+    SaveJob* job = (SaveJob*)data;
+    FILE* stream;
+    int rc = -1;
+
+    if (job->container) {
+        // Old container is replaced only when the new one is complete.
+        if (savepak_write(job->tmpPath, job->chunks, job->chunksLength) == 0) {
+            remove(job->path);
+            if (rename(job->tmpPath, job->path) == 0) {
+                rc = 0;
+            }
+        }
+
+        if (rc == -1) {
+            remove(job->tmpPath);
+        }
+    } else {
+        stream = fopen(job->path, "wb");
+        if (stream != NULL) {
+            if (fwrite(job->data, 1, job->size, stream) == (size_t)job->size) {
+                rc = 0;
+            }
+
+            if (fclose(stream) != 0) {
+                rc = -1;
+            }
+        }
+    }
+
+    job->rc = rc;
+    atomic_set(&(job->done), 1);
+
+    return rc;
+}
+
+static void SaveJobPoll()
+{
+    if (save_job.thread != NULL && atomic_get(&(save_job.done)) != 0) {
+        SaveJobFinish();
+    }
+}
+
+// Joins writer thread and either drops slot backup or restores it if write
+// failed.
+static int SaveJobFinish()
+{
+    int slot;
+
+    if (save_job.thread != NULL) {
+        remove_bk_process(SaveJobPoll);
+
+        thread_join(save_job.thread);
+        save_job.thread = NULL;
+    }
+
+    SaveJobFreeChunks();
+
+    db_free_mem(save_job.data);
+    save_job.data = NULL;
+
+    // Slot functions below operate on `slot_cursor`, which may have been
+    // moved since save was started.
+    slot = slot_cursor;
+    slot_cursor = save_job.slot;
+
+    if (save_job.rc == -1) {
+        debug_printf("\nLOADSAVE: ** Error writing save game to %s! **\n", save_job.path);
+        RestoreSave();
+        gsound_play_sfx_file("iisxxxx1");
+        if (save_job.failureMessage[0] != '\0') {
+            display_print(save_job.failureMessage);
+        }
+    } else {
+        debug_printf("LOADSAVE: Save game written to %s: %d bytes.\n", save_job.path, save_job.size);
+        if (save_job.successMessage[0] != '\0') {
+            display_print(save_job.successMessage);
+        }
+
+        // Slot is now either SAVE.DAT with map files, or a container.
+        if (!save_job.container) {
+            sprintf(gmpath, "%s\\%s\\%s%.2d\\%s", patches, "SAVEGAME", "SLOT", slot_cursor + 1, "SAVE.PAK");
+            remove(gmpath);
+        }
+    }
+
+    sprintf(gmpath, "%s\\%s%.2d\\", "SAVEGAME", "SLOT", slot_cursor + 1);
+    MapDirErase(gmpath, "BAK");
+
+    slot_cursor = slot;
+
+    return save_job.rc;
+}
+
+// Blocks until save game being written in background (if any) is complete.
+// Should be called before anything touches save slots, and before exit.
+void WaitForSave()
+{
+    if (save_job.thread != NULL) {
+        SaveJobFinish();
+    }
+}
+
+static int SaveJobAddChunk(const char* name, unsigned char* data, int length)
+{
+    SavePakChunk* chunk;
+
+    if (save_job.chunksLength == sizeof(save_job.chunks) / sizeof(save_job.chunks[0])) {
+        return -1;
+    }
+
+    chunk = &(save_job.chunks[save_job.chunksLength++]);
+    strncpy(chunk->name, name, sizeof(chunk->name) - 1);
+    chunk->name[sizeof(chunk->name) - 1] = '\0';
+    chunk->data = data;
+    chunk->length = length;
+
+    return 0;
+}
+
+// Reads file at `path` into memory to be stored in container as `name`.
+static int SaveJobAddFile(const char* path, const char* name)
+{
+    DB_FILE* stream;
+    unsigned char* data;
+    int length;
+
+    stream = db_fopen(path, "rb");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    length = db_filelength(stream);
+    if (length == -1) {
+        db_fclose(stream);
+        return -1;
+    }
+
+    data = (unsigned char*)mem_malloc(length + 1);
+    if (data == NULL) {
+        db_fclose(stream);
+        return -1;
+    }
+
+    if (length != 0 && db_fread(data, length, 1, stream) != 1) {
+        mem_free(data);
+        db_fclose(stream);
+        return -1;
+    }
+
+    db_fclose(stream);
+
+    if (SaveJobAddChunk(name, data, length) == -1) {
+        mem_free(data);
+        return -1;
+    }
+
+    save_job.ownedChunksLength = save_job.chunksLength;
+
+    return 0;
+}
+
+static void SaveJobFreeChunks()
+{
+    for (int index = 0; index < save_job.ownedChunksLength; index++) {
+        mem_free(save_job.chunks[index].data);
+    }
+
+    save_job.chunksLength = 0;
+    save_job.ownedChunksLength = 0;
+}
+
+// Opens save game data of `slot` for reading. Slot is either SAVE.DAT, or
+// SAVE.PAK, in which case header and state chunks are unpacked into memory
+// stream. With `headerOnly` only header is unpacked, otherwise container is
+// kept open in `load_pak` for `SlotMap2Game` until `SlotClose`.
+static DB_FILE* SlotOpen(int slot, bool headerOnly)
+{
+    char path[MAX_PATH];
+    char name[SAVEPAK_NAME_LENGTH];
+    dir_entry de;
+    SavePak* pak;
+    DB_FILE* stream;
+    unsigned char* data;
+    int length;
+    int index;
+
+    sprintf(path, "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot + 1, "SAVE.DAT");
+    if (db_dir_entry(path, &de) == 0) {
+        return db_fopen(path, "rb");
+    }
+
+    sprintf(path, "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot + 1, "SAVE.PAK");
+    pak = savepak_open(path);
+    if (pak == NULL) {
+        return NULL;
+    }
+
+    stream = db_fopen_mem_write(0x10000);
+    if (stream == NULL) {
+        savepak_close(pak);
+        return NULL;
+    }
+
+    for (index = -1; index < (headerOnly ? 0 : LOAD_SAVE_HANDLER_COUNT); index++) {
+        if (index == -1) {
+            strcpy(name, "HEADER");
+        } else {
+            sprintf(name, "STATE.%.2d", index);
+        }
+
+        data = savepak_read(pak, savepak_find(pak, name), &length);
+        if (data == NULL) {
+            debug_printf("\nLOADSAVE: ** Error reading %s from %s! **\n", name, path);
+            db_fclose(stream);
+            savepak_close(pak);
+            return NULL;
+        }
+
+        if (db_fwrite(data, 1, length, stream) != (size_t)length) {
+            mem_free(data);
+            db_fclose(stream);
+            savepak_close(pak);
+            return NULL;
+        }
+
+        mem_free(data);
+    }
+
+    data = db_fclose_mem(stream, &length);
+    if (data == NULL) {
+        savepak_close(pak);
+        return NULL;
+    }
+
+    stream = db_fopen_mem(data, length);
+    db_free_mem(data);
+
+    if (stream == NULL || headerOnly) {
+        savepak_close(pak);
+        return stream;
+    }
+
+    SlotClose();
+    load_pak = pak;
+
+    return stream;
+}
+
+static void SlotClose()
+{
+    if (load_pak != NULL) {
+        savepak_close(load_pak);
+        load_pak = NULL;
+    }
+}
+
+// Copies `name` from `slot` to `dest` (relative to patches directory). When
+// `pak` is given the file is read from it instead of slot directory.
+static int SlotCopyFile(SavePak* pak, int slot, const char* name, const char* dest)
+{
+    char path[MAX_PATH];
+    DB_FILE* stream;
+    unsigned char* data;
+    int length;
+    int rc;
+
+    if (pak == NULL) {
+        sprintf(path, "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot + 1, name);
+        return copy_file(path, dest);
+    }
+
+    data = savepak_read(pak, savepak_find(pak, name), &length);
+    if (data == NULL) {
+        return -1;
+    }
+
+    stream = db_fopen(dest, "wb");
+    if (stream == NULL) {
+        mem_free(data);
+        return -1;
+    }
+
+    rc = 0;
+    if (length != 0 && db_fwrite(data, length, 1, stream) != 1) {
+        rc = -1;
+    }
+
+    db_fclose(stream);
+    mem_free(data);
+
+    return rc;
+}
+
+static int MapDirAddPending(const char* name, int length)
+{
+    MapPendingEntry* entry;
+
+    if (map_pending_entries_length == MAP_COUNT || strlen(name) >= sizeof(entry->name)) {
+        return -1;
+    }
+
+    entry = &(map_pending_entries[map_pending_entries_length++]);
+    strcpy(entry->name, name);
+    entry->length = length;
+
+    return 0;
+}
+
+static void MapDirDropPending(const char* name)
+{
+    for (int index = 0; index < map_pending_entries_length; index++) {
+        if (stricmp(map_pending_entries[index].name, name) == 0) {
+            map_pending_entries[index] = map_pending_entries[--map_pending_entries_length];
+            break;
+        }
+    }
+
+    if (map_pending_entries_length == 0) {
+        MapDirResetPending();
+    }
+}
+
+static void MapDirResetPending()
+{
+    map_pending_entries_length = 0;
+    map_pending_slot = -1;
+
+    if (map_pending_pak != NULL) {
+        savepak_close(map_pending_pak);
+        map_pending_pak = NULL;
+    }
+}
+
+// Copies saved map `name` (any extension) to MAPS directory if it's still
+// pending since the game was loaded. Should be called before map's .SAV is
+// accessed.
+//
+// On failure the map stays pending, so saving keeps failing (instead of
+// writing a slot without that map) until another game is loaded.
+int MapDirRestore(const char* name)
+{
+    char fileName[16];
+    char src[MAX_PATH];
+    char dest[MAX_PATH];
+    dir_entry de;
+    int index;
+    int rc;
+
+    if (map_pending_entries_length == 0 || strlen(name) >= sizeof(fileName)) {
+        return 0;
+    }
+
+    strmfe(fileName, name, "SAV");
+
+    for (index = 0; index < map_pending_entries_length; index++) {
+        if (stricmp(map_pending_entries[index].name, fileName) == 0) {
+            break;
+        }
+    }
+
+    if (index == map_pending_entries_length) {
+        return 0;
+    }
+
+    // Slots are never modified while maps are pending, this only guards
+    // against changes from outside.
+    if (map_pending_pak == NULL) {
+        sprintf(src, "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", map_pending_slot + 1, fileName);
+        if (db_dir_entry(src, &de) != 0 || de.length != map_pending_entries[index].length) {
+            debug_printf("\nLOADSAVE: ** Saved map %s has changed since load! **\n", fileName);
+            return -1;
+        }
+    }
+
+    sprintf(dest, "%s\\%s", "MAPS", fileName);
+    rc = SlotCopyFile(map_pending_pak, map_pending_slot, fileName, dest);
+    if (rc != 0) {
+        debug_printf("\nLOADSAVE: ** Error restoring saved map %s! **\n", fileName);
+        return -1;
+    }
+
+    if (map_pending_pak == NULL) {
+        MapDirMarkClean(fileName, map_pending_slot);
+    }
+
+    debug_printf("LOADSAVE: Restored saved map %s.\n", fileName);
+
+    MapDirDropPending(fileName);
+
+    return 0;
+}
+
+static int MapDirRestoreAll()
+{
+    while (map_pending_entries_length != 0) {
+        if (MapDirRestore(map_pending_entries[map_pending_entries_length - 1].name) == -1) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
@@ -30,5 +30,8 @@ int isLoadingGame();
 void KillOldMaps();
 int MapDirErase(const char* path, const char* a2);
 int MapDirEraseFile(const char* a1, const char* a2);
+void MapDirMarkDirty(const char* name);
+int MapDirRestore(const char* name);
+void WaitForSave();
 
 #endif /* FALLOUT_GAME_LOADSAVE_H_ */
@@ -0,0 +1,122 @@
+#include "game/lstfile.h"
+
+#include <stddef.h>
+
+#include "plib/db/db.h"
+#include "plib/gnw/memory.h"
+
+void lst_init(LstFile* lst)
+{
+    lst->pool = NULL;
+    lst->offsets = NULL;
+    lst->length = 0;
+}
+
+// Reads entire file at once and breaks it into lines the same way repeated
+// `db_fgets` does, so line N of the file is `lst_get(lst, N)`.
+int lst_load(LstFile* lst, const char* path)
+{
+    DB_FILE* stream;
+    long size;
+    char* pool;
+    int* offsets;
+    int length;
+    int index;
+    long pos;
+
+    lst_init(lst);
+
+    stream = db_fopen(path, "rb");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    size = db_filelength(stream);
+    if (size < 0) {
+        db_fclose(stream);
+        return -1;
+    }
+
+    pool = (char*)mem_malloc(size + 1);
+    if (pool == NULL) {
+        db_fclose(stream);
+        return -1;
+    }
+
+    if (db_fread(pool, 1, size, stream) != (size_t)size) {
+        mem_free(pool);
+        db_fclose(stream);
+        return -1;
+    }
+
+    db_fclose(stream);
+
+    pool[size] = '\0';
+
+    length = 0;
+    for (pos = 0; pos < size; pos++) {
+        if (pool[pos] == '\n') {
+            length++;
+        }
+    }
+
+    if (size > 0 && pool[size - 1] != '\n') {
+        length++;
+    }
+
+    offsets = NULL;
+    if (length != 0) {
+        offsets = (int*)mem_malloc(sizeof(*offsets) * length);
+        if (offsets == NULL) {
+            mem_free(pool);
+            return -1;
+        }
+    }
+
+    index = 0;
+    pos = 0;
+    while (index < length) {
+        long end = pos;
+        while (end < size && pool[end] != '\n') {
+            end++;
+        }
+
+        pool[end] = '\0';
+
+        if (end > pos && pool[end - 1] == '\r') {
+            pool[end - 1] = '\0';
+        }
+
+        offsets[index++] = (int)pos;
+        pos = end + 1;
+    }
+
+    lst->pool = pool;
+    lst->offsets = offsets;
+    lst->length = length;
+
+    return 0;
+}
+
+void lst_free(LstFile* lst)
+{
+    if (lst->offsets != NULL) {
+        mem_free(lst->offsets);
+    }
+
+    if (lst->pool != NULL) {
+        mem_free(lst->pool);
+    }
+
+    lst_init(lst);
+}
+
+// Returns line at given zero-based index, or NULL if there is no such line.
+const char* lst_get(LstFile* lst, int index)
+{
+    if (index < 0 || index >= lst->length) {
+        return NULL;
+    }
+
+    return lst->pool + lst->offsets[index];
+}
@@ -0,0 +1,20 @@
+#ifndef FALLOUT_GAME_LSTFILE_H_
+#define FALLOUT_GAME_LSTFILE_H_
+
+// Contents of .lst file split into lines.
+typedef struct LstFile {
+    // Every line without line break, each one NUL-terminated.
+    char* pool;
+
+    // Offsets of lines in `pool`.
+    int* offsets;
+
+    int length;
+} LstFile;
+
+void lst_init(LstFile* lst);
+int lst_load(LstFile* lst, const char* path);
+void lst_free(LstFile* lst);
+const char* lst_get(LstFile* lst, int index);
+
+#endif /* FALLOUT_GAME_LSTFILE_H_ */
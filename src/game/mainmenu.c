@@ -282,7 +282,7 @@ void main_menu_show(bool animate)
 
     if (animate) {
         loadColorTable("color.pal");
-        palette_fade_to(cmap);
+        palette_fade_in(cmap);
     }
 
     main_menu_is_hidden = false;
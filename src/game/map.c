@@ -19,6 +19,7 @@
 #include "game/item.h"
 #include "game/light.h"
 #include "game/loadsave.h"
+#include "game/mapcache.h"
 #include "game/object.h"
 #include "game/palette.h"
 #include "game/pipboy.h"
@@ -57,6 +58,23 @@ static int square_load(DB_FILE* stream, int a2);
 static int map_write_MapData(MapHeader* ptr, DB_FILE* stream);
 static int map_read_MapData(MapHeader* ptr, DB_FILE* stream);
 
+// Layout of map header in .map and save files.
+static const DBRecordField map_data_fields[] = {
+    DB_RECORD_INT(MapHeader, version),
+    DB_RECORD_BYTES(MapHeader, name, 16),
+    DB_RECORD_INT(MapHeader, enteringTile),
+    DB_RECORD_INT(MapHeader, enteringElevation),
+    DB_RECORD_INT(MapHeader, enteringRotation),
+    DB_RECORD_INT(MapHeader, localVariablesCount),
+    DB_RECORD_INT(MapHeader, scriptIndex),
+    DB_RECORD_INT(MapHeader, flags),
+    DB_RECORD_INT(MapHeader, darkness),
+    DB_RECORD_INT(MapHeader, globalVariablesCount),
+    DB_RECORD_INT(MapHeader, field_34),
+    DB_RECORD_INT(MapHeader, lastVisitTime),
+    DB_RECORD_INTS(MapHeader, field_3C, 44),
+};
+
 // 0x4735CE
 static const short city_vs_city_idx_table[MAP_COUNT][5] = {
     /*  DESERT1 */ { -1, -1, -1, -1, -1 },
@@ -272,6 +290,10 @@ int iso_init()
     // NOTE: Uninline.
     square_init();
 
+    if (mapcache_init() != 0) {
+        debug_printf("mapcache_init failed in iso_init, continuing without map cache\n");
+    }
+
     display_win = win_add(0, 0, scr_size.lrx - scr_size.ulx + 1, scr_size.lry - scr_size.uly - 99, 256, 10);
     if (display_win == -1) {
         debug_printf("win_add failed in iso_init\n");
@@ -352,6 +374,7 @@ void iso_exit()
     obj_exit();
     tile_exit();
     art_exit();
+    mapcache_exit();
 
     win_delete(display_win);
 
@@ -826,6 +849,16 @@ int map_load(char* file_name)
 
     strupr(file_name);
 
+    // Saved map might not have been copied from save slot yet. Loading
+    // pristine map instead would lose its saved state.
+    if (MapDirRestore(file_name) == -1) {
+        debug_printf("\nMAP: Error restoring saved map %s!\n", file_name);
+        return -1;
+    }
+
+    // Read the music while the map is loading.
+    PrefetchCityMapMusic(map_match_map_name(file_name));
+
     rc = -1;
 
     extension = strstr(file_name, ".MAP");
@@ -845,8 +878,11 @@ int map_load(char* file_name)
     }
 
     if (rc == -1) {
-        file_path = map_file_path(file_name);
-        stream = db_fopen(file_path, "rb");
+        stream = mapcache_fopen(file_name);
+        if (stream == NULL) {
+            file_path = map_file_path(file_name);
+            stream = db_fopen(file_path, "rb");
+        }
         if (stream != NULL) {
             rc = map_load_file(stream);
             db_fclose(stream);
@@ -1451,6 +1487,7 @@ int map_save_in_game(bool a1)
 
         strcpy(name, map_data.name);
         strmfe(map_data.name, name, "SAV");
+        MapDirMarkDirty(map_data.name);
         if (map_save() == -1) {
             return -1;
         }
@@ -1768,19 +1805,7 @@ static int square_load(DB_FILE* stream, int flags)
 // 0x476120
 static int map_write_MapData(MapHeader* ptr, DB_FILE* stream)
 {
-    if (db_fwriteInt(stream, ptr->version) == -1) return -1;
-    if (db_fwriteByteCount(stream, ptr->name, 16) == -1) return -1;
-    if (db_fwriteInt(stream, ptr->enteringTile) == -1) return -1;
-    if (db_fwriteInt(stream, ptr->enteringElevation) == -1) return -1;
-    if (db_fwriteInt(stream, ptr->enteringRotation) == -1) return -1;
-    if (db_fwriteInt(stream, ptr->localVariablesCount) == -1) return -1;
-    if (db_fwriteInt(stream, ptr->scriptIndex) == -1) return -1;
-    if (db_fwriteInt(stream, ptr->flags) == -1) return -1;
-    if (db_fwriteInt(stream, ptr->darkness) == -1) return -1;
-    if (db_fwriteInt(stream, ptr->globalVariablesCount) == -1) return -1;
-    if (db_fwriteInt(stream, ptr->field_34) == -1) return -1;
-    if (db_fwriteInt(stream, ptr->lastVisitTime) == -1) return -1;
-    if (db_fwriteIntCount(stream, ptr->field_3C, 44) == -1) return -1;
+    if (db_fwriteRecord(stream, ptr, map_data_fields, DB_RECORD_LENGTH(map_data_fields)) == -1) return -1;
 
     return 0;
 }
@@ -1788,19 +1813,7 @@ static int map_write_MapData(MapHeader* ptr, DB_FILE* stream)
 // 0x47621C
 static int map_read_MapData(MapHeader* ptr, DB_FILE* stream)
 {
-    if (db_freadInt(stream, &(ptr->version)) == -1) return -1;
-    if (db_freadByteCount(stream, ptr->name, 16) == -1) return -1;
-    if (db_freadInt(stream, &(ptr->enteringTile)) == -1) return -1;
-    if (db_freadInt(stream, &(ptr->enteringElevation)) == -1) return -1;
-    if (db_freadInt(stream, &(ptr->enteringRotation)) == -1) return -1;
-    if (db_freadInt(stream, &(ptr->localVariablesCount)) == -1) return -1;
-    if (db_freadInt(stream, &(ptr->scriptIndex)) == -1) return -1;
-    if (db_freadInt(stream, &(ptr->flags)) == -1) return -1;
-    if (db_freadInt(stream, &(ptr->darkness)) == -1) return -1;
-    if (db_freadInt(stream, &(ptr->globalVariablesCount)) == -1) return -1;
-    if (db_freadInt(stream, &(ptr->field_34)) == -1) return -1;
-    if (db_freadInt(stream, &(ptr->lastVisitTime)) == -1) return -1;
-    if (db_freadIntCount(stream, ptr->field_3C, 44) == -1) return -1;
+    if (db_freadRecord(stream, ptr, map_data_fields, DB_RECORD_LENGTH(map_data_fields)) == -1) return -1;
 
     return 0;
 }
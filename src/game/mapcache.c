@@ -0,0 +1,210 @@
+#include "game/mapcache.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "game/cache.h"
+#include "game/gconfig.h"
+#include "game/map.h"
+#include "plib/gnw/debug.h"
+#include "plib/gnw/memory.h"
+
+// Keeps unpacked images of .MAP files from master datafile, so entering the
+// same map again (random encounter maps are never saved, and neither are
+// maps visited after new game) does not decompress it from datafile every
+// time. Entries are keyed by map index.
+//
+// Files in patches directory (including every .SAV) bypass the cache, they
+// are subject to change during the game.
+
+typedef struct MapCacheImage {
+    // Directory entry the image was read from. The image is only served when
+    // datafile still resolves map file to the same entry.
+    dir_entry source;
+
+    int length;
+} MapCacheImage;
+
+static bool mapcache_path(int map, char* path);
+static bool mapcache_source(const char* path, dir_entry* de);
+static int mapcache_image_size(int map, int* sizePtr);
+static int mapcache_image_load(int map, int* sizePtr, unsigned char* data);
+static void mapcache_image_free(void* ptr);
+
+static Cache mapcache_cache;
+static bool mapcache_initialized = false;
+
+int mapcache_init()
+{
+    int size;
+
+    if (!config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MAP_CACHE_SIZE_KEY, &size)) {
+        size = 0;
+    }
+
+    if (size <= 0) {
+        return 0;
+    }
+
+    if (!cache_init(&mapcache_cache, mapcache_image_size, mapcache_image_load, mapcache_image_free, size << 20)) {
+        debug_printf("mapcache_init: unable to create %d MB cache\n", size);
+        return -1;
+    }
+
+    mapcache_initialized = true;
+
+    return 0;
+}
+
+void mapcache_exit()
+{
+    if (mapcache_initialized) {
+        cache_exit(&mapcache_cache);
+        mapcache_initialized = false;
+    }
+}
+
+// Opens .MAP file `name` (without directory) from the cache, reading it into
+// the cache first if needed. Returns `NULL` when map is not cacheable, in
+// which case it should be opened with `db_fopen` as usual.
+DB_FILE* mapcache_fopen(const char* name)
+{
+    const char* extension;
+    int map;
+    char path[MAX_PATH];
+    dir_entry de;
+    MapCacheImage* image;
+    CacheEntry* cacheEntry;
+    DB_FILE* stream;
+
+    if (!mapcache_initialized) {
+        return NULL;
+    }
+
+    extension = strrchr(name, '.');
+    if (extension == NULL || stricmp(extension, ".MAP") != 0) {
+        return NULL;
+    }
+
+    map = map_match_map_name(name);
+    if (map == -1) {
+        return NULL;
+    }
+
+    if (!mapcache_path(map, path)) {
+        return NULL;
+    }
+
+    if (!mapcache_source(path, &de)) {
+        return NULL;
+    }
+
+    if (!cache_lock(&mapcache_cache, map, (void**)&image, &cacheEntry)) {
+        return NULL;
+    }
+
+    if (memcmp(&(image->source), &de, sizeof(de)) != 0) {
+        // Datafile has changed under us (another datafile was selected), the
+        // image is stale.
+        cache_unlock(&mapcache_cache, cacheEntry);
+        cache_discard(&mapcache_cache, map);
+
+        if (!cache_lock(&mapcache_cache, map, (void**)&image, &cacheEntry)) {
+            return NULL;
+        }
+    }
+
+    stream = db_fopen_mem(image + 1, image->length);
+
+    cache_unlock(&mapcache_cache, cacheEntry);
+
+    return stream;
+}
+
+static bool mapcache_path(int map, char* path)
+{
+    char name[16];
+
+    if (map_get_name_idx(name, map) == -1) {
+        return false;
+    }
+
+    strcpy(path, map_file_path(name));
+    strupr(path);
+
+    return true;
+}
+
+// Resolves `path` the same way `db_fopen` would. Returns `false` if the file
+// is missing or comes from patches directory.
+static bool mapcache_source(const char* path, dir_entry* de)
+{
+    memset(de, 0, sizeof(*de));
+
+    if (db_dir_entry(path, de) != 0) {
+        return false;
+    }
+
+    return (de->flags & 0x8) != 0;
+}
+
+static int mapcache_image_size(int map, int* sizePtr)
+{
+    char path[MAX_PATH];
+    dir_entry de;
+
+    if (!mapcache_path(map, path)) {
+        return -1;
+    }
+
+    if (!mapcache_source(path, &de)) {
+        return -1;
+    }
+
+    *sizePtr = sizeof(MapCacheImage) + de.length;
+
+    return 0;
+}
+
+static int mapcache_image_load(int map, int* sizePtr, unsigned char* data)
+{
+    char path[MAX_PATH];
+    MapCacheImage* image;
+    DB_FILE* stream;
+    size_t bytesRead;
+
+    if (!mapcache_path(map, path)) {
+        return -1;
+    }
+
+    image = (MapCacheImage*)data;
+    if (!mapcache_source(path, &(image->source))) {
+        return -1;
+    }
+
+    if ((int)sizeof(*image) + image->source.length > *sizePtr) {
+        return -1;
+    }
+
+    stream = db_fopen(path, "rb");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    bytesRead = db_fread(image + 1, 1, image->source.length, stream);
+    db_fclose(stream);
+
+    if (bytesRead != (size_t)image->source.length) {
+        return -1;
+    }
+
+    image->length = image->source.length;
+    *sizePtr = sizeof(*image) + image->length;
+
+    return 0;
+}
+
+static void mapcache_image_free(void* ptr)
+{
+    mem_free(ptr);
+}
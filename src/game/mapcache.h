@@ -0,0 +1,10 @@
+#ifndef FALLOUT_GAME_MAPCACHE_H_
+#define FALLOUT_GAME_MAPCACHE_H_
+
+#include "plib/db/db.h"
+
+int mapcache_init();
+void mapcache_exit();
+DB_FILE* mapcache_fopen(const char* name);
+
+#endif /* FALLOUT_GAME_MAPCACHE_H_ */
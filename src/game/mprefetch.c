@@ -0,0 +1,540 @@
+#include "game/mprefetch.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+
+#include "int/audiof.h"
+#include "plib/gnw/thread.h"
+#include "sound_decoder.h"
+
+// Music prefetcher. Reads compressed music files into memory on background
+// threads, so that the next track is (at least partially) in memory by the
+// time it should start playing. Prefetched files are opened with
+// `mprefetch_open` and decoded straight from memory, reads past what has
+// been loaded so far wait for the prefetch thread. Files which were not
+// prefetched are opened with audiof.
+//
+// Everything here is allocated with plain malloc, since prefetch threads
+// cannot use gnw memory manager.
+
+// Number of tracks kept in memory: the one which is playing and the one
+// which is about to.
+#define MPREFETCH_SLOT_COUNT 2
+
+#define MPREFETCH_FILE_COUNT 4
+
+// Size of blocks read by prefetch thread, playback of partially loaded file
+// can advance with this granularity.
+#define MPREFETCH_BLOCK_SIZE 0x8000
+
+typedef enum MusicPrefetchState {
+    MPREFETCH_STATE_LOADING,
+    MPREFETCH_STATE_DONE,
+    MPREFETCH_STATE_FAILED,
+} MusicPrefetchState;
+
+typedef struct MusicPrefetch {
+    char path[MAX_PATH];
+
+    // Written by prefetch thread, valid up to `loaded` bytes.
+    unsigned char* data;
+    int size;
+
+    // Accessed with `atomic_get` and `atomic_set`.
+    volatile int loaded;
+    volatile int state;
+    volatile int cancel;
+
+    Thread* thread;
+
+    // Number of open files reading from `data`.
+    int refs;
+
+    // Slot with the lowest stamp is reused first.
+    unsigned int stamp;
+} MusicPrefetch;
+
+typedef struct MusicPrefetchFile {
+    bool used;
+
+    // `NULL` when file is opened with audiof.
+    MusicPrefetch* prefetch;
+    int audiofHandle;
+
+    AudioDecoder* decoder;
+    int channels;
+    int sampleRate;
+    int fileSize;
+
+    // Position in decoded data.
+    int position;
+
+    // Position in `prefetch->data`.
+    int dataPosition;
+} MusicPrefetchFile;
+
+static MusicPrefetch* mprefetch_find(const char* path);
+static void mprefetch_release(MusicPrefetch* prefetch);
+static int mprefetch_thread_proc(void* data);
+static int mprefetch_wait(MusicPrefetch* prefetch, int size);
+static bool mprefetch_handle_is_legal(int handle);
+static int mprefetch_ad_reader(void* stream, void* buf, unsigned int size);
+static int mprefetch_ad_seek(void* stream, int offset);
+
+static bool mprefetch_initialized = false;
+
+static MusicPrefetch mprefetch_slots[MPREFETCH_SLOT_COUNT];
+
+static MusicPrefetchFile mprefetch_files[MPREFETCH_FILE_COUNT];
+
+static unsigned int mprefetch_clock = 0;
+
+int mprefetch_init()
+{
+    if (mprefetch_initialized) {
+        return 0;
+    }
+
+    memset(mprefetch_slots, 0, sizeof(mprefetch_slots));
+    memset(mprefetch_files, 0, sizeof(mprefetch_files));
+    mprefetch_clock = 0;
+    mprefetch_initialized = true;
+
+    return 0;
+}
+
+void mprefetch_exit()
+{
+    int index;
+
+    if (!mprefetch_initialized) {
+        return;
+    }
+
+    for (index = 0; index < MPREFETCH_FILE_COUNT; index++) {
+        if (mprefetch_files[index].used) {
+            mprefetch_close(index + 1);
+        }
+    }
+
+    for (index = 0; index < MPREFETCH_SLOT_COUNT; index++) {
+        mprefetch_release(&(mprefetch_slots[index]));
+    }
+
+    mprefetch_initialized = false;
+}
+
+// Starts reading file at `path` into memory in background, unless it's
+// already there.
+int mprefetch_start(const char* path)
+{
+    MusicPrefetch* prefetch;
+    int index;
+
+    if (!mprefetch_initialized) {
+        return -1;
+    }
+
+    if (strlen(path) >= MAX_PATH) {
+        return -1;
+    }
+
+    prefetch = mprefetch_find(path);
+    if (prefetch != NULL) {
+        if (atomic_get(&(prefetch->state)) == MPREFETCH_STATE_FAILED && prefetch->refs == 0) {
+            // Try again, the file might have appeared since then (CD
+            // inserted).
+            mprefetch_release(prefetch);
+        } else {
+            prefetch->stamp = ++mprefetch_clock;
+            return 0;
+        }
+    } else {
+        // Reuse least recently used slot which is not being read from.
+        for (index = 0; index < MPREFETCH_SLOT_COUNT; index++) {
+            MusicPrefetch* candidate = &(mprefetch_slots[index]);
+            if (candidate->refs == 0) {
+                if (prefetch == NULL || candidate->stamp < prefetch->stamp) {
+                    prefetch = candidate;
+                }
+            }
+        }
+
+        if (prefetch == NULL) {
+            return -1;
+        }
+
+        mprefetch_release(prefetch);
+    }
+
+    strcpy(prefetch->path, path);
+    prefetch->stamp = ++mprefetch_clock;
+
+    prefetch->thread = thread_create(mprefetch_thread_proc, prefetch);
+    if (prefetch->thread == NULL) {
+        prefetch->path[0] = '\0';
+        return -1;
+    }
+
+    return 0;
+}
+
+static MusicPrefetch* mprefetch_find(const char* path)
+{
+    int index;
+
+    for (index = 0; index < MPREFETCH_SLOT_COUNT; index++) {
+        MusicPrefetch* prefetch = &(mprefetch_slots[index]);
+        if (prefetch->path[0] != '\0' && stricmp(prefetch->path, path) == 0) {
+            return prefetch;
+        }
+    }
+
+    return NULL;
+}
+
+// Stops prefetch thread (if any) and frees loaded data. Slot must not have
+// open files.
+static void mprefetch_release(MusicPrefetch* prefetch)
+{
+    assert(prefetch->refs == 0);
+
+    if (prefetch->thread != NULL) {
+        atomic_set(&(prefetch->cancel), 1);
+        thread_join(prefetch->thread);
+    }
+
+    if (prefetch->data != NULL) {
+        free(prefetch->data);
+    }
+
+    memset(prefetch, 0, sizeof(*prefetch));
+}
+
+static int mprefetch_thread_proc(void* data)
+{
+    MusicPrefetch* prefetch = (MusicPrefetch*)data;
+    FILE* stream;
+    long size;
+    int loaded;
+    size_t bytesToRead;
+    size_t bytesRead;
+
+    stream = fopen(prefetch->path, "rb");
+    if (stream == NULL) {
+        atomic_set(&(prefetch->state), MPREFETCH_STATE_FAILED);
+        return -1;
+    }
+
+    fseek(stream, 0, SEEK_END);
+    size = ftell(stream);
+    fseek(stream, 0, SEEK_SET);
+
+    if (size <= 0) {
+        fclose(stream);
+        atomic_set(&(prefetch->state), MPREFETCH_STATE_FAILED);
+        return -1;
+    }
+
+    prefetch->data = (unsigned char*)malloc(size);
+    if (prefetch->data == NULL) {
+        fclose(stream);
+        atomic_set(&(prefetch->state), MPREFETCH_STATE_FAILED);
+        return -1;
+    }
+
+    prefetch->size = size;
+
+    loaded = 0;
+    while (loaded < size && !atomic_get(&(prefetch->cancel))) {
+        bytesToRead = size - loaded;
+        if (bytesToRead > MPREFETCH_BLOCK_SIZE) {
+            bytesToRead = MPREFETCH_BLOCK_SIZE;
+        }
+
+        bytesRead = fread(prefetch->data + loaded, 1, bytesToRead, stream);
+        if (bytesRead == 0) {
+            break;
+        }
+
+        loaded += bytesRead;
+        atomic_set(&(prefetch->loaded), loaded);
+    }
+
+    fclose(stream);
+
+    atomic_set(&(prefetch->state), loaded == size ? MPREFETCH_STATE_DONE : MPREFETCH_STATE_FAILED);
+
+    return 0;
+}
+
+// Waits until first `size` bytes are loaded or until prefetch thread stops,
+// whichever comes first. Returns number of loaded bytes.
+static int mprefetch_wait(MusicPrefetch* prefetch, int size)
+{
+    int loaded;
+
+    while (true) {
+        loaded = atomic_get(&(prefetch->loaded));
+        if (loaded >= size) {
+            break;
+        }
+
+        if (atomic_get(&(prefetch->state)) != MPREFETCH_STATE_LOADING) {
+            // Thread might have loaded last block in between.
+            loaded = atomic_get(&(prefetch->loaded));
+            break;
+        }
+
+        thread_sleep(1);
+    }
+
+    return loaded;
+}
+
+// Prefetched files are expected to be compressed, see
+// `gsound_compressed_query`.
+int mprefetch_open(const char* fname, int flags)
+{
+    MusicPrefetchFile* file;
+    MusicPrefetch* prefetch;
+    int index;
+
+    if (!mprefetch_initialized) {
+        return -1;
+    }
+
+    for (index = 0; index < MPREFETCH_FILE_COUNT; index++) {
+        if (!mprefetch_files[index].used) {
+            break;
+        }
+    }
+
+    if (index == MPREFETCH_FILE_COUNT) {
+        return -1;
+    }
+
+    file = &(mprefetch_files[index]);
+
+    prefetch = mprefetch_find(fname);
+
+    // Fall back to reading from disk if file could not be prefetched.
+    if (prefetch != NULL && mprefetch_wait(prefetch, 1) < 1) {
+        prefetch = NULL;
+    }
+
+    if (prefetch == NULL) {
+        file->audiofHandle = audiofOpen(fname, flags);
+        if (file->audiofHandle == -1) {
+            return -1;
+        }
+
+        file->used = true;
+        file->prefetch = NULL;
+
+        return index + 1;
+    }
+
+    file->prefetch = prefetch;
+    file->dataPosition = 0;
+    file->position = 0;
+
+    file->decoder = Create_AudioDecoder(mprefetch_ad_reader, file, &(file->channels), &(file->sampleRate), &(file->fileSize));
+    if (file->decoder == NULL) {
+        memset(file, 0, sizeof(*file));
+        return -1;
+    }
+
+    file->fileSize *= 2;
+    AudioDecoder_EnableSeek(file->decoder, mprefetch_ad_seek);
+
+    file->used = true;
+    prefetch->refs++;
+    prefetch->stamp = ++mprefetch_clock;
+
+    return index + 1;
+}
+
+int mprefetch_close(int handle)
+{
+    MusicPrefetchFile* file;
+
+    if (!mprefetch_handle_is_legal(handle)) {
+        return -1;
+    }
+
+    file = &(mprefetch_files[handle - 1]);
+    if (file->prefetch == NULL) {
+        audiofCloseFile(file->audiofHandle);
+    } else {
+        if (file->decoder != NULL) {
+            AudioDecoder_Close(file->decoder);
+        }
+        file->prefetch->refs--;
+    }
+
+    memset(file, 0, sizeof(*file));
+
+    return 0;
+}
+
+int mprefetch_read(int handle, void* buf, unsigned int size)
+{
+    MusicPrefetchFile* file;
+    int bytesRead;
+
+    if (!mprefetch_handle_is_legal(handle)) {
+        return -1;
+    }
+
+    file = &(mprefetch_files[handle - 1]);
+    if (file->prefetch == NULL) {
+        return audiofRead(file->audiofHandle, buf, size);
+    }
+
+    if (file->decoder == NULL) {
+        return 0;
+    }
+
+    bytesRead = AudioDecoder_Read(file->decoder, buf, size);
+    file->position += bytesRead;
+
+    return bytesRead;
+}
+
+int mprefetch_write(int handle, const void* buf, unsigned int size)
+{
+    return -1;
+}
+
+long mprefetch_seek(int handle, long offset, int origin)
+{
+    MusicPrefetchFile* file;
+    int position;
+
+    if (!mprefetch_handle_is_legal(handle)) {
+        return -1;
+    }
+
+    file = &(mprefetch_files[handle - 1]);
+    if (file->prefetch == NULL) {
+        return audiofSeek(file->audiofHandle, offset, origin);
+    }
+
+    switch (origin) {
+    case SEEK_SET:
+        position = offset;
+        break;
+    case SEEK_CUR:
+        position = file->position + offset;
+        break;
+    case SEEK_END:
+        position = file->fileSize + offset;
+        break;
+    default:
+        return -1;
+    }
+
+    // Decoder positions are in 16-bit samples.
+    if (!AudioDecoder_Seek(file->decoder, position / 2)) {
+        // Decoder cannot resume from its seek index, start over.
+        AudioDecoder_Close(file->decoder);
+        file->dataPosition = 0;
+        file->decoder = Create_AudioDecoder(mprefetch_ad_reader, file, &(file->channels), &(file->sampleRate), &(file->fileSize));
+        file->fileSize *= 2;
+
+        if (file->decoder == NULL) {
+            file->position = file->fileSize;
+            return -1;
+        }
+
+        AudioDecoder_EnableSeek(file->decoder, mprefetch_ad_seek);
+        AudioDecoder_Seek(file->decoder, position / 2);
+    }
+
+    file->position = AudioDecoder_Tell(file->decoder) * 2;
+
+    return file->position;
+}
+
+long mprefetch_tell(int handle)
+{
+    MusicPrefetchFile* file;
+
+    if (!mprefetch_handle_is_legal(handle)) {
+        return -1;
+    }
+
+    file = &(mprefetch_files[handle - 1]);
+    if (file->prefetch == NULL) {
+        return audiofTell(file->audiofHandle);
+    }
+
+    return file->position;
+}
+
+long mprefetch_file_size(int handle)
+{
+    MusicPrefetchFile* file;
+
+    if (!mprefetch_handle_is_legal(handle)) {
+        return -1;
+    }
+
+    file = &(mprefetch_files[handle - 1]);
+    if (file->prefetch == NULL) {
+        return audiofFileSize(file->audiofHandle);
+    }
+
+    return file->fileSize;
+}
+
+static bool mprefetch_handle_is_legal(int handle)
+{
+    if (handle < 1 || handle > MPREFETCH_FILE_COUNT) {
+        return false;
+    }
+
+    return mprefetch_files[handle - 1].used;
+}
+
+static int mprefetch_ad_reader(void* stream, void* buf, unsigned int size)
+{
+    MusicPrefetchFile* file = (MusicPrefetchFile*)stream;
+    int available;
+
+    if (size == 0) {
+        return 0;
+    }
+
+    available = mprefetch_wait(file->prefetch, file->dataPosition + size) - file->dataPosition;
+    if (available <= 0) {
+        return 0;
+    }
+
+    if (size > (unsigned int)available) {
+        size = available;
+    }
+
+    memcpy(buf, file->prefetch->data + file->dataPosition, size);
+    file->dataPosition += size;
+
+    return size;
+}
+
+static int mprefetch_ad_seek(void* stream, int offset)
+{
+    MusicPrefetchFile* file = (MusicPrefetchFile*)stream;
+
+    if (offset < 0) {
+        return -1;
+    }
+
+    file->dataPosition = offset;
+
+    return 0;
+}
@@ -0,0 +1,15 @@
+#ifndef FALLOUT_GAME_MPREFETCH_H_
+#define FALLOUT_GAME_MPREFETCH_H_
+
+int mprefetch_init();
+void mprefetch_exit();
+int mprefetch_start(const char* path);
+int mprefetch_open(const char* fname, int flags);
+int mprefetch_close(int handle);
+int mprefetch_read(int handle, void* buf, unsigned int size);
+int mprefetch_write(int handle, const void* buf, unsigned int size);
+long mprefetch_seek(int handle, long offset, int origin);
+long mprefetch_tell(int handle);
+long mprefetch_file_size(int handle);
+
+#endif /* FALLOUT_GAME_MPREFETCH_H_ */
@@ -5,6 +5,8 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "plib/gnw/profile.h"
+
 // IPC state
 static bool mp_active = false;
 static MultiplayerSession mp_session = {0};
@@ -157,7 +159,12 @@ void mp_send_action(const PlayerAction* action) {
 
 bool mp_poll_message(void) {
     if (!mp_active) return false;
-    return receive_messages();
+
+    profile_begin(PROFILE_ZONE_NETWORK);
+    bool received = receive_messages();
+    profile_end(PROFILE_ZONE_NETWORK);
+
+    return received;
 }
 
 const char* mp_get_current_turn_player(void) {
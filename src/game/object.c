@@ -10,6 +10,7 @@
 #include "game/game.h"
 #include "game/gconfig.h"
 #include "game/gmouse.h"
+#include "game/gsound.h"
 #include "game/item.h"
 #include "game/light.h"
 #include "game/map.h"
@@ -27,6 +28,11 @@
 #include "plib/gnw/memory.h"
 #include "plib/gnw/svga.h"
 
+// Steps performed by `obj_render_pre_roof_ex` for every visible object.
+#define OBJ_RENDER_DRAW 0x01
+#define OBJ_RENDER_OUTLINES 0x02
+#define OBJ_RENDER_PIN 0x04
+
 static int obj_read_obj(Object* obj, DB_FILE* stream);
 static int obj_load_func(DB_FILE* stream);
 static void obj_fix_combat_cid_for_dude();
@@ -56,8 +62,33 @@ static int obj_connect_to_tile(ObjectListNode* node, int tile_index, int elev, R
 static int obj_adjust_light(Object* obj, int a2, Rect* rect);
 static void obj_render_outline(Object* object, Rect* rect);
 static void obj_render_object(Object* object, Rect* rect, int light);
+static void obj_render_pre_roof_ex(Rect* rect, int elevation, ObjectListNode** renderList, int flags);
+static void obj_render_visit(Object* object, Rect* rect, int light, int flags);
 static int obj_preload_sort(const void* a1, const void* a2);
 
+// Layout of object in map and save files, followed by its update data (see
+// `proto_read_protoUpdateData`).
+static const DBRecordField obj_record_fields[] = {
+    DB_RECORD_INT(Object, id),
+    DB_RECORD_INT(Object, tile),
+    DB_RECORD_INT(Object, x),
+    DB_RECORD_INT(Object, y),
+    DB_RECORD_INT(Object, sx),
+    DB_RECORD_INT(Object, sy),
+    DB_RECORD_INT(Object, frame),
+    DB_RECORD_INT(Object, rotation),
+    DB_RECORD_INT(Object, fid),
+    DB_RECORD_INT(Object, flags),
+    DB_RECORD_INT(Object, elevation),
+    DB_RECORD_INT(Object, pid),
+    DB_RECORD_INT(Object, cid),
+    DB_RECORD_INT(Object, lightDistance),
+    DB_RECORD_INT(Object, lightIntensity),
+    DB_RECORD_INT(Object, outline),
+    DB_RECORD_INT(Object, sid),
+    DB_RECORD_INT(Object, field_80),
+};
+
 // 0x505B70
 static bool objInitialized = false;
 
@@ -389,26 +420,8 @@ void obj_exit()
 // 0x47A904
 static int obj_read_obj(Object* obj, DB_FILE* stream)
 {
-    int field_74;
-
-    if (db_freadInt(stream, &(obj->id)) == -1) return -1;
-    if (db_freadInt(stream, &(obj->tile)) == -1) return -1;
-    if (db_freadInt(stream, &(obj->x)) == -1) return -1;
-    if (db_freadInt(stream, &(obj->y)) == -1) return -1;
-    if (db_freadInt(stream, &(obj->sx)) == -1) return -1;
-    if (db_freadInt(stream, &(obj->sy)) == -1) return -1;
-    if (db_freadInt(stream, &(obj->frame)) == -1) return -1;
-    if (db_freadInt(stream, &(obj->rotation)) == -1) return -1;
-    if (db_freadInt(stream, &(obj->fid)) == -1) return -1;
-    if (db_freadInt(stream, &(obj->flags)) == -1) return -1;
-    if (db_freadInt(stream, &(obj->elevation)) == -1) return -1;
-    if (db_freadInt(stream, &(obj->pid)) == -1) return -1;
-    if (db_freadInt(stream, &(obj->cid)) == -1) return -1;
-    if (db_freadInt(stream, &(obj->lightDistance)) == -1) return -1;
-    if (db_freadInt(stream, &(obj->lightIntensity)) == -1) return -1;
-    if (db_freadInt(stream, &field_74) == -1) return -1;
-    if (db_freadInt(stream, &(obj->sid)) == -1) return -1;
-    if (db_freadInt(stream, &(obj->field_80)) == -1) return -1;
+    // NOTE: Outline in file is ignored, it's reset below.
+    if (db_freadRecord(stream, obj, obj_record_fields, DB_RECORD_LENGTH(obj_record_fields)) == -1) return -1;
 
     obj->outline = 0;
     obj->owner = NULL;
@@ -643,24 +656,7 @@ static void object_fix_weapon_ammo(Object* obj)
 // 0x47B000
 static int obj_write_obj(Object* obj, DB_FILE* stream)
 {
-    if (db_fwriteInt(stream, obj->id) == -1) return -1;
-    if (db_fwriteInt(stream, obj->tile) == -1) return -1;
-    if (db_fwriteInt(stream, obj->x) == -1) return -1;
-    if (db_fwriteInt(stream, obj->y) == -1) return -1;
-    if (db_fwriteInt(stream, obj->sx) == -1) return -1;
-    if (db_fwriteInt(stream, obj->sy) == -1) return -1;
-    if (db_fwriteInt(stream, obj->frame) == -1) return -1;
-    if (db_fwriteInt(stream, obj->rotation) == -1) return -1;
-    if (db_fwriteInt(stream, obj->fid) == -1) return -1;
-    if (db_fwriteInt(stream, obj->flags) == -1) return -1;
-    if (db_fwriteInt(stream, obj->elevation) == -1) return -1;
-    if (db_fwriteInt(stream, obj->pid) == -1) return -1;
-    if (db_fwriteInt(stream, obj->cid) == -1) return -1;
-    if (db_fwriteInt(stream, obj->lightDistance) == -1) return -1;
-    if (db_fwriteInt(stream, obj->lightIntensity) == -1) return -1;
-    if (db_fwriteInt(stream, obj->outline) == -1) return -1;
-    if (db_fwriteInt(stream, obj->sid) == -1) return -1;
-    if (db_fwriteInt(stream, obj->field_80) == -1) return -1;
+    if (db_fwriteRecord(stream, obj, obj_record_fields, DB_RECORD_LENGTH(obj_record_fields)) == -1) return -1;
     if (proto_write_protoUpdateData(obj, stream) == -1) return -1;
 
     return 0;
@@ -758,6 +754,40 @@ int obj_save(DB_FILE* stream)
 
 // 0x47B350
 void obj_render_pre_roof(Rect* rect, int elevation)
+{
+    obj_render_pre_roof_ex(rect, elevation, renderTable, OBJ_RENDER_DRAW | OBJ_RENDER_OUTLINES);
+}
+
+// Same as `obj_render_pre_roof`, but uses caller's render list and does not
+// collect outlined objects. Apart from screen position of drawn objects (which
+// every caller computes the same) it does not modify object module state, so
+// it can be called for disjoint rects from several threads at once, provided
+// art is pinned (see `obj_render_prepare`).
+void obj_render_pre_roof_list(Rect* rect, int elevation, ObjectListNode** renderList)
+{
+    obj_render_pre_roof_ex(rect, elevation, renderList, OBJ_RENDER_DRAW);
+}
+
+// Walks objects which `obj_render_pre_roof` would draw in `rect` without
+// drawing them. Collects outlined objects for the following
+// `obj_render_post_roof` and pins art and protos needed to render them.
+void obj_render_prepare(Rect* rect, int elevation)
+{
+    obj_render_pre_roof_ex(rect, elevation, renderTable, OBJ_RENDER_OUTLINES | OBJ_RENDER_PIN);
+
+    if (obj_egg != NULL) {
+        art_pin(obj_egg->fid);
+    }
+}
+
+// Returns required number of entries in render list passed to
+// `obj_render_pre_roof_list`.
+int obj_render_table_size()
+{
+    return updateHexArea;
+}
+
+static void obj_render_pre_roof_ex(Rect* rect, int elevation, ObjectListNode** renderList, int flags)
 {
     if (!objInitialized) {
         return;
@@ -781,7 +811,9 @@ void obj_render_pre_roof(Rect* rect, int elevation)
     int* orders = orderTable[parity];
     int* offsets = offsetTable[parity];
 
-    outlineCount = 0;
+    if ((flags & OBJ_RENDER_OUTLINES) != 0) {
+        outlineCount = 0;
+    }
 
     int renderCount = 0;
     for (int i = 0; i < updateHexArea; i++) {
@@ -811,13 +843,7 @@ void obj_render_pre_roof(Rect* rect, int elevation)
                     }
 
                     if ((objectListNode->obj->flags & OBJECT_HIDDEN) == 0) {
-                        obj_render_object(objectListNode->obj, &updatedRect, light);
-
-                        if ((objectListNode->obj->outline & OUTLINE_TYPE_MASK) != 0) {
-                            if ((objectListNode->obj->outline & OUTLINE_DISABLED) == 0 && outlineCount < 100) {
-                                outlinedObjects[outlineCount++] = objectListNode->obj;
-                            }
-                        }
+                        obj_render_visit(objectListNode->obj, &updatedRect, light, flags);
                     }
                 }
 
@@ -825,7 +851,7 @@ void obj_render_pre_roof(Rect* rect, int elevation)
             }
 
             if (objectListNode != NULL) {
-                renderTable[renderCount++] = objectListNode;
+                renderList[renderCount++] = objectListNode;
             }
         }
     }
@@ -833,7 +859,7 @@ void obj_render_pre_roof(Rect* rect, int elevation)
     for (int i = 0; i < renderCount; i++) {
         int light;
 
-        ObjectListNode* objectListNode = renderTable[i];
+        ObjectListNode* objectListNode = renderList[i];
         if (objectListNode != NULL) {
             // NOTE: calls light_get_tile two times, probably result of min/max macro
             int tileLight = light_get_tile(elevation, objectListNode->obj->tile);
@@ -852,13 +878,7 @@ void obj_render_pre_roof(Rect* rect, int elevation)
 
             if (elevation == objectListNode->obj->elevation) {
                 if ((objectListNode->obj->flags & OBJECT_HIDDEN) == 0) {
-                    obj_render_object(object, &updatedRect, light);
-
-                    if ((objectListNode->obj->outline & OUTLINE_TYPE_MASK) != 0) {
-                        if ((objectListNode->obj->outline & OUTLINE_DISABLED) == 0 && outlineCount < 100) {
-                            outlinedObjects[outlineCount++] = objectListNode->obj;
-                        }
-                    }
+                    obj_render_visit(object, &updatedRect, light, flags);
                 }
             }
 
@@ -867,6 +887,31 @@ void obj_render_pre_roof(Rect* rect, int elevation)
     }
 }
 
+static void obj_render_visit(Object* object, Rect* rect, int light, int flags)
+{
+    if ((flags & OBJ_RENDER_DRAW) != 0) {
+        obj_render_object(object, rect, light);
+    }
+
+    if ((flags & OBJ_RENDER_PIN) != 0) {
+        art_pin(object->fid);
+
+        // See `obj_render_object`, it looks up protos of scenery and walls.
+        if (FID_TYPE(object->fid) == OBJ_TYPE_SCENERY || FID_TYPE(object->fid) == OBJ_TYPE_WALL) {
+            Proto* proto;
+            proto_ptr(object->pid, &proto);
+        }
+    }
+
+    if ((flags & OBJ_RENDER_OUTLINES) != 0) {
+        if ((object->outline & OUTLINE_TYPE_MASK) != 0) {
+            if ((object->outline & OUTLINE_DISABLED) == 0 && outlineCount < 100) {
+                outlinedObjects[outlineCount++] = object;
+            }
+        }
+    }
+}
+
 // 0x47B5EC
 void obj_render_post_roof(Rect* rect, int elevation)
 {
@@ -3464,6 +3509,8 @@ static void obj_destroy_object(Object** objectPtr)
         return;
     }
 
+    gsound_sfx_remove_object_references(*objectPtr);
+
     mem_free(*objectPtr);
 
     *objectPtr = NULL;
@@ -29,6 +29,9 @@ void obj_exit();
 int obj_load(DB_FILE* stream);
 int obj_save(DB_FILE* stream);
 void obj_render_pre_roof(Rect* rect, int elevation);
+void obj_render_pre_roof_list(Rect* rect, int elevation, ObjectListNode** renderList);
+void obj_render_prepare(Rect* rect, int elevation);
+int obj_render_table_size();
 void obj_render_post_roof(Rect* rect, int elevation);
 int obj_new(Object** objectPtr, int fid, int pid);
 int obj_pid_new(Object** objectPtr, int pid);
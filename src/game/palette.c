@@ -1,13 +1,29 @@
 #include "game/palette.h"
 
+#include <limits.h>
 #include <string.h>
 
 #include "game/cycle.h"
 #include "game/gsound.h"
 #include "plib/color/color.h"
-#include "plib/gnw/debug.h"
 #include "plib/gnw/input.h"
 
+// Duration of `palette_fade_to` in milliseconds.
+//
+// NOTE: The original calibrated number of fade steps on startup so that fade
+// takes about 700 ms. Fades are now driven by elapsed time.
+#define PALETTE_FADE_DURATION 700U
+
+#define PALETTE_MAX_TRACKS 8
+
+typedef struct PaletteTrack {
+    PaletteTrackProc* proc;
+    int start;
+    int end;
+} PaletteTrack;
+
+static void palette_fade_step(unsigned int time);
+
 // 0x661F20
 static unsigned char current_palette[256 * 3];
 
@@ -17,8 +33,24 @@ unsigned char white_palette[256 * 3];
 // 0x662520
 unsigned char black_palette[256 * 3];
 
-// 0x662820
-static int fade_steps;
+// Palette on screen when the active fade was started.
+static unsigned char fade_from[256 * 3];
+
+// Palette the active fade ends on.
+static unsigned char fade_target[256 * 3];
+
+static bool fade_active = false;
+static unsigned int fade_start_time;
+static unsigned int fade_duration;
+
+// Elapsed time of the last evaluated fade frame, used to skip palette sets
+// when nothing has changed.
+static unsigned int fade_last_elapsed;
+
+// Animations updating palette ranges every frame (color cycling). Tracks are
+// not evaluated while fade is active.
+static PaletteTrack tracks[PALETTE_MAX_TRACKS];
+static int tracks_length = 0;
 
 // 0x485090
 void palette_init()
@@ -27,64 +59,204 @@ void palette_init()
     memset(white_palette, 63, 256 * 3);
     memcpy(current_palette, cmap, 256 * 3);
 
-    unsigned int tick = get_time();
-    if (gsound_background_is_enabled() || gsound_speech_is_enabled()) {
-        colorSetFadeBkFunc(soundUpdate);
-    }
-
-    fadeSystemPalette(current_palette, current_palette, 60);
+    setSystemPalette(current_palette);
 
-    colorSetFadeBkFunc(NULL);
+    fade_active = false;
+    tracks_length = 0;
 
-    unsigned int diff = elapsed_time(tick);
-
-    // NOTE: Modern CPUs are super fast, so it's possible that less than 10ms
-    // (the resolution of underlying GetTicks) is needed to fade between two
-    // palettes, which leads to zero diff, which in turn leads to unpredictable
-    // number of fade steps. To fix that the fallback value is used (46). This
-    // value is commonly seen when running the game in 1 core VM.
-    if (diff == 0) {
-        diff = 46;
-    }
-
-    fade_steps = (int)(60.0 / (diff * (1.0 / 700.0)));
-
-    debug_printf("\nFade time is %u\nFade steps are %d\n", diff, fade_steps);
+    add_bk_process(palette_update);
 }
 
 // 0x485160
 void palette_reset()
 {
+    fade_active = false;
 }
 
 // 0x485160
 void palette_exit()
 {
+    remove_bk_process(palette_update);
+
+    fade_active = false;
+    tracks_length = 0;
 }
 
+// Fades to `palette` and returns when fade is complete. Sound and keyboard
+// buffering keep running while waiting.
+//
 // 0x485164
 void palette_fade_to(unsigned char* palette)
 {
+    bool soundEnabled;
     bool colorCycleWasEnabled = cycle_is_enabled();
     cycle_disable();
 
-    if (gsound_background_is_enabled() || gsound_speech_is_enabled()) {
-        colorSetFadeBkFunc(soundUpdate);
-    }
+    soundEnabled = gsound_background_is_enabled() || gsound_speech_is_enabled();
+
+    palette_fade_start(palette, PALETTE_FADE_DURATION);
 
-    fadeSystemPalette(current_palette, palette, fade_steps);
-    colorSetFadeBkFunc(NULL);
+    while (fade_active) {
+        palette_fade_step(get_time());
+        GNW95_process_message();
 
-    memcpy(current_palette, palette, 768);
+        if (soundEnabled) {
+            soundUpdate();
+        }
+    }
 
     if (colorCycleWasEnabled) {
         cycle_enable();
     }
 }
 
+// Starts fade from palette which is on screen to `palette` and returns
+// immediately. Fade is advanced once per frame by `palette_update`.
+void palette_fade_start(unsigned char* palette, unsigned int duration)
+{
+    memcpy(fade_from, getSystemPalette(), sizeof(fade_from));
+    memcpy(fade_target, palette, sizeof(fade_target));
+
+    fade_start_time = get_time();
+    fade_duration = duration;
+    fade_last_elapsed = UINT_MAX;
+    fade_active = true;
+
+    if (duration == 0) {
+        palette_fade_step(fade_start_time);
+    }
+}
+
+// Non-blocking counterpart of `palette_fade_to` for fade-ins followed by
+// the input loop.
+void palette_fade_in(unsigned char* palette)
+{
+    palette_fade_start(palette, PALETTE_FADE_DURATION);
+}
+
+bool palette_fade_is_active()
+{
+    return fade_active;
+}
+
+// Completes active fade immediately.
+void palette_fade_finish()
+{
+    if (fade_active) {
+        fade_duration = 0;
+        palette_fade_step(get_time());
+    }
+}
+
+// Evaluates active fade or palette tracks. Runs as a background process, so
+// it is called once per pass of the input loop.
+void palette_update()
+{
+    unsigned int time = get_time();
+    unsigned char* palette;
+    int start = 256;
+    int end = -1;
+
+    if (fade_active) {
+        palette_fade_step(time);
+        return;
+    }
+
+    if (tracks_length == 0) {
+        return;
+    }
+
+    palette = getSystemPalette();
+
+    for (int index = 0; index < tracks_length; index++) {
+        PaletteTrack* track = &(tracks[index]);
+        if (track->proc(palette, time)) {
+            if (track->start < start) {
+                start = track->start;
+            }
+
+            if (track->end > end) {
+                end = track->end;
+            }
+        }
+    }
+
+    if (start <= end) {
+        palette_set_entries(palette + start * 3, start, end);
+    }
+}
+
+// Registers animation of palette entries [start, end]. Track proc modifies
+// entries of the palette it is given in place and returns `true` if any of
+// them have changed.
+int palette_add_track(PaletteTrackProc* proc, int start, int end)
+{
+    for (int index = 0; index < tracks_length; index++) {
+        if (tracks[index].proc == proc) {
+            tracks[index].start = start;
+            tracks[index].end = end;
+            return 0;
+        }
+    }
+
+    if (tracks_length == PALETTE_MAX_TRACKS) {
+        return -1;
+    }
+
+    tracks[tracks_length].proc = proc;
+    tracks[tracks_length].start = start;
+    tracks[tracks_length].end = end;
+    tracks_length++;
+
+    return 0;
+}
+
+void palette_remove_track(PaletteTrackProc* proc)
+{
+    for (int index = 0; index < tracks_length; index++) {
+        if (tracks[index].proc == proc) {
+            memmove(&(tracks[index]), &(tracks[index + 1]), sizeof(*tracks) * (tracks_length - index - 1));
+            tracks_length--;
+            return;
+        }
+    }
+}
+
+static void palette_fade_step(unsigned int time)
+{
+    unsigned char palette[256 * 3];
+    unsigned int elapsed;
+
+    if (!fade_active) {
+        return;
+    }
+
+    elapsed = elapsed_tocks(time, fade_start_time);
+    if (elapsed >= fade_duration) {
+        fade_active = false;
+        memcpy(current_palette, fade_target, sizeof(current_palette));
+        setSystemPalette(current_palette);
+        return;
+    }
+
+    if (elapsed == fade_last_elapsed) {
+        return;
+    }
+
+    fade_last_elapsed = elapsed;
+
+    for (int index = 0; index < 768; index++) {
+        palette[index] = fade_from[index] - (fade_from[index] - fade_target[index]) * (int)elapsed / (int)fade_duration;
+    }
+
+    setSystemPalette(palette);
+}
+
 // 0x4851D8
 void palette_set_to(unsigned char* palette)
 {
+    fade_active = false;
+
     memcpy(current_palette, palette, sizeof(current_palette));
     setSystemPalette(palette);
 }
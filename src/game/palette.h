@@ -1,6 +1,10 @@
 #ifndef FALLOUT_GAME_PALETTE_H_
 #define FALLOUT_GAME_PALETTE_H_
 
+#include <stdbool.h>
+
+typedef bool(PaletteTrackProc)(unsigned char* palette, unsigned int time);
+
 extern unsigned char white_palette[256 * 3];
 extern unsigned char black_palette[256 * 3];
 
@@ -8,6 +12,13 @@ void palette_init();
 void palette_reset();
 void palette_exit();
 void palette_fade_to(unsigned char* palette);
+void palette_fade_start(unsigned char* palette, unsigned int duration);
+void palette_fade_in(unsigned char* palette);
+bool palette_fade_is_active();
+void palette_fade_finish();
+void palette_update();
+int palette_add_track(PaletteTrackProc* proc, int start, int end);
+void palette_remove_track(PaletteTrackProc* proc);
 void palette_set_to(unsigned char* palette);
 void palette_set_entries(unsigned char* palette, int start, int end);
 
@@ -16,6 +16,7 @@
 #include "game/gconfig.h"
 #include "game/gmovie.h"
 #include "game/intface.h"
+#include "game/lstfile.h"
 #include "game/map.h"
 #include "game/object.h"
 #include "game/perk.h"
@@ -36,6 +37,10 @@ static int proto_write_item_data(ItemProtoData* item_data, int type, DB_FILE* st
 static int proto_write_scenery_data(SceneryProtoData* scenery_data, int type, DB_FILE* stream);
 static int proto_write_protoSubNode(Proto* buf, DB_FILE* stream);
 static int proto_new_id(int a1);
+static Proto* proto_index_get(int pid);
+static void proto_index_set(Proto* proto);
+static int proto_index_count(int type);
+static void proto_preload_type(int type);
 
 // 0x50734C
 char cd_path_base[MAX_PATH];
@@ -55,6 +60,23 @@ static ProtoList protolists[11] = {
     { 0, 0, 0, 0 },
 };
 
+// Parsed .lst files of types 0-5.
+static LstFile proto_lsts[6];
+
+// Loaded protos of types 0-5 directly indexed by `pid & 0xFFFFFF`. Every
+// indexed proto also lives in its `protolists` extent, which owns it.
+static Proto** proto_index[6];
+
+static int proto_index_capacity[6];
+
+// Number of non-NULL entries in `proto_index`.
+static int proto_index_length[6];
+
+// When set, first lookup of a missing proto loads every proto of its type.
+static bool proto_preload;
+
+static bool proto_preloaded[6];
+
 // 0x507500
 static const size_t proto_sizes[11] = {
     sizeof(ItemProto), // 0x84
@@ -70,6 +92,93 @@ static const size_t proto_sizes[11] = {
     0,
 };
 
+// Common part of object update data in map and save files. For critters
+// flags are followed by combat data, for other objects - by type specific
+// fields.
+static const DBRecordField proto_update_fields[] = {
+    DB_RECORD_INT(Object, data.inventory.length),
+    DB_RECORD_INT(Object, data.inventory.capacity),
+    // TODO: See `proto_write_protoUpdateData`.
+    DB_RECORD_INT(Object, data.inventory.items),
+    DB_RECORD_INT(Object, data.flags),
+};
+
+static const DBRecordField proto_combat_data_fields[] = {
+    DB_RECORD_INT(CritterCombatData, damageLastTurn),
+    DB_RECORD_INT(CritterCombatData, maneuver),
+    DB_RECORD_INT(CritterCombatData, ap),
+    DB_RECORD_INT(CritterCombatData, results),
+    DB_RECORD_INT(CritterCombatData, aiPacket),
+    DB_RECORD_INT(CritterCombatData, team),
+    DB_RECORD_INT(CritterCombatData, whoHitMeCid),
+};
+
+// Layouts of .pro files after pid, message id and fid.
+static const DBRecordField proto_item_fields[] = {
+    DB_RECORD_INT(ItemProto, lightDistance),
+    DB_RECORD_INT(ItemProto, lightIntensity),
+    DB_RECORD_INT(ItemProto, flags),
+    DB_RECORD_INT(ItemProto, extendedFlags),
+    DB_RECORD_INT(ItemProto, sid),
+    DB_RECORD_INT(ItemProto, type),
+    DB_RECORD_INT(ItemProto, material),
+    DB_RECORD_INT(ItemProto, size),
+    DB_RECORD_INT(ItemProto, weight),
+    DB_RECORD_INT(ItemProto, cost),
+    DB_RECORD_INT(ItemProto, inventoryFid),
+    DB_RECORD_BYTE(ItemProto, field_80),
+};
+
+static const DBRecordField proto_critter_fields[] = {
+    DB_RECORD_INT(CritterProto, lightDistance),
+    DB_RECORD_INT(CritterProto, lightIntensity),
+    DB_RECORD_INT(CritterProto, flags),
+    DB_RECORD_INT(CritterProto, extendedFlags),
+    DB_RECORD_INT(CritterProto, sid),
+    DB_RECORD_INT(CritterProto, headFid),
+    DB_RECORD_INT(CritterProto, aiPacket),
+    DB_RECORD_INT(CritterProto, team),
+};
+
+static const DBRecordField proto_scenery_fields[] = {
+    DB_RECORD_INT(SceneryProto, lightDistance),
+    DB_RECORD_INT(SceneryProto, lightIntensity),
+    DB_RECORD_INT(SceneryProto, flags),
+    DB_RECORD_INT(SceneryProto, extendedFlags),
+    DB_RECORD_INT(SceneryProto, sid),
+    DB_RECORD_INT(SceneryProto, type),
+    DB_RECORD_INT(SceneryProto, material),
+    DB_RECORD_BYTE(SceneryProto, field_34),
+};
+
+static const DBRecordField proto_wall_fields[] = {
+    DB_RECORD_INT(WallProto, lightDistance),
+    DB_RECORD_INT(WallProto, lightIntensity),
+    DB_RECORD_INT(WallProto, flags),
+    DB_RECORD_INT(WallProto, extendedFlags),
+    DB_RECORD_INT(WallProto, sid),
+    DB_RECORD_INT(WallProto, material),
+};
+
+static const DBRecordField proto_tile_fields[] = {
+    DB_RECORD_INT(TileProto, flags),
+    DB_RECORD_INT(TileProto, extendedFlags),
+    DB_RECORD_INT(TileProto, sid),
+    DB_RECORD_INT(TileProto, material),
+};
+
+static const DBRecordField proto_misc_fields[] = {
+    DB_RECORD_INT(MiscProto, lightDistance),
+    DB_RECORD_INT(MiscProto, lightIntensity),
+    DB_RECORD_INT(MiscProto, flags),
+    DB_RECORD_INT(MiscProto, extendedFlags),
+};
+
+static const DBRecordField proto_weapon_fields[] = {
+    DB_RECORD_INTS(ProtoItemWeaponData, animationCode, 16),
+    DB_RECORD_BYTE(ProtoItemWeaponData, soundCode),
+};
+
 // 0x50752C
 static int protos_been_initialized = 0;
 
@@ -192,30 +301,19 @@ int proto_list_str(int pid, char* proto_path)
         return -1;
     }
 
-    char path[MAX_PATH];
-    proto_make_path(path, pid);
-    strcat(path, "\\");
-    strcat(path, art_dir(PID_TYPE(pid)));
-    strcat(path, ".lst");
-
-    DB_FILE* stream = db_fopen(path, "rt");
-
-    int i = 1;
-    char string[256];
-    while (db_fgets(string, sizeof(string), stream)) {
-        if (i == (pid & 0xFFFFFF)) {
-            break;
-        }
-
-        i++;
+    if (PID_TYPE(pid) >= 6) {
+        return -1;
     }
 
-    db_fclose(stream);
-
-    if (i != (pid & 0xFFFFFF)) {
+    const char* line = lst_get(&(proto_lsts[PID_TYPE(pid)]), (pid & 0xFFFFFF) - 1);
+    if (line == NULL) {
         return -1;
     }
 
+    char string[256];
+    strncpy(string, line, sizeof(string) - 1);
+    string[sizeof(string) - 1] = '\0';
+
     char* pch = strchr(string, ' ');
     if (pch != NULL) {
         *pch = '\0';
@@ -403,13 +501,7 @@ void clear_pupdate_data(Object* obj)
 // 0x48D4BC
 static int proto_read_CombatData(CritterCombatData* data, DB_FILE* stream)
 {
-    if (db_freadInt(stream, &(data->damageLastTurn)) == -1) return -1;
-    if (db_freadInt(stream, &(data->maneuver)) == -1) return -1;
-    if (db_freadInt(stream, &(data->ap)) == -1) return -1;
-    if (db_freadInt(stream, &(data->results)) == -1) return -1;
-    if (db_freadInt(stream, &(data->aiPacket)) == -1) return -1;
-    if (db_freadInt(stream, &(data->team)) == -1) return -1;
-    if (db_freadInt(stream, &(data->whoHitMeCid)) == -1) return -1;
+    if (db_freadRecord(stream, data, proto_combat_data_fields, DB_RECORD_LENGTH(proto_combat_data_fields)) == -1) return -1;
 
     return 0;
 }
@@ -417,13 +509,7 @@ static int proto_read_CombatData(CritterCombatData* data, DB_FILE* stream)
 // 0x48D544
 static int proto_write_CombatData(CritterCombatData* data, DB_FILE* stream)
 {
-    if (db_fwriteInt(stream, data->damageLastTurn) == -1) return -1;
-    if (db_fwriteInt(stream, data->maneuver) == -1) return -1;
-    if (db_fwriteInt(stream, data->ap) == -1) return -1;
-    if (db_fwriteInt(stream, data->results) == -1) return -1;
-    if (db_fwriteInt(stream, data->aiPacket) == -1) return -1;
-    if (db_fwriteInt(stream, data->team) == -1) return -1;
-    if (db_fwriteInt(stream, data->whoHitMeCid) == -1) return -1;
+    if (db_fwriteRecord(stream, data, proto_combat_data_fields, DB_RECORD_LENGTH(proto_combat_data_fields)) == -1) return -1;
 
     return 0;
 }
@@ -433,21 +519,13 @@ int proto_read_protoUpdateData(Object* obj, DB_FILE* stream)
 {
     Proto* proto;
 
-    Inventory* inventory = &(obj->data.inventory);
-    if (db_freadInt(stream, &(inventory->length)) == -1) return -1;
-    if (db_freadInt(stream, &(inventory->capacity)) == -1) return -1;
-    // TODO: See below.
-    if (db_freadInt(stream, (int*)&(inventory->items)) == -1) return -1;
+    // NOTE: Flags and critter's `field_0` share the same place.
+    if (db_freadRecord(stream, obj, proto_update_fields, DB_RECORD_LENGTH(proto_update_fields)) == -1) return -1;
 
     if (PID_TYPE(obj->pid) == OBJ_TYPE_CRITTER) {
-        if (db_freadInt(stream, &(obj->data.critter.field_0)) == -1) return -1;
         if (proto_read_CombatData(&(obj->data.critter.combat), stream) == -1) return -1;
-        if (db_freadInt(stream, &(obj->data.critter.hp)) == -1) return -1;
-        if (db_freadInt(stream, &(obj->data.critter.radiation)) == -1) return -1;
-        if (db_freadInt(stream, &(obj->data.critter.poison)) == -1) return -1;
+        if (db_freadIntCount(stream, &(obj->data.critter.hp), 3) == -1) return -1;
     } else {
-        if (db_freadInt(stream, &(obj->data.flags)) == -1) return -1;
-
         if (obj->data.flags == 0xCCCCCCCC) {
             debug_printf("\nNote: Reading pud: updated_flags was un-Set!");
             obj->data.flags = 0;
@@ -459,8 +537,7 @@ int proto_read_protoUpdateData(Object* obj, DB_FILE* stream)
 
             switch (proto->item.type) {
             case ITEM_TYPE_WEAPON:
-                if (db_freadInt(stream, &(obj->data.item.weapon.ammoQuantity)) == -1) return -1;
-                if (db_freadInt(stream, &(obj->data.item.weapon.ammoTypePid)) == -1) return -1;
+                if (db_freadIntCount(stream, &(obj->data.item.weapon.ammoQuantity), 2) == -1) return -1;
                 break;
             case ITEM_TYPE_AMMO:
                 if (db_freadInt(stream, &(obj->data.item.ammo.quantity)) == -1) return -1;
@@ -484,12 +561,10 @@ int proto_read_protoUpdateData(Object* obj, DB_FILE* stream)
                 if (db_freadInt(stream, &(obj->data.scenery.door.openFlags)) == -1) return -1;
                 break;
             case SCENERY_TYPE_STAIRS:
-                if (db_freadInt(stream, &(obj->data.scenery.stairs.destinationMap)) == -1) return -1;
-                if (db_freadInt(stream, &(obj->data.scenery.stairs.destinationBuiltTile)) == -1) return -1;
+                if (db_freadIntCount(stream, &(obj->data.scenery.stairs.destinationMap), 2) == -1) return -1;
                 break;
             case SCENERY_TYPE_ELEVATOR:
-                if (db_freadInt(stream, &(obj->data.scenery.elevator.type)) == -1) return -1;
-                if (db_freadInt(stream, &(obj->data.scenery.elevator.level)) == -1) return -1;
+                if (db_freadIntCount(stream, &(obj->data.scenery.elevator.type), 2) == -1) return -1;
                 break;
             case SCENERY_TYPE_LADDER_UP:
                 if (db_freadInt(stream, &(obj->data.scenery.ladder.destinationBuiltTile)) == -1) return -1;
@@ -502,10 +577,7 @@ int proto_read_protoUpdateData(Object* obj, DB_FILE* stream)
             break;
         case OBJ_TYPE_MISC:
             if (obj->pid >= 0x5000010 && obj->pid <= 0x5000017) {
-                if (db_freadInt(stream, &(obj->data.misc.map)) == -1) return -1;
-                if (db_freadInt(stream, &(obj->data.misc.tile)) == -1) return -1;
-                if (db_freadInt(stream, &(obj->data.misc.elevation)) == -1) return -1;
-                if (db_freadInt(stream, &(obj->data.misc.rotation)) == -1) return -1;
+                if (db_freadIntCount(stream, &(obj->data.misc.map), 4) == -1) return -1;
             }
             break;
         }
@@ -520,29 +592,22 @@ int proto_write_protoUpdateData(Object* obj, DB_FILE* stream)
     Proto* proto;
 
     ObjectData* data = &(obj->data);
-    if (db_fwriteInt(stream, data->inventory.length) == -1) return -1;
-    if (db_fwriteInt(stream, data->inventory.capacity) == -1) return -1;
-    // TODO: Why do we need to write address of pointer? That probably means
-    // this field is shared with something else.
-    if (db_fwriteInt(stream, (intptr_t)data->inventory.items) == -1) return -1;
+
+    // TODO: Why do we need to write address of pointer (inventory items)?
+    // That probably means this field is shared with something else.
+    if (db_fwriteRecord(stream, obj, proto_update_fields, DB_RECORD_LENGTH(proto_update_fields)) == -1) return -1;
 
     if (PID_TYPE(obj->pid) == OBJ_TYPE_CRITTER) {
-        if (db_fwriteInt(stream, data->flags) == -1) return -1;
         if (proto_write_CombatData(&(obj->data.critter.combat), stream) == -1) return -1;
-        if (db_fwriteInt(stream, data->critter.hp) == -1) return -1;
-        if (db_fwriteInt(stream, data->critter.radiation) == -1) return -1;
-        if (db_fwriteInt(stream, data->critter.poison) == -1) return -1;
+        if (db_fwriteIntCount(stream, &(data->critter.hp), 3) == -1) return -1;
     } else {
-        if (db_fwriteInt(stream, data->flags) == -1) return -1;
-
         switch (PID_TYPE(obj->pid)) {
         case OBJ_TYPE_ITEM:
             if (proto_ptr(obj->pid, &proto) == -1) return -1;
 
             switch (proto->item.type) {
             case ITEM_TYPE_WEAPON:
-                if (db_fwriteInt(stream, data->item.weapon.ammoQuantity) == -1) return -1;
-                if (db_fwriteInt(stream, data->item.weapon.ammoTypePid) == -1) return -1;
+                if (db_fwriteIntCount(stream, &(data->item.weapon.ammoQuantity), 2) == -1) return -1;
                 break;
             case ITEM_TYPE_AMMO:
                 if (db_fwriteInt(stream, data->item.ammo.quantity) == -1) return -1;
@@ -563,12 +628,10 @@ int proto_write_protoUpdateData(Object* obj, DB_FILE* stream)
                 if (db_fwriteInt(stream, data->scenery.door.openFlags) == -1) return -1;
                 break;
             case SCENERY_TYPE_STAIRS:
-                if (db_fwriteInt(stream, data->scenery.stairs.destinationMap) == -1) return -1;
-                if (db_fwriteInt(stream, data->scenery.stairs.destinationBuiltTile) == -1) return -1;
+                if (db_fwriteIntCount(stream, &(data->scenery.stairs.destinationMap), 2) == -1) return -1;
                 break;
             case SCENERY_TYPE_ELEVATOR:
-                if (db_fwriteInt(stream, data->scenery.elevator.type) == -1) return -1;
-                if (db_fwriteInt(stream, data->scenery.elevator.level) == -1) return -1;
+                if (db_fwriteIntCount(stream, &(data->scenery.elevator.type), 2) == -1) return -1;
                 break;
             case SCENERY_TYPE_LADDER_UP:
                 if (db_fwriteInt(stream, data->scenery.ladder.destinationBuiltTile) == -1) return -1;
@@ -582,10 +645,7 @@ int proto_write_protoUpdateData(Object* obj, DB_FILE* stream)
             break;
         case OBJ_TYPE_MISC:
             if (obj->pid >= 0x5000010 && obj->pid <= 0x5000017) {
-                if (db_fwriteInt(stream, data->misc.map) == -1) return -1;
-                if (db_fwriteInt(stream, data->misc.tile) == -1) return -1;
-                if (db_fwriteInt(stream, data->misc.elevation) == -1) return -1;
-                if (db_fwriteInt(stream, data->misc.rotation) == -1) return -1;
+                if (db_fwriteIntCount(stream, &(data->misc.map), 4) == -1) return -1;
             }
             break;
         default:
@@ -1046,6 +1106,12 @@ int proto_init()
 
     proto_header_load();
 
+    int preload;
+    if (!config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_PRELOAD_PROTOS_KEY, &preload)) {
+        preload = 0;
+    }
+    proto_preload = preload != 0;
+
     protos_been_initialized = 1;
 
     proto_dude_init("premade\\player.gcd");
@@ -1168,6 +1234,16 @@ void proto_exit()
     // NOTE: Uninline.
     proto_remove_all();
 
+    for (i = 0; i < 6; i++) {
+        lst_free(&(proto_lsts[i]));
+
+        if (proto_index[i] != NULL) {
+            mem_free(proto_index[i]);
+            proto_index[i] = NULL;
+        }
+        proto_index_capacity[i] = 0;
+    }
+
     protos_been_initialized = 0;
 
     for (i = 0; i < 6; i++) {
@@ -1177,7 +1253,8 @@ void proto_exit()
     message_exit(&proto_main_msg_file);
 }
 
-// Count .pro lines in .lst files.
+// Count .pro lines in .lst files. The files are kept in memory for
+// `proto_list_str`.
 //
 // 0x48ECD8
 int proto_header_load()
@@ -1195,28 +1272,12 @@ int proto_header_load()
         strcat(path, art_dir(index));
         strcat(path, ".lst");
 
-        DB_FILE* stream = db_fopen(path, "rt");
-        if (stream == NULL) {
+        lst_free(&(proto_lsts[index]));
+        if (lst_load(&(proto_lsts[index]), path) == -1) {
             return -1;
         }
 
-        int ch = '\0';
-        while (1) {
-            ch = db_fgetc(stream);
-            if (ch == -1) {
-                break;
-            }
-
-            if (ch == '\n') {
-                ptr->max_entries_num++;
-            }
-        }
-
-        if (ch != '\n') {
-            ptr->max_entries_num++;
-        }
-
-        db_fclose(stream);
+        ptr->max_entries_num += proto_lsts[index].length;
     }
 
     return 0;
@@ -1225,68 +1286,31 @@ int proto_header_load()
 // 0x48EEE4
 static int proto_read_item_data(ItemProtoData* item_data, int type, DB_FILE* stream)
 {
+    // NOTE: Item data is stored in the same order as it's declared, all
+    // fields are ints except weapon sound code.
     switch (type) {
     case ITEM_TYPE_ARMOR:
-        if (db_freadInt(stream, &(item_data->armor.armorClass)) == -1) return -1;
-        if (db_freadIntCount(stream, item_data->armor.damageResistance, 7) == -1) return -1;
-        if (db_freadIntCount(stream, item_data->armor.damageThreshold, 7) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->armor.perk)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->armor.maleFid)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->armor.femaleFid)) == -1) return -1;
+        if (db_freadIntCount(stream, &(item_data->armor.armorClass), sizeof(item_data->armor) / sizeof(int)) == -1) return -1;
 
         return 0;
     case ITEM_TYPE_CONTAINER:
-        if (db_freadInt(stream, &(item_data->container.maxSize)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->container.openFlags)) == -1) return -1;
+        if (db_freadIntCount(stream, &(item_data->container.maxSize), sizeof(item_data->container) / sizeof(int)) == -1) return -1;
 
         return 0;
     case ITEM_TYPE_DRUG:
-        if (db_freadInt(stream, &(item_data->drug.stat[0])) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->drug.stat[1])) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->drug.stat[2])) == -1) return -1;
-        if (db_freadIntCount(stream, item_data->drug.amount, 3) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->drug.duration1)) == -1) return -1;
-        if (db_freadIntCount(stream, item_data->drug.amount1, 3) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->drug.duration2)) == -1) return -1;
-        if (db_freadIntCount(stream, item_data->drug.amount2, 3) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->drug.addictionChance)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->drug.withdrawalEffect)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->drug.withdrawalOnset)) == -1) return -1;
+        if (db_freadIntCount(stream, item_data->drug.stat, sizeof(item_data->drug) / sizeof(int)) == -1) return -1;
 
         return 0;
     case ITEM_TYPE_WEAPON:
-        if (db_freadInt(stream, &(item_data->weapon.animationCode)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->weapon.minDamage)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->weapon.maxDamage)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->weapon.damageType)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->weapon.maxRange1)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->weapon.maxRange2)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->weapon.projectilePid)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->weapon.minStrength)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->weapon.actionPointCost1)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->weapon.actionPointCost2)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->weapon.criticalFailureType)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->weapon.perk)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->weapon.rounds)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->weapon.caliber)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->weapon.ammoTypePid)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->weapon.ammoCapacity)) == -1) return -1;
-        if (db_freadByte(stream, &(item_data->weapon.soundCode)) == -1) return -1;
+        if (db_freadRecord(stream, &(item_data->weapon), proto_weapon_fields, DB_RECORD_LENGTH(proto_weapon_fields)) == -1) return -1;
 
         return 0;
     case ITEM_TYPE_AMMO:
-        if (db_freadInt(stream, &(item_data->ammo.caliber)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->ammo.quantity)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->ammo.armorClassModifier)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->ammo.damageResistanceModifier)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->ammo.damageMultiplier)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->ammo.damageDivisor)) == -1) return -1;
+        if (db_freadIntCount(stream, &(item_data->ammo.caliber), sizeof(item_data->ammo) / sizeof(int)) == -1) return -1;
 
         return 0;
     case ITEM_TYPE_MISC:
-        if (db_freadInt(stream, &(item_data->misc.powerTypePid)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->misc.powerType)) == -1) return -1;
-        if (db_freadInt(stream, &(item_data->misc.charges)) == -1) return -1;
+        if (db_freadIntCount(stream, &(item_data->misc.powerTypePid), sizeof(item_data->misc) / sizeof(int)) == -1) return -1;
 
         return 0;
     case ITEM_TYPE_KEY:
@@ -1303,18 +1327,15 @@ static int proto_read_scenery_data(SceneryProtoData* scenery_data, int type, DB_
 {
     switch (type) {
     case SCENERY_TYPE_DOOR:
-        if (db_freadInt(stream, &(scenery_data->door.openFlags)) == -1) return -1;
-        if (db_freadInt(stream, &(scenery_data->door.keyCode)) == -1) return -1;
+        if (db_freadIntCount(stream, &(scenery_data->door.openFlags), 2) == -1) return -1;
 
         return 0;
     case SCENERY_TYPE_STAIRS:
-        if (db_freadInt(stream, &(scenery_data->stairs.field_0)) == -1) return -1;
-        if (db_freadInt(stream, &(scenery_data->stairs.field_4)) == -1) return -1;
+        if (db_freadIntCount(stream, &(scenery_data->stairs.field_0), 2) == -1) return -1;
 
         return 0;
     case SCENERY_TYPE_ELEVATOR:
-        if (db_freadInt(stream, &(scenery_data->elevator.type)) == -1) return -1;
-        if (db_freadInt(stream, &(scenery_data->elevator.level)) == -1) return -1;
+        if (db_freadIntCount(stream, &(scenery_data->elevator.type), 2) == -1) return -1;
 
         return 0;
     case SCENERY_TYPE_LADDER_UP:
@@ -1335,72 +1356,33 @@ static int proto_read_scenery_data(SceneryProtoData* scenery_data, int type, DB_
 // 0x48F398
 static int proto_read_protoSubNode(Proto* proto, DB_FILE* stream)
 {
-    if (db_freadInt(stream, &(proto->pid)) == -1) return -1;
-    if (db_freadInt(stream, &(proto->messageId)) == -1) return -1;
-    if (db_freadInt(stream, &(proto->fid)) == -1) return -1;
+    if (db_freadIntCount(stream, &(proto->pid), 3) == -1) return -1;
 
     switch (PID_TYPE(proto->pid)) {
     case OBJ_TYPE_ITEM:
-        if (db_freadInt(stream, &(proto->item.lightDistance)) == -1) return -1;
-        if (db_freadLong(stream, &(proto->item.lightIntensity)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->item.flags)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->item.extendedFlags)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->item.sid)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->item.type)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->item.material)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->item.size)) == -1) return -1;
-        if (db_freadLong(stream, &(proto->item.weight)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->item.cost)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->item.inventoryFid)) == -1) return -1;
-        if (db_freadByte(stream, &(proto->item.field_80)) == -1) return -1;
+        if (db_freadRecord(stream, proto, proto_item_fields, DB_RECORD_LENGTH(proto_item_fields)) == -1) return -1;
         if (proto_read_item_data(&(proto->item.data), proto->item.type, stream) == -1) return -1;
 
         return 0;
     case OBJ_TYPE_CRITTER:
-        if (db_freadInt(stream, &(proto->critter.lightDistance)) == -1) return -1;
-        if (db_freadLong(stream, &(proto->critter.lightIntensity)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->critter.flags)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->critter.extendedFlags)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->critter.sid)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->critter.headFid)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->critter.aiPacket)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->critter.team)) == -1) return -1;
-
+        if (db_freadRecord(stream, proto, proto_critter_fields, DB_RECORD_LENGTH(proto_critter_fields)) == -1) return -1;
         if (critter_read_data(stream, &(proto->critter.data)) == -1) return -1;
 
         return 0;
     case OBJ_TYPE_SCENERY:
-        if (db_freadInt(stream, &(proto->scenery.lightDistance)) == -1) return -1;
-        if (db_freadLong(stream, &(proto->scenery.lightIntensity)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->scenery.flags)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->scenery.extendedFlags)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->scenery.sid)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->scenery.type)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->scenery.material)) == -1) return -1;
-        if (db_freadByte(stream, &(proto->scenery.field_34)) == -1) return -1;
+        if (db_freadRecord(stream, proto, proto_scenery_fields, DB_RECORD_LENGTH(proto_scenery_fields)) == -1) return -1;
         if (proto_read_scenery_data(&(proto->scenery.data), proto->scenery.type, stream) == -1) return -1;
         return 0;
     case OBJ_TYPE_WALL:
-        if (db_freadInt(stream, &(proto->wall.lightDistance)) == -1) return -1;
-        if (db_freadLong(stream, &(proto->wall.lightIntensity)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->wall.flags)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->wall.extendedFlags)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->wall.sid)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->wall.material)) == -1) return -1;
+        if (db_freadRecord(stream, proto, proto_wall_fields, DB_RECORD_LENGTH(proto_wall_fields)) == -1) return -1;
 
         return 0;
     case OBJ_TYPE_TILE:
-        if (db_freadInt(stream, &(proto->tile.flags)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->tile.extendedFlags)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->tile.sid)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->tile.material)) == -1) return -1;
+        if (db_freadRecord(stream, proto, proto_tile_fields, DB_RECORD_LENGTH(proto_tile_fields)) == -1) return -1;
 
         return 0;
     case OBJ_TYPE_MISC:
-        if (db_freadInt(stream, &(proto->misc.lightDistance)) == -1) return -1;
-        if (db_freadLong(stream, &(proto->misc.lightIntensity)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->misc.flags)) == -1) return -1;
-        if (db_freadInt(stream, &(proto->misc.extendedFlags)) == -1) return -1;
+        if (db_freadRecord(stream, proto, proto_misc_fields, DB_RECORD_LENGTH(proto_misc_fields)) == -1) return -1;
 
         return 0;
     }
@@ -1646,6 +1628,9 @@ int proto_load_pid(int pid, Proto** protoPtr)
     }
 
     db_fclose(stream);
+
+    proto_index_set(*protoPtr);
+
     return 0;
 }
 
@@ -1723,6 +1708,12 @@ void proto_remove_all()
         protoList->head = NULL;
         protoList->tail = NULL;
         protoList->length = 0;
+
+        if (proto_index[type] != NULL) {
+            memset(proto_index[type], 0, sizeof(*proto_index[type]) * proto_index_capacity[type]);
+        }
+        proto_index_length[type] = 0;
+        proto_preloaded[type] = false;
     }
 }
 
@@ -1740,22 +1731,123 @@ int proto_ptr(int pid, Proto** protoPtr)
         return 0;
     }
 
-    ProtoList* protoList = &(protolists[PID_TYPE(pid)]);
-    ProtoListExtent* protoListExtent = protoList->head;
-    while (protoListExtent != NULL) {
-        for (int index = 0; index < protoListExtent->length; index++) {
-            Proto* proto = (Proto*)protoListExtent->proto[index];
-            if (pid == proto->pid) {
-                *protoPtr = proto;
-                return 0;
+    int type = PID_TYPE(pid);
+
+    Proto* proto = proto_index_get(pid);
+    if (proto != NULL) {
+        *protoPtr = proto;
+        return 0;
+    }
+
+    if (type < 6 && proto_preload && !proto_preloaded[type]) {
+        proto_preload_type(type);
+
+        proto = proto_index_get(pid);
+        if (proto != NULL) {
+            *protoPtr = proto;
+            return 0;
+        }
+    }
+
+    // Protos obtained with `proto_find_free_subnode` directly get their pid
+    // after the fact, so they are not in the index yet. Scan extents only
+    // when there are such protos.
+    ProtoList* protoList = &(protolists[type]);
+    if (type >= 6 || proto_index_count(type) != proto_index_length[type]) {
+        ProtoListExtent* protoListExtent = protoList->head;
+        while (protoListExtent != NULL) {
+            for (int index = 0; index < protoListExtent->length; index++) {
+                proto = (Proto*)protoListExtent->proto[index];
+                if (pid == proto->pid) {
+                    proto_index_set(proto);
+                    *protoPtr = proto;
+                    return 0;
+                }
             }
+            protoListExtent = protoListExtent->next;
         }
-        protoListExtent = protoListExtent->next;
     }
 
     return proto_load_pid(pid, protoPtr);
 }
 
+static Proto* proto_index_get(int pid)
+{
+    int type = PID_TYPE(pid);
+    int id = pid & 0xFFFFFF;
+
+    if (type >= 6 || id >= proto_index_capacity[type]) {
+        return NULL;
+    }
+
+    Proto* proto = proto_index[type][id];
+    if (proto == NULL || proto->pid != pid) {
+        return NULL;
+    }
+
+    return proto;
+}
+
+static void proto_index_set(Proto* proto)
+{
+    int type = PID_TYPE(proto->pid);
+    int id = proto->pid & 0xFFFFFF;
+
+    if (proto->pid == -1 || type >= 6) {
+        return;
+    }
+
+    if (id >= proto_index_capacity[type]) {
+        // Ids past the end of .lst belong to protos which are not going to
+        // be found on disk anyway, keep them out of the index.
+        if (id >= protolists[type].max_entries_num) {
+            return;
+        }
+
+        int capacity = protolists[type].max_entries_num;
+        Proto** index = (Proto**)mem_realloc(proto_index[type], sizeof(*index) * capacity);
+        if (index == NULL) {
+            return;
+        }
+
+        memset(index + proto_index_capacity[type], 0, sizeof(*index) * (capacity - proto_index_capacity[type]));
+        proto_index[type] = index;
+        proto_index_capacity[type] = capacity;
+    }
+
+    if (proto_index[type][id] == NULL) {
+        proto_index_length[type]++;
+    }
+
+    proto_index[type][id] = proto;
+}
+
+// Returns number of protos of given type kept in `protolists`.
+static int proto_index_count(int type)
+{
+    ProtoList* protoList = &(protolists[type]);
+    if (protoList->tail == NULL) {
+        return 0;
+    }
+
+    return (protoList->length - 1) * PROTO_LIST_EXTENT_SIZE + protoList->tail->length;
+}
+
+// Loads every proto listed in .lst of given type which is not loaded yet.
+static void proto_preload_type(int type)
+{
+    Proto* proto;
+
+    proto_preloaded[type] = true;
+
+    for (int id = 1; id <= proto_lsts[type].length; id++) {
+        int pid = (type << 24) | id;
+        if (proto_index_get(pid) == NULL) {
+            proto_load_pid(pid, &proto);
+        }
+    }
+}
+
 // 0x490530
 static int proto_new_id(int type)
 {
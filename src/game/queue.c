@@ -14,6 +14,7 @@
 #include "game/proto.h"
 #include "game/scripts.h"
 #include "plib/gnw/memory.h"
+#include "plib/gnw/profile.h"
 
 typedef struct QueueListNode {
     // TODO: Make unsigned.
@@ -325,6 +326,8 @@ int queue_process()
     int time = game_time();
     int v1 = 0;
 
+    profile_begin(PROFILE_ZONE_QUEUE);
+
     while (queue != NULL) {
         QueueListNode* queueListNode = queue;
         if (time < queueListNode->time || v1 != 0) {
@@ -343,6 +346,8 @@ int queue_process()
         mem_free(queueListNode);
     }
 
+    profile_end(PROFILE_ZONE_QUEUE);
+
     return v1;
 }
 
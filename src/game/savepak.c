@@ -0,0 +1,348 @@
+#include "game/savepak.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "plib/db/lzss.h"
+#include "plib/gnw/debug.h"
+#include "plib/gnw/memory.h"
+
+// Single file save game container.
+//
+// Layout (all integers are big-endian):
+//  - header: "FOPK", version, number of chunks, offset of index;
+//  - chunk data, each chunk is LZSS compressed unless that does not make it
+//    smaller;
+//  - index: for every chunk its name, offset, stored length, original length
+//    and FNV-1a hash of original data.
+//
+// Index is at the end so chunks can be written as they are compressed.
+// Writing only uses stdio and malloc so it's safe to do on a separate
+// thread, reading goes through db like everything else.
+
+#define SAVEPAK_MAGIC "FOPK"
+#define SAVEPAK_VERSION 1
+#define SAVEPAK_HEADER_SIZE 16
+#define SAVEPAK_ENTRY_SIZE (SAVEPAK_NAME_LENGTH + 16)
+
+// LZSS flag byte followed by eight 2-byte references of 18 bytes each is the
+// best case, so compressed chunk cannot unpack to more than this many times
+// its stored size.
+#define SAVEPAK_MAX_RATIO 9
+
+typedef struct SavePakEntry {
+    char name[SAVEPAK_NAME_LENGTH];
+    int offset;
+    int storedLength;
+    int length;
+    unsigned int checksum;
+} SavePakEntry;
+
+typedef struct SavePak {
+    DB_FILE* stream;
+    SavePakEntry* entries;
+    int entriesLength;
+} SavePak;
+
+static unsigned int savepak_checksum(const unsigned char* data, int length);
+static int savepak_write_int(FILE* stream, unsigned int value);
+
+static unsigned int savepak_checksum(const unsigned char* data, int length)
+{
+    unsigned int hash = 2166136261U;
+
+    for (int index = 0; index < length; index++) {
+        hash ^= data[index];
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+static int savepak_write_int(FILE* stream, unsigned int value)
+{
+    unsigned char bytes[4];
+
+    bytes[0] = (value >> 24) & 0xFF;
+    bytes[1] = (value >> 16) & 0xFF;
+    bytes[2] = (value >> 8) & 0xFF;
+    bytes[3] = value & 0xFF;
+
+    return fwrite(bytes, sizeof(bytes), 1, stream) == 1 ? 0 : -1;
+}
+
+// Writes `chunks` into new container at `path` (real file system path).
+int savepak_write(const char* path, const SavePakChunk* chunks, int count)
+{
+    FILE* stream;
+    SavePakEntry* entries;
+    unsigned char* buffer;
+    int bufferSize;
+    int offset;
+    int rc;
+    const unsigned char* data;
+
+    stream = fopen(path, "wb");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    entries = (SavePakEntry*)malloc(sizeof(*entries) * (count > 0 ? count : 1));
+    if (entries == NULL) {
+        fclose(stream);
+        return -1;
+    }
+
+    buffer = NULL;
+    bufferSize = 0;
+    rc = -1;
+
+    // Header is rewritten once index offset is known.
+    offset = SAVEPAK_HEADER_SIZE;
+    if (fseek(stream, offset, SEEK_SET) != 0) {
+        goto out;
+    }
+
+    for (int index = 0; index < count; index++) {
+        const SavePakChunk* chunk = &(chunks[index]);
+        SavePakEntry* entry = &(entries[index]);
+
+        memset(entry->name, 0, sizeof(entry->name));
+        strncpy(entry->name, chunk->name, sizeof(entry->name) - 1);
+        entry->offset = offset;
+        entry->length = chunk->length;
+        entry->checksum = savepak_checksum(chunk->data, chunk->length);
+
+        if (LZSS_ENCODE_BOUND(chunk->length) > bufferSize) {
+            unsigned char* newBuffer = (unsigned char*)realloc(buffer, LZSS_ENCODE_BOUND(chunk->length));
+            if (newBuffer == NULL) {
+                goto out;
+            }
+
+            buffer = newBuffer;
+            bufferSize = LZSS_ENCODE_BOUND(chunk->length);
+        }
+
+        entry->storedLength = lzss_encode_buf(chunk->data, chunk->length, buffer);
+        if (entry->storedLength < chunk->length) {
+            data = buffer;
+        } else {
+            entry->storedLength = chunk->length;
+            data = chunk->data;
+        }
+
+        if (entry->storedLength != 0 && fwrite(data, entry->storedLength, 1, stream) != 1) {
+            goto out;
+        }
+
+        offset += entry->storedLength;
+    }
+
+    for (int index = 0; index < count; index++) {
+        SavePakEntry* entry = &(entries[index]);
+        if (fwrite(entry->name, sizeof(entry->name), 1, stream) != 1
+            || savepak_write_int(stream, entry->offset) == -1
+            || savepak_write_int(stream, entry->storedLength) == -1
+            || savepak_write_int(stream, entry->length) == -1
+            || savepak_write_int(stream, entry->checksum) == -1) {
+            goto out;
+        }
+    }
+
+    if (fseek(stream, 0, SEEK_SET) != 0) {
+        goto out;
+    }
+
+    if (fwrite(SAVEPAK_MAGIC, 4, 1, stream) != 1
+        || savepak_write_int(stream, SAVEPAK_VERSION) == -1
+        || savepak_write_int(stream, count) == -1
+        || savepak_write_int(stream, offset) == -1) {
+        goto out;
+    }
+
+    rc = 0;
+
+out:
+
+    if (fclose(stream) != 0) {
+        rc = -1;
+    }
+
+    free(buffer);
+    free(entries);
+
+    return rc;
+}
+
+// Opens container at `path` (relative to patches directory as usual) and
+// reads its index.
+SavePak* savepak_open(const char* path)
+{
+    SavePak* pak;
+    char magic[4];
+    int version;
+    int count;
+    int indexOffset;
+    long fileSize;
+
+    pak = (SavePak*)mem_malloc(sizeof(*pak));
+    if (pak == NULL) {
+        return NULL;
+    }
+
+    pak->entries = NULL;
+    pak->entriesLength = 0;
+
+    pak->stream = db_fopen(path, "rb");
+    if (pak->stream == NULL) {
+        mem_free(pak);
+        return NULL;
+    }
+
+    if (db_fread(magic, sizeof(magic), 1, pak->stream) != 1
+        || memcmp(magic, SAVEPAK_MAGIC, sizeof(magic)) != 0
+        || db_freadInt(pak->stream, &version) == -1
+        || version != SAVEPAK_VERSION
+        || db_freadInt(pak->stream, &count) == -1
+        || db_freadInt(pak->stream, &indexOffset) == -1) {
+        debug_printf("savepak_open: %s is not a save container\n", path);
+        savepak_close(pak);
+        return NULL;
+    }
+
+    // Values below come from disk, make sure index fits in the file before
+    // allocating anything for it.
+    fileSize = db_filelength(pak->stream);
+    if (indexOffset < SAVEPAK_HEADER_SIZE
+        || indexOffset > fileSize
+        || count < 0
+        || count > (fileSize - indexOffset) / SAVEPAK_ENTRY_SIZE) {
+        debug_printf("savepak_open: %s has bad index\n", path);
+        savepak_close(pak);
+        return NULL;
+    }
+
+    pak->entries = (SavePakEntry*)mem_malloc(sizeof(*pak->entries) * (count > 0 ? count : 1));
+    if (pak->entries == NULL || db_fseek(pak->stream, indexOffset, SEEK_SET) != 0) {
+        savepak_close(pak);
+        return NULL;
+    }
+
+    for (int index = 0; index < count; index++) {
+        SavePakEntry* entry = &(pak->entries[index]);
+        if (db_fread(entry->name, sizeof(entry->name), 1, pak->stream) != 1
+            || db_freadInt(pak->stream, &(entry->offset)) == -1
+            || db_freadInt(pak->stream, &(entry->storedLength)) == -1
+            || db_freadInt(pak->stream, &(entry->length)) == -1
+            || db_freadInt(pak->stream, (int*)&(entry->checksum)) == -1) {
+            debug_printf("savepak_open: %s has truncated index\n", path);
+            savepak_close(pak);
+            return NULL;
+        }
+
+        // Chunk must lie between header and index, and unpack to a sane
+        // size.
+        if (entry->offset < SAVEPAK_HEADER_SIZE
+            || entry->offset > indexOffset
+            || entry->storedLength < 0
+            || entry->storedLength > indexOffset - entry->offset
+            || entry->length < 0
+            || (entry->storedLength != entry->length && entry->length / SAVEPAK_MAX_RATIO > entry->storedLength)) {
+            debug_printf("savepak_open: %s has bad entry %d\n", path, index);
+            savepak_close(pak);
+            return NULL;
+        }
+
+        entry->name[sizeof(entry->name) - 1] = '\0';
+        pak->entriesLength++;
+    }
+
+    return pak;
+}
+
+void savepak_close(SavePak* pak)
+{
+    if (pak == NULL) {
+        return;
+    }
+
+    if (pak->stream != NULL) {
+        db_fclose(pak->stream);
+    }
+
+    if (pak->entries != NULL) {
+        mem_free(pak->entries);
+    }
+
+    mem_free(pak);
+}
+
+int savepak_find(SavePak* pak, const char* name)
+{
+    for (int index = 0; index < pak->entriesLength; index++) {
+        if (stricmp(pak->entries[index].name, name) == 0) {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+// Reads and unpacks chunk at `index`, verifying its checksum. Returned
+// buffer should be freed with `mem_free`.
+unsigned char* savepak_read(SavePak* pak, int index, int* lengthPtr)
+{
+    SavePakEntry* entry;
+    unsigned char* stored;
+    unsigned char* data;
+
+    if (index < 0 || index >= pak->entriesLength) {
+        return NULL;
+    }
+
+    entry = &(pak->entries[index]);
+
+    // Always allocate at least one byte, empty chunks are valid.
+    data = (unsigned char*)mem_malloc(entry->length + 1);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    if (db_fseek(pak->stream, entry->offset, SEEK_SET) != 0) {
+        mem_free(data);
+        return NULL;
+    }
+
+    if (entry->storedLength == entry->length) {
+        if (entry->length != 0 && db_fread(data, entry->length, 1, pak->stream) != 1) {
+            mem_free(data);
+            return NULL;
+        }
+    } else {
+        stored = (unsigned char*)mem_malloc(entry->storedLength + 1);
+        if (stored == NULL) {
+            mem_free(data);
+            return NULL;
+        }
+
+        if (db_fread(stored, entry->storedLength, 1, pak->stream) != 1
+            || lzss_decode_buf(stored, entry->storedLength, data, entry->length) != entry->length) {
+            mem_free(stored);
+            mem_free(data);
+            return NULL;
+        }
+
+        mem_free(stored);
+    }
+
+    if (savepak_checksum(data, entry->length) != entry->checksum) {
+        debug_printf("savepak_read: checksum mismatch in %s\n", entry->name);
+        mem_free(data);
+        return NULL;
+    }
+
+    *lengthPtr = entry->length;
+
+    return data;
+}
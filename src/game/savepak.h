@@ -0,0 +1,22 @@
+#ifndef FALLOUT_GAME_SAVEPAK_H_
+#define FALLOUT_GAME_SAVEPAK_H_
+
+#include "plib/db/db.h"
+
+#define SAVEPAK_NAME_LENGTH 16
+
+typedef struct SavePak SavePak;
+
+typedef struct SavePakChunk {
+    char name[SAVEPAK_NAME_LENGTH];
+    unsigned char* data;
+    int length;
+} SavePakChunk;
+
+int savepak_write(const char* path, const SavePakChunk* chunks, int count);
+SavePak* savepak_open(const char* path);
+void savepak_close(SavePak* pak);
+int savepak_find(SavePak* pak, const char* name);
+unsigned char* savepak_read(SavePak* pak, int index, int* lengthPtr);
+
+#endif /* FALLOUT_GAME_SAVEPAK_H_ */
@@ -15,6 +15,7 @@
 #include "game/gdialog.h"
 #include "game/gmouse.h"
 #include "game/gmovie.h"
+#include "game/lstfile.h"
 #include "game/object.h"
 #include "game/protinst.h"
 #include "game/proto.h"
@@ -92,6 +93,31 @@ static void scrExecMapProcScripts(int a1);
 // 0x50784C
 int num_script_indexes = 0;
 
+// Parsed scripts.lst, loaded once in `scr_header_load`.
+static LstFile scr_lst;
+
+// Layout of script in map and save files after id and next id (and
+// spatial or timed data).
+//
+// NOTE: Program pointer is written as is (see `scr_write_ScriptSubNode`)
+// and is reset on read.
+static const DBRecordField scr_fields[] = {
+    DB_RECORD_INT(Script, scr_flags),
+    DB_RECORD_INT(Script, scr_script_idx),
+    DB_RECORD_INT(Script, program),
+    DB_RECORD_INT(Script, scr_oid),
+    DB_RECORD_INT(Script, scr_local_var_offset),
+    DB_RECORD_INT(Script, scr_num_local_vars),
+    DB_RECORD_INT(Script, field_28),
+    DB_RECORD_INT(Script, action),
+    DB_RECORD_INT(Script, fixedParam),
+    DB_RECORD_INT(Script, actionBeingUsed),
+    DB_RECORD_INT(Script, scriptOverrides),
+    DB_RECORD_INT(Script, field_48),
+    DB_RECORD_INT(Script, howMuch),
+    DB_RECORD_INT(Script, run_info_flags),
+};
+
 // 0x507850
 static int scr_find_first_idx = 0;
 
@@ -1164,9 +1190,7 @@ static int scr_build_lookup_table(Script* script)
 int scr_find_str_run_info(int scr_script_idx, int* run_info_flags, int sid)
 {
     int rc = -1;
-    char path[MAX_PATH];
-    DB_FILE* stream;
-    int idx;
+    const char* line;
     char string[MAX_PATH];
     char* sep;
     Script* script;
@@ -1179,21 +1203,11 @@ int scr_find_str_run_info(int scr_script_idx, int* run_info_flags, int sid)
         return -1;
     }
 
-    script_make_path(path);
-    strcat(path, "scripts.lst");
-
-    stream = db_fopen(path, "rt");
-    if (stream == NULL) {
-        return -1;
-    }
-
-    for (idx = 0; idx <= scr_script_idx; idx++) {
-        if (db_fgets(string, sizeof(string), stream) == NULL) {
-            break;
-        }
-    }
+    line = lst_get(&scr_lst, scr_script_idx);
+    if (line != NULL) {
+        strncpy(string, line, sizeof(string) - 1);
+        string[sizeof(string) - 1] = '\0';
 
-    if (idx - 1 == scr_script_idx) {
         rc = 0;
         sep = strchr(string, '#');
         if (sep != NULL) {
@@ -1218,8 +1232,6 @@ int scr_find_str_run_info(int scr_script_idx, int* run_info_flags, int sid)
         }
     }
 
-    db_fclose(stream);
-
     return rc;
 }
 
@@ -1227,9 +1239,7 @@ int scr_find_str_run_info(int scr_script_idx, int* run_info_flags, int sid)
 static int scr_index_to_name(int scr_script_idx, char* name)
 {
     int rc = -1;
-    char path[MAX_PATH];
-    DB_FILE* stream;
-    int idx;
+    const char* line;
     char string[MAX_PATH];
     char* sep;
 
@@ -1241,21 +1251,11 @@ static int scr_index_to_name(int scr_script_idx, char* name)
         return -1;
     }
 
-    script_make_path(path);
-    strcat(path, "scripts.lst");
-
-    stream = db_fopen(path, "rt");
-    if (stream == NULL) {
-        return -1;
-    }
-
-    for (idx = 0; idx <= scr_script_idx; idx++) {
-        if (db_fgets(string, sizeof(string), stream) == NULL) {
-            break;
-        }
-    }
+    line = lst_get(&scr_lst, scr_script_idx);
+    if (line != NULL) {
+        strncpy(string, line, sizeof(string) - 1);
+        string[sizeof(string) - 1] = '\0';
 
-    if (idx - 1 == scr_script_idx) {
         sep = strchr(string, '.');
         if (sep != NULL) {
             *sep = '\0';
@@ -1264,8 +1264,6 @@ static int scr_index_to_name(int scr_script_idx, char* name)
         }
     }
 
-    db_fclose(stream);
-
     return rc;
 }
 
@@ -1443,6 +1441,8 @@ int scr_exit()
     interpretClose();
     clearPrograms();
 
+    lst_free(&scr_lst);
+
     remove_bk_process(doBkProcesses);
 
     // NOTE: Uninline.
@@ -1580,32 +1580,18 @@ int scr_game_load2(DB_FILE* stream)
 static int scr_header_load()
 {
     char path[MAX_PATH];
-    DB_FILE* stream;
 
     num_script_indexes = 0;
 
     script_make_path(path);
     strcat(path, "scripts.lst");
 
-    stream = db_fopen(path, "rt");
-    if (stream == NULL) {
+    lst_free(&scr_lst);
+    if (lst_load(&scr_lst, path) == -1) {
         return -1;
     }
 
-    while (1) {
-        int ch = db_fgetc(stream);
-        if (ch == -1) {
-            break;
-        }
-
-        if (ch == '\n') {
-            num_script_indexes++;
-        }
-    }
-
-    num_script_indexes++;
-
-    db_fclose(stream);
+    num_script_indexes = scr_lst.length + 1;
 
     for (int scriptType = 0; scriptType < SCRIPT_TYPE_COUNT; scriptType++) {
         ScriptList* scriptList = &(scriptlists[scriptType]);
@@ -1621,33 +1607,19 @@ static int scr_header_load()
 // 0x49372C
 static int scr_write_ScriptSubNode(Script* scr, DB_FILE* stream)
 {
-    if (db_fwriteInt(stream, scr->scr_id) == -1) return -1;
-    if (db_fwriteInt(stream, scr->scr_next) == -1) return -1;
+    if (db_fwriteIntCount(stream, &(scr->scr_id), 2) == -1) return -1;
 
     switch (SID_TYPE(scr->scr_id)) {
     case SCRIPT_TYPE_SPATIAL:
-        if (db_fwriteInt(stream, scr->sp.built_tile) == -1) return -1;
-        if (db_fwriteInt(stream, scr->sp.radius) == -1) return -1;
+        if (db_fwriteIntCount(stream, &(scr->sp.built_tile), 2) == -1) return -1;
         break;
     case SCRIPT_TYPE_TIMED:
         if (db_fwriteInt(stream, scr->tm.time) == -1) return -1;
         break;
     }
 
-    if (db_fwriteInt(stream, scr->scr_flags) == -1) return -1;
-    if (db_fwriteInt(stream, scr->scr_script_idx) == -1) return -1;
-    if (db_fwriteInt(stream, (int)scr->program) == -1) return -1; // FIXME: writing pointer to file
-    if (db_fwriteInt(stream, scr->scr_oid) == -1) return -1;
-    if (db_fwriteInt(stream, scr->scr_local_var_offset) == -1) return -1;
-    if (db_fwriteInt(stream, scr->scr_num_local_vars) == -1) return -1;
-    if (db_fwriteInt(stream, scr->field_28) == -1) return -1;
-    if (db_fwriteInt(stream, scr->action) == -1) return -1;
-    if (db_fwriteInt(stream, scr->fixedParam) == -1) return -1;
-    if (db_fwriteInt(stream, scr->actionBeingUsed) == -1) return -1;
-    if (db_fwriteInt(stream, scr->scriptOverrides) == -1) return -1;
-    if (db_fwriteInt(stream, scr->field_48) == -1) return -1;
-    if (db_fwriteInt(stream, scr->howMuch) == -1) return -1;
-    if (db_fwriteInt(stream, scr->run_info_flags) == -1) return -1;
+    // FIXME: Writes program pointer to file.
+    if (db_fwriteRecord(stream, scr, scr_fields, DB_RECORD_LENGTH(scr_fields)) == -1) return -1;
 
     return 0;
 }
@@ -1772,35 +1744,18 @@ int scr_save(DB_FILE* stream)
 // 0x493BB8
 static int scr_read_ScriptSubNode(Script* scr, DB_FILE* stream)
 {
-    int prg;
-
-    if (db_freadInt(stream, &(scr->scr_id)) == -1) return -1;
-    if (db_freadInt(stream, &(scr->scr_next)) == -1) return -1;
+    if (db_freadIntCount(stream, &(scr->scr_id), 2) == -1) return -1;
 
     switch (SID_TYPE(scr->scr_id)) {
     case SCRIPT_TYPE_SPATIAL:
-        if (db_freadInt(stream, &(scr->sp.built_tile)) == -1) return -1;
-        if (db_freadInt(stream, &(scr->sp.radius)) == -1) return -1;
+        if (db_freadIntCount(stream, &(scr->sp.built_tile), 2) == -1) return -1;
         break;
     case SCRIPT_TYPE_TIMED:
         if (db_freadInt(stream, &(scr->tm.time)) == -1) return -1;
         break;
     }
 
-    if (db_freadInt(stream, &(scr->scr_flags)) == -1) return -1;
-    if (db_freadInt(stream, &(scr->scr_script_idx)) == -1) return -1;
-    if (db_freadInt(stream, &(prg)) == -1) return -1;
-    if (db_freadInt(stream, &(scr->scr_oid)) == -1) return -1;
-    if (db_freadInt(stream, &(scr->scr_local_var_offset)) == -1) return -1;
-    if (db_freadInt(stream, &(scr->scr_num_local_vars)) == -1) return -1;
-    if (db_freadInt(stream, &(scr->field_28)) == -1) return -1;
-    if (db_freadInt(stream, &(scr->action)) == -1) return -1;
-    if (db_freadInt(stream, &(scr->fixedParam)) == -1) return -1;
-    if (db_freadInt(stream, &(scr->actionBeingUsed)) == -1) return -1;
-    if (db_freadInt(stream, &(scr->scriptOverrides)) == -1) return -1;
-    if (db_freadInt(stream, &(scr->field_48)) == -1) return -1;
-    if (db_freadInt(stream, &(scr->howMuch)) == -1) return -1;
-    if (db_freadInt(stream, &(scr->run_info_flags)) == -1) return -1;
+    if (db_freadRecord(stream, scr, scr_fields, DB_RECORD_LENGTH(scr_fields)) == -1) return -1;
 
     scr->program = NULL;
     scr->owner = NULL;
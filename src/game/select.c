@@ -205,7 +205,7 @@ int select_character()
     }
 
     loadColorTable("color.pal");
-    palette_fade_to(cmap);
+    palette_fade_in(cmap);
 
     int rc = 0;
     bool done = false;
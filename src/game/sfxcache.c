@@ -16,6 +16,9 @@
 
 #define SOUND_EFFECTS_CACHE_MIN_SIZE 0x40000
 
+// Size of scratch buffer used to skip decoded data.
+#define SOUND_EFFECTS_SKIP_BUFFER_SIZE 4096
+
 typedef struct SoundEffect {
     // NOTE: This field is only 1 byte, likely unsigned char. It always uses
     // cmp for checking implying it's not bitwise flags. Therefore it's better
@@ -29,9 +32,23 @@ typedef struct SoundEffect {
     int position;
     int dataPosition;
     unsigned char* data;
+
+    // Decoder kept between reads, so streaming effect decodes it once.
+    // `NULL` until the first read.
+    AudioDecoder* decoder;
+
+    // Number of bytes `decoder` has produced so far.
+    int decoderPosition;
+
+    // Cache entry holds decoded samples rather than file contents.
+    bool decoded;
 } SoundEffect;
 
-static_assert(sizeof(SoundEffect) == 32, "wrong size");
+typedef struct SoundEffectBuffer {
+    unsigned char* data;
+    int size;
+    int position;
+} SoundEffectBuffer;
 
 static int sfxc_effect_size(int tag, int* sizePtr);
 static int sfxc_effect_load(int tag, int* sizePtr, unsigned char* data);
@@ -44,6 +61,10 @@ static bool sfxc_handle_is_legal(int a1);
 static bool sfxc_mode_is_legal(int mode);
 static int sfxc_decode(int handle, void* buf, unsigned int size);
 static int sfxc_ad_reader(void* stream, void* buf, unsigned int size);
+static int sfxc_ad_seek(void* stream, int offset);
+static int sfxc_skip(AudioDecoder* ad, int size);
+static bool sfxc_effect_is_decoded(int tag);
+static int sfxc_buffer_reader(void* stream, void* buf, unsigned int size);
 
 // 0x507A70
 static int sfxc_dlevel = INT_MAX;
@@ -66,6 +87,10 @@ static bool sfxc_initialized = false;
 // 0x507A88
 static int sfxc_cmpr = 1;
 
+// Effects which are no longer than this when decoded (in bytes) are kept
+// decoded in the cache.
+static int sfxc_decoded_limit = 0;
+
 // 0x497140
 int sfxc_init(int cacheSize, const char* effectsPath)
 {
@@ -73,6 +98,11 @@ int sfxc_init(int cacheSize, const char* effectsPath)
         sfxc_dlevel = 1;
     }
 
+    if (!config_get_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_SFX_DECODED_CACHE_LIMIT_KEY, &sfxc_decoded_limit)) {
+        sfxc_decoded_limit = 0;
+    }
+    sfxc_decoded_limit <<= 10;
+
     if (cacheSize <= SOUND_EFFECTS_CACHE_MIN_SIZE) {
         return -1;
     }
@@ -233,7 +263,9 @@ int sfxc_cached_read(int handle, void* buf, unsigned int size)
         memcpy(buf, soundEffect->data + soundEffect->position, bytesToRead);
         break;
     case 1:
-        if (sfxc_decode(handle, buf, bytesToRead) != 0) {
+        if (soundEffect->decoded) {
+            memcpy(buf, soundEffect->data + soundEffect->position, bytesToRead);
+        } else if (sfxc_decode(handle, buf, bytesToRead) != 0) {
             return -1;
         }
         break;
@@ -323,8 +355,14 @@ long sfxc_cached_file_size(int handle)
 static int sfxc_effect_size(int tag, int* sizePtr)
 {
     int size;
-    if (sfxl_size_cached(tag, &size) == -1) {
-        return -1;
+    if (sfxc_effect_is_decoded(tag)) {
+        if (sfxl_size_full(tag, &size) == -1) {
+            return -1;
+        }
+    } else {
+        if (sfxl_size_cached(tag, &size) == -1) {
+            return -1;
+        }
     }
 
     *sizePtr = size;
@@ -345,6 +383,49 @@ static int sfxc_effect_load(int tag, int* sizePtr, unsigned char* data)
     char* name;
     sfxl_name(tag, &name);
 
+    if (sfxc_effect_is_decoded(tag)) {
+        SoundEffectBuffer buffer;
+        buffer.data = (unsigned char*)mem_malloc(size);
+        buffer.size = size;
+        buffer.position = 0;
+
+        if (buffer.data == NULL) {
+            mem_free(name);
+            return -1;
+        }
+
+        if (db_read_to_buf(name, buffer.data)) {
+            mem_free(buffer.data);
+            mem_free(name);
+            return -1;
+        }
+
+        mem_free(name);
+
+        sfxl_size_full(tag, &size);
+
+        int channels;
+        int sampleRate;
+        int sampleCount;
+        AudioDecoder* ad = Create_AudioDecoder(sfxc_buffer_reader, &buffer, &channels, &sampleRate, &sampleCount);
+        if (ad == NULL) {
+            mem_free(buffer.data);
+            return -1;
+        }
+
+        size_t bytesRead = AudioDecoder_Read(ad, data, size);
+        AudioDecoder_Close(ad);
+        mem_free(buffer.data);
+
+        if (bytesRead != size) {
+            return -1;
+        }
+
+        *sizePtr = size;
+
+        return 0;
+    }
+
     if (db_read_to_buf(name, data)) {
         mem_free(name);
         return -1;
@@ -428,6 +509,10 @@ static int sfxc_handle_create(int* handlePtr, int tag, void* data, CacheEntry* c
 
     soundEffect->data = (unsigned char*)data;
 
+    soundEffect->decoder = NULL;
+    soundEffect->decoderPosition = 0;
+    soundEffect->decoded = sfxc_effect_is_decoded(tag);
+
     *handlePtr = index;
 
     return 0;
@@ -440,6 +525,11 @@ static void sfxc_handle_destroy(int handle)
     // thanks to [sfxc_handle_is_legal] handle will always be less than
     // [SOUND_EFFECTS_MAX_COUNT].
     if (handle <= SOUND_EFFECTS_MAX_COUNT) {
+        if (sfxc_handle_list[handle].decoder != NULL) {
+            AudioDecoder_Close(sfxc_handle_list[handle].decoder);
+            sfxc_handle_list[handle].decoder = NULL;
+        }
+
         sfxc_handle_list[handle].used = false;
     }
 }
@@ -474,6 +564,10 @@ static bool sfxc_mode_is_legal(int mode)
     return true;
 }
 
+// NOTE: The original created new decoder on every read and decoded (and
+// discarded) everything up to current position. Decoder is now kept in the
+// handle and seeks backwards using its seek index.
+//
 // 0x4977F8
 static int sfxc_decode(int handle, void* buf, unsigned int size)
 {
@@ -482,31 +576,43 @@ static int sfxc_decode(int handle, void* buf, unsigned int size)
     }
 
     SoundEffect* soundEffect = &(sfxc_handle_list[handle]);
-    soundEffect->dataPosition = 0;
 
-    int channels;
-    int sampleRate;
-    int sampleCount;
-    AudioDecoder* ad = Create_AudioDecoder(sfxc_ad_reader, (void*)handle, &channels, &sampleRate, &sampleCount);
+    if (soundEffect->decoder != NULL && soundEffect->decoderPosition > soundEffect->position) {
+        if (AudioDecoder_Seek(soundEffect->decoder, soundEffect->position / 2)) {
+            soundEffect->decoderPosition = AudioDecoder_Tell(soundEffect->decoder) * 2;
+        } else {
+            AudioDecoder_Close(soundEffect->decoder);
+            soundEffect->decoder = NULL;
+        }
+    }
 
-    if (soundEffect->position != 0) {
-        void* temp = mem_malloc(soundEffect->position);
-        if (temp == NULL) {
-            AudioDecoder_Close(ad);
+    if (soundEffect->decoder == NULL) {
+        soundEffect->dataPosition = 0;
+        soundEffect->decoderPosition = 0;
+
+        int channels;
+        int sampleRate;
+        int sampleCount;
+        soundEffect->decoder = Create_AudioDecoder(sfxc_ad_reader, (void*)handle, &channels, &sampleRate, &sampleCount);
+        if (soundEffect->decoder == NULL) {
             return -1;
         }
 
-        size_t bytesRead = AudioDecoder_Read(ad, temp, soundEffect->position);
-        mem_free(temp);
+        AudioDecoder_EnableSeek(soundEffect->decoder, sfxc_ad_seek);
+    }
 
-        if (bytesRead != soundEffect->position) {
-            AudioDecoder_Close(ad);
+    if (soundEffect->decoderPosition < soundEffect->position) {
+        if (sfxc_skip(soundEffect->decoder, soundEffect->position - soundEffect->decoderPosition) != 0) {
+            AudioDecoder_Close(soundEffect->decoder);
+            soundEffect->decoder = NULL;
             return -1;
         }
+
+        soundEffect->decoderPosition = soundEffect->position;
     }
 
-    size_t bytesRead = AudioDecoder_Read(ad, buf, size);
-    AudioDecoder_Close(ad);
+    size_t bytesRead = AudioDecoder_Read(soundEffect->decoder, buf, size);
+    soundEffect->decoderPosition += bytesRead;
 
     if (bytesRead != size) {
         return -1;
@@ -536,3 +642,65 @@ static int sfxc_ad_reader(void* stream, void* buf, unsigned int size)
 
     return bytesToRead;
 }
+
+static int sfxc_ad_seek(void* stream, int offset)
+{
+    int handle = (int)stream;
+    SoundEffect* soundEffect = &(sfxc_handle_list[handle]);
+
+    if (offset < 0 || offset > soundEffect->fileSize) {
+        return -1;
+    }
+
+    soundEffect->dataPosition = offset;
+
+    return 0;
+}
+
+// Decodes and discards `size` bytes.
+static int sfxc_skip(AudioDecoder* ad, int size)
+{
+    unsigned char buffer[SOUND_EFFECTS_SKIP_BUFFER_SIZE];
+
+    while (size > 0) {
+        size_t chunkSize = size < SOUND_EFFECTS_SKIP_BUFFER_SIZE ? size : SOUND_EFFECTS_SKIP_BUFFER_SIZE;
+        if (AudioDecoder_Read(ad, buffer, chunkSize) != chunkSize) {
+            return -1;
+        }
+
+        size -= chunkSize;
+    }
+
+    return 0;
+}
+
+static bool sfxc_effect_is_decoded(int tag)
+{
+    int size;
+
+    if (sfxc_cmpr != 1 || sfxc_decoded_limit <= 0) {
+        return false;
+    }
+
+    if (sfxl_size_full(tag, &size) == -1) {
+        return false;
+    }
+
+    return size <= sfxc_decoded_limit;
+}
+
+static int sfxc_buffer_reader(void* stream, void* buf, unsigned int size)
+{
+    SoundEffectBuffer* buffer = (SoundEffectBuffer*)stream;
+
+    unsigned int bytesToRead = buffer->size - buffer->position;
+    if (size <= bytesToRead) {
+        bytesToRead = size;
+    }
+
+    memcpy(buf, buffer->data + buffer->position, bytesToRead);
+
+    buffer->position += bytesToRead;
+
+    return bytesToRead;
+}
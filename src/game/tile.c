@@ -6,6 +6,7 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 
+#include "game/art.h"
 #include "game/config.h"
 #include "game/gconfig.h"
 #include "game/gmouse.h"
@@ -16,9 +17,19 @@
 #include "plib/gnw/debug.h"
 #include "plib/gnw/grbuf.h"
 #include "plib/gnw/input.h"
+#include "plib/gnw/memory.h"
+#include "plib/gnw/profile.h"
+#include "plib/gnw/thread.h"
 
 #define TILE_IS_VALID(tile) ((tile) >= 0 && (tile) < grid_size)
 
+// Dirty rects smaller than this (in pixels) are not worth splitting and are
+// rendered on the calling thread.
+#define TILE_COMPOSITOR_MIN_AREA 65536
+
+#define TILE_COMPOSITOR_MAX_TILES 16
+#define TILE_COMPOSITOR_MIN_TILE_HEIGHT 32
+
 typedef struct STRUCT_51D99C {
     int field_0;
     int field_4;
@@ -48,12 +59,23 @@ typedef struct STRUCT_51DB48 {
     int field_8;
 } STRUCT_51DB48;
 
+typedef struct TileCompositorJob {
+    Rect rect;
+    int elevation;
+    ObjectListNode** renderList;
+} TileCompositorJob;
+
 static void refresh_mapper(Rect* rect, int elevation);
 static void refresh_game(Rect* rect, int elevation);
 static bool tile_on_edge(int tile);
 static void roof_fill_on(int x, int y, int elevation);
 static void roof_fill_off(int x, int y, int elevation);
 static void roof_draw(int fid, int x, int y, Rect* rect, int light);
+static int tile_compositor_init(int threads);
+static void tile_compositor_exit();
+static bool refresh_game_parallel(Rect* rect, int elevation);
+static void tile_compositor_render(void* data, int index);
+static void square_pin_art(Rect* rect, int elevation);
 
 // 0x51D950
 static bool borderInitialized = false;
@@ -162,9 +184,6 @@ static STRUCT_51DB48 upside_down_triangles[5] = {
     { 6, 9, 7 },
 };
 
-// 0x668224
-static int intensity_map[3280];
-
 // 0x66B564
 static int dir_tile2[2][6];
 
@@ -264,6 +283,16 @@ static int buf_width;
 // 0x66BE34
 int tile_center_tile;
 
+// Worker pool of parallel compositor, `NULL` when compositor is disabled.
+static WorkerPool* tile_compositor_pool = NULL;
+
+// Horizontal bands of the dirty rect being rendered. Render lists are owned
+// by job slots and allocated on first use.
+static TileCompositorJob tile_compositor_jobs[TILE_COMPOSITOR_MAX_TILES];
+
+// Set while bands are rendered by compositor threads.
+static bool tile_compositor_running = false;
+
 // 0x4B0C40
 int tile_init(TileData** a1, int squareGridWidth, int squareGridHeight, int hexGridWidth, int hexGridHeight, unsigned char* buffer, int windowWidth, int windowHeight, int windowPitch, TileWindowRefreshProc* windowRefreshProc)
 {
@@ -419,6 +448,11 @@ int tile_init(TileData** a1, int squareGridWidth, int squareGridHeight, int hexG
     config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_EXECUTABLE_KEY, &executable);
     if (stricmp(executable, "mapper") == 0) {
         tile_refresh = refresh_mapper;
+    } else {
+        int compositorThreads;
+        if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_COMPOSITOR_THREADS_KEY, &compositorThreads)) {
+            tile_compositor_init(compositorThreads);
+        }
     }
 
     return 0;
@@ -454,6 +488,7 @@ void tile_reset()
 // NOTE: Uncollapsed 0x4B129C.
 void tile_exit()
 {
+    tile_compositor_exit();
 }
 
 // 0x4B12A8
@@ -592,11 +627,142 @@ static void refresh_game(Rect* rect, int elevation)
         return;
     }
 
-    square_render_floor(&rectToUpdate, elevation);
-    obj_render_pre_roof(&rectToUpdate, elevation);
-    square_render_roof(&rectToUpdate, elevation);
+    profile_begin(PROFILE_ZONE_RENDER);
+    if (!refresh_game_parallel(&rectToUpdate, elevation)) {
+        square_render_floor(&rectToUpdate, elevation);
+        obj_render_pre_roof(&rectToUpdate, elevation);
+        square_render_roof(&rectToUpdate, elevation);
+    }
     obj_render_post_roof(&rectToUpdate, elevation);
     blit(&rectToUpdate);
+    profile_end(PROFILE_ZONE_RENDER);
+}
+
+// Sets up parallel compositor with given number of worker threads (in
+// addition to the main thread). Negative value means one per each additional
+// CPU.
+static int tile_compositor_init(int threads)
+{
+    if (threads < 0) {
+        threads = thread_get_cpu_count() - 1;
+    }
+
+    if (threads <= 0) {
+        return 0;
+    }
+
+    tile_compositor_pool = worker_pool_create(threads);
+    if (tile_compositor_pool == NULL) {
+        debug_printf("tile_compositor_init: failed to create worker pool\n");
+        return -1;
+    }
+
+    debug_printf("tile_compositor_init: %d worker threads\n", worker_pool_get_size(tile_compositor_pool));
+
+    return 0;
+}
+
+static void tile_compositor_exit()
+{
+    if (tile_compositor_pool != NULL) {
+        worker_pool_free(tile_compositor_pool);
+        tile_compositor_pool = NULL;
+    }
+
+    for (int index = 0; index < TILE_COMPOSITOR_MAX_TILES; index++) {
+        if (tile_compositor_jobs[index].renderList != NULL) {
+            mem_free(tile_compositor_jobs[index].renderList);
+            tile_compositor_jobs[index].renderList = NULL;
+        }
+    }
+}
+
+// Renders floor, objects below roof and roof in `rect` splitting it into
+// horizontal bands which are rendered by compositor threads. Everything
+// render threads are going to lock is pinned up front, so during render phase
+// they only read art cache, object table and squares. Post-roof pass and blit
+// are left to the caller.
+//
+// Returns `false` if compositor is disabled or `rect` is too small, in which
+// case nothing is rendered.
+static bool refresh_game_parallel(Rect* rect, int elevation)
+{
+    int width;
+    int height;
+    int count;
+    int tileHeight;
+    int renderListSize;
+
+    if (tile_compositor_pool == NULL) {
+        return false;
+    }
+
+    width = rect->lrx - rect->ulx + 1;
+    height = rect->lry - rect->uly + 1;
+    if (width * height < TILE_COMPOSITOR_MIN_AREA) {
+        return false;
+    }
+
+    // Two bands per thread to even out bands which are heavier on objects.
+    count = (worker_pool_get_size(tile_compositor_pool) + 1) * 2;
+    if (count > TILE_COMPOSITOR_MAX_TILES) {
+        count = TILE_COMPOSITOR_MAX_TILES;
+    }
+
+    if (height / count < TILE_COMPOSITOR_MIN_TILE_HEIGHT) {
+        count = height / TILE_COMPOSITOR_MIN_TILE_HEIGHT;
+    }
+
+    if (count < 2) {
+        return false;
+    }
+
+    renderListSize = obj_render_table_size();
+    if (renderListSize == 0) {
+        return false;
+    }
+
+    tileHeight = (height + count - 1) / count;
+
+    for (int index = 0; index < count; index++) {
+        TileCompositorJob* job = &(tile_compositor_jobs[index]);
+        if (job->renderList == NULL) {
+            job->renderList = (ObjectListNode**)mem_malloc(sizeof(*job->renderList) * renderListSize);
+            if (job->renderList == NULL) {
+                return false;
+            }
+        }
+
+        job->rect.ulx = rect->ulx;
+        job->rect.uly = rect->uly + tileHeight * index;
+        job->rect.lrx = rect->lrx;
+        job->rect.lry = job->rect.uly + tileHeight - 1;
+        if (job->rect.lry > rect->lry) {
+            job->rect.lry = rect->lry;
+        }
+        job->elevation = elevation;
+    }
+
+    // Also collects outlined objects for `obj_render_post_roof`.
+    obj_render_prepare(rect, elevation);
+    square_pin_art(rect, elevation);
+
+    art_pin_activate(true);
+    tile_compositor_running = true;
+    worker_pool_run(tile_compositor_pool, tile_compositor_render, NULL, count);
+    tile_compositor_running = false;
+    art_unpin_all();
+
+    return true;
+}
+
+static void tile_compositor_render(void* data, int index)
+{
+    TileCompositorJob* job = &(tile_compositor_jobs[index]);
+
+    square_render_floor(&(job->rect), job->elevation);
+    obj_render_pre_roof_list(&(job->rect), job->elevation, job->renderList);
+    square_render_roof(&(job->rect), job->elevation);
 }
 
 // 0x4B1634
@@ -1457,6 +1623,84 @@ void square_render_floor(Rect* rect, int elevation)
     }
 }
 
+// Pins art of floor and roof tiles `square_render_floor` and
+// `square_render_roof` draw in `rect`.
+static void square_pin_art(Rect* rect, int elevation)
+{
+    int minX;
+    int minY;
+    int maxX;
+    int maxY;
+    int temp;
+
+    if (art_get_disable(OBJ_TYPE_TILE) == 0) {
+        square_xy(rect->ulx, rect->uly, elevation, &temp, &minY);
+        square_xy(rect->lrx, rect->uly, elevation, &minX, &temp);
+        square_xy(rect->ulx, rect->lry, elevation, &maxX, &temp);
+        square_xy(rect->lrx, rect->lry, elevation, &temp, &maxY);
+
+        if (minX < 0) {
+            minX = 0;
+        }
+
+        if (minY < 0) {
+            minY = 0;
+        }
+
+        if (maxX >= square_width) {
+            maxX = square_width - 1;
+        }
+
+        if (maxY >= square_length) {
+            maxY = square_length - 1;
+        }
+
+        for (int y = minY; y <= maxY; y++) {
+            for (int x = minX; x <= maxX; x++) {
+                int frmId = squares[elevation]->field_0[square_width * y + x];
+                if ((((frmId & 0xF000) >> 12) & 0x01) == 0) {
+                    art_pin(art_id(OBJ_TYPE_TILE, frmId & 0xFFF, 0, 0, 0));
+                }
+            }
+        }
+    }
+
+    if (show_roof) {
+        square_xy_roof(rect->ulx, rect->uly, elevation, &temp, &minY);
+        square_xy_roof(rect->lrx, rect->uly, elevation, &minX, &temp);
+        square_xy_roof(rect->ulx, rect->lry, elevation, &maxX, &temp);
+        square_xy_roof(rect->lrx, rect->lry, elevation, &temp, &maxY);
+
+        if (minX < 0) {
+            minX = 0;
+        }
+
+        if (minY < 0) {
+            minY = 0;
+        }
+
+        if (maxX >= square_width) {
+            maxX = square_width - 1;
+        }
+
+        if (maxY >= square_length) {
+            maxY = square_length - 1;
+        }
+
+        for (int y = minY; y <= maxY; y++) {
+            for (int x = minX; x <= maxX; x++) {
+                int frmId = squares[elevation]->field_0[square_width * y + x] >> 16;
+                if ((((frmId & 0xF000) >> 12) & 0x01) == 0) {
+                    int fid = art_id(OBJ_TYPE_TILE, frmId & 0xFFF, 0, 0, 0);
+                    if (fid != art_id(OBJ_TYPE_TILE, 1, 0, 0, 0)) {
+                        art_pin(fid);
+                    }
+                }
+            }
+        }
+    }
+}
+
 // 0x4B2B10
 bool square_roof_intersect(int x, int y, int elevation)
 {
@@ -1625,6 +1869,14 @@ void floor_draw(int fid, int x, int y, Rect* rect)
         return;
     }
 
+    // NOTE: Intensity map and vertex light levels were globals in the
+    // original code (`intensity_map` at 0x668224 and `field_C` of
+    // `verticies`). They are kept on stack so that floor can be drawn from
+    // several threads at once, only first vertex level is carried over in
+    // `verticies` outside of compositor.
+    int intensityMap[3280];
+    int vertexLight[10];
+
     int elev = map_elevation;
     int left = rect->ulx;
     int top = rect->uly;
@@ -1693,6 +1945,16 @@ void floor_draw(int fid, int x, int y, Rect* rect)
     v15 = tile_num(savedX, savedY + 13, map_elevation);
     if (v15 != -1) {
         int v17 = light_get_ambient();
+
+        // NOTE: First vertex is skipped for odd tiles, so it keeps level
+        // from the previous call. Compositor threads have no previous call to
+        // speak of and use ambient light instead.
+        if (tile_compositor_running) {
+            vertexLight[0] = v17;
+        } else {
+            vertexLight[0] = verticies[0].field_C;
+        }
+
         for (int i = v15 & 1; i < 10; i++) {
             // NOTE: calling light_get_tile two times, probably a result of using __min kind macro
             int v21 = light_get_tile(elev, v15 + verticies[i].field_4);
@@ -1700,12 +1962,16 @@ void floor_draw(int fid, int x, int y, Rect* rect)
                 v21 = v17;
             }
 
-            verticies[i].field_C = v21;
+            vertexLight[i] = v21;
+        }
+
+        if (!tile_compositor_running) {
+            verticies[0].field_C = vertexLight[0];
         }
 
         int v23 = 0;
         for (int i = 0; i < 9; i++) {
-            if (verticies[i + 1].field_C != verticies[i].field_C) {
+            if (vertexLight[i + 1] != vertexLight[i]) {
                 break;
             }
 
@@ -1714,19 +1980,19 @@ void floor_draw(int fid, int x, int y, Rect* rect)
 
         if (v23 == 9) {
             unsigned char* frame_data = art_frame_data(art, 0, 0);
-            dark_trans_buf_to_buf(frame_data + frameWidth * v78 + v79, v77, v76, frameWidth, buf, x, y, buf_full, verticies[0].field_C);
+            dark_trans_buf_to_buf(frame_data + frameWidth * v78 + v79, v77, v76, frameWidth, buf, x, y, buf_full, vertexLight[0]);
             goto out;
         }
 
         for (int i = 0; i < 5; i++) {
             STRUCT_51DB0C* ptr_51DB0C = &(rightside_up_triangles[i]);
-            int v32 = verticies[ptr_51DB0C->field_8].field_C;
+            int v32 = vertexLight[ptr_51DB0C->field_8];
             int v33 = verticies[ptr_51DB0C->field_8].field_0;
-            int v34 = verticies[ptr_51DB0C->field_4].field_C - verticies[ptr_51DB0C->field_0].field_C;
+            int v34 = vertexLight[ptr_51DB0C->field_4] - vertexLight[ptr_51DB0C->field_0];
             // TODO: Probably wrong.
             int v35 = v34 / 32;
-            int v36 = (verticies[ptr_51DB0C->field_0].field_C - v32) / 13;
-            int* v37 = &(intensity_map[v33]);
+            int v36 = (vertexLight[ptr_51DB0C->field_0] - v32) / 13;
+            int* v37 = &(intensityMap[v33]);
             if (v35 != 0) {
                 if (v36 != 0) {
                     for (int i = 0; i < 13; i++) {
@@ -1774,13 +2040,13 @@ void floor_draw(int fid, int x, int y, Rect* rect)
 
         for (int i = 0; i < 5; i++) {
             STRUCT_51DB48* ptr_51DB48 = &(upside_down_triangles[i]);
-            int v50 = verticies[ptr_51DB48->field_0].field_C;
+            int v50 = vertexLight[ptr_51DB48->field_0];
             int v51 = verticies[ptr_51DB48->field_0].field_0;
-            int v52 = verticies[ptr_51DB48->field_8].field_C - v50;
+            int v52 = vertexLight[ptr_51DB48->field_8] - v50;
             // TODO: Probably wrong.
             int v53 = v52 / 32;
-            int v54 = (verticies[ptr_51DB48->field_4].field_C - v50) / 13;
-            int* v55 = &(intensity_map[v51]);
+            int v54 = (vertexLight[ptr_51DB48->field_4] - v50) / 13;
+            int* v55 = &(intensityMap[v51]);
             if (v53 != 0) {
                 if (v54 != 0) {
                     for (int i = 0; i < 13; i++) {
@@ -1828,7 +2094,7 @@ void floor_draw(int fid, int x, int y, Rect* rect)
 
         unsigned char* v66 = buf + buf_full * y + x;
         unsigned char* v67 = art_frame_data(art, 0, 0) + frameWidth * v78 + v79;
-        int* v68 = &(intensity_map[160 + 80 * v78]) + v79;
+        int* v68 = &(intensityMap[160 + 80 * v78]) + v79;
         int v86 = frameWidth - v77;
         int v85 = buf_full - v77;
         int v87 = 80 - v77;
@@ -21,6 +21,7 @@
 #include "game/gsound.h"
 #include "game/intface.h"
 #include "game/item.h"
+#include "game/map.h"
 #include "game/map_defs.h"
 #include "game/message.h"
 #include "game/object.h"
@@ -107,6 +108,7 @@ static int RegTMAPsels(int win, int city);
 static void UnregTMAPsels(int count);
 static void DrawTMAPsels(int win, int city);
 static void CalcTimeAdder();
+static void PrefetchTownMusic(int town, int section);
 static void BlackOut();
 
 // 0x4A9330
@@ -1062,6 +1064,7 @@ int world_map(WorldMapContext ctx)
 
         reselect = 1;
         TargetTown(ctx.town);
+        PrefetchTownMusic(ctx.town, ctx.section);
         entering_city = ctx.town;
         is_moving_to_town = 1;
         is_moving = 1;
@@ -1169,6 +1172,7 @@ int world_map(WorldMapContext ctx)
                         if (temp_town != InCity(world_xpos, world_ypos) || temp_town == -1) {
                             autofollow = !is_moving;
                             TargetTown(temp_town);
+                            PrefetchTownMusic(temp_town, 0);
                             is_moving = 1;
                             is_moving_to_town = 1;
                         } else {
@@ -3684,6 +3688,25 @@ int PlayCityMapMusic()
     return -1;
 }
 
+// Starts loading music of the given map in background, so that
+// `PlayCityMapMusic` does not have to wait for it.
+void PrefetchCityMapMusic(int map_idx)
+{
+    if (map_idx >= 0 && map_idx < MAP_COUNT) {
+        gsound_background_prefetch(CityMusic[map_idx]);
+    }
+}
+
+// Prefetches music of the map party is travelling to.
+static void PrefetchTownMusic(int town, int section)
+{
+    if (town < 0 || town >= TOWN_COUNT) {
+        return;
+    }
+
+    PrefetchCityMapMusic(map_match_map_name(TownHotSpots[town][section].name));
+}
+
 // 0x4AEBA0
 static void BlackOut()
 {
@@ -159,5 +159,6 @@ void KillWorldWin();
 int worldmap_script_jump(int city, int a2);
 int xlate_mapidx_to_town(int map_idx);
 int PlayCityMapMusic();
+void PrefetchCityMapMusic(int map_idx);
 
 #endif /* FALLOUT_GAME_WORLDMAP_H_ */
@@ -10,14 +10,48 @@
 #include "plib/gnw/debug.h"
 #include "sound_decoder.h"
 
+// Number of files `audioPreload` keeps in memory.
+#define AUDIO_PRELOAD_CAPACITY 8
+
 typedef enum AudioFlags {
     AUDIO_FILE_IN_USE = 0x01,
     AUDIO_FILE_COMPRESSED = 0x02,
 } AudioFlags;
 
+// File read ahead of time by `audioPreload`. Its data is shared with every
+// stream opened from it and stays in memory until it is evicted to make room
+// for another file.
+typedef struct AudioPreload {
+    char path[80];
+    unsigned char* data;
+    int size;
+
+    // Number of bytes read so far, file is complete when it reaches `size`.
+    int loaded;
+
+    // Open while file is being read.
+    DB_FILE* stream;
+
+    // Number of open streams using `data`.
+    int refs;
+
+    unsigned int stamp;
+} AudioPreload;
+
+// File contents. Files are read in full on open, so reading and decoding
+// them later does not touch database and can be done from sound thread.
+typedef struct AudioStream {
+    unsigned char* data;
+    int size;
+    int position;
+
+    // Owner of `data` when it was opened from preloaded file.
+    AudioPreload* preload;
+} AudioStream;
+
 typedef struct Audio {
     int flags;
-    DB_FILE* stream;
+    AudioStream* stream;
     AudioDecoder* audioDecoder;
     int fileSize;
     int sampleRate;
@@ -27,6 +61,12 @@ typedef struct Audio {
 
 static bool defaultCompressionFunc(char* filePath);
 static int decodeRead(void* stream, void* buf, unsigned int size);
+static int decodeSeek(void* stream, int offset);
+static AudioStream* audioStreamOpen(const char* path, const char* mode);
+static void audioStreamClose(AudioStream* stream);
+static AudioPreload* audioPreloadFind(const char* path);
+static int audioPreloadRead(AudioPreload* preload, int size);
+static void audioPreloadFree(AudioPreload* preload);
 
 // 0x4FEC00
 static AudioQueryCompressedFunc* queryCompressedFunc = defaultCompressionFunc;
@@ -37,6 +77,10 @@ static int numAudio;
 // 0x56B864
 static Audio* audio;
 
+static AudioPreload audioPreloads[AUDIO_PRELOAD_CAPACITY];
+
+static unsigned int audioPreloadStamp;
+
 // 0x4198F0
 static bool defaultCompressionFunc(char* filePath)
 {
@@ -51,7 +95,244 @@ static bool defaultCompressionFunc(char* filePath)
 // 0x419910
 static int decodeRead(void* stream, void* buffer, unsigned int size)
 {
-    return db_fread(buffer, 1, size, (DB_FILE*)stream);
+    AudioStream* audioStream = (AudioStream*)stream;
+    unsigned int remaining = audioStream->size - audioStream->position;
+
+    if (size > remaining) {
+        size = remaining;
+    }
+
+    memcpy(buffer, audioStream->data + audioStream->position, size);
+    audioStream->position += size;
+
+    return size;
+}
+
+static int decodeSeek(void* stream, int offset)
+{
+    AudioStream* audioStream = (AudioStream*)stream;
+
+    if (offset < 0 || offset > audioStream->size) {
+        return -1;
+    }
+
+    audioStream->position = offset;
+
+    return 0;
+}
+
+static AudioStream* audioStreamOpen(const char* path, const char* mode)
+{
+    DB_FILE* stream;
+    AudioStream* audioStream;
+    AudioPreload* preload;
+
+    preload = audioPreloadFind(path);
+    if (preload != NULL && audioPreloadRead(preload, preload->size - preload->loaded) == 0) {
+        audioStream = (AudioStream*)mymalloc(sizeof(*audioStream), __FILE__, __LINE__);
+        if (audioStream == NULL) {
+            return NULL;
+        }
+
+        audioStream->data = preload->data;
+        audioStream->size = preload->size;
+        audioStream->position = 0;
+        audioStream->preload = preload;
+
+        preload->refs++;
+        preload->stamp = ++audioPreloadStamp;
+
+        return audioStream;
+    }
+
+    stream = db_fopen(path, mode);
+    if (stream == NULL) {
+        return NULL;
+    }
+
+    audioStream = (AudioStream*)mymalloc(sizeof(*audioStream), __FILE__, __LINE__);
+    if (audioStream == NULL) {
+        db_fclose(stream);
+        return NULL;
+    }
+
+    audioStream->size = db_filelength(stream);
+    audioStream->position = 0;
+    audioStream->preload = NULL;
+    audioStream->data = (unsigned char*)mymalloc(audioStream->size > 0 ? audioStream->size : 1, __FILE__, __LINE__);
+    if (audioStream->data == NULL) {
+        myfree(audioStream, __FILE__, __LINE__);
+        db_fclose(stream);
+        return NULL;
+    }
+
+    if (db_fread(audioStream->data, 1, audioStream->size, stream) != (size_t)audioStream->size) {
+        audioStreamClose(audioStream);
+        db_fclose(stream);
+        return NULL;
+    }
+
+    db_fclose(stream);
+
+    return audioStream;
+}
+
+static void audioStreamClose(AudioStream* stream)
+{
+    if (stream->preload != NULL) {
+        stream->preload->refs--;
+    } else {
+        myfree(stream->data, __FILE__, __LINE__);
+    }
+
+    myfree(stream, __FILE__, __LINE__);
+}
+
+static AudioPreload* audioPreloadFind(const char* path)
+{
+    for (int index = 0; index < AUDIO_PRELOAD_CAPACITY; index++) {
+        AudioPreload* preload = &(audioPreloads[index]);
+        if (preload->data != NULL && stricmp(preload->path, path) == 0) {
+            return preload;
+        }
+    }
+
+    return NULL;
+}
+
+// Reads up to `size` more bytes of preloaded file. Unreadable file is
+// dropped from the cache.
+static int audioPreloadRead(AudioPreload* preload, int size)
+{
+    if (size > preload->size - preload->loaded) {
+        size = preload->size - preload->loaded;
+    }
+
+    if (size > 0) {
+        if (db_fread(preload->data + preload->loaded, 1, size, preload->stream) != (size_t)size) {
+            audioPreloadFree(preload);
+            return -1;
+        }
+
+        preload->loaded += size;
+    }
+
+    if (preload->loaded == preload->size && preload->stream != NULL) {
+        db_fclose(preload->stream);
+        preload->stream = NULL;
+    }
+
+    return 0;
+}
+
+static void audioPreloadFree(AudioPreload* preload)
+{
+    if (preload->stream != NULL) {
+        db_fclose(preload->stream);
+    }
+
+    if (preload->data != NULL) {
+        myfree(preload->data, __FILE__, __LINE__);
+    }
+
+    memset(preload, 0, sizeof(*preload));
+}
+
+// Queues file to be read into memory by `audioPreloadUpdate`, so opening it
+// later does not wait for database. Files already in memory are marked as
+// recently used. Returns -1 if file does not exist or every slot is taken by
+// a file which is currently playing.
+int audioPreload(const char* fname)
+{
+    char path[80];
+    AudioPreload* preload;
+
+    snprintf(path, sizeof(path), "%s", fname);
+    queryCompressedFunc(path);
+
+    preload = audioPreloadFind(path);
+    if (preload != NULL) {
+        preload->stamp = ++audioPreloadStamp;
+        return 0;
+    }
+
+    for (int index = 0; index < AUDIO_PRELOAD_CAPACITY; index++) {
+        AudioPreload* candidate = &(audioPreloads[index]);
+        if (candidate->data == NULL) {
+            preload = candidate;
+            break;
+        }
+
+        if (candidate->refs == 0 && (preload == NULL || candidate->stamp < preload->stamp)) {
+            preload = candidate;
+        }
+    }
+
+    if (preload == NULL) {
+        return -1;
+    }
+
+    audioPreloadFree(preload);
+
+    preload->stream = db_fopen(path, "rb");
+    if (preload->stream == NULL) {
+        return -1;
+    }
+
+    preload->size = db_filelength(preload->stream);
+    preload->data = (unsigned char*)mymalloc(preload->size > 0 ? preload->size : 1, __FILE__, __LINE__);
+    if (preload->data == NULL) {
+        audioPreloadFree(preload);
+        return -1;
+    }
+
+    strcpy(preload->path, path);
+    preload->stamp = ++audioPreloadStamp;
+
+    return 0;
+}
+
+// Reads at most `budget` bytes of queued files. Returns `true` if there are
+// still files to read.
+bool audioPreloadUpdate(int budget)
+{
+    bool pending = false;
+
+    for (int index = 0; index < AUDIO_PRELOAD_CAPACITY; index++) {
+        AudioPreload* preload = &(audioPreloads[index]);
+        if (preload->data == NULL || preload->loaded == preload->size) {
+            continue;
+        }
+
+        if (budget > 0) {
+            int size = preload->size - preload->loaded;
+            if (size > budget) {
+                size = budget;
+            }
+
+            if (audioPreloadRead(preload, size) != 0) {
+                continue;
+            }
+
+            budget -= size;
+        }
+
+        if (preload->data != NULL && preload->loaded < preload->size) {
+            pending = true;
+        }
+    }
+
+    return pending;
+}
+
+// Frees preloaded files which are not playing.
+void audioPreloadFlush()
+{
+    for (int index = 0; index < AUDIO_PRELOAD_CAPACITY; index++) {
+        if (audioPreloads[index].refs == 0) {
+            audioPreloadFree(&(audioPreloads[index]));
+        }
+    }
 }
 
 // 0x41992C
@@ -88,7 +369,7 @@ int audioOpen(const char* fname, int flags)
         *pm++ = 'b';
     }
 
-    DB_FILE* stream = db_fopen(path, mode);
+    AudioStream* stream = audioStreamOpen(path, mode);
     if (stream == NULL) {
         debug_printf("AudioOpen: Couldn't open %s for read\n", path);
         return -1;
@@ -118,8 +399,12 @@ int audioOpen(const char* fname, int flags)
         audioFile->flags |= AUDIO_FILE_COMPRESSED;
         audioFile->audioDecoder = Create_AudioDecoder(decodeRead, audioFile->stream, &(audioFile->channels), &(audioFile->sampleRate), &(audioFile->fileSize));
         audioFile->fileSize *= 2;
+
+        if (audioFile->audioDecoder != NULL) {
+            AudioDecoder_EnableSeek(audioFile->audioDecoder, decodeSeek);
+        }
     } else {
-        audioFile->fileSize = db_filelength(stream);
+        audioFile->fileSize = stream->size;
     }
 
     audioFile->position = 0;
@@ -131,9 +416,9 @@ int audioOpen(const char* fname, int flags)
 int audioCloseFile(int fileHandle)
 {
     Audio* audioFile = &(audio[fileHandle - 1]);
-    db_fclose(audioFile->stream);
+    audioStreamClose(audioFile->stream);
 
-    if ((audioFile->flags & AUDIO_FILE_COMPRESSED) != 0) {
+    if ((audioFile->flags & AUDIO_FILE_COMPRESSED) != 0 && audioFile->audioDecoder != NULL) {
         AudioDecoder_Close(audioFile->audioDecoder);
     }
 
@@ -149,9 +434,13 @@ int audioRead(int fileHandle, void* buffer, unsigned int size)
 
     int bytesRead;
     if ((audioFile->flags & AUDIO_FILE_COMPRESSED) != 0) {
+        if (audioFile->audioDecoder == NULL) {
+            return 0;
+        }
+
         bytesRead = AudioDecoder_Read(audioFile->audioDecoder, buffer, size);
     } else {
-        bytesRead = db_fread(buffer, 1, size, audioFile->stream);
+        bytesRead = decodeRead(audioFile->stream, buffer, size);
     }
 
     audioFile->position += bytesRead;
@@ -163,8 +452,6 @@ int audioRead(int fileHandle, void* buffer, unsigned int size)
 long audioSeek(int fileHandle, long offset, int origin)
 {
     int pos;
-    unsigned char* buf;
-    int v10;
 
     Audio* audioFile = &(audio[fileHandle - 1]);
 
@@ -183,44 +470,35 @@ long audioSeek(int fileHandle, long offset, int origin)
     }
 
     if ((audioFile->flags & AUDIO_FILE_COMPRESSED) != 0) {
-        if (pos < audioFile->position) {
+        // Decoder positions are in 16-bit samples.
+        if (!AudioDecoder_Seek(audioFile->audioDecoder, pos / 2)) {
+            // Decoder cannot resume from its seek index, start over.
             AudioDecoder_Close(audioFile->audioDecoder);
-            db_fseek(audioFile->stream, 0, SEEK_SET);
+            decodeSeek(audioFile->stream, 0);
             audioFile->audioDecoder = Create_AudioDecoder(decodeRead, audioFile->stream, &(audioFile->channels), &(audioFile->sampleRate), &(audioFile->fileSize));
-            audioFile->position = 0;
             audioFile->fileSize *= 2;
 
-            if (pos != 0) {
-                buf = (unsigned char*)mymalloc(4096, __FILE__, __LINE__); // "..\int\audio.c", 361
-                while (pos > 4096) {
-                    pos -= 4096;
-                    audioRead(fileHandle, buf, 4096);
-                }
-
-                if (pos != 0) {
-                    audioRead(fileHandle, buf, pos);
-                }
-
-                myfree(buf, __FILE__, __LINE__); // // "..\int\audio.c", 367
-            }
-        } else {
-            buf = (unsigned char*)mymalloc(1024, __FILE__, __LINE__); // "..\int\audio.c", 321
-            v10 = audioFile->position - pos;
-            while (v10 > 1024) {
-                v10 -= 1024;
-                audioRead(fileHandle, buf, 1024);
+            if (audioFile->audioDecoder == NULL) {
+                // Leave file at its end, reads return nothing from now on.
+                audioFile->position = audioFile->fileSize;
+                return -1;
             }
 
-            if (v10 != 0) {
-                audioRead(fileHandle, buf, v10);
-            }
-
-            // TODO: Probably leaks memory.
+            AudioDecoder_EnableSeek(audioFile->audioDecoder, decodeSeek);
+            AudioDecoder_Seek(audioFile->audioDecoder, pos / 2);
         }
 
+        audioFile->position = AudioDecoder_Tell(audioFile->audioDecoder) * 2;
+
         return audioFile->position;
     } else {
-        return db_fseek(audioFile->stream, offset, origin);
+        if (decodeSeek(audioFile->stream, pos) != 0) {
+            return -1;
+        }
+
+        audioFile->position = pos;
+
+        return 0;
     }
 }
 
@@ -262,6 +540,10 @@ void audioClose()
         myfree(audio, __FILE__, __LINE__); // "..\int\audio.c", 406
     }
 
+    for (int index = 0; index < AUDIO_PRELOAD_CAPACITY; index++) {
+        audioPreloadFree(&(audioPreloads[index]));
+    }
+
     numAudio = 0;
     audio = NULL;
 }
@@ -14,5 +14,8 @@ long audioTell(int fileHandle);
 int audioWrite(int handle, const void* buf, unsigned int size);
 int initAudio(AudioQueryCompressedFunc* isCompressedProc);
 void audioClose();
+int audioPreload(const char* fname);
+bool audioPreloadUpdate(int budget);
+void audioPreloadFlush();
 
 #endif /* FALLOUT_INT_AUDIO_H_ */
@@ -29,6 +29,7 @@ static_assert(sizeof(AudioFile) == 28, "wrong size");
 
 static bool defaultCompressionFunc(char* filePath);
 static int decodeRead(void* stream, void* buffer, unsigned int size);
+static int decodeSeek(void* stream, int offset);
 
 // 0x4FEC04
 static AudioFileQueryCompressedFunc* queryCompressedFunc = defaultCompressionFunc;
@@ -56,6 +57,11 @@ static int decodeRead(void* stream, void* buffer, unsigned int size)
     return fread(buffer, 1, size, (FILE*)stream);
 }
 
+static int decodeSeek(void* stream, int offset)
+{
+    return fseek((FILE*)stream, offset, SEEK_SET);
+}
+
 // 0x419ECC
 int audiofOpen(const char* fname, int flags)
 {
@@ -119,6 +125,10 @@ int audiofOpen(const char* fname, int flags)
         audioFile->flags |= AUDIO_FILE_COMPRESSED;
         audioFile->audioDecoder = Create_AudioDecoder(decodeRead, audioFile->stream, &(audioFile->channels), &(audioFile->sampleRate), &(audioFile->fileSize));
         audioFile->fileSize *= 2;
+
+        if (audioFile->audioDecoder != NULL) {
+            AudioDecoder_EnableSeek(audioFile->audioDecoder, decodeSeek);
+        }
     } else {
         audioFile->fileSize = filelength(fileno(stream));
     }
@@ -134,7 +144,7 @@ int audiofCloseFile(int fileHandle)
     AudioFile* audioFile = &(audiof[fileHandle - 1]);
     fclose((FILE*)audioFile->stream);
 
-    if ((audioFile->flags & AUDIO_FILE_COMPRESSED) != 0) {
+    if ((audioFile->flags & AUDIO_FILE_COMPRESSED) != 0 && audioFile->audioDecoder != NULL) {
         AudioDecoder_Close(audioFile->audioDecoder);
     }
 
@@ -152,6 +162,10 @@ int audiofRead(int fileHandle, void* buffer, unsigned int size)
 
     int bytesRead;
     if ((ptr->flags & AUDIO_FILE_COMPRESSED) != 0) {
+        if (ptr->audioDecoder == NULL) {
+            return 0;
+        }
+
         bytesRead = AudioDecoder_Read(ptr->audioDecoder, buffer, size);
     } else {
         bytesRead = fread(buffer, 1, size, ptr->stream);
@@ -165,57 +179,46 @@ int audiofRead(int fileHandle, void* buffer, unsigned int size)
 // 0x41A1B4
 long audiofSeek(int fileHandle, long offset, int origin)
 {
-    void* buf;
-    int remaining;
     int a4;
 
     AudioFile* audioFile = &(audiof[fileHandle - 1]);
 
+    // NOTE: Original code mixed up `SEEK_CUR` and `SEEK_END`.
     switch (origin) {
     case SEEK_SET:
         a4 = offset;
         break;
     case SEEK_CUR:
-        a4 = audioFile->fileSize + offset;
+        a4 = audioFile->position + offset;
         break;
     case SEEK_END:
-        a4 = audioFile->position + offset;
+        a4 = audioFile->fileSize + offset;
         break;
     default:
         assert(false && "Should be unreachable");
     }
 
     if ((audioFile->flags & AUDIO_FILE_COMPRESSED) != 0) {
-        if (a4 <= audioFile->position) {
+        // Decoder positions are in 16-bit samples.
+        if (!AudioDecoder_Seek(audioFile->audioDecoder, a4 / 2)) {
+            // Decoder cannot resume from its seek index, start over.
             AudioDecoder_Close(audioFile->audioDecoder);
             fseek(audioFile->stream, 0, SEEK_SET);
             audioFile->audioDecoder = Create_AudioDecoder(decodeRead, audioFile->stream, &(audioFile->channels), &(audioFile->sampleRate), &(audioFile->fileSize));
             audioFile->fileSize *= 2;
-            audioFile->position = 0;
-
-            if (a4) {
-                buf = mymalloc(4096, __FILE__, __LINE__); // "..\int\audiof.c", 363
-                while (a4 > 4096) {
-                    audiofRead(fileHandle, buf, 4096);
-                    a4 -= 4096;
-                }
-                if (a4 != 0) {
-                    audiofRead(fileHandle, buf, a4);
-                }
-                myfree(buf, __FILE__, __LINE__); // "..\int\audiof.c", 369
-            }
-        } else {
-            buf = mymalloc(0x400, __FILE__, __LINE__); // "..\int\audiof.c", 315
-            remaining = audioFile->position - a4;
-            while (remaining > 1024) {
-                audiofRead(fileHandle, buf, 1024);
-                remaining -= 1024;
-            }
-            if (remaining != 0) {
-                audiofRead(fileHandle, buf, remaining);
+
+            if (audioFile->audioDecoder == NULL) {
+                // Leave file at its end, reads return nothing from now on.
+                audioFile->position = audioFile->fileSize;
+                return -1;
             }
-            // TODO: Obiously leaks memory.
+
+            AudioDecoder_EnableSeek(audioFile->audioDecoder, decodeSeek);
+            AudioDecoder_Seek(audioFile->audioDecoder, a4 / 2);
         }
+
+        audioFile->position = AudioDecoder_Tell(audioFile->audioDecoder) * 2;
+
         return audioFile->position;
     }
 
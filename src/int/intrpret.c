@@ -14,10 +14,17 @@
 #include "plib/db/db.h"
 #include "plib/gnw/debug.h"
 #include "plib/gnw/input.h"
+#include "plib/gnw/profile.h"
 
 // The maximum number of opcodes.
 #define OPCODE_MAX_COUNT 342
 
+// Maximum number of literal arguments `interpretFindLiteralCall` can match.
+#define INTERPRET_LITERAL_CALL_MAX_ARGUMENTS 4
+
+// Maximum number of code bytes `interpretFindLiteralCall` looks through.
+#define INTERPRET_LITERAL_CALL_MAX_SCAN 4096
+
 // Size of internal stack in bytes (per program).
 #define STACK_SIZE 0x800
 
@@ -511,6 +518,7 @@ Program* allocateProgram(const char* path)
     program->framePointer = -1;
     program->returnStack = (unsigned char*)mycalloc(1, STACK_SIZE, __FILE__, __LINE__); // ..\int\INTRPRET.C, 411
     program->data = data;
+    program->dataSize = fileSize;
     program->procedures = data + 42;
     program->identifiers = sizeof(Procedure) * fetchLong(program->procedures, 0) + program->procedures + 4;
     program->staticStrings = program->identifiers + fetchLong(program->identifiers, 0) + 4;
@@ -3108,6 +3116,99 @@ int interpretFindProcedure(Program* program, const char* name)
     return -1;
 }
 
+// Scans procedure body for the first call of `opcode` which takes its last
+// `argumentCount` arguments as integer literals, for example to learn what
+// procedure is going to do without running it. Scanning follows code linearly
+// (branches are not taken) and stops at the first return. Returns 0 and
+// literal arguments in order they were pushed, or -1 if there is no such
+// call.
+int interpretFindLiteralCall(Program* program, int procedureIndex, opcode_t opcode, int* arguments, int argumentCount)
+{
+    unsigned char* procedurePtr;
+    int pos;
+    int end;
+    int literals[INTERPRET_LITERAL_CALL_MAX_ARGUMENTS];
+    int literalsLength;
+
+    if (argumentCount <= 0 || argumentCount > INTERPRET_LITERAL_CALL_MAX_ARGUMENTS) {
+        return -1;
+    }
+
+    if (procedureIndex < 0 || procedureIndex >= fetchLong(program->procedures, 0)) {
+        return -1;
+    }
+
+    procedurePtr = program->procedures + 4 + sizeof(Procedure) * procedureIndex;
+    if ((fetchLong(procedurePtr, 4) & PROCEDURE_FLAG_IMPORTED) != 0) {
+        return -1;
+    }
+
+    pos = fetchLong(procedurePtr, 16);
+    if (pos < 0 || pos >= program->dataSize) {
+        return -1;
+    }
+
+    end = pos + INTERPRET_LITERAL_CALL_MAX_SCAN;
+    if (end > program->dataSize) {
+        end = program->dataSize;
+    }
+
+    literalsLength = 0;
+
+    while (pos + 2 <= end) {
+        opcode_t current = fetchWord(program->data, pos);
+        pos += 2;
+
+        if ((current & RAW_VALUE_TYPE_OPCODE) == 0) {
+            break;
+        }
+
+        // Literals are the only opcodes with operand.
+        if ((current & 0x3FF) == (OPCODE_PUSH & 0x3FF)) {
+            if (pos + 4 > end) {
+                break;
+            }
+
+            if (current == VALUE_TYPE_INT) {
+                memmove(literals, literals + 1, sizeof(*literals) * (INTERPRET_LITERAL_CALL_MAX_ARGUMENTS - 1));
+                literals[INTERPRET_LITERAL_CALL_MAX_ARGUMENTS - 1] = fetchLong(program->data, pos);
+                if (literalsLength < INTERPRET_LITERAL_CALL_MAX_ARGUMENTS) {
+                    literalsLength++;
+                }
+            } else {
+                literalsLength = 0;
+            }
+            pos += 4;
+            continue;
+        }
+
+        if (current == opcode && literalsLength >= argumentCount) {
+            memcpy(arguments, literals + INTERPRET_LITERAL_CALL_MAX_ARGUMENTS - argumentCount, sizeof(*arguments) * argumentCount);
+            return 0;
+        }
+
+        switch (current) {
+        case OPCODE_EXIT:
+        case OPCODE_EXIT_PROGRAM:
+        case OPCODE_STOP_PROGRAM:
+        case OPCODE_POP_RETURN:
+        case OPCODE_POP_EXIT:
+        case OPCODE_POP_FLAGS_RETURN:
+        case OPCODE_POP_FLAGS_EXIT:
+        case OPCODE_POP_FLAGS_RETURN_EXTERN:
+        case OPCODE_POP_FLAGS_EXIT_EXTERN:
+        case OPCODE_POP_FLAGS_RETURN_VAL_EXTERN:
+        case OPCODE_POP_FLAGS_RETURN_VAL_EXIT:
+        case OPCODE_POP_FLAGS_RETURN_VAL_EXIT_EXTERN:
+            return -1;
+        }
+
+        literalsLength = 0;
+    }
+
+    return -1;
+}
+
 // 0x4619D4
 void executeProcedure(Program* program, int procedureIndex)
 {
@@ -3291,6 +3392,8 @@ void interpretSetCPUBurstSize(int value)
 // 0x461F28
 void updatePrograms()
 {
+    profile_begin(PROFILE_ZONE_SCRIPTS);
+
     ProgramListNode* curr = head;
     while (curr != NULL) {
         ProgramListNode* next = curr->next;
@@ -3304,6 +3407,8 @@ void updatePrograms()
     }
     doEvents();
     updateIntLib();
+
+    profile_end(PROFILE_ZONE_SCRIPTS);
 }
 
 // 0x461F74
@@ -160,6 +160,7 @@ typedef struct Program {
     int flags; // flags
     int windowId;
     bool exited;
+    int dataSize; // size of data in bytes
 } Program;
 
 typedef char*(InterpretMangleFunc)(char* fileName);
@@ -187,6 +188,7 @@ void interpretEnableInterpreter(int enabled);
 void interpret(Program* program, int a2);
 void executeProc(Program* program, int procedureIndex);
 int interpretFindProcedure(Program* prg, const char* name);
+int interpretFindLiteralCall(Program* program, int procedureIndex, opcode_t opcode, int* arguments, int argumentCount);
 void executeProcedure(Program* program, int procedureIndex);
 void runProgram(Program* program);
 Program* runScript(char* name);
@@ -14,12 +14,32 @@
 #include "plib/gnw/gnw.h"
 #include "plib/gnw/grbuf.h"
 #include "plib/gnw/input.h"
+#include "plib/gnw/profile.h"
 #include "plib/gnw/svga.h"
 #include "plib/gnw/text.h"
+#include "plib/gnw/thread.h"
 #include "plib/gnw/winmain.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MOVIE_SSE2
+#include <emmintrin.h>
+#endif
+
 typedef void(MovieCallback)();
 typedef int(MovieBlitFunc)(int win, unsigned char* data, int width, int height, int pitch);
+typedef void(MovieScaleRowsFunc)(unsigned char* dest, int destPitch, unsigned char* src, int srcPitch, int width, int height);
+
+// Horizontal bands of the frame being scaled by worker pool.
+typedef struct MovieScaleJob {
+    MovieScaleRowsFunc* func;
+    unsigned char* dest;
+    int destPitch;
+    unsigned char* src;
+    int srcPitch;
+    int width;
+    int height;
+    int bands;
+} MovieScaleJob;
 
 typedef struct MovieSubtitleListNode {
     int num;
@@ -33,12 +53,21 @@ static bool movieRead(int fileHandle, void* buf, int count);
 static void movie_MVE_ShowFrame(LPDIRECTDRAWSURFACE a1, int a2, int a3, int a4, int a5, int a6, int a7, int a8, int a9);
 static void movieShowFrame(LPDIRECTDRAWSURFACE a1, int a2, int a3, int a4, int a5, int a6, int a7, int a8, int a9);
 static int movieScaleSubRect(int win, unsigned char* data, int width, int height, int pitch);
+static void movieScaleSubRectRows(unsigned char* dest, int destPitch, unsigned char* src, int srcPitch, int width, int height);
+static void movieScaleWindowRows(unsigned char* dest, int destPitch, unsigned char* src, int srcPitch, int width, int height);
+#ifdef MOVIE_SSE2
+static inline __m128i movieScaleTriples_sse2(__m128i triples, bool repeat);
+#endif
+static void movieScaleRows(MovieScaleRowsFunc* func, unsigned char* dest, int destPitch, unsigned char* src, int srcPitch, int width, int height);
+static void movieScaleBand(void* data, int index);
 static int movieScaleWindowAlpha(int win, unsigned char* data, int width, int height, int pitch);
 static int movieScaleSubRectAlpha(int win, unsigned char* data, int width, int height, int pitch);
 static int blitAlpha(int win, unsigned char* data, int width, int height, int pitch);
 static int movieScaleWindow(int win, unsigned char* data, int width, int height, int pitch);
 static int blitNormal(int win, unsigned char* data, int width, int height, int pitch);
 static void movieSetPalette(unsigned char* palette, int start, int end);
+static void movieBenchmarkShowFrame(LPDIRECTDRAWSURFACE surface, int srcWidth, int srcHeight, int srcX, int srcY, int destWidth, int destHeight, int a8, int a9);
+static void movieBenchmarkSetPalette(unsigned char* palette, int start, int end);
 static int noop();
 static void cleanupMovie(int a1);
 static void cleanupLast();
@@ -208,6 +237,17 @@ static DB_FILE* alphaHandle;
 // 0x637418
 static unsigned char* alphaBuf;
 
+// Worker pool scaling frames, `NULL` when movies are single-threaded.
+static WorkerPool* moviePool = NULL;
+
+// Scratch window for frames scaled by `movieBenchmark`.
+static unsigned char* movieBenchmarkBuffer = NULL;
+static int movieBenchmarkBufferSize = 0;
+
+static unsigned int movieBenchmarkHash;
+static unsigned long long movieBenchmarkScaleTime;
+static unsigned long long movieBenchmarkShowTime;
+
 // 0x4783F0
 void movieSetPreDrawFunc(MoviePreDrawFunc* func)
 {
@@ -440,10 +480,32 @@ static int movieScaleSubRect(int win, unsigned char* data, int width, int height
         return 0;
     }
 
+    // Every row writes `width / 3 + width` bytes and skips the rest of the
+    // movie rect.
+    movieScaleRows(movieScaleSubRectRows, windowBuffer, width / 3 + width + windowWidth - movieW, data, pitch, width, height);
+
+    return 1;
+}
+
+static void movieScaleSubRectRows(unsigned char* dest, int destPitch, unsigned char* src, int srcPitch, int width, int height)
+{
     int v1 = width / 3;
     for (int y = 0; y < height; y++) {
-        int x;
-        for (x = 0; x < v1; x++) {
+        unsigned char* windowBuffer = dest + destPitch * y;
+        unsigned char* data = src + srcPitch * y;
+        int x = 0;
+
+#ifdef MOVIE_SSE2
+        // Every load takes 16 bytes for 4 triples, stay 2 triples away from
+        // the end of the row.
+        for (; x + 6 <= v1; x += 4) {
+            _mm_storeu_si128((__m128i*)windowBuffer, movieScaleTriples_sse2(_mm_loadu_si128((__m128i*)data), true));
+            windowBuffer += 16;
+            data += 12;
+        }
+#endif
+
+        for (; x < v1; x++) {
             unsigned int value = data[0];
             value |= data[1] << 8;
             value |= data[2] << 16;
@@ -458,12 +520,7 @@ static int movieScaleSubRect(int win, unsigned char* data, int width, int height
         for (x = x * 3; x < width; x++) {
             *windowBuffer++ = *data++;
         }
-
-        data += pitch - width;
-        windowBuffer += windowWidth - movieW;
     }
-
-    return 1;
 }
 
 // 0x478A84
@@ -498,10 +555,31 @@ static int movieScaleWindow(int win, unsigned char* data, int width, int height,
         return 0;
     }
 
+    // Rows are packed one after another, source skips `pitch - width` after
+    // the last whole triple.
     unsigned char* windowBuffer = win_get_buf(win);
+    movieScaleRows(movieScaleWindowRows, windowBuffer, width / 3 * 4, data, width / 3 * 3 + pitch - width, width, height);
+
+    return 1;
+}
+
+static void movieScaleWindowRows(unsigned char* dest, int destPitch, unsigned char* src, int srcPitch, int width, int height)
+{
     for (int y = 0; y < height; y++) {
+        unsigned char* windowBuffer = dest + destPitch * y;
+        unsigned char* data = src + srcPitch * y;
         int scaledWidth = width / 3;
-        for (int x = 0; x < scaledWidth; x++) {
+        int x = 0;
+
+#ifdef MOVIE_SSE2
+        for (; x + 6 <= scaledWidth; x += 4) {
+            _mm_storeu_si128((__m128i*)windowBuffer, movieScaleTriples_sse2(_mm_loadu_si128((__m128i*)data), false));
+            windowBuffer += 16;
+            data += 12;
+        }
+#endif
+
+        for (; x < scaledWidth; x++) {
             unsigned int value = data[0];
             value |= data[1] << 8;
             value |= data[2] << 16;
@@ -512,10 +590,73 @@ static int movieScaleWindow(int win, unsigned char* data, int width, int height,
             windowBuffer += 4;
             data += 3;
         }
-        data += pitch - width;
     }
+}
 
-    return 1;
+#ifdef MOVIE_SSE2
+// Stretches 4 triples of pixels at the bottom of `triples` to 4 quads. Fourth
+// pixel of every quad either repeats the third one (as in
+// `movieScaleSubRectRows`) or is taken from the next triple (as in
+// `movieScaleWindowRows`).
+static inline __m128i movieScaleTriples_sse2(__m128i triples, bool repeat)
+{
+    __m128i quads;
+
+    if (repeat) {
+        quads = _mm_and_si128(triples, _mm_set_epi32(0, 0, 0, 0x00FFFFFF));
+        quads = _mm_or_si128(quads, _mm_and_si128(_mm_slli_si128(triples, 1), _mm_set_epi32(0, 0, 0x00FFFFFF, 0)));
+        quads = _mm_or_si128(quads, _mm_and_si128(_mm_slli_si128(triples, 2), _mm_set_epi32(0, 0x00FFFFFF, 0, 0)));
+        quads = _mm_or_si128(quads, _mm_and_si128(_mm_slli_si128(triples, 3), _mm_set_epi32(0x00FFFFFF, 0, 0, 0)));
+        quads = _mm_or_si128(quads, _mm_and_si128(_mm_slli_si128(quads, 1), _mm_set1_epi32((int)0xFF000000)));
+    } else {
+        quads = _mm_and_si128(triples, _mm_set_epi32(0, 0, 0, -1));
+        quads = _mm_or_si128(quads, _mm_and_si128(_mm_slli_si128(triples, 1), _mm_set_epi32(0, 0, -1, 0)));
+        quads = _mm_or_si128(quads, _mm_and_si128(_mm_slli_si128(triples, 2), _mm_set_epi32(0, -1, 0, 0)));
+        quads = _mm_or_si128(quads, _mm_and_si128(_mm_slli_si128(triples, 3), _mm_set_epi32(-1, 0, 0, 0)));
+    }
+
+    return quads;
+}
+#endif
+
+// Runs row scaler over the frame, splitting it into horizontal bands between
+// movie worker pool threads.
+static void movieScaleRows(MovieScaleRowsFunc* func, unsigned char* dest, int destPitch, unsigned char* src, int srcPitch, int width, int height)
+{
+    MovieScaleJob job;
+
+    if (moviePool == NULL) {
+        func(dest, destPitch, src, srcPitch, width, height);
+        return;
+    }
+
+    job.func = func;
+    job.dest = dest;
+    job.destPitch = destPitch;
+    job.src = src;
+    job.srcPitch = srcPitch;
+    job.width = width;
+    job.height = height;
+    job.bands = worker_pool_get_size(moviePool) + 1;
+    if (job.bands > height) {
+        job.bands = height;
+    }
+
+    worker_pool_run(moviePool, movieScaleBand, &job, job.bands);
+}
+
+static void movieScaleBand(void* data, int index)
+{
+    MovieScaleJob* job = (MovieScaleJob*)data;
+    int start = job->height * index / job->bands;
+    int end = job->height * (index + 1) / job->bands;
+
+    job->func(job->dest + job->destPitch * start,
+        job->destPitch,
+        job->src + job->srcPitch * start,
+        job->srcPitch,
+        job->width,
+        end - start);
 }
 
 // 0x478B94
@@ -553,6 +694,152 @@ void initMovie()
     movieLibSetReadProc(movieRead);
 }
 
+// Sets up threaded movie playback with given number of worker threads (in
+// addition to the main thread). Video is decoded on its own thread ahead of
+// playback and frames are scaled by the rest. Zero goes back to
+// single-threaded playback, negative value means one per each additional CPU.
+int movieSetThreads(int threads)
+{
+    if (running) {
+        return -1;
+    }
+
+    if (moviePool != NULL) {
+        worker_pool_free(moviePool);
+        moviePool = NULL;
+    }
+
+    if (threads < 0) {
+        threads = thread_get_cpu_count() - 1;
+    }
+
+    if (threads <= 0) {
+        movieLibSetThreaded(false);
+        return 0;
+    }
+
+    if (!movieLibSetThreaded(true)) {
+        debug_printf("movieSetThreads: failed to start decode thread\n");
+        return -1;
+    }
+
+    // Decode thread takes one of them.
+    if (threads > 1) {
+        moviePool = worker_pool_create(threads - 1);
+        if (moviePool == NULL) {
+            debug_printf("movieSetThreads: failed to create worker pool\n");
+        }
+    }
+
+    debug_printf("movieSetThreads: decode thread, %d scale threads\n", worker_pool_get_size(moviePool));
+
+    return 0;
+}
+
+// Decodes movie as fast as possible without playing it. Frames are scaled to
+// scratch buffer the same way `movieScaleSubRect` does and hashed, so decoder
+// and scaler changes can be checked to be bit-exact. Returns number of frames
+// or -1 if movie cannot be decoded.
+int movieBenchmark(char* filePath, unsigned int* hashPtr, unsigned long long* decodeTimePtr, unsigned long long* scaleTimePtr)
+{
+    DB_FILE* stream;
+    unsigned long long start;
+    int frames;
+    int dropped;
+
+    if (running) {
+        return -1;
+    }
+
+    stream = db_fopen(filePath, "rb");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    movieBenchmarkHash = 2166136261U;
+    movieBenchmarkScaleTime = 0;
+    movieBenchmarkShowTime = 0;
+
+    movieLibSetDirectSound(NULL);
+    movieLibSetPaletteEntriesProc(movieBenchmarkSetPalette);
+    movieLibSetSync(false);
+    _MVE_rmCallbacks(noop);
+    _MVE_sfCallbacks(movieBenchmarkShowFrame);
+
+    frames = -1;
+
+    if (_MVE_rmPrepMovie((int)stream, 0, 0, 0) == 0) {
+        start = profile_get_time();
+        while (_MVE_rmStepMovie() == 0) {
+        }
+
+        *decodeTimePtr += profile_get_time() - start - movieBenchmarkShowTime;
+        *scaleTimePtr += movieBenchmarkScaleTime;
+
+        _MVE_rmFrameCounts(&frames, &dropped);
+        _MVE_rmEndMovie();
+    }
+
+    _MVE_ReleaseMem();
+    db_fclose(stream);
+
+    movieLibSetSync(true);
+    movieLibSetPaletteEntriesProc(movieSetPalette);
+    movieLibSetDirectSound(soundDSObject);
+
+    if (movieBenchmarkBuffer != NULL) {
+        myfree(movieBenchmarkBuffer, __FILE__, __LINE__);
+        movieBenchmarkBuffer = NULL;
+        movieBenchmarkBufferSize = 0;
+    }
+
+    if (frames != -1) {
+        *hashPtr = (*hashPtr ^ movieBenchmarkHash) * 16777619U;
+    }
+
+    return frames;
+}
+
+static void movieBenchmarkShowFrame(LPDIRECTDRAWSURFACE surface, int srcWidth, int srcHeight, int srcX, int srcY, int destWidth, int destHeight, int a8, int a9)
+{
+    unsigned long long start = profile_get_time();
+    unsigned long long scaleStart;
+    int scaledWidth = srcWidth / 3 + srcWidth;
+    int size = scaledWidth * srcHeight;
+
+    if (size > movieBenchmarkBufferSize) {
+        movieBenchmarkBuffer = (unsigned char*)myrealloc(movieBenchmarkBuffer, size, __FILE__, __LINE__);
+        movieBenchmarkBufferSize = movieBenchmarkBuffer != NULL ? size : 0;
+    }
+
+    DDSURFACEDESC ddsd;
+    ddsd.dwSize = sizeof(DDSURFACEDESC);
+
+    if (movieBenchmarkBuffer != NULL && IDirectDrawSurface_Lock(surface, NULL, &ddsd, 1, NULL) == DD_OK) {
+        scaleStart = profile_get_time();
+        movieScaleRows(movieScaleSubRectRows,
+            movieBenchmarkBuffer,
+            scaledWidth,
+            (unsigned char*)ddsd.lpSurface + ddsd.lPitch * srcY + srcX,
+            ddsd.lPitch,
+            srcWidth,
+            srcHeight);
+        movieBenchmarkScaleTime += profile_get_time() - scaleStart;
+
+        IDirectDrawSurface_Unlock(surface, ddsd.lpSurface);
+
+        for (int index = 0; index < size; index++) {
+            movieBenchmarkHash = (movieBenchmarkHash ^ movieBenchmarkBuffer[index]) * 16777619U;
+        }
+    }
+
+    movieBenchmarkShowTime += profile_get_time() - start;
+}
+
+static void movieBenchmarkSetPalette(unsigned char* palette, int start, int end)
+{
+}
+
 // 0x478CA8
 static void cleanupMovie(int a1)
 {
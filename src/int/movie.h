@@ -34,6 +34,8 @@ void movieSetFunc(MovieStartFunc* startFunc, MovieEndFunc* endFunc);
 void movieSetFrameGrabFunc(MovieFrameGrabProc* func);
 void movieSetCaptureFrameFunc(MovieCaptureFrameProc* func);
 void initMovie();
+int movieSetThreads(int threads);
+int movieBenchmark(char* filePath, unsigned int* hashPtr, unsigned long long* decodeTimePtr, unsigned long long* scaleTimePtr);
 void movieClose();
 void movieStop();
 int movieSetFlags(int a1);
@@ -9,8 +9,19 @@
 
 #include "plib/gnw/debug.h"
 #include "plib/gnw/memory.h"
+#include "plib/gnw/profile.h"
+#include "plib/gnw/thread.h"
 #include "plib/gnw/winmain.h"
 
+// Capacity of stream ring buffer in `field_7C` sized chunks.
+#define SOUND_STREAM_CHUNKS 8
+
+// Max number of streams sound thread can serve at once.
+#define SOUND_STREAM_CAPACITY 16
+
+// How long sound thread sleeps when all streams are full (in ms).
+#define SOUND_THREAD_INTERVAL 10
+
 typedef struct FadeSound {
     Sound* sound;
     int deltaVolume;
@@ -22,7 +33,42 @@ typedef struct FadeSound {
     struct FadeSound* next;
 } FadeSound;
 
-static_assert(sizeof(Sound) == 156, "wrong size");
+typedef struct SoundChunk {
+    int size;
+
+    // Number of times the loop was restarted while reading the chunk.
+    int loops;
+
+    // Loop count was exhausted while reading the chunk.
+    bool loopEnded;
+
+    // Chunk is the last one, the end of data was reached while reading it.
+    bool end;
+} SoundChunk;
+
+// Decoded data of threaded sound. It's a single producer single consumer ring
+// of chunks: sound thread reads the file into it and advances `head`,
+// `refreshSoundBuffers` copies chunks to DirectSound buffer and advances
+// `tail`. Everything producer touches apart from the ring (file and loop
+// state) is guarded by `soundMutex`.
+//
+// Loop events are attached to chunks, so consumer reports them on its own
+// thread at the same point unthreaded sound would.
+struct SoundStream {
+    unsigned char* data;
+    SoundChunk chunks[SOUND_STREAM_CHUNKS];
+    volatile int head;
+    volatile int tail;
+
+    // Set by producer after the last chunk, consumer plays silence from then
+    // on.
+    volatile int eof;
+
+    // Producer state: loop restarts in the chunk being read, and whether loop
+    // count is exhausted.
+    int loops;
+    bool loopEnded;
+};
 
 static void* defaultMalloc(size_t size);
 static void* defaultRealloc(void* ptr, size_t size);
@@ -36,6 +82,7 @@ static int soundSeekData(int fileHandle, long offset, int origin);
 static int soundCloseData(int fileHandle);
 static char* defaultMangler(char* fname);
 static void refreshSoundBuffers(Sound* sound);
+static int readSoundBuffer(Sound* sound, unsigned char* buf, bool* endPtr);
 static int preloadBuffers(Sound* sound);
 static int addSoundData(Sound* sound, unsigned char* buf, int size);
 static void CALLBACK doTimerEvent(UINT uTimerID, UINT uMsg, DWORD_PTR dwUser, DWORD_PTR dw1, DWORD_PTR dw2);
@@ -43,6 +90,16 @@ static void removeTimedEvent(unsigned int* timerId);
 static void removeFadeSound(FadeSound* fadeSound);
 static void fadeSounds();
 static int internalSoundFade(Sound* sound, int duration, int targetVolume, int a4);
+static void soundLock();
+static void soundUnlock();
+static bool soundLooping(Sound* sound);
+static void soundStreamStart(Sound* sound);
+static void soundStreamReset(Sound* sound);
+static void soundStreamStop(Sound* sound);
+static void soundStreamConsume(Sound* sound, SoundChunk* chunk);
+static bool soundStreamFill(Sound* sound);
+static int soundThreadFill();
+static int soundThreadProc(void* data);
 
 // 0x507E04
 static FadeSound* fadeHead = NULL;
@@ -152,6 +209,19 @@ static Sound* soundMgrList;
 // 0x6651C8
 LPDIRECTSOUND soundDSObject;
 
+// Sound thread decoding threaded streams, see `soundStartThread`.
+static Thread* soundThread = NULL;
+static volatile int soundThreadQuit = 0;
+
+// Guards `soundStreams` and file and loop state of threaded sounds.
+static Mutex* soundMutex = NULL;
+
+static Sound* soundStreams[SOUND_STREAM_CAPACITY];
+
+// Software mixer used in place of DirectSound, see `soundSetMixer`.
+static MixerSink* soundMixerSink = NULL;
+static int soundMixerRate = 0;
+
 // 0x499C80
 static void* defaultMalloc(size_t size)
 {
@@ -304,6 +374,20 @@ static void refreshSoundBuffers(Sound* sound)
         v53 = (sound->readLimit + sound->field_7C - 1) / sound->field_7C;
     }
 
+    if (sound->stream != NULL && !(sound->field_3C & 0x0200)) {
+        // Take only what sound thread has decoded so far, the rest is picked
+        // up on the next refresh. Once there is nothing left to decode the
+        // rest is silence. `eof` is set after the last chunk is published, so
+        // it should be checked first.
+        if (!atomic_get(&(sound->stream->eof))) {
+            int available = atomic_get(&(sound->stream->head)) - sound->stream->tail;
+            if (available < v53) {
+                v53 = available;
+                v6 = (sound->field_70 + v53) % sound->field_78;
+            }
+        }
+    }
+
     if (v53 < sound->field_5C) {
         return;
     }
@@ -335,88 +419,54 @@ static void refreshSoundBuffers(Sound* sound)
     unsigned char* audioPtr = (unsigned char*)audioPtr1;
     int audioBytes = audioBytes1;
     while (--v53 != -1) {
+        unsigned char* src = sound->field_20;
         int bytesRead;
+        bool consumed = false;
         if (sound->field_3C & 0x0200) {
             bytesRead = sound->field_7C;
             memset(sound->field_20, 0, bytesRead);
-        } else {
-            int bytesToRead = sound->field_7C;
-            if (sound->field_58 != -1) {
-                int pos = sound->io.tell(sound->io.fd);
-                if (bytesToRead + pos > sound->field_58) {
-                    bytesToRead = sound->field_58 - pos;
-                }
+        } else if (sound->stream != NULL) {
+            SoundStream* stream = sound->stream;
+            if (stream->tail != atomic_get(&(stream->head))) {
+                int slot = stream->tail % SOUND_STREAM_CHUNKS;
+                src = stream->data + sound->field_7C * slot;
+                bytesRead = stream->chunks[slot].size;
+                soundStreamConsume(sound, &(stream->chunks[slot]));
+                consumed = true;
+            } else {
+                bytesRead = sound->field_7C;
+                memset(sound->field_20, 0, bytesRead);
+                sound->field_3C |= 0x0200;
             }
-
-            bytesRead = sound->io.read(sound->io.fd, sound->field_20, bytesToRead);
-            if (bytesRead < sound->field_7C) {
-                if (!(sound->field_3C & 0x20) || (sound->field_3C & 0x0100)) {
-                    memset(sound->field_20 + bytesRead, 0, sound->field_7C - bytesRead);
-                    sound->field_3C |= 0x0200;
-                    bytesRead = sound->field_7C;
-                } else {
-                    while (bytesRead < sound->field_7C) {
-                        if (sound->field_50 == -1) {
-                            sound->io.seek(sound->io.fd, sound->field_54, SEEK_SET);
-                            if (sound->callback != NULL) {
-                                sound->callback(sound->callbackUserData, 0x0400);
-                            }
-                        } else {
-                            if (sound->field_50 <= 0) {
-                                sound->field_58 = -1;
-                                sound->field_54 = 0;
-                                sound->field_50 = 0;
-                                sound->field_3C &= ~0x20;
-                                bytesRead += sound->io.read(sound->io.fd, sound->field_20 + bytesRead, sound->field_7C - bytesRead);
-                                break;
-                            }
-
-                            sound->field_50--;
-                            sound->io.seek(sound->io.fd, sound->field_54, SEEK_SET);
-
-                            if (sound->callback != NULL) {
-                                sound->callback(sound->callbackUserData, 0x400);
-                            }
-                        }
-
-                        if (sound->field_58 == -1) {
-                            bytesToRead = sound->field_7C - bytesRead;
-                        } else {
-                            int pos = sound->io.tell(sound->io.fd);
-                            if (sound->field_7C + bytesRead + pos <= sound->field_58) {
-                                bytesToRead = sound->field_7C - bytesRead;
-                            } else {
-                                bytesToRead = sound->field_58 - bytesRead - pos;
-                            }
-                        }
-
-                        int v20 = sound->io.read(sound->io.fd, sound->field_20 + bytesRead, bytesToRead);
-                        bytesRead += v20;
-                        if (v20 < bytesToRead) {
-                            break;
-                        }
-                    }
-                }
+        } else {
+            bool end;
+            bytesRead = readSoundBuffer(sound, sound->field_20, &end);
+            if (end) {
+                sound->field_3C |= 0x0200;
             }
         }
 
         if (bytesRead > audioBytes) {
             if (audioBytes != 0) {
-                memcpy(audioPtr, sound->field_20, audioBytes);
+                memcpy(audioPtr, src, audioBytes);
             }
 
             if (audioPtr2 != NULL) {
-                memcpy(audioPtr2, sound->field_20 + audioBytes, bytesRead - audioBytes);
+                memcpy(audioPtr2, src + audioBytes, bytesRead - audioBytes);
                 audioPtr = (unsigned char*)audioPtr2 + bytesRead - audioBytes;
                 audioBytes = audioBytes2 - bytesRead;
             } else {
                 debug_printf("Hm, no second write pointer, but buffer not big enough, this shouldn't happen\n");
             }
         } else {
-            memcpy(audioPtr, sound->field_20, bytesRead);
+            memcpy(audioPtr, src, bytesRead);
             audioPtr += bytesRead;
             audioBytes -= bytesRead;
         }
+
+        if (consumed) {
+            atomic_set(&(sound->stream->tail), sound->stream->tail + 1);
+        }
     }
 
     IDirectSoundBuffer_Unlock(sound->directSoundBuffer, audioPtr1, audioBytes1, audioPtr2, audioBytes2);
@@ -426,13 +476,101 @@ static void refreshSoundBuffers(Sound* sound)
     return;
 }
 
+// Reads next chunk of sound data into `buf`, restarting the loop when the end
+// is reached. `endPtr` is set when there is no more data, the rest of the
+// chunk is silence then.
+//
+// Threaded sounds are read on sound thread, so the loop state consumer cares
+// about is passed through the stream instead of flags and callback.
+static int readSoundBuffer(Sound* sound, unsigned char* buf, bool* endPtr)
+{
+    int bytesRead;
+    int bytesToRead = sound->field_7C;
+
+    *endPtr = false;
+
+    if (sound->field_58 != -1) {
+        int pos = sound->io.tell(sound->io.fd);
+        if (bytesToRead + pos > sound->field_58) {
+            bytesToRead = sound->field_58 - pos;
+        }
+    }
+
+    bytesRead = sound->io.read(sound->io.fd, buf, bytesToRead);
+    if (bytesRead < sound->field_7C) {
+        if (!soundLooping(sound) || (sound->field_3C & 0x0100)) {
+            memset(buf + bytesRead, 0, sound->field_7C - bytesRead);
+            *endPtr = true;
+            bytesRead = sound->field_7C;
+        } else {
+            while (bytesRead < sound->field_7C) {
+                if (sound->field_50 == -1) {
+                    sound->io.seek(sound->io.fd, sound->field_54, SEEK_SET);
+                    if (sound->stream != NULL) {
+                        sound->stream->loops++;
+                    } else if (sound->callback != NULL) {
+                        sound->callback(sound->callbackUserData, 0x0400);
+                    }
+                } else {
+                    if (sound->field_50 <= 0) {
+                        sound->field_58 = -1;
+                        sound->field_54 = 0;
+                        sound->field_50 = 0;
+                        if (sound->stream != NULL) {
+                            sound->stream->loopEnded = true;
+                        } else {
+                            sound->field_3C &= ~0x20;
+                        }
+                        bytesRead += sound->io.read(sound->io.fd, buf + bytesRead, sound->field_7C - bytesRead);
+                        break;
+                    }
+
+                    sound->field_50--;
+                    sound->io.seek(sound->io.fd, sound->field_54, SEEK_SET);
+
+                    if (sound->stream != NULL) {
+                        sound->stream->loops++;
+                    } else if (sound->callback != NULL) {
+                        sound->callback(sound->callbackUserData, 0x400);
+                    }
+                }
+
+                if (sound->field_58 == -1) {
+                    bytesToRead = sound->field_7C - bytesRead;
+                } else {
+                    int pos = sound->io.tell(sound->io.fd);
+                    if (sound->field_7C + bytesRead + pos <= sound->field_58) {
+                        bytesToRead = sound->field_7C - bytesRead;
+                    } else {
+                        bytesToRead = sound->field_58 - bytesRead - pos;
+                    }
+                }
+
+                int v20 = sound->io.read(sound->io.fd, buf + bytesRead, bytesToRead);
+                bytesRead += v20;
+                if (v20 < bytesToRead) {
+                    break;
+                }
+            }
+        }
+    }
+
+    return bytesRead;
+}
+
 // 0x49A1E4
 int soundInit(int a1, int a2, int a3, int a4, int rate)
 {
     HRESULT hr;
     DWORD v24;
 
-    if (GNW95_DirectSoundCreate(0, &soundDSObject, 0) != DS_OK) {
+    if (soundMixerSink != NULL) {
+        hr = mixer_create(soundMixerSink, soundMixerRate, true, &soundDSObject);
+    } else {
+        hr = GNW95_DirectSoundCreate(0, &soundDSObject, 0);
+    }
+
+    if (hr != DS_OK) {
         soundDSObject = NULL;
         soundErrorno = SOUND_SOS_DETECTION_FAILURE;
         return soundErrorno;
@@ -574,6 +712,8 @@ void soundClose()
         removeTimedEvent(&fadeEventHandle);
     }
 
+    soundStopThread();
+
     while (fadeFreeList != NULL) {
         FadeSound* next = fadeFreeList->next;
         freePtr(fadeFreeList);
@@ -734,6 +874,10 @@ static int preloadBuffers(Sound* sound)
         if (sound->field_20 == NULL) {
             sound->field_20 = (unsigned char*)mallocPtr(sound->field_7C);
         }
+
+        if (sound->threaded) {
+            soundStreamStart(sound);
+        }
     }
 
     return result;
@@ -752,13 +896,22 @@ int soundLoad(Sound* sound, char* filePath)
         return soundErrorno;
     }
 
+    // File IO tables can be reallocated on open while sound thread is using
+    // them.
+    soundLock();
+
     sound->io.fd = sound->io.open(nameMangler(filePath), 0x0200);
     if (sound->io.fd == -1) {
+        soundUnlock();
         soundErrorno = SOUND_FILE_NOT_FOUND;
         return soundErrorno;
     }
 
-    return preloadBuffers(sound);
+    int rc = preloadBuffers(sound);
+
+    soundUnlock();
+
+    return rc;
 }
 
 // 0x49AA88
@@ -777,6 +930,7 @@ int soundRewind(Sound* sound)
     }
 
     if (sound->field_44 & 0x02) {
+        soundLock();
         sound->io.seek(sound->io.fd, 0, SEEK_SET);
         sound->field_70 = 0;
         sound->field_74 = 0;
@@ -784,6 +938,7 @@ int soundRewind(Sound* sound)
         sound->field_3C &= 0xFD7F;
         hr = IDirectSoundBuffer_SetCurrentPosition(sound->directSoundBuffer, 0);
         preloadBuffers(sound);
+        soundUnlock();
     } else {
         hr = IDirectSoundBuffer_SetCurrentPosition(sound->directSoundBuffer, 0);
     }
@@ -948,6 +1103,10 @@ int soundDelete(Sound* sample)
         return soundErrorno;
     }
 
+    soundLock();
+
+    soundStreamStop(sample);
+
     if (sample->io.fd != -1) {
         sample->io.close(sample->io.fd);
         sample->io.fd = -1;
@@ -955,6 +1114,75 @@ int soundDelete(Sound* sample)
 
     soundMgrDelete(sample);
 
+    soundUnlock();
+
+    soundErrorno = SOUND_NO_ERROR;
+    return soundErrorno;
+}
+
+// Releases data of the sound so another file can be loaded into it with
+// `soundLoad`. Unlike `soundDelete` the sound itself stays allocated and keeps
+// its type, format, file IO and volume, and its callback is not called.
+int soundUnload(Sound* sound)
+{
+    FadeSound* curr;
+
+    if (!driverInit) {
+        soundErrorno = SOUND_NOT_INITIALIZED;
+        return soundErrorno;
+    }
+
+    if (sound == NULL) {
+        soundErrorno = SOUND_NO_SOUND;
+        return soundErrorno;
+    }
+
+    soundLock();
+
+    soundStreamStop(sound);
+
+    if (sound->io.fd != -1) {
+        sound->io.close(sound->io.fd);
+        sound->io.fd = -1;
+    }
+
+    if (sound->field_40 & SOUND_FLAG_SOUND_IS_FADING) {
+        curr = fadeHead;
+        while (curr != NULL) {
+            if (sound == curr->sound) {
+                break;
+            }
+
+            curr = curr->next;
+        }
+
+        removeFadeSound(curr);
+    }
+
+    if (sound->directSoundBuffer != NULL) {
+        if (sound->field_40 & SOUND_FLAG_SOUND_IS_PLAYING) {
+            soundStop(sound);
+        }
+
+        IDirectSoundBuffer_Release(sound->directSoundBuffer);
+        sound->directSoundBuffer = NULL;
+    }
+
+    if (sound->field_20 != NULL) {
+        freePtr(sound->field_20);
+        sound->field_20 = NULL;
+    }
+
+    sound->field_40 = 0;
+    sound->field_48 = 0;
+    sound->field_60 = 0;
+    sound->field_64 = 0;
+    sound->field_68 = 0;
+    sound->field_70 = 0;
+    sound->field_74 = 0;
+
+    soundUnlock();
+
     soundErrorno = SOUND_NO_ERROR;
     return soundErrorno;
 }
@@ -1167,6 +1395,8 @@ int soundLoop(Sound* sound, int a2)
         return soundErrorno;
     }
 
+    soundLock();
+
     if (a2) {
         sound->field_3C |= 0x20;
         sound->field_50 = a2;
@@ -1177,6 +1407,12 @@ int soundLoop(Sound* sound, int a2)
         sound->field_3C &= ~(0x20);
     }
 
+    if (sound->stream != NULL) {
+        sound->stream->loopEnded = false;
+    }
+
+    soundUnlock();
+
     soundErrorno = SOUND_NO_ERROR;
     return soundErrorno;
 }
@@ -1471,6 +1707,8 @@ void soundMgrDelete(Sound* sound)
     Sound* v10;
     Sound* v11;
 
+    soundStreamStop(sound);
+
     if (sound->field_40 & SOUND_FLAG_SOUND_IS_FADING) {
         curr = fadeHead;
 
@@ -1614,6 +1852,8 @@ int soundSetPosition(Sound* sound, int a2)
     }
 
     if (sound->field_44 & 0x02) {
+        soundLock();
+
         int v6 = a2 / sound->field_7C % sound->field_78;
 
         IDirectSoundBuffer_SetCurrentPosition(sound->directSoundBuffer, v6 * sound->field_7C + a2 % sound->field_7C);
@@ -1638,6 +1878,20 @@ int soundSetPosition(Sound* sound, int a2)
             sound->field_70 = 0;
         }
 
+        if (sound->stream != NULL) {
+            soundStreamReset(sound);
+
+            // Buffer is refreshed from the new position right below, so it
+            // has to be there already.
+            for (int index = 0; index < sound->field_78; index++) {
+                if (!soundStreamFill(sound)) {
+                    break;
+                }
+            }
+        }
+
+        soundUnlock();
+
         soundContinue(sound);
     } else {
         IDirectSoundBuffer_SetCurrentPosition(sound->directSoundBuffer, a2);
@@ -1836,6 +2090,8 @@ void soundFlushAllSounds()
 // 0x49C15C
 void soundUpdate()
 {
+    profile_begin(PROFILE_ZONE_SOUND);
+
     Sound* curr = soundMgrList;
     while (curr != NULL) {
         // Sound can be deallocated in `soundContinue`.
@@ -1843,6 +2099,8 @@ void soundUpdate()
         soundContinue(curr);
         curr = next;
     }
+
+    profile_end(PROFILE_ZONE_SOUND);
 }
 
 // 0x49C17C
@@ -1879,3 +2137,281 @@ int soundSetDefaultFileIO(SoundOpenProc* openProc, SoundCloseProc* closeProc, So
     soundErrorno = SOUND_NO_ERROR;
     return soundErrorno;
 }
+
+// Starts sound thread. Streamed sounds marked with `soundSetThreaded` are read
+// and decoded there, so updating them on the main thread is just a copy.
+int soundStartThread()
+{
+    if (!driverInit) {
+        soundErrorno = SOUND_NOT_INITIALIZED;
+        return soundErrorno;
+    }
+
+    if (soundThread != NULL) {
+        soundErrorno = SOUND_NO_ERROR;
+        return soundErrorno;
+    }
+
+    soundMutex = mutex_create();
+    if (soundMutex == NULL) {
+        soundErrorno = SOUND_NO_MEMORY_AVAILABLE;
+        return soundErrorno;
+    }
+
+    memset(soundStreams, 0, sizeof(soundStreams));
+    soundThreadQuit = 0;
+
+    soundThread = thread_create(soundThreadProc, NULL);
+    if (soundThread == NULL) {
+        mutex_free(soundMutex);
+        soundMutex = NULL;
+
+        soundErrorno = SOUND_UNKNOWN_ERROR;
+        return soundErrorno;
+    }
+
+    soundErrorno = SOUND_NO_ERROR;
+    return soundErrorno;
+}
+
+void soundStopThread()
+{
+    if (soundThread == NULL) {
+        return;
+    }
+
+    atomic_set(&soundThreadQuit, 1);
+    thread_join(soundThread);
+    soundThread = NULL;
+
+    // Sounds which are still around read their streams on the main thread
+    // from now on.
+    for (int index = 0; index < SOUND_STREAM_CAPACITY; index++) {
+        if (soundStreams[index] != NULL) {
+            soundStreamStop(soundStreams[index]);
+        }
+    }
+
+    mutex_free(soundMutex);
+    soundMutex = NULL;
+}
+
+// Marks streamed sound to be decoded on sound thread. Should be called before
+// `soundLoad`. Has no effect when sound thread is not running, or for sounds
+// which are loaded in full.
+//
+// Sound file IO procs should be safe to call from sound thread while the main
+// thread is using other files.
+int soundSetThreaded(Sound* sound, bool threaded)
+{
+    if (!driverInit) {
+        soundErrorno = SOUND_NOT_INITIALIZED;
+        return soundErrorno;
+    }
+
+    if (sound == NULL) {
+        soundErrorno = SOUND_NO_SOUND;
+        return soundErrorno;
+    }
+
+    sound->threaded = threaded;
+
+    soundErrorno = SOUND_NO_ERROR;
+    return soundErrorno;
+}
+
+// Makes `soundInit` create software mixer playing to `sink` instead of
+// DirectSound. Movie library shares `soundDSObject`, so movies are mixed as
+// well. Pass NULL to go back to DirectSound.
+void soundSetMixer(MixerSink* sink, int rate)
+{
+    soundMixerSink = sink;
+    soundMixerRate = rate;
+}
+
+static void soundLock()
+{
+    if (soundMutex != NULL) {
+        mutex_lock(soundMutex);
+    }
+}
+
+static void soundUnlock()
+{
+    if (soundMutex != NULL) {
+        mutex_unlock(soundMutex);
+    }
+}
+
+static bool soundLooping(Sound* sound)
+{
+    if (sound->stream != NULL && sound->stream->loopEnded) {
+        return false;
+    }
+
+    return (sound->field_3C & 0x20) != 0;
+}
+
+// Hands sound over to sound thread, or restarts its stream after the file was
+// repositioned. Should be called with `soundMutex` locked.
+static void soundStreamStart(Sound* sound)
+{
+    int index;
+
+    if (sound->stream != NULL) {
+        soundStreamReset(sound);
+        return;
+    }
+
+    if (soundThread == NULL) {
+        return;
+    }
+
+    for (index = 0; index < SOUND_STREAM_CAPACITY; index++) {
+        if (soundStreams[index] == NULL) {
+            break;
+        }
+    }
+
+    // Out of slots, sound is read on the main thread as usual.
+    if (index == SOUND_STREAM_CAPACITY) {
+        return;
+    }
+
+    SoundStream* stream = (SoundStream*)mallocPtr(sizeof(*stream));
+    if (stream == NULL) {
+        return;
+    }
+
+    memset(stream, 0, sizeof(*stream));
+
+    stream->data = (unsigned char*)mallocPtr(sound->field_7C * SOUND_STREAM_CHUNKS);
+    if (stream->data == NULL) {
+        freePtr(stream);
+        return;
+    }
+
+    sound->stream = stream;
+    soundStreams[index] = sound;
+}
+
+// Drops decoded data after the file was repositioned. Should be called with
+// `soundMutex` locked, so producer is not in the middle of a chunk.
+static void soundStreamReset(Sound* sound)
+{
+    SoundStream* stream = sound->stream;
+
+    // Unthreaded sound stops looping as soon as loop end is read.
+    if (stream->loopEnded) {
+        sound->field_3C &= ~0x20;
+    }
+
+    stream->head = 0;
+    stream->tail = 0;
+    stream->eof = 0;
+    stream->loops = 0;
+    stream->loopEnded = false;
+}
+
+static void soundStreamStop(Sound* sound)
+{
+    if (sound->stream == NULL) {
+        return;
+    }
+
+    soundLock();
+
+    for (int index = 0; index < SOUND_STREAM_CAPACITY; index++) {
+        if (soundStreams[index] == sound) {
+            soundStreams[index] = NULL;
+            break;
+        }
+    }
+
+    freePtr(sound->stream->data);
+    freePtr(sound->stream);
+    sound->stream = NULL;
+
+    soundUnlock();
+}
+
+// Reports loop and end events producer has run into while reading the chunk.
+static void soundStreamConsume(Sound* sound, SoundChunk* chunk)
+{
+    for (int index = 0; index < chunk->loops; index++) {
+        if (sound->callback != NULL) {
+            sound->callback(sound->callbackUserData, 0x400);
+        }
+    }
+
+    if (chunk->loopEnded) {
+        sound->field_3C &= ~0x20;
+    }
+
+    if (chunk->end) {
+        sound->field_3C |= 0x0200;
+    }
+}
+
+// Reads next chunk of the stream if there is room for it. Should be called
+// with `soundMutex` locked.
+static bool soundStreamFill(Sound* sound)
+{
+    SoundStream* stream = sound->stream;
+    int head = stream->head;
+
+    if (stream->eof || head - atomic_get(&(stream->tail)) >= SOUND_STREAM_CHUNKS) {
+        return false;
+    }
+
+    int slot = head % SOUND_STREAM_CHUNKS;
+    SoundChunk* chunk = &(stream->chunks[slot]);
+    bool loopEnded = stream->loopEnded;
+    bool end;
+
+    stream->loops = 0;
+    chunk->size = readSoundBuffer(sound, stream->data + sound->field_7C * slot, &end);
+    chunk->loops = stream->loops;
+    chunk->loopEnded = !loopEnded && stream->loopEnded;
+    chunk->end = end;
+    atomic_set(&(stream->head), head + 1);
+
+    if (end) {
+        atomic_set(&(stream->eof), 1);
+    }
+
+    return true;
+}
+
+// Reads one chunk into every stream which has room for it. Returns number of
+// chunks read.
+static int soundThreadFill()
+{
+    int chunks = 0;
+
+    for (int index = 0; index < SOUND_STREAM_CAPACITY; index++) {
+        // Lock is taken per chunk, so the main thread never waits for more
+        // than one chunk to decode.
+        mutex_lock(soundMutex);
+
+        Sound* sound = soundStreams[index];
+        if (sound != NULL && soundStreamFill(sound)) {
+            chunks++;
+        }
+
+        mutex_unlock(soundMutex);
+    }
+
+    return chunks;
+}
+
+static int soundThreadProc(void* data)
+{
+    while (!atomic_get(&soundThreadQuit)) {
+        if (soundThreadFill() == 0) {
+            thread_sleep(SOUND_THREAD_INTERVAL);
+        }
+    }
+
+    return 0;
+}
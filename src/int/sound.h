@@ -5,6 +5,7 @@
 #include <stddef.h>
 
 #include "plib/gnw/gnw95dx.h"
+#include "plib/gnw/mixer.h"
 
 #define SOUND_FLAG_SOUND_IS_DONE 0x01
 #define SOUND_FLAG_SOUND_IS_PLAYING 0x02
@@ -76,6 +77,8 @@ typedef struct SoundFileIO {
 
 typedef void SoundCallback(void* userData, int a2);
 
+typedef struct SoundStream SoundStream;
+
 typedef struct Sound {
     SoundFileIO io;
     unsigned char* field_20;
@@ -109,6 +112,9 @@ typedef struct Sound {
     void (*field_90)(int);
     struct Sound* next;
     struct Sound* prev;
+    // Streamed data is decoded on sound thread, see `soundSetThreaded`.
+    bool threaded;
+    SoundStream* stream;
 } Sound;
 
 extern LPDIRECTSOUNDBUFFER primaryDSBuffer;
@@ -125,6 +131,7 @@ int soundSetData(Sound* sound, unsigned char* buf, int size);
 int soundPlay(Sound* sound);
 int soundStop(Sound* sound);
 int soundDelete(Sound* sound);
+int soundUnload(Sound* sound);
 int numSoundsPlaying();
 int soundContinue(Sound* sound);
 bool soundPlaying(Sound* sound);
@@ -152,5 +159,9 @@ int soundFade(Sound* sound, int duration, int targetVolume);
 void soundFlushAllSounds();
 void soundUpdate();
 int soundSetDefaultFileIO(SoundOpenProc* openProc, SoundCloseProc* closeProc, SoundReadProc* readProc, SoundWriteProc* writeProc, SoundSeekProc* seekProc, SoundTellProc* tellProc, SoundFileLengthProc* fileLengthProc);
+int soundStartThread();
+void soundStopThread();
+int soundSetThreaded(Sound* sound, bool threaded);
+void soundSetMixer(MixerSink* sink, int rate);
 
 #endif /* FALLOUT_INT_SOUND_H_ */
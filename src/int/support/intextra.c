@@ -4656,7 +4656,7 @@ static void op_gfade_in(Program* program)
     }
 
     if (data != 0) {
-        palette_fade_to(cmap);
+        palette_fade_in(cmap);
     } else {
         dbg_error(program, "gfade_in", SCRIPT_ERROR_OBJECT_IS_NULL);
     }
@@ -5813,3 +5813,20 @@ void updateIntExtra()
 void intExtraRemoveProgramReferences(Program* program)
 {
 }
+
+// Finds which reply dialogue option procedure is going to display, without
+// running it. Only replies with literal message list and message ids are
+// recognized.
+int intExtraFindReply(Program* program, int procedureIndex, int* messageListIdPtr, int* messageIdPtr)
+{
+    int arguments[3];
+
+    if (interpretFindLiteralCall(program, procedureIndex, 0x811E, arguments, 2) == 0
+        || interpretFindLiteralCall(program, procedureIndex, 0x8120, arguments, 3) == 0) {
+        *messageListIdPtr = arguments[0];
+        *messageIdPtr = arguments[1];
+        return 0;
+    }
+
+    return -1;
+}
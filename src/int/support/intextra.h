@@ -20,5 +20,6 @@ void intExtraClose();
 void initIntExtra();
 void updateIntExtra();
 void intExtraRemoveProgramReferences(Program* program);
+int intExtraFindReply(Program* program, int procedureIndex, int* messageListIdPtr, int* messageIdPtr);
 
 #endif /* FALLOUT_INT_SUPPORT_INTEXTRA_H_ */
@@ -1,6 +1,7 @@
 // NOTE: This module is completely standalone. It does not have external
 // dependencies and uses __cdecl calling convention, which probably means it
-// was implemented as a separate library and linked statically.
+// was implemented as a separate library and linked statically. The only
+// addition is optional decode thread built on plib/gnw/thread.h.
 
 #include "movie_lib.h"
 
@@ -10,6 +11,61 @@
 
 #include <timeapi.h>
 
+#include "plib/gnw/thread.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MOVIE_LIB_SSE2
+#include <emmintrin.h>
+#endif
+
+// Number of records read ahead of the parser, which is also the number of
+// frames decode thread can have ready.
+#define MOVIE_LIB_QUEUE_LENGTH 4
+
+// Sync waits longer than this (in microseconds) sleep instead of spinning
+// while decode thread is running.
+#define MOVIE_LIB_SLEEP_THRESHOLD 20000
+
+typedef struct MovieLibRecord {
+    STRUCT_6B3690 mem;
+    unsigned char* data;
+    int size;
+
+    // Video chunk submitted to decode thread when record was read ahead,
+    // `NULL` if parser should submit it itself.
+    unsigned short* video;
+
+    // Decode job number of `video`.
+    int job;
+
+    // Set when record changes video mode.
+    bool blocking;
+} MovieLibRecord;
+
+typedef struct MovieLibDecodeJob {
+    unsigned char* map;
+    unsigned short* chunk;
+} MovieLibDecodeJob;
+
+static void movieLibSetDecodeRect(int a3, int a4, int a5, int a6);
+static unsigned char* movieLibReadRecord(STRUCT_6B3690* mem, int* sizePtr);
+static void movieLibScanRecord(MovieLibRecord* record);
+static void movieLibReadAhead();
+static unsigned char* movieLibNextRecord();
+static void movieLibResetRecords();
+static int movieLibSubmit(unsigned char* map, unsigned short* chunk);
+static void movieLibWaitJob(int job);
+static void movieLibDiscardJobs();
+static bool movieLibAllocFrames();
+static void movieLibFreeFrames();
+static void movieLibPresentFrame(int job);
+static int movieLibDecodeThreadProc(void* data);
+#ifdef MOVIE_LIB_SSE2
+static void movieLibCopyBlock_sse2(unsigned char* dest, unsigned char* src, int srcPitch);
+static void movieLibFillBlock_sse2(unsigned char* dest, unsigned int value1, unsigned int value2);
+static void movieLibPatternBlock_sse2(unsigned char* dest, unsigned char* pattern, unsigned char color0, unsigned char color1);
+#endif
+
 // 0x51EBD8
 int dword_51EBD8 = 0;
 
@@ -438,6 +494,61 @@ int dword_6B403B;
 // 0x6B403F
 int dword_6B403F;
 
+// Decode thread, `NULL` when video chunks are decoded by the parser.
+static Thread* gMovieLibDecodeThread = NULL;
+
+// Signalled once per submitted decode job.
+static Semaphore* gMovieLibDecodeStart = NULL;
+
+// Signalled by decode thread once per completed decode job.
+static Semaphore* gMovieLibDecodeDone = NULL;
+
+static volatile int gMovieLibDecodeQuit = 0;
+
+// Whether current video mode is decoded by decode thread. Set by `_nfConfig`
+// for 8-bit non-interlaced modes (the only ones `_nfPkDecomp` handles).
+static bool gMovieLibPipeline = false;
+
+static MovieLibDecodeJob gMovieLibDecodeJobs[MOVIE_LIB_QUEUE_LENGTH];
+
+// Decoded frames, one per decode job slot.
+static unsigned char* gMovieLibFrames[MOVIE_LIB_QUEUE_LENGTH];
+
+// Previous and current frames decode thread works on instead of locked
+// surfaces.
+static unsigned char* gMovieLibDecodeBuffers[2];
+
+// Number of decode jobs submitted by the parser.
+static int gMovieLibJobsSubmitted = 0;
+
+// Number of decode jobs the parser knows to be complete.
+static int gMovieLibJobsCompleted = 0;
+
+// Number of decode jobs completed by decode thread, only used there.
+static int gMovieLibJobsDecoded = 0;
+
+// Decode job of the frame shown by the next show frame chunk.
+static int gMovieLibShowJob = 0;
+
+// Records read ahead of the parser.
+static MovieLibRecord gMovieLibRecords[MOVIE_LIB_QUEUE_LENGTH];
+static int gMovieLibRecordsFirst = 0;
+static int gMovieLibRecordsLength = 0;
+
+// Ring slot of the record being parsed, -1 when it's in `_io_mem_buf`.
+static int gMovieLibRecordCurrent = -1;
+
+// Set when record read ahead changes video mode. Nothing more is read ahead
+// until the parser is done with that record.
+static bool gMovieLibReadAheadBlocked = false;
+
+// Set when end of movie record was read ahead.
+static bool gMovieLibReadAheadEnd = false;
+
+// When cleared, frames are not paced by movie frame rate and are stepped as
+// fast as they can be decoded.
+static bool gMovieLibSync = true;
+
 // 0x4F4800
 void movieLibSetMemoryProcs(MveMallocFunc* mallocProc, MveFreeFunc* freeProc)
 {
@@ -594,6 +705,8 @@ int _MVE_rmPrepMovie(int fileHandle, int a2, int a3, char a4)
         _rm_track_bit = 1;
     }
 
+    movieLibResetRecords();
+
     if (!_ioReset(fileHandle)) {
         _MVE_rmEndMovie();
         return -8;
@@ -807,7 +920,7 @@ LABEL_5:
             return -1;
         case 1:
             v0 = 0;
-            v1 = (unsigned short*)_ioNextRecord();
+            v1 = (unsigned short*)movieLibNextRecord();
             goto LABEL_5;
         case 2:
             if (!_syncInit(v1[0], v1[2])) {
@@ -901,12 +1014,17 @@ LABEL_5:
             if (v21) {
                 _do_nothing_(_rm_dx, _rm_dy, v21);
             } else if (!_sync_late || v1[1]) {
+                if (gMovieLibShowJob != 0) {
+                    movieLibPresentFrame(gMovieLibShowJob);
+                }
                 _sfShowFrame(_rm_dx, _rm_dy, v18);
             } else {
                 _sync_FrameDropped = 1;
                 ++_rm_FrameDropCount;
             }
 
+            gMovieLibShowJob = 0;
+
             v20 = v1[1];
             if (v20 && !v21 && !dword_6B3680) {
                 _SetPalette_1(v1[0], v20);
@@ -958,6 +1076,19 @@ LABEL_5:
                 break;
             }
 
+            movieLibSetDecodeRect(v1[2], v1[3], v1[4], v1[5]);
+
+            if (gMovieLibPipeline) {
+                // Decoded by decode thread, either when record was read
+                // ahead or now.
+                if (gMovieLibRecordCurrent != -1 && gMovieLibRecords[gMovieLibRecordCurrent].video == v1) {
+                    gMovieLibShowJob = gMovieLibRecords[gMovieLibRecordCurrent].job;
+                } else {
+                    gMovieLibShowJob = movieLibSubmit((unsigned char*)v3, v1);
+                }
+                continue;
+            }
+
             // swap movie surfaces
             if (v1[6] & 0x01) {
                 movieSwapSurfaces();
@@ -1042,6 +1173,10 @@ int _syncInit(int a1, int a2)
 {
     int v2;
 
+    if (!gMovieLibSync) {
+        return 1;
+    }
+
     v2 = -((a2 >> 1) + a1 * a2);
 
     if (_sync_active && _sync_wait_quanta == v2) {
@@ -1288,6 +1423,11 @@ int _syncWaitLevel(int a1)
     v2 = _sync_time + a1;
     do {
         result = v2 + 1000 * timeGetTime();
+
+        // Leave CPU to decode thread while there is plenty of time left.
+        if (gMovieLibPipeline && result < -MOVIE_LIB_SLEEP_THRESHOLD) {
+            thread_sleep(1);
+        }
     } while (result < 0);
 
     _sync_time += _sync_wait_quanta;
@@ -1436,6 +1576,9 @@ int _nfConfig(int a1, int a2, int a3, int a4)
 {
     DDSURFACEDESC ddsd;
 
+    movieLibDiscardJobs();
+    movieLibFreeFrames();
+
     if (gMovieDirectDrawSurface1 != NULL) {
         IDirectDrawSurface_Release(gMovieDirectDrawSurface1);
         gMovieDirectDrawSurface1 = NULL;
@@ -1497,6 +1640,10 @@ int _nfConfig(int a1, int a2, int a3, int a4)
 
     _nfPkConfig();
 
+    if (gMovieLibDecodeThread != NULL && !a4 && !dword_51EBD8) {
+        gMovieLibPipeline = movieLibAllocFrames();
+    }
+
     return 1;
 }
 
@@ -1671,6 +1818,12 @@ void _MVE_ReleaseMem()
 // 0x4F6370
 void _ioRelease()
 {
+    movieLibResetRecords();
+
+    for (int index = 0; index < MOVIE_LIB_QUEUE_LENGTH; index++) {
+        _MVE_MemFree(&(gMovieLibRecords[index].mem));
+    }
+
     _MVE_MemFree(&_io_mem_buf);
 }
 
@@ -1682,6 +1835,9 @@ void _MVE_sndRelease()
 // 0x4F6390
 void _nfRelease()
 {
+    movieLibDiscardJobs();
+    movieLibFreeFrames();
+
     if (gMovieDirectDrawSurface1 != NULL) {
         IDirectDrawSurface_Release(gMovieDirectDrawSurface1);
         gMovieDirectDrawSurface1 = NULL;
@@ -1859,18 +2015,15 @@ void _nfPkDecomp(unsigned char* a1, unsigned char* a2, int a3, int a4, int a5, i
     unsigned int* dest_ptr;
     unsigned int nibbles[2];
 
-    dword_6B401B = 8 * a3;
-    dword_6B4017 = 8 * a5;
-    dword_6B401F = 8 * a4 * byte_6B4016;
-    dword_6B4023 = 8 * a6 * byte_6B4016;
-
-    var_8 = dword_6B3D00 - dword_6B4017;
+    // NOTE: Dirty rect is set by the caller with `movieLibSetDecodeRect`,
+    // this function can run on decode thread while previous frame is shown.
+    var_8 = dword_6B3D00 - 8 * a5;
     dest = gMovieDirectDrawSurfaceBuffer1;
 
     var_10 = dword_6B3CEC - 8;
 
     if (a3 || a4) {
-        dest = gMovieDirectDrawSurfaceBuffer1 + dword_6B401B + _mveBW * dword_6B401F;
+        dest = gMovieDirectDrawSurfaceBuffer1 + 8 * a3 + _mveBW * 8 * a4 * byte_6B4016;
     }
 
     while (a6--) {
@@ -1920,6 +2073,14 @@ void _nfPkDecomp(unsigned char* a1, unsigned char* a2, int a3, int a4, int a5, i
                         break;
                     }
 
+#ifdef MOVIE_LIB_SSE2
+                    // NOTE: Blocks copied within the same frame (2 and 3) are
+                    // at least 8 pixels away and the rest come from the other
+                    // buffer, so source never overlaps destination and rows
+                    // can be copied whole.
+                    movieLibCopyBlock_sse2(dest, dest + v10, _mveBW);
+                    dest += _mveBW * 7;
+#else
                     value2 = _mveBW;
 
                     for (i = 0; i < 8; i++) {
@@ -1933,6 +2094,7 @@ void _nfPkDecomp(unsigned char* a1, unsigned char* a2, int a3, int a4, int a5, i
                     }
 
                     dest -= value2;
+#endif
 
                     dest -= var_10;
 
@@ -1997,6 +2159,10 @@ void _nfPkDecomp(unsigned char* a1, unsigned char* a2, int a3, int a4, int a5, i
                     } else {
                         // 7/2
                         // VERIFIED
+#ifdef MOVIE_LIB_SSE2
+                        movieLibPatternBlock_sse2(dest, a2 + 2, a2[0], a2[1]);
+                        dest += _mveBW * 8;
+#else
                         for (i = 0; i < 8; i++) {
                             value1 = _$$R0004[a2[2 + i]];
                             map1[i * 4] = value1 & 0xFF;
@@ -2019,8 +2185,9 @@ void _nfPkDecomp(unsigned char* a1, unsigned char* a2, int a3, int a4, int a5, i
 
                             dest += value2;
                         }
+#endif
 
-                        dest -= value2;
+                        dest -= _mveBW;
 
                         a2 += 10;
                         dest -= var_10;
@@ -2645,6 +2812,10 @@ void _nfPkDecomp(unsigned char* a1, unsigned char* a2, int a3, int a4, int a5, i
                     }
                     break;
                 case 11:
+#ifdef MOVIE_LIB_SSE2
+                    movieLibCopyBlock_sse2(dest, a2, 8);
+                    dest += _mveBW * 7;
+#else
                     value2 = _mveBW;
 
                     src_ptr = (unsigned int*)a2;
@@ -2656,6 +2827,7 @@ void _nfPkDecomp(unsigned char* a1, unsigned char* a2, int a3, int a4, int a5, i
                     }
 
                     dest -= value2;
+#endif
 
                     a2 += 64;
                     dest -= var_10;
@@ -2748,6 +2920,10 @@ void _nfPkDecomp(unsigned char* a1, unsigned char* a2, int a3, int a4, int a5, i
                         value2 = _rotl(value2, 8);
                     }
 
+#ifdef MOVIE_LIB_SSE2
+                    movieLibFillBlock_sse2(dest, value1, value2);
+                    dest += _mveBW * 7;
+#else
                     for (i = 0; i < 4; i++) {
                         dest_ptr = (unsigned int*)dest;
                         dest_ptr[0] = value1;
@@ -2761,6 +2937,7 @@ void _nfPkDecomp(unsigned char* a1, unsigned char* a2, int a3, int a4, int a5, i
                     }
 
                     dest -= _mveBW;
+#endif
 
                     dest -= var_10;
                     break;
@@ -2771,3 +2948,439 @@ void _nfPkDecomp(unsigned char* a1, unsigned char* a2, int a3, int a4, int a5, i
         dest += var_8;
     }
 }
+
+// Enables or disables frame pacing for movies prepared afterwards.
+void movieLibSetSync(bool enabled)
+{
+    gMovieLibSync = enabled;
+}
+
+// Starts or stops decode thread. While it runs, records are read ahead of the
+// parser and their video chunks are decoded there, the parser only presents
+// decoded frames. Should not be called while movie is playing.
+bool movieLibSetThreaded(bool threaded)
+{
+    if (threaded) {
+        if (gMovieLibDecodeThread != NULL) {
+            return true;
+        }
+
+        gMovieLibDecodeStart = semaphore_create(0);
+        gMovieLibDecodeDone = semaphore_create(0);
+        if (gMovieLibDecodeStart == NULL || gMovieLibDecodeDone == NULL) {
+            semaphore_free(gMovieLibDecodeStart);
+            semaphore_free(gMovieLibDecodeDone);
+            gMovieLibDecodeStart = NULL;
+            gMovieLibDecodeDone = NULL;
+            return false;
+        }
+
+        gMovieLibJobsSubmitted = 0;
+        gMovieLibJobsCompleted = 0;
+        gMovieLibJobsDecoded = 0;
+        atomic_set(&gMovieLibDecodeQuit, 0);
+
+        gMovieLibDecodeThread = thread_create(movieLibDecodeThreadProc, NULL);
+        if (gMovieLibDecodeThread == NULL) {
+            semaphore_free(gMovieLibDecodeStart);
+            semaphore_free(gMovieLibDecodeDone);
+            gMovieLibDecodeStart = NULL;
+            gMovieLibDecodeDone = NULL;
+            return false;
+        }
+
+        return true;
+    }
+
+    if (gMovieLibDecodeThread == NULL) {
+        return true;
+    }
+
+    movieLibDiscardJobs();
+
+    atomic_set(&gMovieLibDecodeQuit, 1);
+    semaphore_post(gMovieLibDecodeStart, 1);
+    thread_join(gMovieLibDecodeThread);
+    gMovieLibDecodeThread = NULL;
+
+    semaphore_free(gMovieLibDecodeStart);
+    semaphore_free(gMovieLibDecodeDone);
+    gMovieLibDecodeStart = NULL;
+    gMovieLibDecodeDone = NULL;
+
+    return true;
+}
+
+// Sets dirty rect of the frame being decoded (in blocks), `_sfShowFrame`
+// shows only this part of the frame.
+static void movieLibSetDecodeRect(int a3, int a4, int a5, int a6)
+{
+    dword_6B401B = 8 * a3;
+    dword_6B4017 = 8 * a5;
+    dword_6B401F = 8 * a4 * byte_6B4016;
+    dword_6B4023 = 8 * a6 * byte_6B4016;
+}
+
+// Same as `_ioNextRecord`, but reads into given buffer.
+static unsigned char* movieLibReadRecord(STRUCT_6B3690* mem, int* sizePtr)
+{
+    unsigned char* buf;
+    int size;
+
+    size = (_io_next_hdr & 0xFFFF) + 4;
+
+    buf = (unsigned char*)_MVE_MemAlloc(mem, size);
+    if (buf == NULL) {
+        return NULL;
+    }
+
+    if (gMovieLibReadProc(_io_handle, buf, size) < 1) {
+        return NULL;
+    }
+
+    _io_next_hdr = *(int*)(buf + (_io_next_hdr & 0xFFFF));
+    *sizePtr = size;
+
+    return buf;
+}
+
+// Walks chunks of the record read ahead the same way `_MVE_rmStepMovie` does
+// and submits its video chunk to decode thread.
+static void movieLibScanRecord(MovieLibRecord* record)
+{
+    unsigned char* map;
+    unsigned int hdr;
+    int pos;
+    int len;
+
+    record->video = NULL;
+    record->job = 0;
+    record->blocking = false;
+
+    map = NULL;
+    pos = 0;
+    len = 0;
+
+    while (pos + len + 4 <= record->size) {
+        hdr = *(unsigned int*)(record->data + pos + len);
+        pos += len + 4;
+        len = hdr & 0xFFFF;
+
+        switch ((hdr >> 16) & 0xFF) {
+        case 0:
+            gMovieLibReadAheadEnd = true;
+            return;
+        case 1:
+            return;
+        case 5:
+            // Frames which follow should be decoded in new video mode.
+            record->blocking = true;
+            gMovieLibReadAheadBlocked = true;
+            break;
+        case 15:
+            map = record->data + pos;
+            break;
+        case 17:
+            if (record->video == NULL
+                && map != NULL
+                && (hdr >> 24) >= 3
+                && gMovieLibPipeline
+                && !gMovieLibReadAheadBlocked) {
+                record->video = (unsigned short*)(record->data + pos);
+                record->job = movieLibSubmit(map, record->video);
+            }
+            break;
+        }
+    }
+}
+
+// Tops up records read ahead of the parser.
+static void movieLibReadAhead()
+{
+    MovieLibRecord* record;
+
+    // One slot is taken by the record being parsed.
+    while (gMovieLibRecordsLength < MOVIE_LIB_QUEUE_LENGTH - 1
+        && !gMovieLibReadAheadEnd
+        && !gMovieLibReadAheadBlocked) {
+        record = &(gMovieLibRecords[(gMovieLibRecordsFirst + gMovieLibRecordsLength) % MOVIE_LIB_QUEUE_LENGTH]);
+
+        // Decode job of the previous record in this slot can still point to
+        // its buffer.
+        movieLibWaitJob(record->job);
+
+        record->data = movieLibReadRecord(&(record->mem), &(record->size));
+        if (record->data == NULL) {
+            record->video = NULL;
+            record->job = 0;
+            record->blocking = false;
+            gMovieLibReadAheadEnd = true;
+            break;
+        }
+
+        gMovieLibRecordsLength++;
+
+        movieLibScanRecord(record);
+    }
+}
+
+// Replaces `_ioNextRecord` in `_MVE_rmStepMovie`. Records are read ahead when
+// decode thread is used.
+static unsigned char* movieLibNextRecord()
+{
+    // Video mode change is processed, records which follow can be decoded
+    // ahead again.
+    if (gMovieLibRecordCurrent != -1 && gMovieLibRecords[gMovieLibRecordCurrent].blocking) {
+        gMovieLibRecords[gMovieLibRecordCurrent].blocking = false;
+        gMovieLibReadAheadBlocked = false;
+    }
+
+    if (gMovieLibRecordsLength == 0) {
+        if (!gMovieLibPipeline) {
+            gMovieLibRecordCurrent = -1;
+            return _ioNextRecord();
+        }
+
+        movieLibReadAhead();
+
+        if (gMovieLibRecordsLength == 0) {
+            return NULL;
+        }
+    }
+
+    gMovieLibRecordCurrent = gMovieLibRecordsFirst;
+    gMovieLibRecordsFirst = (gMovieLibRecordsFirst + 1) % MOVIE_LIB_QUEUE_LENGTH;
+    gMovieLibRecordsLength--;
+
+    if (gMovieLibPipeline) {
+        movieLibReadAhead();
+    }
+
+    return gMovieLibRecords[gMovieLibRecordCurrent].data;
+}
+
+static void movieLibResetRecords()
+{
+    movieLibDiscardJobs();
+
+    for (int index = 0; index < MOVIE_LIB_QUEUE_LENGTH; index++) {
+        gMovieLibRecords[index].data = NULL;
+        gMovieLibRecords[index].size = 0;
+        gMovieLibRecords[index].blocking = false;
+    }
+
+    gMovieLibRecordsFirst = 0;
+    gMovieLibRecordsLength = 0;
+    gMovieLibRecordCurrent = -1;
+    gMovieLibReadAheadBlocked = false;
+    gMovieLibReadAheadEnd = false;
+}
+
+// Queues video chunk for decoding and returns job number.
+static int movieLibSubmit(unsigned char* map, unsigned short* chunk)
+{
+    MovieLibDecodeJob* job;
+
+    // Job slot and its frame are reused, make sure the previous job there is
+    // complete.
+    movieLibWaitJob(gMovieLibJobsSubmitted + 1 - MOVIE_LIB_QUEUE_LENGTH);
+
+    job = &(gMovieLibDecodeJobs[gMovieLibJobsSubmitted % MOVIE_LIB_QUEUE_LENGTH]);
+    job->map = map;
+    job->chunk = chunk;
+
+    gMovieLibJobsSubmitted++;
+    semaphore_post(gMovieLibDecodeStart, 1);
+
+    return gMovieLibJobsSubmitted;
+}
+
+static void movieLibWaitJob(int job)
+{
+    while (gMovieLibJobsCompleted < job) {
+        semaphore_wait(gMovieLibDecodeDone);
+        gMovieLibJobsCompleted++;
+    }
+}
+
+// Waits for decode thread to become idle and forgets decoded frames.
+static void movieLibDiscardJobs()
+{
+    movieLibWaitJob(gMovieLibJobsSubmitted);
+
+    for (int index = 0; index < MOVIE_LIB_QUEUE_LENGTH; index++) {
+        gMovieLibRecords[index].video = NULL;
+        gMovieLibRecords[index].job = 0;
+    }
+
+    gMovieLibShowJob = 0;
+}
+
+static bool movieLibAllocFrames()
+{
+    int size;
+    int index;
+
+    if (gMovieLibMallocProc == NULL) {
+        return false;
+    }
+
+    size = _mveBW * _mveBH;
+
+    for (index = 0; index < 2; index++) {
+        gMovieLibDecodeBuffers[index] = (unsigned char*)gMovieLibMallocProc(size);
+        if (gMovieLibDecodeBuffers[index] == NULL) {
+            movieLibFreeFrames();
+            return false;
+        }
+        memset(gMovieLibDecodeBuffers[index], 0, size);
+    }
+
+    for (index = 0; index < MOVIE_LIB_QUEUE_LENGTH; index++) {
+        gMovieLibFrames[index] = (unsigned char*)gMovieLibMallocProc(size);
+        if (gMovieLibFrames[index] == NULL) {
+            movieLibFreeFrames();
+            return false;
+        }
+    }
+
+    gMovieDirectDrawSurfaceBuffer1 = gMovieLibDecodeBuffers[0];
+    gMovieDirectDrawSurfaceBuffer2 = gMovieLibDecodeBuffers[1];
+
+    return true;
+}
+
+static void movieLibFreeFrames()
+{
+    int index;
+
+    gMovieLibPipeline = false;
+
+    for (index = 0; index < 2; index++) {
+        if (gMovieLibDecodeBuffers[index] != NULL) {
+            gMovieLibFreeProc(gMovieLibDecodeBuffers[index]);
+            gMovieLibDecodeBuffers[index] = NULL;
+        }
+    }
+
+    for (index = 0; index < MOVIE_LIB_QUEUE_LENGTH; index++) {
+        if (gMovieLibFrames[index] != NULL) {
+            gMovieLibFreeProc(gMovieLibFrames[index]);
+            gMovieLibFrames[index] = NULL;
+        }
+    }
+}
+
+// Copies frame decoded by given job to the surface `_sfShowFrame` shows.
+static void movieLibPresentFrame(int job)
+{
+    DDSURFACEDESC ddsd;
+    unsigned char* src;
+    unsigned char* dest;
+    int y;
+
+    movieLibWaitJob(job);
+
+    ddsd.dwSize = sizeof(DDSURFACEDESC);
+    if (IDirectDrawSurface_Lock(gMovieDirectDrawSurface1, NULL, &ddsd, 0, NULL) != DD_OK) {
+        return;
+    }
+
+    src = gMovieLibFrames[(job - 1) % MOVIE_LIB_QUEUE_LENGTH];
+    dest = (unsigned char*)ddsd.lpSurface;
+    for (y = 0; y < _mveBH; y++) {
+        memcpy(dest, src, _mveBW);
+        src += _mveBW;
+        dest += ddsd.lPitch;
+    }
+
+    IDirectDrawSurface_Unlock(gMovieDirectDrawSurface1, NULL);
+}
+
+static int movieLibDecodeThreadProc(void* data)
+{
+    MovieLibDecodeJob* job;
+    unsigned char* tmp;
+
+    while (true) {
+        semaphore_wait(gMovieLibDecodeStart);
+
+        if (atomic_get(&gMovieLibDecodeQuit)) {
+            break;
+        }
+
+        job = &(gMovieLibDecodeJobs[gMovieLibJobsDecoded % MOVIE_LIB_QUEUE_LENGTH]);
+
+        // Same as `movieSwapSurfaces`, but on buffers.
+        if (job->chunk[6] & 0x01) {
+            tmp = gMovieDirectDrawSurfaceBuffer2;
+            gMovieDirectDrawSurfaceBuffer2 = gMovieDirectDrawSurfaceBuffer1;
+            gMovieDirectDrawSurfaceBuffer1 = tmp;
+        }
+
+        _nfPkDecomp(job->map, (unsigned char*)&(job->chunk[7]), job->chunk[2], job->chunk[3], job->chunk[4], job->chunk[5]);
+
+        memcpy(gMovieLibFrames[gMovieLibJobsDecoded % MOVIE_LIB_QUEUE_LENGTH], gMovieDirectDrawSurfaceBuffer1, _mveBW * _mveBH);
+
+        gMovieLibJobsDecoded++;
+        semaphore_post(gMovieLibDecodeDone, 1);
+    }
+
+    return 0;
+}
+
+#ifdef MOVIE_LIB_SSE2
+// Copies 8x8 block from `src` to `dest`, one row per store.
+static void movieLibCopyBlock_sse2(unsigned char* dest, unsigned char* src, int srcPitch)
+{
+    for (int row = 0; row < 8; row++) {
+        _mm_storel_epi64((__m128i*)dest, _mm_loadl_epi64((__m128i*)src));
+        dest += _mveBW;
+        src += srcPitch;
+    }
+}
+
+// Fills 8x8 block with `value1` on even rows and `value2` on odd rows.
+static void movieLibFillBlock_sse2(unsigned char* dest, unsigned int value1, unsigned int value2)
+{
+    __m128i even = _mm_set1_epi32(value1);
+    __m128i odd = _mm_set1_epi32(value2);
+
+    for (int row = 0; row < 8; row += 2) {
+        _mm_storel_epi64((__m128i*)dest, even);
+        _mm_storel_epi64((__m128i*)(dest + _mveBW), odd);
+        dest += _mveBW * 2;
+    }
+}
+
+// Same as 7/2 table lookups, but expands two rows of `pattern` bits at once.
+// Every byte of `pattern` is a row, bit N selects `color1` for pixel N.
+static void movieLibPatternBlock_sse2(unsigned char* dest, unsigned char* pattern, unsigned char color0, unsigned char color1)
+{
+    __m128i bits = _mm_set_epi8((char)0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01, (char)0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+    __m128i colors0 = _mm_set1_epi8((char)color0);
+    __m128i colorsXor = _mm_xor_si128(colors0, _mm_set1_epi8((char)color1));
+    __m128i rows = _mm_loadl_epi64((__m128i*)pattern);
+    __m128i quads[2];
+    __m128i mask;
+    __m128i pixels;
+
+    // Spread every row byte over 8 bytes, two rows per register.
+    rows = _mm_unpacklo_epi8(rows, rows);
+    quads[0] = _mm_unpacklo_epi16(rows, rows);
+    quads[1] = _mm_unpackhi_epi16(rows, rows);
+
+    for (int row = 0; row < 8; row += 2) {
+        rows = quads[row >> 2];
+        rows = (row & 2) != 0 ? _mm_unpackhi_epi32(rows, rows) : _mm_unpacklo_epi32(rows, rows);
+
+        mask = _mm_cmpeq_epi8(_mm_and_si128(rows, bits), bits);
+        pixels = _mm_xor_si128(colors0, _mm_and_si128(mask, colorsXor));
+
+        _mm_storel_epi64((__m128i*)dest, pixels);
+        _mm_storel_epi64((__m128i*)(dest + _mveBW), _mm_srli_si128(pixels, 8));
+
+        dest += _mveBW * 2;
+    }
+}
+#endif
@@ -199,5 +199,7 @@ int _MVE_sndDecompM16(unsigned short* a1, unsigned char* a2, int a3, int a4);
 int _MVE_sndDecompS16(unsigned short* a1, unsigned char* a2, int a3, int a4);
 void _nfPkConfig();
 void _nfPkDecomp(unsigned char* buf, unsigned char* a2, int a3, int a4, int a5, int a6);
+bool movieLibSetThreaded(bool threaded);
+void movieLibSetSync(bool enabled);
 
 #endif /* MOVIE_LIB_H */
@@ -1,11 +1,46 @@
 #include "plib/color/color.h"
 
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "plib/gnw/debug.h"
 #include "plib/gnw/input.h"
+#include "plib/gnw/profile.h"
 #include "plib/gnw/svga.h"
 
+// "CTBC"
+#define COLOR_TABLE_CACHE_MAGIC 0x43544243
+
+// Bump when layout of the cache file or any table generator changes.
+#define COLOR_TABLE_CACHE_VERSION 1
+
+#define COLOR_BLEND_TABLE_SIZE 4096
+
+typedef struct ColorTableCacheHeader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned long long hash;
+} ColorTableCacheHeader;
+
+// Layout of the cache file. It is mapped into memory as is, so it only
+// contains byte arrays after the header.
+typedef struct ColorTableCache {
+    ColorTableCacheHeader header;
+    unsigned char intensityColorTable[256][256];
+    unsigned char colorMixAddTable[256][256];
+    unsigned char colorMixMulTable[256][256];
+    unsigned char blendTables[256][COLOR_BLEND_TABLE_SIZE];
+} ColorTableCache;
+
 static int colorOpen(const char* filePath, int flags);
 static int colorRead(int fd, void* buffer, size_t size);
 static int colorClose(int fd);
@@ -18,6 +53,12 @@ static void setMixTableColor(int a1);
 static void setMixTable();
 static void buildBlendTable(unsigned char* ptr, unsigned char ch);
 static void rebuildColorBlendTables();
+static void buildColorTables(bool precomputed);
+static unsigned long long colorTableHash(bool precomputed);
+static void colorTableCachePath(char* path, unsigned long long hash);
+static bool colorTableCacheOpen(unsigned long long hash);
+static void colorTableCacheClose();
+static bool colorTableCacheWrite(unsigned long long hash);
 static void maxfill();
 
 // 0x4FE0DC
@@ -61,6 +102,17 @@ unsigned char cmap[768] = {
     0x3F, 0x3F, 0x3F
 };
 
+// Directory with precomputed tables, NULL when cache is disabled.
+static char* colorTableCacheDir = NULL;
+
+// Tables of the current palette mapped from cache file.
+static ColorTableCache* colorTableCacheData = NULL;
+
+#if defined(_WIN32)
+static HANDLE colorTableCacheFile = INVALID_HANDLE_VALUE;
+static HANDLE colorTableCacheMapping = NULL;
+#endif
+
 // 0x673280
 static ColorPaletteStackEntry* colorPaletteStack[COLOR_PALETTE_STACK_CAPACITY];
 
@@ -493,15 +545,9 @@ bool loadColorTable(const char* path)
 
         // NOTE: Uninline.
         colorRead(fd, colorMixMulTable, 0x10000);
-    } else {
-        setIntensityTables();
-
-        for (int index = 0; index < 256; index++) {
-            setMixTableColor(index);
-        }
     }
 
-    rebuildColorBlendTables();
+    buildColorTables(type == 0x4E455743);
 
     // NOTE: Uninline.
     colorClose(fd);
@@ -611,7 +657,11 @@ static void rebuildColorBlendTables()
 
     for (i = 0; i < 256; i++) {
         if (blendTable[i]) {
-            buildBlendTable(blendTable[i], i);
+            if (colorTableCacheData != NULL) {
+                memcpy(blendTable[i], colorTableCacheData->blendTables[i], COLOR_BLEND_TABLE_SIZE);
+            } else {
+                buildBlendTable(blendTable[i], i);
+            }
         }
     }
 }
@@ -625,7 +675,12 @@ unsigned char* getColorBlendTable(int ch)
         ptr = (unsigned char*)mallocPtr(4100);
         *(int*)ptr = 1;
         blendTable[ch] = ptr + 4;
-        buildBlendTable(blendTable[ch], ch);
+
+        if (colorTableCacheData != NULL) {
+            memcpy(blendTable[ch], colorTableCacheData->blendTables[ch], COLOR_BLEND_TABLE_SIZE);
+        } else {
+            buildBlendTable(blendTable[ch], ch);
+        }
     }
 
     ptr = blendTable[ch];
@@ -734,13 +789,7 @@ bool colorPopColorPalette()
     free(entry);
     colorPaletteStack[tos] = NULL;
 
-    setIntensityTables();
-
-    for (int index = 0; index < 256; index++) {
-        setMixTableColor(index);
-    }
-
-    rebuildColorBlendTables();
+    buildColorTables(false);
 
     return true;
 }
@@ -777,6 +826,9 @@ void colorsClose()
     }
 
     tos = 0;
+
+    colorTableCacheClose();
+    colorSetTableCacheDir(NULL);
 }
 
 // 0x4C15E8
@@ -784,3 +836,339 @@ unsigned char* getColorPalette()
 {
     return cmap;
 }
+
+// Sets directory where intensity, mix and blend tables are persisted, one
+// file per palette. Pass NULL to disable the cache. The directory must exist.
+//
+// NOTE: Uses CRT allocator since this is called before window system installs
+// its own, while `colorsClose` runs after.
+void colorSetTableCacheDir(const char* path)
+{
+    if (colorTableCacheDir != NULL) {
+        free(colorTableCacheDir);
+        colorTableCacheDir = NULL;
+    }
+
+    if (path != NULL && *path != '\0') {
+        colorTableCacheDir = (char*)malloc(strlen(path) + 1);
+        if (colorTableCacheDir != NULL) {
+            strcpy(colorTableCacheDir, path);
+        }
+    }
+}
+
+// Generates tables of the current palette `iterations` times and then loads
+// them from the cache the same number of times, reporting average time of
+// both via debug output. Live tables and cache mapping are restored
+// afterwards, so precomputed tables of the palette are not lost.
+void colorTableBenchmark(int iterations)
+{
+    unsigned char* buffer;
+    unsigned char* saved;
+    bool cached;
+    unsigned long long cachedHash;
+    unsigned long long start;
+    unsigned long long generateTime;
+    unsigned long long loadTime;
+    unsigned long long hash;
+    bool loaded;
+
+    if (iterations <= 0) {
+        return;
+    }
+
+    buffer = (unsigned char*)mallocPtr(COLOR_BLEND_TABLE_SIZE);
+    if (buffer == NULL) {
+        return;
+    }
+
+    saved = (unsigned char*)mallocPtr(sizeof(intensityColorTable) + sizeof(colorMixAddTable) + sizeof(colorMixMulTable));
+    if (saved == NULL) {
+        freePtr(buffer);
+        return;
+    }
+
+    memcpy(saved, intensityColorTable, sizeof(intensityColorTable));
+    memcpy(saved + sizeof(intensityColorTable), colorMixAddTable, sizeof(colorMixAddTable));
+    memcpy(saved + sizeof(intensityColorTable) + sizeof(colorMixAddTable), colorMixMulTable, sizeof(colorMixMulTable));
+
+    cached = colorTableCacheData != NULL;
+    cachedHash = cached ? colorTableCacheData->header.hash : 0;
+
+    memset(buffer, 0, COLOR_BLEND_TABLE_SIZE);
+
+    start = profile_get_time();
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        setIntensityTables();
+        setMixTable();
+
+        for (int index = 0; index < 256; index++) {
+            buildBlendTable(buffer, index);
+        }
+    }
+    generateTime = profile_get_time() - start;
+
+    freePtr(buffer);
+
+    debug_printf("color: generated tables in %.3f ms\n", generateTime / 1000.0 / iterations);
+
+    if (colorTableCacheDir != NULL) {
+        // Generated tables are still in place, so they are what gets written
+        // should the cache miss.
+        hash = colorTableHash(false);
+        loaded = true;
+
+        start = profile_get_time();
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            colorTableCacheClose();
+            if (!colorTableCacheOpen(hash)) {
+                if (!colorTableCacheWrite(hash) || !colorTableCacheOpen(hash)) {
+                    loaded = false;
+                    break;
+                }
+            }
+
+            memcpy(intensityColorTable, colorTableCacheData->intensityColorTable, sizeof(intensityColorTable));
+            memcpy(colorMixAddTable, colorTableCacheData->colorMixAddTable, sizeof(colorMixAddTable));
+            memcpy(colorMixMulTable, colorTableCacheData->colorMixMulTable, sizeof(colorMixMulTable));
+        }
+        loadTime = profile_get_time() - start;
+
+        if (loaded) {
+            debug_printf("color: loaded tables from cache in %.3f ms\n", loadTime / 1000.0 / iterations);
+        }
+
+        colorTableCacheClose();
+        if (cached) {
+            colorTableCacheOpen(cachedHash);
+        }
+    }
+
+    memcpy(intensityColorTable, saved, sizeof(intensityColorTable));
+    memcpy(colorMixAddTable, saved + sizeof(intensityColorTable), sizeof(colorMixAddTable));
+    memcpy(colorMixMulTable, saved + sizeof(intensityColorTable) + sizeof(colorMixAddTable), sizeof(colorMixMulTable));
+
+    freePtr(saved);
+}
+
+// Makes intensity, mix and blend tables match current palette. When
+// `precomputed` is true intensity and mix tables were read from palette file
+// and are not regenerated.
+static void buildColorTables(bool precomputed)
+{
+    unsigned long long hash;
+
+    colorTableCacheClose();
+
+    if (colorTableCacheDir != NULL) {
+        hash = colorTableHash(precomputed);
+
+        if (!colorTableCacheOpen(hash)) {
+            if (!precomputed) {
+                setIntensityTables();
+                setMixTable();
+            }
+
+            if (colorTableCacheWrite(hash)) {
+                colorTableCacheOpen(hash);
+            }
+        } else if (!precomputed) {
+            memcpy(intensityColorTable, colorTableCacheData->intensityColorTable, sizeof(intensityColorTable));
+            memcpy(colorMixAddTable, colorTableCacheData->colorMixAddTable, sizeof(colorMixAddTable));
+            memcpy(colorMixMulTable, colorTableCacheData->colorMixMulTable, sizeof(colorMixMulTable));
+        }
+    } else {
+        if (!precomputed) {
+            setIntensityTables();
+            setMixTable();
+        }
+    }
+
+    rebuildColorBlendTables();
+}
+
+// FNV-1a of everything table generators depend on.
+static unsigned long long colorTableHash(bool precomputed)
+{
+    unsigned long long hash = 0xCBF29CE484222325ULL;
+
+    for (int index = 0; index < sizeof(cmap); index++) {
+        hash = (hash ^ cmap[index]) * 0x100000001B3ULL;
+    }
+
+    for (int index = 0; index < sizeof(mappedColor); index++) {
+        hash = (hash ^ mappedColor[index]) * 0x100000001B3ULL;
+    }
+
+    for (int index = 0; index < sizeof(colorTable); index++) {
+        hash = (hash ^ colorTable[index]) * 0x100000001B3ULL;
+    }
+
+    // Precomputed intensity table feeds blend tables.
+    if (precomputed) {
+        unsigned char* data = (unsigned char*)intensityColorTable;
+        for (int index = 0; index < sizeof(intensityColorTable); index++) {
+            hash = (hash ^ data[index]) * 0x100000001B3ULL;
+        }
+    }
+
+    return hash;
+}
+
+static void colorTableCachePath(char* path, unsigned long long hash)
+{
+    sprintf(path, "%s\\%08X%08X.ctb", colorTableCacheDir, (unsigned int)(hash >> 32), (unsigned int)hash);
+}
+
+// Maps cache file of the palette with given hash.
+static bool colorTableCacheOpen(unsigned long long hash)
+{
+    char path[FILENAME_MAX];
+    ColorTableCache* data;
+
+    colorTableCachePath(path, hash);
+
+#if defined(_WIN32)
+    colorTableCacheFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (colorTableCacheFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    if (GetFileSize(colorTableCacheFile, NULL) != sizeof(ColorTableCache)) {
+        colorTableCacheClose();
+        return false;
+    }
+
+    colorTableCacheMapping = CreateFileMappingA(colorTableCacheFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (colorTableCacheMapping == NULL) {
+        colorTableCacheClose();
+        return false;
+    }
+
+    data = (ColorTableCache*)MapViewOfFile(colorTableCacheMapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL) {
+        colorTableCacheClose();
+        return false;
+    }
+#else
+    struct stat st;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+
+    if (fstat(fd, &st) != 0 || st.st_size != sizeof(ColorTableCache)) {
+        close(fd);
+        return false;
+    }
+
+    data = (ColorTableCache*)mmap(NULL, sizeof(ColorTableCache), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        return false;
+    }
+#endif
+
+    colorTableCacheData = data;
+
+    if (data->header.magic != COLOR_TABLE_CACHE_MAGIC
+        || data->header.version != COLOR_TABLE_CACHE_VERSION
+        || data->header.hash != hash) {
+        colorTableCacheClose();
+        return false;
+    }
+
+    return true;
+}
+
+static void colorTableCacheClose()
+{
+#if defined(_WIN32)
+    if (colorTableCacheData != NULL) {
+        UnmapViewOfFile(colorTableCacheData);
+    }
+
+    if (colorTableCacheMapping != NULL) {
+        CloseHandle(colorTableCacheMapping);
+        colorTableCacheMapping = NULL;
+    }
+
+    if (colorTableCacheFile != INVALID_HANDLE_VALUE) {
+        CloseHandle(colorTableCacheFile);
+        colorTableCacheFile = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (colorTableCacheData != NULL) {
+        munmap(colorTableCacheData, sizeof(ColorTableCache));
+    }
+#endif
+
+    colorTableCacheData = NULL;
+}
+
+// Writes tables of the current palette to cache. Blend tables are built for
+// every color, so later `getColorBlendTable` calls are just copies. The file
+// is written under temporary name and renamed when complete.
+static bool colorTableCacheWrite(unsigned long long hash)
+{
+    char path[FILENAME_MAX];
+    char tempPath[FILENAME_MAX];
+    ColorTableCacheHeader header;
+    unsigned char* buffer;
+    unsigned long long start;
+    FILE* stream;
+    bool success;
+
+    buffer = (unsigned char*)mallocPtr(COLOR_BLEND_TABLE_SIZE);
+    if (buffer == NULL) {
+        return false;
+    }
+
+    // Blend table is only 3584 bytes, keep the padding deterministic.
+    memset(buffer, 0, COLOR_BLEND_TABLE_SIZE);
+
+    colorTableCachePath(path, hash);
+    sprintf(tempPath, "%s.tmp", path);
+
+    stream = fopen(tempPath, "wb");
+    if (stream == NULL) {
+        freePtr(buffer);
+        return false;
+    }
+
+    start = profile_get_time();
+
+    header.magic = COLOR_TABLE_CACHE_MAGIC;
+    header.version = COLOR_TABLE_CACHE_VERSION;
+    header.hash = hash;
+
+    success = fwrite(&header, sizeof(header), 1, stream) == 1
+        && fwrite(intensityColorTable, sizeof(intensityColorTable), 1, stream) == 1
+        && fwrite(colorMixAddTable, sizeof(colorMixAddTable), 1, stream) == 1
+        && fwrite(colorMixMulTable, sizeof(colorMixMulTable), 1, stream) == 1;
+
+    for (int index = 0; index < 256 && success; index++) {
+        buildBlendTable(buffer, index);
+        success = fwrite(buffer, COLOR_BLEND_TABLE_SIZE, 1, stream) == 1;
+    }
+
+    fclose(stream);
+    freePtr(buffer);
+
+    if (success) {
+        remove(path);
+        success = rename(tempPath, path) == 0;
+    }
+
+    if (!success) {
+        remove(tempPath);
+        return false;
+    }
+
+    debug_printf("color: built table cache %s in %.3f ms\n", path, (profile_get_time() - start) / 1000.0);
+
+    return true;
+}
@@ -65,5 +65,7 @@ bool colorPopColorPalette();
 bool initColors();
 void colorsClose();
 unsigned char* getColorPalette();
+void colorSetTableCacheDir(const char* path);
+void colorTableBenchmark(int iterations);
 
 #endif /* FALLOUT_PLIB_COLOR_COLOR_H_ */
@@ -19,6 +19,13 @@
 #define DB_DATABASE_FILE_LIST_CAPACITY 32
 #define DB_HASH_TABLE_SIZE 4095
 
+// Number of values byte-swapped at once by bulk writers.
+#define DB_SWAP_BUFFER_SIZE 256
+
+// Max size of record in file read or written by `db_freadRecord` and
+// `db_fwriteRecord`.
+#define DB_RECORD_BUFFER_SIZE 1024
+
 typedef struct DB_DATABASE DB_DATABASE;
 
 typedef struct DB_FILE {
@@ -96,6 +103,9 @@ static char* db_default_strdup(const char* string);
 static void db_default_free(void* ptr);
 static void db_preload_buffer(DB_FILE* stream);
 static int fread_short(FILE* stream, unsigned short* s);
+static void db_swap_shorts(unsigned short* s, int count);
+static void db_swap_ints(unsigned int* i, int count);
+static int db_mem_write(DB_FILE* stream, const void* buf, int size);
 
 static inline bool fileFindIsDirectory(DB_FIND_DATA* find_data);
 static inline char* fileFindGetName(DB_FIND_DATA* find_data);
@@ -648,6 +658,99 @@ DB_FILE* db_fopen(const char* filename, const char* mode)
     return NULL;
 }
 
+// Opens read-only binary stream over a copy of `size` bytes at `buf`, so
+// caller is free to discard `buf` once stream is open.
+DB_FILE* db_fopen_mem(const void* buf, int size)
+{
+    unsigned char* copy;
+    DB_FILE* stream;
+
+    if (current_database == NULL) {
+        return NULL;
+    }
+
+    if (buf == NULL || size < 0) {
+        return NULL;
+    }
+
+    if (current_database->files_length >= DB_DATABASE_FILE_LIST_CAPACITY) {
+        return NULL;
+    }
+
+    copy = (unsigned char*)internal_malloc(size != 0 ? size : 1);
+    if (copy == NULL) {
+        return NULL;
+    }
+
+    memcpy(copy, buf, size);
+
+    stream = db_add_fp_rec(NULL, copy, size, 0x1 | 0x10 | 0x8);
+    if (stream == NULL) {
+        internal_free(copy);
+    }
+
+    return stream;
+}
+
+// Opens binary stream writing into growable memory buffer. Use
+// `db_fclose_mem` to take written data.
+DB_FILE* db_fopen_mem_write(int capacity)
+{
+    unsigned char* buf;
+    DB_FILE* stream;
+
+    if (current_database == NULL) {
+        return NULL;
+    }
+
+    if (current_database->files_length >= DB_DATABASE_FILE_LIST_CAPACITY) {
+        return NULL;
+    }
+
+    if (capacity <= 0) {
+        capacity = 4096;
+    }
+
+    buf = (unsigned char*)internal_malloc(capacity);
+    if (buf == NULL) {
+        return NULL;
+    }
+
+    stream = db_add_fp_rec(NULL, buf, 0, 0x1 | 0x80);
+    if (stream == NULL) {
+        internal_free(buf);
+        return NULL;
+    }
+
+    stream->field_14 = capacity;
+
+    return stream;
+}
+
+// Closes stream opened with `db_fopen_mem_write` and returns its buffer,
+// which should be released with `db_free_mem`.
+unsigned char* db_fclose_mem(DB_FILE* stream, int* sizePtr)
+{
+    unsigned char* buf;
+
+    if (stream == NULL || (stream->flags & 0xF0) != 128) {
+        return NULL;
+    }
+
+    buf = stream->field_1C;
+    *sizePtr = stream->field_C;
+
+    stream->field_1C = NULL;
+    db_delete_fp_rec(stream);
+
+    return buf;
+}
+
+void db_free_mem(void* ptr)
+{
+    internal_free(ptr);
+}
+
 // 0x4B2664
 int db_fclose(DB_FILE* stream)
 {
@@ -1060,6 +1163,10 @@ int db_fseek(DB_FILE* stream, long offset, int origin)
                 stream->field_10 = stream->field_C - offset;
                 rc = 0;
                 break;
+            case 128:
+                stream->field_18 = offset;
+                rc = 0;
+                break;
             case 32:
                 if (fseek(stream->database->stream, stream->field_14 + offset, SEEK_SET) == 0) {
                     stream->field_18 = ftell(stream->database->stream);
@@ -1118,6 +1225,8 @@ long db_ftell(DB_FILE* stream)
             case 32:
             case 64:
                 return stream->field_C - stream->field_10;
+            case 128:
+                return stream->field_18;
             }
         }
     }
@@ -1147,6 +1256,9 @@ void db_rewind(DB_FILE* stream)
                 stream->field_18 = stream->field_14;
                 db_preload_buffer(stream);
                 break;
+            case 128:
+                stream->field_18 = 0;
+                break;
             }
         }
     }
@@ -1159,16 +1271,33 @@ size_t db_fwrite(const void* buf, size_t size, size_t count, DB_FILE* stream)
         return fwrite(buf, size, count, stream->uncompressed_file_stream);
     }
 
+    if (stream != NULL && (stream->flags & 0xF0) == 128) {
+        if (db_mem_write(stream, buf, (int)(size * count)) == -1) {
+            return 0;
+        }
+        return count;
+    }
+
     return count - 1;
 }
 
 // 0x4B077C
 int db_fputc(int ch, DB_FILE* stream)
 {
+    unsigned char c;
+
     if (stream != NULL && (stream->flags & 0x4) != 0) {
         return fputc(ch, stream->uncompressed_file_stream);
     }
 
+    if (stream != NULL && (stream->flags & 0xF0) == 128) {
+        c = (unsigned char)ch;
+        if (db_mem_write(stream, &c, 1) == -1) {
+            return -1;
+        }
+        return c;
+    }
+
     return -1;
 }
 
@@ -1179,6 +1308,10 @@ int db_fputs(const char* string, DB_FILE* stream)
         return fputs(string, stream->uncompressed_file_stream);
     }
 
+    if (stream != NULL && (stream->flags & 0xF0) == 128) {
+        return db_mem_write(stream, string, strlen(string));
+    }
+
     return -1;
 }
 
@@ -1305,16 +1438,12 @@ int db_fwriteFloat(DB_FILE* stream, float q)
 // 0x4B09D4
 int db_freadByteCount(DB_FILE* stream, unsigned char* c, int count)
 {
-    int index;
-    unsigned char value;
-
-    for (index = 0; index < count; index++) {
-        // NOTE: Uninline.
-        if (db_freadByte(stream, &value) == -1) {
-            return -1;
-        }
+    if (count <= 0) {
+        return 0;
+    }
 
-        c[index] = value;
+    if (db_fread(c, 1, count, stream) != (size_t)count) {
+        return -1;
     }
 
     return 0;
@@ -1323,36 +1452,32 @@ int db_freadByteCount(DB_FILE* stream, unsigned char* c, int count)
 // 0x4B0A14
 int db_freadShortCount(DB_FILE* stream, unsigned short* s, int count)
 {
-    int index;
-    unsigned short value;
-
-    for (index = 0; index < count; index++) {
-        // NOTE: Uninline.
-        if (db_freadShort(stream, &value) == -1) {
-            return -1;
-        }
+    if (count <= 0) {
+        return 0;
+    }
 
-        s[index] = value;
+    if (db_fread(s, sizeof(*s), count, stream) != (size_t)count) {
+        return -1;
     }
 
+    db_swap_shorts(s, count);
+
     return 0;
 }
 
 // 0x4B0AB0
 int db_freadIntCount(DB_FILE* stream, int* i, int count)
 {
-    int index;
-    int value;
-
-    for (index = 0; index < count; index++) {
-        // NOTE: Uninline.
-        if (db_freadInt(stream, &value) == -1) {
-            return -1;
-        }
+    if (count <= 0) {
+        return 0;
+    }
 
-        i[index] = value;
+    if (db_fread(i, sizeof(*i), count, stream) != (size_t)count) {
+        return -1;
     }
 
+    db_swap_ints((unsigned int*)i, count);
+
     return 0;
 }
 
@@ -1395,13 +1520,12 @@ int db_freadFloatCount(DB_FILE* stream, float* q, int count)
 // 0x4B0B80
 int db_fwriteByteCount(DB_FILE* stream, unsigned char* c, int count)
 {
-    int index;
+    if (count <= 0) {
+        return 0;
+    }
 
-    for (index = 0; index < count; index++) {
-        // NOTE: Uninline.
-        if (db_fwriteByte(stream, c[index]) == -1) {
-            return -1;
-        }
+    if (db_fwrite(c, 1, count, stream) != (size_t)count) {
+        return -1;
     }
 
     return 0;
@@ -1410,13 +1534,20 @@ int db_fwriteByteCount(DB_FILE* stream, unsigned char* c, int count)
 // 0x4B0BC8
 int db_fwriteShortCount(DB_FILE* stream, unsigned short* s, int count)
 {
-    int index;
+    unsigned short buffer[DB_SWAP_BUFFER_SIZE];
+    int chunk;
 
-    for (index = 0; index < count; index++) {
-        // NOTE: Uninline.
-        if (db_fwriteShort(stream, s[index]) == -1) {
+    while (count > 0) {
+        chunk = count < DB_SWAP_BUFFER_SIZE ? count : DB_SWAP_BUFFER_SIZE;
+        memcpy(buffer, s, sizeof(*buffer) * chunk);
+        db_swap_shorts(buffer, chunk);
+
+        if (db_fwrite(buffer, sizeof(*buffer), chunk, stream) != (size_t)chunk) {
             return -1;
         }
+
+        s += chunk;
+        count -= chunk;
     }
 
     return 0;
@@ -1425,13 +1556,20 @@ int db_fwriteShortCount(DB_FILE* stream, unsigned short* s, int count)
 // 0x4B0C3C
 int db_fwriteIntCount(DB_FILE* stream, int* i, int count)
 {
-    int index;
+    unsigned int buffer[DB_SWAP_BUFFER_SIZE];
+    int chunk;
 
-    for (index = 0; index < count; index++) {
-        // NOTE: Uninline.
-        if (db_fwriteInt(stream, i[index]) == -1) {
+    while (count > 0) {
+        chunk = count < DB_SWAP_BUFFER_SIZE ? count : DB_SWAP_BUFFER_SIZE;
+        memcpy(buffer, i, sizeof(*buffer) * chunk);
+        db_swap_ints(buffer, chunk);
+
+        if (db_fwrite(buffer, sizeof(*buffer), chunk, stream) != (size_t)chunk) {
             return -1;
         }
+
+        i += chunk;
+        count -= chunk;
     }
 
     return 0;
@@ -1467,6 +1605,162 @@ int db_fwriteFloatCount(DB_FILE* stream, float* q, int count)
     return 0;
 }
 
+// Reads big-endian record described by `fields` with a single read and
+// stores its fields into `record`.
+int db_freadRecord(DB_FILE* stream, void* record, const DBRecordField* fields, int count)
+{
+    unsigned char buffer[DB_RECORD_BUFFER_SIZE];
+    unsigned char* ptr;
+    unsigned char* dest;
+    size_t size;
+    int index;
+    int value;
+
+    size = 0;
+    for (index = 0; index < count; index++) {
+        size += fields[index].size * fields[index].count;
+    }
+
+    if (size > sizeof(buffer)) {
+        return -1;
+    }
+
+    if (db_fread(buffer, 1, size, stream) != size) {
+        return -1;
+    }
+
+    ptr = buffer;
+    for (index = 0; index < count; index++) {
+        dest = (unsigned char*)record + fields[index].offset;
+        for (value = 0; value < fields[index].count; value++) {
+            switch (fields[index].size) {
+            case 1:
+                *dest = ptr[0];
+                break;
+            case 2:
+                *(unsigned short*)dest = (unsigned short)((ptr[0] << 8) | ptr[1]);
+                break;
+            case 4:
+                *(unsigned int*)dest = ((unsigned int)ptr[0] << 24) | ((unsigned int)ptr[1] << 16) | ((unsigned int)ptr[2] << 8) | ptr[3];
+                break;
+            }
+            dest += fields[index].size;
+            ptr += fields[index].size;
+        }
+    }
+
+    return 0;
+}
+
+// Mirrors `db_freadRecord`.
+int db_fwriteRecord(DB_FILE* stream, const void* record, const DBRecordField* fields, int count)
+{
+    unsigned char buffer[DB_RECORD_BUFFER_SIZE];
+    unsigned char* ptr;
+    const unsigned char* src;
+    unsigned int data;
+    size_t size;
+    int index;
+    int value;
+
+    size = 0;
+    for (index = 0; index < count; index++) {
+        size += fields[index].size * fields[index].count;
+    }
+
+    if (size > sizeof(buffer)) {
+        return -1;
+    }
+
+    ptr = buffer;
+    for (index = 0; index < count; index++) {
+        src = (const unsigned char*)record + fields[index].offset;
+        for (value = 0; value < fields[index].count; value++) {
+            switch (fields[index].size) {
+            case 1:
+                ptr[0] = *src;
+                break;
+            case 2:
+                data = *(const unsigned short*)src;
+                ptr[0] = (data >> 8) & 0xFF;
+                ptr[1] = data & 0xFF;
+                break;
+            case 4:
+                data = *(const unsigned int*)src;
+                ptr[0] = (data >> 24) & 0xFF;
+                ptr[1] = (data >> 16) & 0xFF;
+                ptr[2] = (data >> 8) & 0xFF;
+                ptr[3] = data & 0xFF;
+                break;
+            }
+            src += fields[index].size;
+            ptr += fields[index].size;
+        }
+    }
+
+    if (db_fwrite(buffer, 1, size, stream) != size) {
+        return -1;
+    }
+
+    return 0;
+}
+
+// Converts big-endian values read from file to native order and back.
+static void db_swap_shorts(unsigned short* s, int count)
+{
+    int index;
+
+    for (index = 0; index < count; index++) {
+        s[index] = (unsigned short)((s[index] >> 8) | (s[index] << 8));
+    }
+}
+
+static void db_swap_ints(unsigned int* i, int count)
+{
+    int index;
+    unsigned int value;
+
+    for (index = 0; index < count; index++) {
+        value = i[index];
+        i[index] = (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+    }
+}
+
+// Writes `size` bytes at current position of memory stream, growing it as
+// needed.
+static int db_mem_write(DB_FILE* stream, const void* buf, int size)
+{
+    int capacity;
+    unsigned char* data;
+
+    if (stream->field_18 + size > stream->field_14) {
+        capacity = stream->field_14 * 2;
+        while (capacity < stream->field_18 + size) {
+            capacity *= 2;
+        }
+
+        data = (unsigned char*)internal_malloc(capacity);
+        if (data == NULL) {
+            return -1;
+        }
+
+        memcpy(data, stream->field_1C, stream->field_C);
+        internal_free(stream->field_1C);
+
+        stream->field_1C = data;
+        stream->field_14 = capacity;
+    }
+
+    memcpy(stream->field_1C + stream->field_18, buf, size);
+    stream->field_18 += size;
+
+    if (stream->field_18 > stream->field_C) {
+        stream->field_C = stream->field_18;
+    }
+
+    return 0;
+}
+
 // 0x4B0D94
 static int db_read_long(FILE* stream, unsigned long* value_ptr)
 {
@@ -2385,6 +2679,11 @@ static DB_FILE* db_add_fp_rec(FILE* stream, unsigned char* a2, int a3, int flags
                     current_database->files[pos].field_20 = a2 + 0x4000;
                     ptr = &(current_database->files[pos]);
                     break;
+                case 128:
+                    current_database->files[pos].field_18 = 0;
+                    current_database->files[pos].field_1C = a2;
+                    ptr = &(current_database->files[pos]);
+                    break;
                 }
             }
         }
@@ -2418,6 +2717,7 @@ static int db_delete_fp_rec(DB_FILE* stream)
         case 32:
             break;
         case 64:
+        case 128:
             if (stream->field_1C != NULL) {
                 internal_free(stream->field_1C);
             }
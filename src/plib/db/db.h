@@ -13,6 +13,24 @@ typedef struct dir_entry_s {
     int field_C;
 } dir_entry;
 
+// Describes big-endian field of a record in file, see `db_freadRecord`.
+typedef struct DBRecordField {
+    // Size of one value in file and in memory: 1, 2 or 4 bytes.
+    int size;
+
+    // Offset of field in record struct.
+    int offset;
+
+    // Number of consecutive values (for array fields).
+    int count;
+} DBRecordField;
+
+#define DB_RECORD_BYTE(type, member) { 1, (int)offsetof(type, member), 1 }
+#define DB_RECORD_BYTES(type, member, n) { 1, (int)offsetof(type, member), n }
+#define DB_RECORD_INT(type, member) { 4, (int)offsetof(type, member), 1 }
+#define DB_RECORD_INTS(type, member, n) { 4, (int)offsetof(type, member), n }
+#define DB_RECORD_LENGTH(fields) ((int)(sizeof(fields) / sizeof((fields)[0])))
+
 typedef void db_read_callback();
 typedef void*(db_malloc_func)(size_t size);
 typedef char*(db_strdup_func)(const char* string);
@@ -27,6 +45,10 @@ void db_exit();
 int db_dir_entry(const char* filePath, dir_entry* de);
 int db_read_to_buf(const char* filePath, unsigned char* ptr);
 DB_FILE* db_fopen(const char* filename, const char* mode);
+DB_FILE* db_fopen_mem(const void* buf, int size);
+DB_FILE* db_fopen_mem_write(int capacity);
+unsigned char* db_fclose_mem(DB_FILE* stream, int* sizePtr);
+void db_free_mem(void* ptr);
 int db_fclose(DB_FILE* stream);
 size_t db_fread(void* buf, size_t size, size_t count, DB_FILE* stream);
 int db_fgetc(DB_FILE* stream);
@@ -58,6 +80,8 @@ int db_fwriteShortCount(DB_FILE* stream, unsigned short* s, int count);
 int db_fwriteIntCount(DB_FILE* stream, int* i, int count);
 int db_fwriteLongCount(DB_FILE* stream, unsigned long* l, int count);
 int db_fwriteFloatCount(DB_FILE* stream, float* q, int count);
+int db_freadRecord(DB_FILE* stream, void* record, const DBRecordField* fields, int count);
+int db_fwriteRecord(DB_FILE* stream, const void* record, const DBRecordField* fields, int count);
 int db_fprintf(DB_FILE* stream, const char* format, ...);
 int db_feof(DB_FILE* stream);
 int db_get_file_list(const char* filespec, char*** filelist, char*** desclist, int desclen);
@@ -9,6 +9,16 @@
 
 #include <string.h>
 
+// Ring buffer parameters of the format, decoders above start at
+// `LZSS_RING_START` with ring filled with spaces.
+#define LZSS_RING_SIZE 4096
+#define LZSS_RING_START 4078
+#define LZSS_MIN_MATCH 3
+#define LZSS_MAX_MATCH 18
+
+#define LZSS_HASH_SIZE 4096
+#define LZSS_MAX_CHAIN 32
+
 static inline void lzss_fill_decode_buffer(FILE* stream);
 static inline void lzss_decode_chunk_to_buf(unsigned int type, unsigned char** dest, unsigned int* length);
 static inline void lzss_decode_chunk_to_file(unsigned int type, FILE* stream, unsigned int* length);
@@ -302,3 +312,157 @@ static inline void lzss_decode_chunk_to_file(unsigned int type, FILE* stream, un
         }
     }
 }
+
+// Same as `lzss_decode_to_buf`, but reads from memory and uses no shared
+// state, so it can be used from any thread. Returns number of bytes decoded,
+// or -1 if `src` is truncated or decodes to more than `length` bytes.
+int lzss_decode_buf(const unsigned char* src, unsigned int srcLength, unsigned char* dest, unsigned int length)
+{
+    unsigned char ring[LZSS_RING_SIZE];
+    const unsigned char* end;
+    unsigned char* curr;
+    int ringIndex;
+    unsigned int flags;
+    int bit;
+    int offset;
+    int matchLength;
+    int index;
+
+    memset(ring, ' ', LZSS_RING_START);
+    ringIndex = LZSS_RING_START;
+
+    end = src + srcLength;
+    curr = dest;
+
+    while (src < end) {
+        flags = *src++;
+
+        for (bit = 0; bit < 8 && src < end; bit++) {
+            if ((flags & (1 << bit)) != 0) {
+                if (curr == dest + length) {
+                    return -1;
+                }
+
+                *curr = *src++;
+                ring[ringIndex] = *curr++;
+                ringIndex = (ringIndex + 1) & (LZSS_RING_SIZE - 1);
+            } else {
+                if (end - src < 2) {
+                    return -1;
+                }
+
+                offset = src[0] | ((src[1] & 0xF0) << 4);
+                matchLength = (src[1] & 0x0F) + LZSS_MIN_MATCH;
+                src += 2;
+
+                if (curr + matchLength > dest + length) {
+                    return -1;
+                }
+
+                for (index = 0; index < matchLength; index++) {
+                    *curr = ring[(offset + index) & (LZSS_RING_SIZE - 1)];
+                    ring[ringIndex] = *curr++;
+                    ringIndex = (ringIndex + 1) & (LZSS_RING_SIZE - 1);
+                }
+            }
+        }
+    }
+
+    return curr - dest;
+}
+
+// Compresses `length` bytes into format understood by decoders above.
+// `dest` should be at least `LZSS_ENCODE_BOUND(length)` bytes. Returns size
+// of compressed data. Uses no shared state.
+//
+// Matches are only searched within the input itself (not the initial
+// spaces of the ring) using hash chains over three byte prefixes.
+unsigned int lzss_encode_buf(const unsigned char* src, unsigned int length, unsigned char* dest)
+{
+    int head[LZSS_HASH_SIZE];
+    int prev[LZSS_RING_SIZE];
+    unsigned char* flagsPtr;
+    unsigned char* curr;
+    int bit;
+    int pos;
+    int hash;
+    int candidate;
+    int chain;
+    int bestLength;
+    int bestPos;
+    int matchLength;
+    int maxLength;
+    int index;
+
+    memset(head, 0xFF, sizeof(head));
+
+    curr = dest;
+    flagsPtr = NULL;
+    bit = 8;
+    pos = 0;
+
+    while (pos < (int)length) {
+        if (bit == 8) {
+            flagsPtr = curr++;
+            *flagsPtr = 0;
+            bit = 0;
+        }
+
+        bestLength = 0;
+        bestPos = 0;
+
+        maxLength = (int)length - pos;
+        if (maxLength > LZSS_MAX_MATCH) {
+            maxLength = LZSS_MAX_MATCH;
+        }
+
+        if (maxLength >= LZSS_MIN_MATCH) {
+            hash = ((src[pos] << 4) ^ (src[pos + 1] << 2) ^ src[pos + 2]) & (LZSS_HASH_SIZE - 1);
+            candidate = head[hash];
+            chain = LZSS_MAX_CHAIN;
+
+            // Distance is limited so that referenced bytes are still in the
+            // decoder ring when copy starts.
+            while (candidate != -1 && pos - candidate < LZSS_RING_SIZE - LZSS_MAX_MATCH && chain-- > 0) {
+                matchLength = 0;
+                while (matchLength < maxLength && src[candidate + matchLength] == src[pos + matchLength]) {
+                    matchLength++;
+                }
+
+                if (matchLength > bestLength) {
+                    bestLength = matchLength;
+                    bestPos = candidate;
+                    if (matchLength == maxLength) {
+                        break;
+                    }
+                }
+
+                candidate = prev[candidate & (LZSS_RING_SIZE - 1)];
+            }
+        }
+
+        if (bestLength >= LZSS_MIN_MATCH) {
+            index = (bestPos + LZSS_RING_START) & (LZSS_RING_SIZE - 1);
+            *curr++ = index & 0xFF;
+            *curr++ = ((index >> 4) & 0xF0) | (bestLength - LZSS_MIN_MATCH);
+        } else {
+            *flagsPtr |= 1 << bit;
+            *curr++ = src[pos];
+            bestLength = 1;
+        }
+
+        bit++;
+
+        // Insert every consumed position into hash chains.
+        for (index = 0; index < bestLength; index++) {
+            if (pos + 2 < (int)length) {
+                hash = ((src[pos] << 4) ^ (src[pos + 1] << 2) ^ src[pos + 2]) & (LZSS_HASH_SIZE - 1);
+                prev[pos & (LZSS_RING_SIZE - 1)] = head[hash];
+                head[hash] = pos;
+            }
+            pos++;
+        }
+    }
+
+    return curr - dest;
+}
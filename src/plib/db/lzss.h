@@ -3,7 +3,13 @@
 
 #include <stdio.h>
 
+// The maximum size of data produced by `lzss_encode_buf` from `length`
+// bytes.
+#define LZSS_ENCODE_BOUND(length) ((length) + ((length) + 7) / 8)
+
 int lzss_decode_to_buf(FILE* in, unsigned char* dest, unsigned int length);
 void lzss_decode_to_file(FILE* in, FILE* out, unsigned int length);
+int lzss_decode_buf(const unsigned char* src, unsigned int srcLength, unsigned char* dest, unsigned int length);
+unsigned int lzss_encode_buf(const unsigned char* src, unsigned int length, unsigned char* dest);
 
 #endif /* FALLOUT_PLIB_DB_LZSS_H_ */
@@ -0,0 +1,422 @@
+#include "plib/gnw/headless.h"
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "plib/gnw/debug.h"
+#include "plib/gnw/grbuf.h"
+#include "plib/gnw/profile.h"
+
+// Video backend which keeps the screen in memory instead of presenting it.
+// It does not depend on DirectDraw or GDI so the renderer can be exercised
+// (and timed) on machines without a display.
+//
+// NOTE: Only the backend itself is portable. The executable is still a WIN32
+// build (input, sound and window setup go through DirectX), so on Linux it has
+// to run under Wine, or this file has to be linked into a separate harness.
+
+static int headless_dump_ppm(FILE* stream);
+static int headless_dump_png(FILE* stream);
+static int headless_write_png_chunk(FILE* stream, const char* type, unsigned char* data, unsigned int length);
+static unsigned int headless_crc32(unsigned int crc, unsigned char* data, unsigned int length);
+static void headless_write_be32(unsigned char* dest, unsigned int value);
+
+VideoBackend headless_video_backend = {
+    "headless",
+    headless_init,
+    headless_reset,
+    headless_set_palette_entries,
+    headless_get_palette,
+    headless_show_rect,
+};
+
+static unsigned char* headless_framebuffer = NULL;
+static int headless_width = 0;
+static int headless_height = 0;
+
+// Current palette in 6-bit VGA format.
+static unsigned char headless_palette[768];
+
+static HeadlessStats headless_stats;
+
+// When non-zero every n-th present is written to `frameNNNNNN.<ext>` in the
+// working directory.
+static int headless_dump_interval = 0;
+
+// Whether periodic dumps are PNG instead of PPM.
+static bool headless_dump_as_png = false;
+
+static unsigned int headless_crc_table[256];
+static bool headless_crc_table_inited = false;
+
+int headless_init(int width, int height, int bpp)
+{
+    if (bpp != 8) {
+        return -1;
+    }
+
+    if (headless_framebuffer != NULL) {
+        headless_reset();
+    }
+
+    headless_framebuffer = (unsigned char*)malloc(width * height);
+    if (headless_framebuffer == NULL) {
+        return -1;
+    }
+
+    memset(headless_framebuffer, 0, width * height);
+
+    // Same grayscale ramp DirectDraw palette is created with.
+    for (int index = 0; index < 256; index++) {
+        headless_palette[index * 3] = index >> 2;
+        headless_palette[index * 3 + 1] = index >> 2;
+        headless_palette[index * 3 + 2] = index >> 2;
+    }
+
+    headless_width = width;
+    headless_height = height;
+
+    headless_reset_stats();
+
+    return 0;
+}
+
+void headless_reset()
+{
+    if (headless_framebuffer != NULL) {
+        if (headless_stats.presents != 0) {
+            debug_printf("headless: %u presents, avg %u us, max %u us\n",
+                headless_stats.presents,
+                (unsigned int)(headless_stats.totalPresentTime / headless_stats.presents),
+                headless_stats.maxPresentTime);
+        }
+
+        free(headless_framebuffer);
+        headless_framebuffer = NULL;
+    }
+
+    headless_width = 0;
+    headless_height = 0;
+}
+
+void headless_set_palette_entries(unsigned char* palette, int start, int count)
+{
+    if (start < 0 || count <= 0 || start + count > 256) {
+        return;
+    }
+
+    memcpy(headless_palette + start * 3, palette, count * 3);
+}
+
+unsigned char* headless_get_palette()
+{
+    return headless_palette;
+}
+
+void headless_show_rect(unsigned char* src, unsigned int srcPitch, unsigned int a3, unsigned int srcX, unsigned int srcY, unsigned int srcWidth, unsigned int srcHeight, unsigned int destX, unsigned int destY)
+{
+    unsigned long long start;
+    unsigned int elapsed;
+    char path[32];
+
+    if (src == NULL || headless_framebuffer == NULL) {
+        return;
+    }
+
+    if (destX + srcWidth > (unsigned int)headless_width
+        || destY + srcHeight > (unsigned int)headless_height) {
+        return;
+    }
+
+    start = profile_get_time();
+
+    buf_to_buf(src + srcPitch * srcY + srcX,
+        srcWidth,
+        srcHeight,
+        srcPitch,
+        headless_framebuffer + headless_width * destY + destX,
+        headless_width);
+
+    elapsed = (unsigned int)(profile_get_time() - start);
+
+    headless_stats.presents++;
+    headless_stats.pixels += srcWidth * srcHeight;
+    headless_stats.lastPresentTime = elapsed;
+    headless_stats.totalPresentTime += elapsed;
+    if (elapsed > headless_stats.maxPresentTime) {
+        headless_stats.maxPresentTime = elapsed;
+    }
+
+    if (headless_dump_interval != 0 && headless_stats.presents % headless_dump_interval == 0) {
+        sprintf(path, "frame%.6u.%s", headless_stats.presents / headless_dump_interval, headless_dump_as_png ? "png" : "ppm");
+        headless_dump_frame(path);
+    }
+}
+
+unsigned char* headless_get_framebuffer(int* widthPtr, int* heightPtr)
+{
+    if (widthPtr != NULL) {
+        *widthPtr = headless_width;
+    }
+
+    if (heightPtr != NULL) {
+        *heightPtr = headless_height;
+    }
+
+    return headless_framebuffer;
+}
+
+void headless_get_stats(HeadlessStats* stats)
+{
+    memcpy(stats, &headless_stats, sizeof(*stats));
+}
+
+void headless_reset_stats()
+{
+    memset(&headless_stats, 0, sizeof(headless_stats));
+}
+
+void headless_set_dump_interval(int interval)
+{
+    headless_dump_interval = interval > 0 ? interval : 0;
+}
+
+// Sets format of periodic dumps, either "png" or "ppm" (default).
+void headless_set_dump_format(const char* format)
+{
+    headless_dump_as_png = format != NULL
+        && tolower(format[0]) == 'p'
+        && tolower(format[1]) == 'n'
+        && tolower(format[2]) == 'g'
+        && format[3] == '\0';
+}
+
+// Writes current framebuffer to `path`. The format is PNG when file name ends
+// with `.png`, and binary PPM otherwise.
+int headless_dump_frame(const char* path)
+{
+    FILE* stream;
+    const char* ext;
+    int rc;
+
+    if (headless_framebuffer == NULL) {
+        return -1;
+    }
+
+    stream = fopen(path, "wb");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    ext = strrchr(path, '.');
+    if (ext != NULL
+        && tolower(ext[1]) == 'p'
+        && tolower(ext[2]) == 'n'
+        && tolower(ext[3]) == 'g'
+        && ext[4] == '\0') {
+        rc = headless_dump_png(stream);
+    } else {
+        rc = headless_dump_ppm(stream);
+    }
+
+    fclose(stream);
+
+    return rc;
+}
+
+static int headless_dump_ppm(FILE* stream)
+{
+    unsigned char* row;
+    unsigned char* src;
+
+    row = (unsigned char*)malloc(headless_width * 3);
+    if (row == NULL) {
+        return -1;
+    }
+
+    fprintf(stream, "P6\n%d %d\n255\n", headless_width, headless_height);
+
+    src = headless_framebuffer;
+    for (int y = 0; y < headless_height; y++) {
+        for (int x = 0; x < headless_width; x++) {
+            unsigned char* rgb = headless_palette + src[x] * 3;
+            row[x * 3] = rgb[0] << 2;
+            row[x * 3 + 1] = rgb[1] << 2;
+            row[x * 3 + 2] = rgb[2] << 2;
+        }
+
+        if (fwrite(row, 1, headless_width * 3, stream) != (size_t)(headless_width * 3)) {
+            free(row);
+            return -1;
+        }
+
+        src += headless_width;
+    }
+
+    free(row);
+
+    return 0;
+}
+
+// Writes indexed PNG. Image data is stored in uncompressed deflate blocks,
+// which keeps the writer trivial and fast at the expense of file size.
+static int headless_dump_png(FILE* stream)
+{
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    unsigned char header[13];
+    unsigned char palette[768];
+    unsigned char* data;
+    unsigned char* dest;
+    unsigned int rawLength;
+    unsigned int blocks;
+    unsigned int dataLength;
+    unsigned int adlerA;
+    unsigned int adlerB;
+    int rc;
+
+    if (fwrite(signature, 1, sizeof(signature), stream) != sizeof(signature)) {
+        return -1;
+    }
+
+    headless_write_be32(header, headless_width);
+    headless_write_be32(header + 4, headless_height);
+    header[8] = 8; // bit depth
+    header[9] = 3; // indexed color
+    header[10] = 0;
+    header[11] = 0;
+    header[12] = 0;
+
+    if (headless_write_png_chunk(stream, "IHDR", header, sizeof(header)) != 0) {
+        return -1;
+    }
+
+    for (int index = 0; index < 768; index++) {
+        palette[index] = headless_palette[index] << 2;
+    }
+
+    if (headless_write_png_chunk(stream, "PLTE", palette, sizeof(palette)) != 0) {
+        return -1;
+    }
+
+    // Every scanline is prefixed with filter type (0 - none).
+    rawLength = (headless_width + 1) * headless_height;
+    blocks = (rawLength + 65534) / 65535;
+    dataLength = 2 + rawLength + blocks * 5 + 4;
+
+    data = (unsigned char*)malloc(dataLength);
+    if (data == NULL) {
+        return -1;
+    }
+
+    dest = data;
+
+    // zlib header, no compression.
+    *dest++ = 0x78;
+    *dest++ = 0x01;
+
+    adlerA = 1;
+    adlerB = 0;
+
+    unsigned int remaining = rawLength;
+    unsigned int offset = 0;
+    while (remaining != 0) {
+        unsigned int length = remaining > 65535 ? 65535 : remaining;
+
+        *dest++ = length == remaining ? 1 : 0;
+        *dest++ = length & 0xFF;
+        *dest++ = (length >> 8) & 0xFF;
+        *dest++ = ~length & 0xFF;
+        *dest++ = (~length >> 8) & 0xFF;
+
+        for (unsigned int index = 0; index < length; index++) {
+            unsigned int pos = offset + index;
+            unsigned int x = pos % (headless_width + 1);
+            unsigned int y = pos / (headless_width + 1);
+            unsigned char value = x == 0 ? 0 : headless_framebuffer[y * headless_width + x - 1];
+
+            *dest++ = value;
+
+            adlerA = (adlerA + value) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+
+        offset += length;
+        remaining -= length;
+    }
+
+    headless_write_be32(dest, (adlerB << 16) | adlerA);
+
+    rc = headless_write_png_chunk(stream, "IDAT", data, dataLength);
+    free(data);
+
+    if (rc != 0) {
+        return -1;
+    }
+
+    return headless_write_png_chunk(stream, "IEND", NULL, 0);
+}
+
+static int headless_write_png_chunk(FILE* stream, const char* type, unsigned char* data, unsigned int length)
+{
+    unsigned char buffer[4];
+    unsigned int crc;
+
+    headless_write_be32(buffer, length);
+    if (fwrite(buffer, 1, 4, stream) != 4) {
+        return -1;
+    }
+
+    if (fwrite(type, 1, 4, stream) != 4) {
+        return -1;
+    }
+
+    if (length != 0) {
+        if (fwrite(data, 1, length, stream) != length) {
+            return -1;
+        }
+    }
+
+    crc = headless_crc32(0xFFFFFFFF, (unsigned char*)type, 4);
+    if (length != 0) {
+        crc = headless_crc32(crc, data, length);
+    }
+
+    headless_write_be32(buffer, crc ^ 0xFFFFFFFF);
+    if (fwrite(buffer, 1, 4, stream) != 4) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static unsigned int headless_crc32(unsigned int crc, unsigned char* data, unsigned int length)
+{
+    if (!headless_crc_table_inited) {
+        for (unsigned int index = 0; index < 256; index++) {
+            unsigned int value = index;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) != 0 ? 0xEDB88320 ^ (value >> 1) : value >> 1;
+            }
+            headless_crc_table[index] = value;
+        }
+        headless_crc_table_inited = true;
+    }
+
+    for (unsigned int index = 0; index < length; index++) {
+        crc = headless_crc_table[(crc ^ data[index]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+static void headless_write_be32(unsigned char* dest, unsigned int value)
+{
+    dest[0] = (value >> 24) & 0xFF;
+    dest[1] = (value >> 16) & 0xFF;
+    dest[2] = (value >> 8) & 0xFF;
+    dest[3] = value & 0xFF;
+}
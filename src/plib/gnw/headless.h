@@ -0,0 +1,37 @@
+#ifndef FALLOUT_PLIB_GNW_HEADLESS_H_
+#define FALLOUT_PLIB_GNW_HEADLESS_H_
+
+#include "plib/gnw/svga_types.h"
+
+typedef struct HeadlessStats {
+    // Number of rects presented since init.
+    unsigned int presents;
+
+    // Number of pixels copied into framebuffer since init.
+    unsigned long long pixels;
+
+    // Duration of the last present in microseconds.
+    unsigned int lastPresentTime;
+
+    // Longest present in microseconds.
+    unsigned int maxPresentTime;
+
+    // Sum of all presents in microseconds.
+    unsigned long long totalPresentTime;
+} HeadlessStats;
+
+extern VideoBackend headless_video_backend;
+
+int headless_init(int width, int height, int bpp);
+void headless_reset();
+void headless_set_palette_entries(unsigned char* palette, int start, int count);
+unsigned char* headless_get_palette();
+void headless_show_rect(unsigned char* src, unsigned int srcPitch, unsigned int a3, unsigned int srcX, unsigned int srcY, unsigned int srcWidth, unsigned int srcHeight, unsigned int destX, unsigned int destY);
+unsigned char* headless_get_framebuffer(int* widthPtr, int* heightPtr);
+void headless_get_stats(HeadlessStats* stats);
+void headless_reset_stats();
+void headless_set_dump_interval(int interval);
+void headless_set_dump_format(const char* format);
+int headless_dump_frame(const char* path);
+
+#endif /* FALLOUT_PLIB_GNW_HEADLESS_H_ */
@@ -10,6 +10,7 @@
 #include "plib/gnw/intrface.h"
 #include "plib/gnw/memory.h"
 #include "plib/gnw/mmx.h"
+#include "plib/gnw/profile.h"
 #include "plib/gnw/svga.h"
 #include "plib/gnw/text.h"
 #include "plib/gnw/vcr.h"
@@ -180,6 +181,8 @@ int get_input()
 {
     int v3;
 
+    profile_frame();
+
     GNW95_process_message();
 
     if (!GNW95_isActive) {
@@ -0,0 +1,1164 @@
+#include "plib/gnw/mixer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "plib/gnw/debug.h"
+#include "plib/gnw/profile.h"
+#include "plib/gnw/thread.h"
+
+// Software replacement for DirectSound. The mixer implements enough of
+// IDirectSound and IDirectSoundBuffer for sound library and movie library to
+// run on top of it unchanged, and hands mixed audio to a sink instead of the
+// sound card. Everything here is allocated with plain malloc, since mixing
+// happens on mixer thread.
+
+// Maximum number of frames mixed at once.
+#define MIXER_BLOCK_FRAMES 1024
+
+// How often realtime mixer wakes up (in milliseconds).
+#define MIXER_INTERVAL 10
+
+// Channel gains are 4.12 fixed point.
+#define MIXER_GAIN_SHIFT 12
+#define MIXER_GAIN_ONE (1 << MIXER_GAIN_SHIFT)
+
+typedef struct MixerBuffer MixerBuffer;
+
+typedef struct Mixer {
+    // Should be the first member, mixer is handed out as `LPDIRECTSOUND`.
+    IDirectSoundVtbl* lpVtbl;
+    ULONG refs;
+
+    MixerSink* sink;
+    int rate;
+
+    // Protects buffer list and playback state of every buffer. Data itself is
+    // not protected, like in DirectSound the caller only writes to the part
+    // of the buffer which is not being played.
+    Mutex* mutex;
+    MixerBuffer* buffers;
+
+    Thread* thread;
+    volatile int quit;
+
+    int* accum;
+    short* output;
+
+    MixerStats stats;
+} Mixer;
+
+struct MixerBuffer {
+    // Should be the first member, buffer is handed out as
+    // `LPDIRECTSOUNDBUFFER`.
+    IDirectSoundBufferVtbl* lpVtbl;
+    ULONG refs;
+
+    // NULL when mixer was released before the buffer.
+    Mixer* mixer;
+    MixerBuffer* prev;
+    MixerBuffer* next;
+
+    DWORD flags;
+    WAVEFORMATEX format;
+    unsigned char* data;
+    int size;
+    int frames;
+
+    // Play cursor in frames, and the fraction of the frame in 16.16 fixed
+    // point when buffer frequency differs from mixer rate.
+    int position;
+    unsigned int fraction;
+
+    DWORD frequency;
+    LONG volume;
+    LONG pan;
+    int leftGain;
+    int rightGain;
+    bool playing;
+    bool looping;
+};
+
+static HRESULT STDMETHODCALLTYPE mixer_query_interface(IDirectSound* directSound, REFIID riid, LPVOID* ppvObj);
+static ULONG STDMETHODCALLTYPE mixer_add_ref(IDirectSound* directSound);
+static ULONG STDMETHODCALLTYPE mixer_release(IDirectSound* directSound);
+static HRESULT STDMETHODCALLTYPE mixer_create_sound_buffer(IDirectSound* directSound, LPCDSBUFFERDESC desc, LPDIRECTSOUNDBUFFER* bufferPtr, LPUNKNOWN outer);
+static HRESULT STDMETHODCALLTYPE mixer_get_caps(IDirectSound* directSound, LPDSCAPS caps);
+static HRESULT STDMETHODCALLTYPE mixer_duplicate_sound_buffer(IDirectSound* directSound, LPDIRECTSOUNDBUFFER original, LPDIRECTSOUNDBUFFER* duplicatePtr);
+static HRESULT STDMETHODCALLTYPE mixer_set_cooperative_level(IDirectSound* directSound, HWND hwnd, DWORD level);
+static HRESULT STDMETHODCALLTYPE mixer_compact(IDirectSound* directSound);
+static HRESULT STDMETHODCALLTYPE mixer_get_speaker_config(IDirectSound* directSound, LPDWORD speakerConfig);
+static HRESULT STDMETHODCALLTYPE mixer_set_speaker_config(IDirectSound* directSound, DWORD speakerConfig);
+static HRESULT STDMETHODCALLTYPE mixer_initialize(IDirectSound* directSound, LPCGUID guid);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_query_interface(IDirectSoundBuffer* directSoundBuffer, REFIID riid, LPVOID* ppvObj);
+static ULONG STDMETHODCALLTYPE mixer_buffer_add_ref(IDirectSoundBuffer* directSoundBuffer);
+static ULONG STDMETHODCALLTYPE mixer_buffer_release(IDirectSoundBuffer* directSoundBuffer);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_get_caps(IDirectSoundBuffer* directSoundBuffer, LPDSBCAPS caps);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_get_current_position(IDirectSoundBuffer* directSoundBuffer, LPDWORD playCursor, LPDWORD writeCursor);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_get_format(IDirectSoundBuffer* directSoundBuffer, LPWAVEFORMATEX format, DWORD sizeAllocated, LPDWORD sizeWritten);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_get_volume(IDirectSoundBuffer* directSoundBuffer, LPLONG volume);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_get_pan(IDirectSoundBuffer* directSoundBuffer, LPLONG pan);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_get_frequency(IDirectSoundBuffer* directSoundBuffer, LPDWORD frequency);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_get_status(IDirectSoundBuffer* directSoundBuffer, LPDWORD status);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_initialize(IDirectSoundBuffer* directSoundBuffer, LPDIRECTSOUND directSound, LPCDSBUFFERDESC desc);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_lock(IDirectSoundBuffer* directSoundBuffer, DWORD offset, DWORD bytes, LPVOID* audioPtr1, LPDWORD audioBytes1, LPVOID* audioPtr2, LPDWORD audioBytes2, DWORD flags);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_play(IDirectSoundBuffer* directSoundBuffer, DWORD reserved, DWORD priority, DWORD flags);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_set_current_position(IDirectSoundBuffer* directSoundBuffer, DWORD position);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_set_format(IDirectSoundBuffer* directSoundBuffer, LPCWAVEFORMATEX format);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_set_volume(IDirectSoundBuffer* directSoundBuffer, LONG volume);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_set_pan(IDirectSoundBuffer* directSoundBuffer, LONG pan);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_set_frequency(IDirectSoundBuffer* directSoundBuffer, DWORD frequency);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_stop(IDirectSoundBuffer* directSoundBuffer);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_unlock(IDirectSoundBuffer* directSoundBuffer, LPVOID audioPtr1, DWORD audioBytes1, LPVOID audioPtr2, DWORD audioBytes2);
+static HRESULT STDMETHODCALLTYPE mixer_buffer_restore(IDirectSoundBuffer* directSoundBuffer);
+static void mixer_free(Mixer* mixer);
+static void mixer_lock(Mixer* mixer);
+static void mixer_unlock(Mixer* mixer);
+static void mixer_render_block(Mixer* mixer, int frames);
+static void mixer_mix_buffer(Mixer* mixer, MixerBuffer* buffer, int frames);
+static void mixer_buffer_update_gain(MixerBuffer* buffer);
+static int mixer_attenuation_to_gain(LONG attenuation);
+static int mixer_thread_proc(void* data);
+static int mixer_null_open(int rate);
+static void mixer_null_write(short* samples, int frames);
+static void mixer_null_close();
+static int mixer_wav_open(int rate);
+static void mixer_wav_write(short* samples, int frames);
+static void mixer_wav_close();
+static int mixer_wav_write_header(int rate, unsigned int dataLength);
+static void mixer_write_le16(unsigned char* dest, unsigned int value);
+static void mixer_write_le32(unsigned char* dest, unsigned int value);
+
+static IDirectSoundVtbl mixer_vtbl = {
+    mixer_query_interface,
+    mixer_add_ref,
+    mixer_release,
+    mixer_create_sound_buffer,
+    mixer_get_caps,
+    mixer_duplicate_sound_buffer,
+    mixer_set_cooperative_level,
+    mixer_compact,
+    mixer_get_speaker_config,
+    mixer_set_speaker_config,
+    mixer_initialize,
+};
+
+static IDirectSoundBufferVtbl mixer_buffer_vtbl = {
+    mixer_buffer_query_interface,
+    mixer_buffer_add_ref,
+    mixer_buffer_release,
+    mixer_buffer_get_caps,
+    mixer_buffer_get_current_position,
+    mixer_buffer_get_format,
+    mixer_buffer_get_volume,
+    mixer_buffer_get_pan,
+    mixer_buffer_get_frequency,
+    mixer_buffer_get_status,
+    mixer_buffer_initialize,
+    mixer_buffer_lock,
+    mixer_buffer_play,
+    mixer_buffer_set_current_position,
+    mixer_buffer_set_format,
+    mixer_buffer_set_volume,
+    mixer_buffer_set_pan,
+    mixer_buffer_set_frequency,
+    mixer_buffer_stop,
+    mixer_buffer_unlock,
+    mixer_buffer_restore,
+};
+
+// Discards mixed audio, used to run (and time) sound without a sound card.
+MixerSink mixer_null_sink = {
+    "null",
+    mixer_null_open,
+    mixer_null_write,
+    mixer_null_close,
+};
+
+// Writes mixed audio to a WAV file, see `mixer_set_wav_path`.
+MixerSink mixer_wav_sink = {
+    "wav",
+    mixer_wav_open,
+    mixer_wav_write,
+    mixer_wav_close,
+};
+
+static MixerSink* mixer_sinks[] = {
+    &mixer_null_sink,
+    &mixer_wav_sink,
+};
+
+static char mixer_wav_path[MAX_PATH] = "mixer.wav";
+static FILE* mixer_wav_stream = NULL;
+static int mixer_wav_rate = 0;
+static unsigned int mixer_wav_length = 0;
+
+MixerSink* mixer_find_sink(const char* name)
+{
+    for (int index = 0; index < (int)(sizeof(mixer_sinks) / sizeof(mixer_sinks[0])); index++) {
+        if (stricmp(mixer_sinks[index]->name, name) == 0) {
+            return mixer_sinks[index];
+        }
+    }
+
+    return NULL;
+}
+
+void mixer_set_wav_path(const char* path)
+{
+    strncpy(mixer_wav_path, path, sizeof(mixer_wav_path) - 1);
+    mixer_wav_path[sizeof(mixer_wav_path) - 1] = '\0';
+}
+
+// Creates mixer which can be used in place of DirectSound object.
+//
+// Realtime mixer advances on its own thread at `rate` frames per second, just
+// like the sound card would. Otherwise nothing is played until
+// `mixer_render` is called, which makes the output depend on the calls only,
+// not on timing.
+HRESULT mixer_create(MixerSink* sink, int rate, bool realtime, LPDIRECTSOUND* directSoundPtr)
+{
+    Mixer* mixer;
+
+    *directSoundPtr = NULL;
+
+    if (sink == NULL || rate <= 0) {
+        return DSERR_INVALIDPARAM;
+    }
+
+    mixer = (Mixer*)malloc(sizeof(*mixer));
+    if (mixer == NULL) {
+        return DSERR_OUTOFMEMORY;
+    }
+
+    memset(mixer, 0, sizeof(*mixer));
+    mixer->lpVtbl = &mixer_vtbl;
+    mixer->refs = 1;
+    mixer->rate = rate;
+
+    mixer->mutex = mutex_create();
+    mixer->accum = (int*)malloc(sizeof(*mixer->accum) * MIXER_BLOCK_FRAMES * 2);
+    mixer->output = (short*)malloc(sizeof(*mixer->output) * MIXER_BLOCK_FRAMES * 2);
+    if (mixer->mutex == NULL || mixer->accum == NULL || mixer->output == NULL) {
+        mixer_free(mixer);
+        return DSERR_OUTOFMEMORY;
+    }
+
+    if (sink->open(rate) != 0) {
+        debug_printf("mixer: unable to open %s sink\n", sink->name);
+        mixer_free(mixer);
+        return DSERR_NODRIVER;
+    }
+
+    mixer->sink = sink;
+
+    if (realtime) {
+        mixer->thread = thread_create(mixer_thread_proc, mixer);
+        if (mixer->thread == NULL) {
+            mixer_free(mixer);
+            return DSERR_GENERIC;
+        }
+    }
+
+    *directSoundPtr = (LPDIRECTSOUND)mixer;
+
+    return DS_OK;
+}
+
+// Mixes next `frames` frames of every playing buffer and passes them to the
+// sink.
+void mixer_render(LPDIRECTSOUND directSound, int frames)
+{
+    Mixer* mixer = (Mixer*)directSound;
+
+    while (frames > 0) {
+        int block = frames < MIXER_BLOCK_FRAMES ? frames : MIXER_BLOCK_FRAMES;
+
+        mixer_lock(mixer);
+        mixer_render_block(mixer, block);
+        mixer_unlock(mixer);
+
+        frames -= block;
+    }
+}
+
+void mixer_get_stats(LPDIRECTSOUND directSound, MixerStats* stats)
+{
+    Mixer* mixer = (Mixer*)directSound;
+
+    mixer_lock(mixer);
+    memcpy(stats, &(mixer->stats), sizeof(*stats));
+    mixer_unlock(mixer);
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_query_interface(IDirectSound* directSound, REFIID riid, LPVOID* ppvObj)
+{
+    if (ppvObj != NULL) {
+        *ppvObj = NULL;
+    }
+
+    return E_NOINTERFACE;
+}
+
+static ULONG STDMETHODCALLTYPE mixer_add_ref(IDirectSound* directSound)
+{
+    Mixer* mixer = (Mixer*)directSound;
+    return ++mixer->refs;
+}
+
+static ULONG STDMETHODCALLTYPE mixer_release(IDirectSound* directSound)
+{
+    Mixer* mixer = (Mixer*)directSound;
+
+    if (--mixer->refs != 0) {
+        return mixer->refs;
+    }
+
+    if (mixer->stats.renders != 0) {
+        debug_printf("mixer: %u renders, %llu frames, avg %u us, max %u us, max %u voices\n",
+            mixer->stats.renders,
+            mixer->stats.frames,
+            (unsigned int)(mixer->stats.totalRenderTime / mixer->stats.renders),
+            mixer->stats.maxRenderTime,
+            mixer->stats.maxVoices);
+    }
+
+    mixer_free(mixer);
+
+    return 0;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_create_sound_buffer(IDirectSound* directSound, LPCDSBUFFERDESC desc, LPDIRECTSOUNDBUFFER* bufferPtr, LPUNKNOWN outer)
+{
+    Mixer* mixer = (Mixer*)directSound;
+    MixerBuffer* buffer;
+
+    if (desc == NULL || bufferPtr == NULL) {
+        return DSERR_INVALIDPARAM;
+    }
+
+    *bufferPtr = NULL;
+
+    if (outer != NULL) {
+        return DSERR_NOAGGREGATION;
+    }
+
+    buffer = (MixerBuffer*)malloc(sizeof(*buffer));
+    if (buffer == NULL) {
+        return DSERR_OUTOFMEMORY;
+    }
+
+    memset(buffer, 0, sizeof(*buffer));
+    buffer->lpVtbl = &mixer_buffer_vtbl;
+    buffer->refs = 1;
+    buffer->mixer = mixer;
+    buffer->flags = desc->dwFlags;
+
+    // Primary buffer only keeps its format, the output format is defined by
+    // the mixer.
+    if ((desc->dwFlags & DSBCAPS_PRIMARYBUFFER) != 0) {
+        buffer->format.wFormatTag = WAVE_FORMAT_PCM;
+        buffer->format.nChannels = 2;
+        buffer->format.nSamplesPerSec = mixer->rate;
+        buffer->format.wBitsPerSample = 16;
+        buffer->format.nBlockAlign = 4;
+        buffer->format.nAvgBytesPerSec = mixer->rate * 4;
+
+        *bufferPtr = (LPDIRECTSOUNDBUFFER)buffer;
+        return DS_OK;
+    }
+
+    if (desc->lpwfxFormat == NULL
+        || desc->lpwfxFormat->wFormatTag != WAVE_FORMAT_PCM
+        || (desc->lpwfxFormat->nChannels != 1 && desc->lpwfxFormat->nChannels != 2)
+        || (desc->lpwfxFormat->wBitsPerSample != 8 && desc->lpwfxFormat->wBitsPerSample != 16)
+        || desc->lpwfxFormat->nSamplesPerSec < DSBFREQUENCY_MIN
+        || desc->lpwfxFormat->nSamplesPerSec > DSBFREQUENCY_MAX) {
+        free(buffer);
+        return DSERR_BADFORMAT;
+    }
+
+    memcpy(&(buffer->format), desc->lpwfxFormat, sizeof(buffer->format));
+    buffer->format.cbSize = 0;
+    buffer->format.nBlockAlign = buffer->format.nChannels * buffer->format.wBitsPerSample / 8;
+    buffer->format.nAvgBytesPerSec = buffer->format.nSamplesPerSec * buffer->format.nBlockAlign;
+
+    buffer->frames = desc->dwBufferBytes / buffer->format.nBlockAlign;
+    if (desc->dwBufferBytes < DSBSIZE_MIN || desc->dwBufferBytes > DSBSIZE_MAX || buffer->frames == 0) {
+        free(buffer);
+        return DSERR_INVALIDPARAM;
+    }
+
+    buffer->size = desc->dwBufferBytes;
+    buffer->data = (unsigned char*)malloc(buffer->size);
+    if (buffer->data == NULL) {
+        free(buffer);
+        return DSERR_OUTOFMEMORY;
+    }
+
+    memset(buffer->data, buffer->format.wBitsPerSample == 8 ? 0x80 : 0, buffer->size);
+
+    buffer->frequency = buffer->format.nSamplesPerSec;
+    buffer->volume = DSBVOLUME_MAX;
+    buffer->pan = DSBPAN_CENTER;
+    mixer_buffer_update_gain(buffer);
+
+    mixer_lock(mixer);
+    buffer->next = mixer->buffers;
+    if (mixer->buffers != NULL) {
+        mixer->buffers->prev = buffer;
+    }
+    mixer->buffers = buffer;
+    mixer_unlock(mixer);
+
+    *bufferPtr = (LPDIRECTSOUNDBUFFER)buffer;
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_get_caps(IDirectSound* directSound, LPDSCAPS caps)
+{
+    if (caps == NULL) {
+        return DSERR_INVALIDPARAM;
+    }
+
+    caps->dwFlags = DSCAPS_PRIMARYMONO
+        | DSCAPS_PRIMARYSTEREO
+        | DSCAPS_PRIMARY8BIT
+        | DSCAPS_PRIMARY16BIT
+        | DSCAPS_CONTINUOUSRATE
+        | DSCAPS_SECONDARYMONO
+        | DSCAPS_SECONDARYSTEREO
+        | DSCAPS_SECONDARY8BIT
+        | DSCAPS_SECONDARY16BIT;
+    caps->dwMinSecondarySampleRate = DSBFREQUENCY_MIN;
+    caps->dwMaxSecondarySampleRate = DSBFREQUENCY_MAX;
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_duplicate_sound_buffer(IDirectSound* directSound, LPDIRECTSOUNDBUFFER original, LPDIRECTSOUNDBUFFER* duplicatePtr)
+{
+    if (duplicatePtr != NULL) {
+        *duplicatePtr = NULL;
+    }
+
+    return DSERR_UNSUPPORTED;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_set_cooperative_level(IDirectSound* directSound, HWND hwnd, DWORD level)
+{
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_compact(IDirectSound* directSound)
+{
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_get_speaker_config(IDirectSound* directSound, LPDWORD speakerConfig)
+{
+    if (speakerConfig == NULL) {
+        return DSERR_INVALIDPARAM;
+    }
+
+    *speakerConfig = DSSPEAKER_STEREO;
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_set_speaker_config(IDirectSound* directSound, DWORD speakerConfig)
+{
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_initialize(IDirectSound* directSound, LPCGUID guid)
+{
+    return DSERR_ALREADYINITIALIZED;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_query_interface(IDirectSoundBuffer* directSoundBuffer, REFIID riid, LPVOID* ppvObj)
+{
+    if (ppvObj != NULL) {
+        *ppvObj = NULL;
+    }
+
+    return E_NOINTERFACE;
+}
+
+static ULONG STDMETHODCALLTYPE mixer_buffer_add_ref(IDirectSoundBuffer* directSoundBuffer)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+    return ++buffer->refs;
+}
+
+static ULONG STDMETHODCALLTYPE mixer_buffer_release(IDirectSoundBuffer* directSoundBuffer)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+    Mixer* mixer = buffer->mixer;
+
+    if (--buffer->refs != 0) {
+        return buffer->refs;
+    }
+
+    if (mixer != NULL && buffer->data != NULL) {
+        mixer_lock(mixer);
+
+        if (buffer->prev != NULL) {
+            buffer->prev->next = buffer->next;
+        } else {
+            mixer->buffers = buffer->next;
+        }
+
+        if (buffer->next != NULL) {
+            buffer->next->prev = buffer->prev;
+        }
+
+        mixer_unlock(mixer);
+    }
+
+    if (buffer->data != NULL) {
+        free(buffer->data);
+    }
+
+    free(buffer);
+
+    return 0;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_get_caps(IDirectSoundBuffer* directSoundBuffer, LPDSBCAPS caps)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+
+    if (caps == NULL) {
+        return DSERR_INVALIDPARAM;
+    }
+
+    caps->dwFlags = buffer->flags | DSBCAPS_LOCSOFTWARE;
+    caps->dwBufferBytes = buffer->size;
+    caps->dwUnlockTransferRate = 0;
+    caps->dwPlayCpuOverhead = 0;
+
+    return DS_OK;
+}
+
+// Write cursor is the same as play cursor, the data is read at the moment it
+// is mixed.
+static HRESULT STDMETHODCALLTYPE mixer_buffer_get_current_position(IDirectSoundBuffer* directSoundBuffer, LPDWORD playCursor, LPDWORD writeCursor)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+    DWORD position;
+
+    if (buffer->data == NULL) {
+        return DSERR_INVALIDCALL;
+    }
+
+    mixer_lock(buffer->mixer);
+    position = buffer->position * buffer->format.nBlockAlign;
+    mixer_unlock(buffer->mixer);
+
+    if (playCursor != NULL) {
+        *playCursor = position;
+    }
+
+    if (writeCursor != NULL) {
+        *writeCursor = position;
+    }
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_get_format(IDirectSoundBuffer* directSoundBuffer, LPWAVEFORMATEX format, DWORD sizeAllocated, LPDWORD sizeWritten)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+    DWORD size = sizeof(buffer->format);
+
+    if (format != NULL) {
+        if (size > sizeAllocated) {
+            size = sizeAllocated;
+        }
+        memcpy(format, &(buffer->format), size);
+    }
+
+    if (sizeWritten != NULL) {
+        *sizeWritten = size;
+    }
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_get_volume(IDirectSoundBuffer* directSoundBuffer, LPLONG volume)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+
+    if (volume == NULL) {
+        return DSERR_INVALIDPARAM;
+    }
+
+    *volume = buffer->volume;
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_get_pan(IDirectSoundBuffer* directSoundBuffer, LPLONG pan)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+
+    if (pan == NULL) {
+        return DSERR_INVALIDPARAM;
+    }
+
+    *pan = buffer->pan;
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_get_frequency(IDirectSoundBuffer* directSoundBuffer, LPDWORD frequency)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+
+    if (frequency == NULL) {
+        return DSERR_INVALIDPARAM;
+    }
+
+    *frequency = buffer->frequency;
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_get_status(IDirectSoundBuffer* directSoundBuffer, LPDWORD status)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+
+    if (status == NULL) {
+        return DSERR_INVALIDPARAM;
+    }
+
+    *status = 0;
+
+    if (buffer->data != NULL) {
+        mixer_lock(buffer->mixer);
+
+        if (buffer->playing) {
+            *status |= DSBSTATUS_PLAYING;
+            if (buffer->looping) {
+                *status |= DSBSTATUS_LOOPING;
+            }
+        }
+
+        mixer_unlock(buffer->mixer);
+    }
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_initialize(IDirectSoundBuffer* directSoundBuffer, LPDIRECTSOUND directSound, LPCDSBUFFERDESC desc)
+{
+    return DSERR_ALREADYINITIALIZED;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_lock(IDirectSoundBuffer* directSoundBuffer, DWORD offset, DWORD bytes, LPVOID* audioPtr1, LPDWORD audioBytes1, LPVOID* audioPtr2, LPDWORD audioBytes2, DWORD flags)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+
+    if (buffer->data == NULL) {
+        return DSERR_INVALIDCALL;
+    }
+
+    if ((flags & DSBLOCK_FROMWRITECURSOR) != 0) {
+        mixer_buffer_get_current_position(directSoundBuffer, NULL, &offset);
+    }
+
+    if ((flags & DSBLOCK_ENTIREBUFFER) != 0) {
+        bytes = buffer->size;
+    }
+
+    if (offset >= (DWORD)buffer->size || bytes > (DWORD)buffer->size || audioPtr1 == NULL || audioBytes1 == NULL) {
+        return DSERR_INVALIDPARAM;
+    }
+
+    *audioPtr1 = buffer->data + offset;
+
+    if (offset + bytes > (DWORD)buffer->size) {
+        *audioBytes1 = buffer->size - offset;
+
+        if (audioPtr2 != NULL) {
+            *audioPtr2 = buffer->data;
+        }
+
+        if (audioBytes2 != NULL) {
+            *audioBytes2 = offset + bytes - buffer->size;
+        }
+    } else {
+        *audioBytes1 = bytes;
+
+        if (audioPtr2 != NULL) {
+            *audioPtr2 = NULL;
+        }
+
+        if (audioBytes2 != NULL) {
+            *audioBytes2 = 0;
+        }
+    }
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_play(IDirectSoundBuffer* directSoundBuffer, DWORD reserved, DWORD priority, DWORD flags)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+
+    if (buffer->data == NULL) {
+        return DS_OK;
+    }
+
+    mixer_lock(buffer->mixer);
+    buffer->playing = true;
+    buffer->looping = (flags & DSBPLAY_LOOPING) != 0;
+    mixer_unlock(buffer->mixer);
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_set_current_position(IDirectSoundBuffer* directSoundBuffer, DWORD position)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+
+    if (buffer->data == NULL) {
+        return DSERR_INVALIDCALL;
+    }
+
+    if (position >= (DWORD)buffer->size) {
+        return DSERR_INVALIDPARAM;
+    }
+
+    mixer_lock(buffer->mixer);
+    buffer->position = position / buffer->format.nBlockAlign;
+    buffer->fraction = 0;
+    mixer_unlock(buffer->mixer);
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_set_format(IDirectSoundBuffer* directSoundBuffer, LPCWAVEFORMATEX format)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+
+    if ((buffer->flags & DSBCAPS_PRIMARYBUFFER) == 0) {
+        return DSERR_INVALIDCALL;
+    }
+
+    if (format == NULL || format->wFormatTag != WAVE_FORMAT_PCM) {
+        return DSERR_BADFORMAT;
+    }
+
+    memcpy(&(buffer->format), format, sizeof(buffer->format));
+    buffer->format.cbSize = 0;
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_set_volume(IDirectSoundBuffer* directSoundBuffer, LONG volume)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+
+    if (volume < DSBVOLUME_MIN || volume > DSBVOLUME_MAX) {
+        return DSERR_INVALIDPARAM;
+    }
+
+    mixer_lock(buffer->mixer);
+    buffer->volume = volume;
+    mixer_buffer_update_gain(buffer);
+    mixer_unlock(buffer->mixer);
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_set_pan(IDirectSoundBuffer* directSoundBuffer, LONG pan)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+
+    if (pan < DSBPAN_LEFT || pan > DSBPAN_RIGHT) {
+        return DSERR_INVALIDPARAM;
+    }
+
+    mixer_lock(buffer->mixer);
+    buffer->pan = pan;
+    mixer_buffer_update_gain(buffer);
+    mixer_unlock(buffer->mixer);
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_set_frequency(IDirectSoundBuffer* directSoundBuffer, DWORD frequency)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+
+    if (frequency == DSBFREQUENCY_ORIGINAL) {
+        frequency = buffer->format.nSamplesPerSec;
+    }
+
+    if (frequency < DSBFREQUENCY_MIN || frequency > DSBFREQUENCY_MAX) {
+        return DSERR_INVALIDPARAM;
+    }
+
+    mixer_lock(buffer->mixer);
+    buffer->frequency = frequency;
+    mixer_unlock(buffer->mixer);
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_stop(IDirectSoundBuffer* directSoundBuffer)
+{
+    MixerBuffer* buffer = (MixerBuffer*)directSoundBuffer;
+
+    mixer_lock(buffer->mixer);
+    buffer->playing = false;
+    mixer_unlock(buffer->mixer);
+
+    return DS_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE mixer_buffer_unlock(IDirectSoundBuffer* directSoundBuffer, LPVOID audioPtr1, DWORD audioBytes1, LPVOID audioPtr2, DWORD audioBytes2)
+{
+    return DS_OK;
+}
+
+// Software buffers are never lost.
+static HRESULT STDMETHODCALLTYPE mixer_buffer_restore(IDirectSoundBuffer* directSoundBuffer)
+{
+    return DS_OK;
+}
+
+static void mixer_free(Mixer* mixer)
+{
+    MixerBuffer* buffer;
+
+    if (mixer->thread != NULL) {
+        atomic_set(&(mixer->quit), 1);
+        thread_join(mixer->thread);
+    }
+
+    if (mixer->sink != NULL) {
+        mixer->sink->close();
+    }
+
+    // Buffers which are still around are detached and play nothing.
+    buffer = mixer->buffers;
+    while (buffer != NULL) {
+        MixerBuffer* next = buffer->next;
+        buffer->mixer = NULL;
+        buffer->playing = false;
+        buffer->prev = NULL;
+        buffer->next = NULL;
+        buffer = next;
+    }
+
+    if (mixer->output != NULL) {
+        free(mixer->output);
+    }
+
+    if (mixer->accum != NULL) {
+        free(mixer->accum);
+    }
+
+    mutex_free(mixer->mutex);
+    free(mixer);
+}
+
+// Buffer methods can be called after mixer was released, so both accept NULL.
+static void mixer_lock(Mixer* mixer)
+{
+    if (mixer != NULL) {
+        mutex_lock(mixer->mutex);
+    }
+}
+
+static void mixer_unlock(Mixer* mixer)
+{
+    if (mixer != NULL) {
+        mutex_unlock(mixer->mutex);
+    }
+}
+
+// Should be called with mixer locked.
+static void mixer_render_block(Mixer* mixer, int frames)
+{
+    unsigned long long start;
+    unsigned int elapsed;
+    unsigned int voices = 0;
+    MixerBuffer* buffer;
+
+    start = profile_get_time();
+
+    memset(mixer->accum, 0, sizeof(*mixer->accum) * frames * 2);
+
+    buffer = mixer->buffers;
+    while (buffer != NULL) {
+        if (buffer->playing) {
+            mixer_mix_buffer(mixer, buffer, frames);
+            voices++;
+        }
+        buffer = buffer->next;
+    }
+
+    for (int index = 0; index < frames * 2; index++) {
+        int sample = mixer->accum[index];
+        if (sample > 32767) {
+            sample = 32767;
+        } else if (sample < -32768) {
+            sample = -32768;
+        }
+        mixer->output[index] = (short)sample;
+    }
+
+    mixer->sink->write(mixer->output, frames);
+
+    elapsed = (unsigned int)(profile_get_time() - start);
+
+    mixer->stats.renders++;
+    mixer->stats.frames += frames;
+    mixer->stats.voiceFrames += (unsigned long long)voices * frames;
+    mixer->stats.totalRenderTime += elapsed;
+    if (elapsed > mixer->stats.maxRenderTime) {
+        mixer->stats.maxRenderTime = elapsed;
+    }
+    if (voices > mixer->stats.maxVoices) {
+        mixer->stats.maxVoices = voices;
+    }
+}
+
+// Adds `frames` frames of the buffer to the accumulator, resampling it to
+// mixer rate with linear interpolation.
+static void mixer_mix_buffer(Mixer* mixer, MixerBuffer* buffer, int frames)
+{
+    int* dest = mixer->accum;
+    unsigned int step = (unsigned int)(((unsigned long long)buffer->frequency << 16) / mixer->rate);
+    int position = buffer->position;
+    unsigned int fraction = buffer->fraction;
+    int blockAlign = buffer->format.nBlockAlign;
+    bool stereo = buffer->format.nChannels == 2;
+    bool wide = buffer->format.wBitsPerSample == 16;
+
+    if (buffer->leftGain == 0 && buffer->rightGain == 0) {
+        // Silent buffer still has to advance.
+        unsigned long long advance = (unsigned long long)fraction + (unsigned long long)step * frames;
+        unsigned long long end = position + (advance >> 16);
+
+        if (end >= (unsigned long long)buffer->frames && !buffer->looping) {
+            buffer->playing = false;
+            buffer->position = 0;
+            buffer->fraction = 0;
+        } else {
+            buffer->position = (int)(end % buffer->frames);
+            buffer->fraction = (unsigned int)(advance & 0xFFFF);
+        }
+        return;
+    }
+
+    for (int index = 0; index < frames; index++) {
+        int samples[2][2];
+        int next = position;
+
+        if (fraction != 0) {
+            next = position + 1;
+            if (next == buffer->frames) {
+                next = buffer->looping ? 0 : position;
+            }
+        }
+
+        for (int tap = 0; tap < 2; tap++) {
+            unsigned char* src = buffer->data + (tap == 0 ? position : next) * blockAlign;
+
+            if (wide) {
+                samples[tap][0] = ((short*)src)[0];
+                samples[tap][1] = stereo ? ((short*)src)[1] : samples[tap][0];
+            } else {
+                samples[tap][0] = (src[0] - 128) * 256;
+                samples[tap][1] = stereo ? (src[1] - 128) * 256 : samples[tap][0];
+            }
+        }
+
+        // Fraction is reduced to 15 bits so the product fits in int.
+        int left = samples[0][0] + (((samples[1][0] - samples[0][0]) * (int)(fraction >> 1)) >> 15);
+        int right = samples[0][1] + (((samples[1][1] - samples[0][1]) * (int)(fraction >> 1)) >> 15);
+
+        dest[0] += (left * buffer->leftGain) >> MIXER_GAIN_SHIFT;
+        dest[1] += (right * buffer->rightGain) >> MIXER_GAIN_SHIFT;
+        dest += 2;
+
+        fraction += step;
+        position += fraction >> 16;
+        fraction &= 0xFFFF;
+
+        if (position >= buffer->frames) {
+            if (!buffer->looping) {
+                buffer->playing = false;
+                position = 0;
+                fraction = 0;
+                break;
+            }
+
+            position %= buffer->frames;
+        }
+    }
+
+    buffer->position = position;
+    buffer->fraction = fraction;
+}
+
+// Volume and pan are attenuations in hundredths of decibel. Pan attenuates
+// one channel and leaves another one intact.
+static void mixer_buffer_update_gain(MixerBuffer* buffer)
+{
+    buffer->leftGain = mixer_attenuation_to_gain(buffer->volume - (buffer->pan > 0 ? buffer->pan : 0));
+    buffer->rightGain = mixer_attenuation_to_gain(buffer->volume + (buffer->pan < 0 ? buffer->pan : 0));
+}
+
+static int mixer_attenuation_to_gain(LONG attenuation)
+{
+    if (attenuation <= DSBVOLUME_MIN) {
+        return 0;
+    }
+
+    if (attenuation >= 0) {
+        return MIXER_GAIN_ONE;
+    }
+
+    return (int)(pow(10.0, attenuation / 2000.0) * MIXER_GAIN_ONE + 0.5);
+}
+
+static int mixer_thread_proc(void* data)
+{
+    Mixer* mixer = (Mixer*)data;
+    unsigned long long start = profile_get_time();
+    unsigned long long rendered = 0;
+    unsigned long long due;
+
+    while (!atomic_get(&(mixer->quit))) {
+        due = (profile_get_time() - start) * mixer->rate / 1000000;
+
+        // Do not try to catch up after a long stall, the sound card would
+        // not either.
+        if (due > rendered + mixer->rate) {
+            rendered = due - MIXER_BLOCK_FRAMES;
+        }
+
+        while (rendered < due) {
+            int frames = due - rendered < MIXER_BLOCK_FRAMES ? (int)(due - rendered) : MIXER_BLOCK_FRAMES;
+
+            mixer_lock(mixer);
+            mixer_render_block(mixer, frames);
+            mixer_unlock(mixer);
+
+            rendered += frames;
+        }
+
+        thread_sleep(MIXER_INTERVAL);
+    }
+
+    return 0;
+}
+
+static int mixer_null_open(int rate)
+{
+    return 0;
+}
+
+static void mixer_null_write(short* samples, int frames)
+{
+}
+
+static void mixer_null_close()
+{
+}
+
+static int mixer_wav_open(int rate)
+{
+    if (mixer_wav_stream != NULL) {
+        return -1;
+    }
+
+    mixer_wav_stream = fopen(mixer_wav_path, "wb");
+    if (mixer_wav_stream == NULL) {
+        return -1;
+    }
+
+    mixer_wav_rate = rate;
+    mixer_wav_length = 0;
+
+    // Lengths are patched when the file is closed.
+    if (mixer_wav_write_header(rate, 0) != 0) {
+        fclose(mixer_wav_stream);
+        mixer_wav_stream = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+// NOTE: Samples are written as is, which assumes little-endian host.
+static void mixer_wav_write(short* samples, int frames)
+{
+    if (mixer_wav_stream == NULL) {
+        return;
+    }
+
+    mixer_wav_length += (unsigned int)fwrite(samples, 4, frames, mixer_wav_stream) * 4;
+}
+
+static void mixer_wav_close()
+{
+    if (mixer_wav_stream == NULL) {
+        return;
+    }
+
+    if (fseek(mixer_wav_stream, 0, SEEK_SET) == 0) {
+        mixer_wav_write_header(mixer_wav_rate, mixer_wav_length);
+    }
+
+    fclose(mixer_wav_stream);
+    mixer_wav_stream = NULL;
+}
+
+static int mixer_wav_write_header(int rate, unsigned int dataLength)
+{
+    unsigned char header[44];
+
+    memcpy(header, "RIFF", 4);
+    mixer_write_le32(header + 4, 36 + dataLength);
+    memcpy(header + 8, "WAVE", 4);
+    memcpy(header + 12, "fmt ", 4);
+    mixer_write_le32(header + 16, 16);
+    mixer_write_le16(header + 20, WAVE_FORMAT_PCM);
+    mixer_write_le16(header + 22, 2);
+    mixer_write_le32(header + 24, rate);
+    mixer_write_le32(header + 28, rate * 4);
+    mixer_write_le16(header + 32, 4);
+    mixer_write_le16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    mixer_write_le32(header + 40, dataLength);
+
+    if (fwrite(header, 1, sizeof(header), mixer_wav_stream) != sizeof(header)) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static void mixer_write_le16(unsigned char* dest, unsigned int value)
+{
+    dest[0] = value & 0xFF;
+    dest[1] = (value >> 8) & 0xFF;
+}
+
+static void mixer_write_le32(unsigned char* dest, unsigned int value)
+{
+    dest[0] = value & 0xFF;
+    dest[1] = (value >> 8) & 0xFF;
+    dest[2] = (value >> 16) & 0xFF;
+    dest[3] = (value >> 24) & 0xFF;
+}
@@ -0,0 +1,38 @@
+#ifndef FALLOUT_PLIB_GNW_MIXER_H_
+#define FALLOUT_PLIB_GNW_MIXER_H_
+
+#include <stdbool.h>
+
+#include "plib/gnw/gnw95dx.h"
+
+typedef int(MixerSinkOpenFunc)(int rate);
+typedef void(MixerSinkWriteFunc)(short* samples, int frames);
+typedef void(MixerSinkCloseFunc)();
+
+// Receives mixed audio, interleaved signed 16-bit stereo at the mixer rate.
+typedef struct MixerSink {
+    const char* name;
+    MixerSinkOpenFunc* open;
+    MixerSinkWriteFunc* write;
+    MixerSinkCloseFunc* close;
+} MixerSink;
+
+typedef struct MixerStats {
+    unsigned int renders;
+    unsigned long long frames;
+    unsigned long long voiceFrames;
+    unsigned long long totalRenderTime;
+    unsigned int maxRenderTime;
+    unsigned int maxVoices;
+} MixerStats;
+
+extern MixerSink mixer_null_sink;
+extern MixerSink mixer_wav_sink;
+
+MixerSink* mixer_find_sink(const char* name);
+void mixer_set_wav_path(const char* path);
+HRESULT mixer_create(MixerSink* sink, int rate, bool realtime, LPDIRECTSOUND* directSoundPtr);
+void mixer_render(LPDIRECTSOUND directSound, int frames);
+void mixer_get_stats(LPDIRECTSOUND directSound, MixerStats* stats);
+
+#endif /* FALLOUT_PLIB_GNW_MIXER_H_ */
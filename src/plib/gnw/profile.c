@@ -0,0 +1,360 @@
+#include "plib/gnw/profile.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "plib/color/color.h"
+#include "plib/gnw/grbuf.h"
+#include "plib/gnw/svga.h"
+#include "plib/gnw/text.h"
+
+// Number of frames averaged in the overlay.
+#define PROFILE_OVERLAY_FRAMES 30
+
+#define PROFILE_OVERLAY_WIDTH 220
+
+static void profile_draw_overlay();
+
+static const char* profile_zone_names[PROFILE_ZONE_COUNT] = {
+    "input",
+    "animate",
+    "queue",
+    "scripts",
+    "render",
+    "sound",
+    "network",
+};
+
+static bool profile_enabled = false;
+static bool profile_overlay_enabled = false;
+
+// Completed frames, `profile_frame_head` points to the slot of the frame being
+// recorded.
+static ProfileFrame profile_frames[PROFILE_FRAME_CAPACITY];
+static int profile_frame_head = 0;
+static int profile_frame_count = 0;
+
+static ProfileEvent profile_events[PROFILE_EVENT_CAPACITY];
+static int profile_event_head = 0;
+static int profile_event_count = 0;
+
+// Start time and nesting depth of every open zone. Recursive entries are
+// folded into the outermost one, so zone time is never counted twice.
+static unsigned long long profile_zone_start[PROFILE_ZONE_COUNT];
+static int profile_zone_depth[PROFILE_ZONE_COUNT];
+
+// Returns monotonic time in microseconds.
+unsigned long long profile_get_time()
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+
+    QueryPerformanceCounter(&counter);
+    return (unsigned long long)(counter.QuadPart / frequency.QuadPart * 1000000
+        + counter.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+void profile_enable(bool enabled)
+{
+    if (enabled == profile_enabled) {
+        return;
+    }
+
+    profile_enabled = enabled;
+
+    memset(profile_frames, 0, sizeof(profile_frames));
+    memset(profile_zone_depth, 0, sizeof(profile_zone_depth));
+    profile_frame_head = 0;
+    profile_frame_count = 0;
+    profile_event_head = 0;
+    profile_event_count = 0;
+
+    if (enabled) {
+        profile_frames[0].start = profile_get_time();
+    } else {
+        profile_overlay_enabled = false;
+    }
+}
+
+bool profile_is_enabled()
+{
+    return profile_enabled;
+}
+
+// Overlay shows collected frames, so it can only be turned on while
+// profiling is enabled.
+void profile_overlay_enable(bool enabled)
+{
+    profile_overlay_enabled = enabled && profile_enabled;
+}
+
+bool profile_overlay_is_enabled()
+{
+    return profile_overlay_enabled;
+}
+
+void profile_begin(ProfileZone zone)
+{
+    if (!profile_enabled) {
+        return;
+    }
+
+    if (profile_zone_depth[zone]++ == 0) {
+        profile_zone_start[zone] = profile_get_time();
+    }
+}
+
+void profile_end(ProfileZone zone)
+{
+    ProfileFrame* frame;
+    ProfileEvent* event;
+    unsigned int duration;
+
+    if (!profile_enabled) {
+        return;
+    }
+
+    // Zone was opened before profiler was enabled.
+    if (profile_zone_depth[zone] == 0) {
+        return;
+    }
+
+    if (--profile_zone_depth[zone] != 0) {
+        return;
+    }
+
+    duration = (unsigned int)(profile_get_time() - profile_zone_start[zone]);
+
+    frame = &(profile_frames[profile_frame_head]);
+    frame->zoneTime[zone] += duration;
+    frame->zoneCalls[zone]++;
+
+    event = &(profile_events[profile_event_head]);
+    event->start = profile_zone_start[zone];
+    event->duration = duration;
+    event->zone = zone;
+
+    profile_event_head = (profile_event_head + 1) % PROFILE_EVENT_CAPACITY;
+    if (profile_event_count < PROFILE_EVENT_CAPACITY) {
+        profile_event_count++;
+    }
+}
+
+// Closes current frame and starts the next one. Should be called once per
+// pass of the input loop.
+void profile_frame()
+{
+    ProfileFrame* frame;
+    unsigned long long now;
+
+    if (!profile_enabled) {
+        return;
+    }
+
+    now = profile_get_time();
+
+    frame = &(profile_frames[profile_frame_head]);
+    frame->duration = (unsigned int)(now - frame->start);
+
+    profile_frame_head = (profile_frame_head + 1) % PROFILE_FRAME_CAPACITY;
+    if (profile_frame_count < PROFILE_FRAME_CAPACITY) {
+        profile_frame_count++;
+    }
+
+    frame = &(profile_frames[profile_frame_head]);
+    memset(frame, 0, sizeof(*frame));
+    frame->start = now;
+
+    if (profile_overlay_enabled) {
+        profile_draw_overlay();
+    }
+}
+
+const char* profile_zone_name(ProfileZone zone)
+{
+    if (zone < 0 || zone >= PROFILE_ZONE_COUNT) {
+        return "unknown";
+    }
+
+    return profile_zone_names[zone];
+}
+
+// Copies completed frames oldest first. Returns number of copied frames.
+int profile_get_frames(ProfileFrame* frames, int capacity)
+{
+    int count = profile_frame_count < capacity ? profile_frame_count : capacity;
+    int index = (profile_frame_head - count + PROFILE_FRAME_CAPACITY) % PROFILE_FRAME_CAPACITY;
+
+    for (int frame = 0; frame < count; frame++) {
+        memcpy(&(frames[frame]), &(profile_frames[index]), sizeof(*frames));
+        index = (index + 1) % PROFILE_FRAME_CAPACITY;
+    }
+
+    return count;
+}
+
+// Writes completed frames as CSV, one row per frame with zone times in
+// microseconds.
+int profile_export_csv(const char* path)
+{
+    FILE* stream;
+    int index;
+
+    stream = fopen(path, "wt");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    fprintf(stream, "frame,start_us,frame_us");
+    for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++) {
+        fprintf(stream, ",%s_us,%s_calls", profile_zone_names[zone], profile_zone_names[zone]);
+    }
+    fprintf(stream, "\n");
+
+    index = (profile_frame_head - profile_frame_count + PROFILE_FRAME_CAPACITY) % PROFILE_FRAME_CAPACITY;
+    for (int frame = 0; frame < profile_frame_count; frame++) {
+        ProfileFrame* entry = &(profile_frames[index]);
+
+        fprintf(stream, "%d,%llu,%u", frame, entry->start, entry->duration);
+        for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++) {
+            fprintf(stream, ",%u,%u", entry->zoneTime[zone], entry->zoneCalls[zone]);
+        }
+        fprintf(stream, "\n");
+
+        index = (index + 1) % PROFILE_FRAME_CAPACITY;
+    }
+
+    fclose(stream);
+
+    return 0;
+}
+
+// Writes recorded zone events and frames in Chrome trace event format
+// (chrome://tracing, Perfetto).
+int profile_export_trace(const char* path)
+{
+    FILE* stream;
+    int index;
+    bool first = true;
+
+    stream = fopen(path, "wt");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    fprintf(stream, "{\"traceEvents\":[\n");
+
+    index = (profile_frame_head - profile_frame_count + PROFILE_FRAME_CAPACITY) % PROFILE_FRAME_CAPACITY;
+    for (int frame = 0; frame < profile_frame_count; frame++) {
+        ProfileFrame* entry = &(profile_frames[index]);
+
+        fprintf(stream, "%s{\"name\":\"frame\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%llu,\"dur\":%u}",
+            first ? "" : ",\n",
+            entry->start,
+            entry->duration);
+        first = false;
+
+        index = (index + 1) % PROFILE_FRAME_CAPACITY;
+    }
+
+    index = (profile_event_head - profile_event_count + PROFILE_EVENT_CAPACITY) % PROFILE_EVENT_CAPACITY;
+    for (int event = 0; event < profile_event_count; event++) {
+        ProfileEvent* entry = &(profile_events[index]);
+
+        fprintf(stream, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":1,\"ts\":%llu,\"dur\":%u}",
+            first ? "" : ",\n",
+            profile_zone_names[entry->zone],
+            entry->start,
+            entry->duration);
+        first = false;
+
+        index = (index + 1) % PROFILE_EVENT_CAPACITY;
+    }
+
+    fprintf(stream, "\n]}\n");
+    fclose(stream);
+
+    return 0;
+}
+
+// Draws averages of the last frames straight to the screen. The overlay is
+// not a window, so it is overdrawn by any window refresh and redrawn on the
+// next frame.
+static void profile_draw_overlay()
+{
+    unsigned char buf[PROFILE_OVERLAY_WIDTH * (PROFILE_ZONE_COUNT + 1) * 12];
+    char string[64];
+    unsigned int frameTime = 0;
+    unsigned int frameMax = 0;
+    unsigned int zoneTime[PROFILE_ZONE_COUNT];
+    unsigned int zoneMax[PROFILE_ZONE_COUNT];
+    int lineHeight;
+    int height;
+    int count;
+    int index;
+    int color;
+
+    lineHeight = text_height() + 1;
+    if (lineHeight > 12) {
+        return;
+    }
+
+    count = profile_frame_count < PROFILE_OVERLAY_FRAMES ? profile_frame_count : PROFILE_OVERLAY_FRAMES;
+    if (count == 0) {
+        return;
+    }
+
+    memset(zoneTime, 0, sizeof(zoneTime));
+    memset(zoneMax, 0, sizeof(zoneMax));
+
+    index = (profile_frame_head - count + PROFILE_FRAME_CAPACITY) % PROFILE_FRAME_CAPACITY;
+    for (int frame = 0; frame < count; frame++) {
+        ProfileFrame* entry = &(profile_frames[index]);
+
+        frameTime += entry->duration;
+        if (entry->duration > frameMax) {
+            frameMax = entry->duration;
+        }
+
+        for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++) {
+            zoneTime[zone] += entry->zoneTime[zone];
+            if (entry->zoneTime[zone] > zoneMax[zone]) {
+                zoneMax[zone] = entry->zoneTime[zone];
+            }
+        }
+
+        index = (index + 1) % PROFILE_FRAME_CAPACITY;
+    }
+
+    height = lineHeight * (PROFILE_ZONE_COUNT + 1);
+    buf_fill(buf, PROFILE_OVERLAY_WIDTH, height, PROFILE_OVERLAY_WIDTH, colorTable[0]);
+
+    color = colorTable[32767];
+
+    sprintf(string, "frame %6.2f ms (max %6.2f)", frameTime / count / 1000.0, frameMax / 1000.0);
+    text_to_buf(buf + 2, string, PROFILE_OVERLAY_WIDTH - 2, PROFILE_OVERLAY_WIDTH, color);
+
+    for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++) {
+        sprintf(string, "%-8s %6.2f ms (max %6.2f)", profile_zone_names[zone], zoneTime[zone] / count / 1000.0, zoneMax[zone] / 1000.0);
+        text_to_buf(buf + lineHeight * (zone + 1) * PROFILE_OVERLAY_WIDTH + 2, string, PROFILE_OVERLAY_WIDTH - 2, PROFILE_OVERLAY_WIDTH, color);
+    }
+
+    scr_blit(buf, PROFILE_OVERLAY_WIDTH, height, 0, 0, PROFILE_OVERLAY_WIDTH, height, 0, 0);
+}
@@ -0,0 +1,53 @@
+#ifndef FALLOUT_PLIB_GNW_PROFILE_H_
+#define FALLOUT_PLIB_GNW_PROFILE_H_
+
+#include <stdbool.h>
+
+#define PROFILE_FRAME_CAPACITY 256
+#define PROFILE_EVENT_CAPACITY 16384
+
+typedef enum ProfileZone {
+    PROFILE_ZONE_INPUT,
+    PROFILE_ZONE_ANIMATE,
+    PROFILE_ZONE_QUEUE,
+    PROFILE_ZONE_SCRIPTS,
+    PROFILE_ZONE_RENDER,
+    PROFILE_ZONE_SOUND,
+    PROFILE_ZONE_NETWORK,
+    PROFILE_ZONE_COUNT,
+} ProfileZone;
+
+typedef struct ProfileFrame {
+    // Start of the frame in microseconds.
+    unsigned long long start;
+
+    // Duration of the frame in microseconds.
+    unsigned int duration;
+
+    // Inclusive time spent in every zone in microseconds.
+    unsigned int zoneTime[PROFILE_ZONE_COUNT];
+
+    // Number of times every zone was entered.
+    unsigned short zoneCalls[PROFILE_ZONE_COUNT];
+} ProfileFrame;
+
+typedef struct ProfileEvent {
+    unsigned long long start;
+    unsigned int duration;
+    int zone;
+} ProfileEvent;
+
+unsigned long long profile_get_time();
+void profile_enable(bool enabled);
+bool profile_is_enabled();
+void profile_overlay_enable(bool enabled);
+bool profile_overlay_is_enabled();
+void profile_begin(ProfileZone zone);
+void profile_end(ProfileZone zone);
+void profile_frame();
+const char* profile_zone_name(ProfileZone zone);
+int profile_get_frames(ProfileFrame* frames, int capacity);
+int profile_export_csv(const char* path);
+int profile_export_trace(const char* path);
+
+#endif /* FALLOUT_PLIB_GNW_PROFILE_H_ */
@@ -25,6 +25,9 @@ static int GNW95_WindowHeight = 480;
 static unsigned char* GNW95_WindowBuffer = NULL;
 static BITMAPINFO* GNW95_WindowBMI = NULL;
 
+// Alternative presentation backend, NULL means DirectDraw/GDI.
+static VideoBackend* video_backend = NULL;
+
 // 0x51E2B0
 LPDIRECTDRAW GNW95_DDObject = NULL;
 
@@ -158,9 +161,40 @@ void reset_mode()
 {
 }
 
+// Installs video backend used by subsequent mode sets. Pass NULL to restore
+// DirectDraw/GDI presentation.
+void svga_set_backend(VideoBackend* backend)
+{
+    video_backend = backend;
+}
+
+VideoBackend* svga_get_backend()
+{
+    return video_backend;
+}
+
 // 0x4CAE1C
 static int GNW95_init_mode_ex(int width, int height, int bpp)
 {
+    if (video_backend != NULL) {
+        if (video_backend->init(width, height, bpp) == -1) {
+            return -1;
+        }
+
+        scr_size.ulx = 0;
+        scr_size.uly = 0;
+        scr_size.lrx = width - 1;
+        scr_size.lry = height - 1;
+
+        mmxEnable(true);
+
+        mouse_blit_trans = NULL;
+        scr_blit = video_backend->showRect;
+        mouse_blit = video_backend->showRect;
+
+        return 0;
+    }
+
     if (GNW95_init_window() == -1) {
         return -1;
     }
@@ -405,6 +439,11 @@ int GNW95_init_DirectDraw(int width, int height, int bpp)
 // 0x4CB1B0
 void GNW95_reset_mode()
 {
+    if (video_backend != NULL) {
+        video_backend->reset();
+        return;
+    }
+
     // Clean up GDI windowed mode resources
     if (GNW95_WindowBuffer != NULL) {
         free(GNW95_WindowBuffer);
@@ -452,6 +491,19 @@ void GNW95_SetPaletteEntry(int entry, unsigned char r, unsigned char g, unsigned
 {
     PALETTEENTRY tempEntry;
 
+    if (video_backend != NULL) {
+        unsigned char rgb[3];
+        rgb[0] = r;
+        rgb[1] = g;
+        rgb[2] = b;
+        video_backend->setPalette(rgb, entry, 1);
+
+        if (update_palette_func != NULL) {
+            update_palette_func();
+        }
+        return;
+    }
+
     r <<= 2;
     g <<= 2;
     b <<= 2;
@@ -482,7 +534,9 @@ void GNW95_SetPaletteEntry(int entry, unsigned char r, unsigned char g, unsigned
 // 0x4CB310
 void GNW95_SetPaletteEntries(unsigned char* palette, int start, int count)
 {
-    if (GNW95_WindowBMI != NULL) {
+    if (video_backend != NULL) {
+        video_backend->setPalette(palette, start, count);
+    } else if (GNW95_WindowBMI != NULL) {
         // GDI windowed mode
         for (int index = 0; index < count; index++) {
             GNW95_WindowBMI->bmiColors[start + index].rgbRed = palette[index * 3] << 2;
@@ -535,7 +589,9 @@ void GNW95_SetPaletteEntries(unsigned char* palette, int start, int count)
 // 0x4CB568
 void GNW95_SetPalette(unsigned char* palette)
 {
-    if (GNW95_WindowBMI != NULL) {
+    if (video_backend != NULL) {
+        video_backend->setPalette(palette, 0, 256);
+    } else if (GNW95_WindowBMI != NULL) {
         // GDI windowed mode
         for (int index = 0; index < 256; index++) {
             GNW95_WindowBMI->bmiColors[index].rgbRed = palette[index * 3] << 2;
@@ -593,6 +649,11 @@ unsigned char* GNW95_GetPalette()
     // 0x6ACA24
     static unsigned char cmap[768];  // Fixed: need 256 * 3 = 768 bytes
 
+    if (video_backend != NULL) {
+        memcpy(cmap, video_backend->getPalette(), sizeof(cmap));
+        return cmap;
+    }
+
     if (GNW95_WindowBMI != NULL) {
         // GDI windowed mode
         for (int index = 0; index < 256; index++) {
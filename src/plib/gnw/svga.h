@@ -31,6 +31,8 @@ extern bool GNW95_isWindowed;
 extern int GNW95_WindowScale;
 
 void mmxEnable(bool enable);
+void svga_set_backend(VideoBackend* backend);
+VideoBackend* svga_get_backend();
 int init_mode_320_200();
 int init_mode_320_400();
 int init_mode_640_480_16();
@@ -12,4 +12,21 @@ typedef int(SetModeFunc)();
 typedef void(ScreenTransBlitFunc)(unsigned char* srcBuf, unsigned int srcW, unsigned int srcH, unsigned int subX, unsigned int subY, unsigned int subW, unsigned int subH, unsigned int dstX, unsigned int dstY, unsigned char trans);
 typedef void(ScreenBlitFunc)(unsigned char* srcBuf, unsigned int srcW, unsigned int srcH, unsigned int subX, unsigned int subY, unsigned int subW, unsigned int subH, unsigned int dstX, unsigned int dstY);
 
+typedef int(VideoInitFunc)(int width, int height, int bpp);
+typedef void(VideoResetFunc)();
+typedef void(VideoSetPaletteFunc)(unsigned char* palette, int start, int count);
+typedef unsigned char*(VideoGetPaletteFunc)();
+
+// Replaces DirectDraw/GDI presentation when installed with
+// `svga_set_backend`. Palette entries are 6-bit VGA values, exactly as they
+// are passed to `GNW95_SetPaletteEntries`.
+typedef struct VideoBackend {
+    const char* name;
+    VideoInitFunc* init;
+    VideoResetFunc* reset;
+    VideoSetPaletteFunc* setPalette;
+    VideoGetPaletteFunc* getPalette;
+    ScreenBlitFunc* showRect;
+} VideoBackend;
+
 #endif /* FALLOUT_PLIB_GNW_SVGA_TYPES_H_ */
@@ -0,0 +1,453 @@
+#include "plib/gnw/thread.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// Thin wrappers over native threads and synchronization primitives, and a
+// fork-join worker pool on top of them. Everything here is allocated with
+// plain malloc, since gnw memory manager is not thread-safe.
+
+typedef struct Thread {
+#if defined(_WIN32)
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    ThreadProc* proc;
+    void* data;
+    int rc;
+} Thread;
+
+typedef struct Mutex {
+#if defined(_WIN32)
+    CRITICAL_SECTION criticalSection;
+#else
+    pthread_mutex_t mutex;
+#endif
+} Mutex;
+
+typedef struct Semaphore {
+#if defined(_WIN32)
+    HANDLE handle;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int value;
+#endif
+} Semaphore;
+
+typedef struct WorkerPool {
+    Thread** threads;
+    int threadsLength;
+
+    // Signalled once per worker which should join the current batch.
+    Semaphore* start;
+
+    // Signalled by every worker which has run out of work.
+    Semaphore* done;
+
+    // Protects `next`.
+    Mutex* mutex;
+
+    WorkerPoolFunc* func;
+    void* data;
+    int count;
+    int next;
+    bool quit;
+} WorkerPool;
+
+static void worker_pool_drain(WorkerPool* pool);
+static int worker_pool_proc(void* data);
+
+#if defined(_WIN32)
+static unsigned __stdcall thread_start(void* data)
+{
+    Thread* thread = (Thread*)data;
+    thread->rc = thread->proc(thread->data);
+    return 0;
+}
+#else
+static void* thread_start(void* data)
+{
+    Thread* thread = (Thread*)data;
+    thread->rc = thread->proc(thread->data);
+    return NULL;
+}
+#endif
+
+int thread_get_cpu_count()
+{
+#if defined(_WIN32)
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    return systemInfo.dwNumberOfProcessors > 0 ? (int)systemInfo.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+Thread* thread_create(ThreadProc* proc, void* data)
+{
+    Thread* thread = (Thread*)malloc(sizeof(*thread));
+    if (thread == NULL) {
+        return NULL;
+    }
+
+    thread->proc = proc;
+    thread->data = data;
+    thread->rc = 0;
+
+#if defined(_WIN32)
+    thread->handle = (HANDLE)_beginthreadex(NULL, 0, thread_start, thread, 0, NULL);
+    if (thread->handle == NULL) {
+        free(thread);
+        return NULL;
+    }
+#else
+    if (pthread_create(&(thread->handle), NULL, thread_start, thread) != 0) {
+        free(thread);
+        return NULL;
+    }
+#endif
+
+    return thread;
+}
+
+// Waits for thread to finish and frees it. Returns value returned by thread
+// proc.
+int thread_join(Thread* thread)
+{
+    int rc;
+
+    if (thread == NULL) {
+        return -1;
+    }
+
+#if defined(_WIN32)
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+
+    rc = thread->rc;
+    free(thread);
+
+    return rc;
+}
+
+void thread_sleep(int ms)
+{
+#if defined(_WIN32)
+    Sleep(ms);
+#else
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000L;
+    nanosleep(&ts, NULL);
+#endif
+}
+
+// Reads value written by another thread with `atomic_set`. Everything the
+// writer did before the store is visible after the load.
+int atomic_get(volatile int* ptr)
+{
+#if defined(_WIN32)
+    return InterlockedCompareExchange((volatile LONG*)ptr, 0, 0);
+#else
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+void atomic_set(volatile int* ptr, int value)
+{
+#if defined(_WIN32)
+    InterlockedExchange((volatile LONG*)ptr, value);
+#else
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif
+}
+
+// Mutexes are recursive, the same thread can lock it several times (and
+// should unlock it the same number of times).
+Mutex* mutex_create()
+{
+#if !defined(_WIN32)
+    pthread_mutexattr_t attr;
+#endif
+
+    Mutex* mutex = (Mutex*)malloc(sizeof(*mutex));
+    if (mutex == NULL) {
+        return NULL;
+    }
+
+#if defined(_WIN32)
+    InitializeCriticalSection(&(mutex->criticalSection));
+#else
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&(mutex->mutex), &attr);
+    pthread_mutexattr_destroy(&attr);
+#endif
+
+    return mutex;
+}
+
+void mutex_free(Mutex* mutex)
+{
+    if (mutex == NULL) {
+        return;
+    }
+
+#if defined(_WIN32)
+    DeleteCriticalSection(&(mutex->criticalSection));
+#else
+    pthread_mutex_destroy(&(mutex->mutex));
+#endif
+
+    free(mutex);
+}
+
+void mutex_lock(Mutex* mutex)
+{
+#if defined(_WIN32)
+    EnterCriticalSection(&(mutex->criticalSection));
+#else
+    pthread_mutex_lock(&(mutex->mutex));
+#endif
+}
+
+void mutex_unlock(Mutex* mutex)
+{
+#if defined(_WIN32)
+    LeaveCriticalSection(&(mutex->criticalSection));
+#else
+    pthread_mutex_unlock(&(mutex->mutex));
+#endif
+}
+
+Semaphore* semaphore_create(int value)
+{
+    Semaphore* semaphore = (Semaphore*)malloc(sizeof(*semaphore));
+    if (semaphore == NULL) {
+        return NULL;
+    }
+
+#if defined(_WIN32)
+    semaphore->handle = CreateSemaphoreA(NULL, value, 0x7FFFFFFF, NULL);
+    if (semaphore->handle == NULL) {
+        free(semaphore);
+        return NULL;
+    }
+#else
+    pthread_mutex_init(&(semaphore->mutex), NULL);
+    pthread_cond_init(&(semaphore->cond), NULL);
+    semaphore->value = value;
+#endif
+
+    return semaphore;
+}
+
+void semaphore_free(Semaphore* semaphore)
+{
+    if (semaphore == NULL) {
+        return;
+    }
+
+#if defined(_WIN32)
+    CloseHandle(semaphore->handle);
+#else
+    pthread_cond_destroy(&(semaphore->cond));
+    pthread_mutex_destroy(&(semaphore->mutex));
+#endif
+
+    free(semaphore);
+}
+
+void semaphore_wait(Semaphore* semaphore)
+{
+#if defined(_WIN32)
+    WaitForSingleObject(semaphore->handle, INFINITE);
+#else
+    pthread_mutex_lock(&(semaphore->mutex));
+    while (semaphore->value == 0) {
+        pthread_cond_wait(&(semaphore->cond), &(semaphore->mutex));
+    }
+    semaphore->value--;
+    pthread_mutex_unlock(&(semaphore->mutex));
+#endif
+}
+
+void semaphore_post(Semaphore* semaphore, int count)
+{
+    if (count <= 0) {
+        return;
+    }
+
+#if defined(_WIN32)
+    ReleaseSemaphore(semaphore->handle, count, NULL);
+#else
+    pthread_mutex_lock(&(semaphore->mutex));
+    semaphore->value += count;
+    pthread_cond_broadcast(&(semaphore->cond));
+    pthread_mutex_unlock(&(semaphore->mutex));
+#endif
+}
+
+// Creates pool with given number of worker threads. The thread calling
+// `worker_pool_run` participates in the work as well, so pool of size 0 is
+// valid and simply runs everything inline.
+WorkerPool* worker_pool_create(int threads)
+{
+    WorkerPool* pool = (WorkerPool*)malloc(sizeof(*pool));
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    pool->threads = NULL;
+    pool->threadsLength = 0;
+    pool->func = NULL;
+    pool->data = NULL;
+    pool->count = 0;
+    pool->next = 0;
+    pool->quit = false;
+
+    pool->start = semaphore_create(0);
+    pool->done = semaphore_create(0);
+    pool->mutex = mutex_create();
+    if (pool->start == NULL || pool->done == NULL || pool->mutex == NULL) {
+        worker_pool_free(pool);
+        return NULL;
+    }
+
+    if (threads > 0) {
+        pool->threads = (Thread**)malloc(sizeof(*pool->threads) * threads);
+        if (pool->threads == NULL) {
+            worker_pool_free(pool);
+            return NULL;
+        }
+
+        for (int index = 0; index < threads; index++) {
+            pool->threads[index] = thread_create(worker_pool_proc, pool);
+            if (pool->threads[index] == NULL) {
+                break;
+            }
+            pool->threadsLength++;
+        }
+    }
+
+    return pool;
+}
+
+void worker_pool_free(WorkerPool* pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+
+    if (pool->threadsLength != 0) {
+        pool->quit = true;
+        semaphore_post(pool->start, pool->threadsLength);
+
+        for (int index = 0; index < pool->threadsLength; index++) {
+            thread_join(pool->threads[index]);
+        }
+    }
+
+    if (pool->threads != NULL) {
+        free(pool->threads);
+    }
+
+    semaphore_free(pool->start);
+    semaphore_free(pool->done);
+    mutex_free(pool->mutex);
+    free(pool);
+}
+
+int worker_pool_get_size(WorkerPool* pool)
+{
+    return pool != NULL ? pool->threadsLength : 0;
+}
+
+// Calls `func` for every index in [0, count) and returns when all calls
+// are complete. Calls are distributed between pool threads and the calling
+// thread in no particular order.
+void worker_pool_run(WorkerPool* pool, WorkerPoolFunc* func, void* data, int count)
+{
+    int helpers;
+
+    if (count <= 0) {
+        return;
+    }
+
+    if (pool == NULL || pool->threadsLength == 0 || count == 1) {
+        for (int index = 0; index < count; index++) {
+            func(data, index);
+        }
+        return;
+    }
+
+    pool->func = func;
+    pool->data = data;
+    pool->count = count;
+    pool->next = 0;
+
+    helpers = count - 1 < pool->threadsLength ? count - 1 : pool->threadsLength;
+    semaphore_post(pool->start, helpers);
+
+    worker_pool_drain(pool);
+
+    for (int index = 0; index < helpers; index++) {
+        semaphore_wait(pool->done);
+    }
+
+    pool->func = NULL;
+    pool->data = NULL;
+    pool->count = 0;
+}
+
+static void worker_pool_drain(WorkerPool* pool)
+{
+    int index;
+
+    while (true) {
+        mutex_lock(pool->mutex);
+        index = pool->next < pool->count ? pool->next++ : -1;
+        mutex_unlock(pool->mutex);
+
+        if (index == -1) {
+            break;
+        }
+
+        pool->func(pool->data, index);
+    }
+}
+
+static int worker_pool_proc(void* data)
+{
+    WorkerPool* pool = (WorkerPool*)data;
+
+    while (true) {
+        semaphore_wait(pool->start);
+
+        if (pool->quit) {
+            break;
+        }
+
+        worker_pool_drain(pool);
+        semaphore_post(pool->done, 1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,31 @@
+#ifndef FALLOUT_PLIB_GNW_THREAD_H_
+#define FALLOUT_PLIB_GNW_THREAD_H_
+
+typedef struct Thread Thread;
+typedef struct Mutex Mutex;
+typedef struct Semaphore Semaphore;
+typedef struct WorkerPool WorkerPool;
+
+typedef int(ThreadProc)(void* data);
+typedef void(WorkerPoolFunc)(void* data, int index);
+
+int thread_get_cpu_count();
+Thread* thread_create(ThreadProc* proc, void* data);
+int thread_join(Thread* thread);
+void thread_sleep(int ms);
+int atomic_get(volatile int* ptr);
+void atomic_set(volatile int* ptr, int value);
+Mutex* mutex_create();
+void mutex_free(Mutex* mutex);
+void mutex_lock(Mutex* mutex);
+void mutex_unlock(Mutex* mutex);
+Semaphore* semaphore_create(int value);
+void semaphore_free(Semaphore* semaphore);
+void semaphore_wait(Semaphore* semaphore);
+void semaphore_post(Semaphore* semaphore, int count);
+WorkerPool* worker_pool_create(int threads);
+void worker_pool_free(WorkerPool* pool);
+int worker_pool_get_size(WorkerPool* pool);
+void worker_pool_run(WorkerPool* pool, WorkerPoolFunc* func, void* data, int count);
+
+#endif /* FALLOUT_PLIB_GNW_THREAD_H_ */
@@ -12,8 +12,20 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOUND_DECODER_SSE2
+#include <emmintrin.h>
+#endif
+
 #define SOUND_DECODER_IN_BUFFER_SIZE 512
 
+// Number of bits peeked to decode one code of prefix coded band formats.
+#define SOUND_DECODER_CODE_BITS 5
+
+// Desired distance between seek points in samples. Actual distance is rounded
+// down to whole blocks, so seeking never decodes more than this much.
+#define SOUND_DECODER_SEEK_POINT_SAMPLES 32768
+
 typedef int (*ReadBandFunc)(AudioDecoder* ad, int subband, int n);
 
 typedef struct _byte_reader {
@@ -23,14 +35,36 @@ typedef struct _byte_reader {
     size_t buf_size;
     unsigned char* buf_ptr;
     int buf_cnt;
+    int pos;
+    bool eof;
 } byte_reader;
 
+// NOTE: The original accumulated bits in 32-bit int one byte at a time. It's
+// 64-bit now and refilled with as many whole bytes as fit, which is
+// indistinguishable for readers since they only look at requested bits.
 typedef struct _bit_reader {
     byte_reader bytes;
-    int data;
+    unsigned long long data;
     int bitcnt;
 } bit_reader;
 
+// Entry of prefix code table: how many bits the code occupies, and how many
+// times (1 or 2) scale table value at `index` should be written.
+typedef struct _band_code {
+    unsigned char bits;
+    unsigned char count;
+    signed char index;
+} band_code;
+
+// Decoder state at the beginning of a block. Together with the contents of
+// `prev_samples` (stored separately) it's everything needed to resume
+// decoding from that block.
+typedef struct _seek_point {
+    int offset;
+    unsigned long long data;
+    int bitcnt;
+} seek_point;
+
 typedef struct _AudioDecoder {
     bit_reader bits;
     int levels;
@@ -46,41 +80,49 @@ typedef struct _AudioDecoder {
     int file_cnt;
     unsigned char* samp_ptr;
     int samp_cnt;
+    int total_cnt;
+    int prev_samples_size;
+    AudioDecoderSeekFunc* seek;
+    int seek_point_blocks;
+    seek_point* seek_points;
+    unsigned char* seek_point_samples;
+    int seek_points_cnt;
+    int seek_points_capacity;
+    // Band scale table, centered. It's rebuilt for every block, so every
+    // decoder has its own to let decoders run on different threads.
+    unsigned char* scale_tbl;
+    unsigned char* scale0;
 } AudioDecoder;
 
-#if _WIN32
-static_assert(sizeof(AudioDecoder) == 84, "wrong size");
-#endif
-
 static bool bytes_init(byte_reader* bytes, AudioDecoderReadFunc* read, void* data);
 static unsigned char ByteReaderFill(byte_reader* bytes);
 static bool bits_init(bit_reader* bits, AudioDecoderReadFunc* read, void* data);
 static void init_pack_tables();
+static void init_band_codes();
+static void set_band_code(int fmt, int pattern, int bits, int count, int index);
 static int ReadBand_Fail(AudioDecoder* ad, int subband, int n);
 static int ReadBand_Fmt0(AudioDecoder* ad, int subband, int n);
 static int ReadBand_Fmt3_16(AudioDecoder* ad, int subband, int n);
-static int ReadBand_Fmt17(AudioDecoder* ad, int subband, int n);
-static int ReadBand_Fmt18(AudioDecoder* ad, int subband, int n);
+static int ReadBand_Code(AudioDecoder* ad, int subband, int n);
 static int ReadBand_Fmt19(AudioDecoder* ad, int subband, int n);
-static int ReadBand_Fmt20(AudioDecoder* ad, int subband, int n);
-static int ReadBand_Fmt21(AudioDecoder* ad, int subband, int n);
 static int ReadBand_Fmt22(AudioDecoder* ad, int subband, int n);
-static int ReadBand_Fmt23(AudioDecoder* ad, int subband, int n);
-static int ReadBand_Fmt24(AudioDecoder* ad, int subband, int n);
-static int ReadBand_Fmt26(AudioDecoder* ad, int subband, int n);
-static int ReadBand_Fmt27(AudioDecoder* ad, int subband, int n);
 static int ReadBand_Fmt29(AudioDecoder* ad, int subband, int n);
 static int ReadBands(AudioDecoder* ad);
 static void untransform_subband0(unsigned char* prv, unsigned char* buf, int step, int count);
 static void untransform_subband(unsigned char* prv, unsigned char* buf, int step, int count);
 static void untransform_all(AudioDecoder* ad);
+#ifdef SOUND_DECODER_SSE2
+static void untransform_subband0_sse2(unsigned char* prv, unsigned char* buf, int step, int count);
+static void untransform_subband_sse2(unsigned char* prv, unsigned char* buf, int step, int count);
+#endif
+static bool AudioDecoder_fill(AudioDecoder* ad);
+static void AudioDecoder_AddSeekPoint(AudioDecoder* ad);
+static bool AudioDecoder_RestoreSeekPoint(AudioDecoder* ad, int index);
 
 static inline void requireBits(AudioDecoder* ad, int n);
+static void fillBits(bit_reader* bits, int n);
 static inline void dropBits(AudioDecoder* ad, int n);
 
-// 0x539E58
-static int AudioDecoder_cnt = 0;
-
 // 0x539E60
 static ReadBandFunc ReadBand_tbl[32] = {
     ReadBand_Fmt0,
@@ -100,17 +142,17 @@ static ReadBandFunc ReadBand_tbl[32] = {
     ReadBand_Fmt3_16,
     ReadBand_Fmt3_16,
     ReadBand_Fmt3_16,
-    ReadBand_Fmt17,
-    ReadBand_Fmt18,
+    ReadBand_Code,
+    ReadBand_Code,
     ReadBand_Fmt19,
-    ReadBand_Fmt20,
-    ReadBand_Fmt21,
+    ReadBand_Code,
+    ReadBand_Code,
     ReadBand_Fmt22,
-    ReadBand_Fmt23,
-    ReadBand_Fmt24,
+    ReadBand_Code,
+    ReadBand_Code,
     ReadBand_Fail,
-    ReadBand_Fmt26,
-    ReadBand_Fmt27,
+    ReadBand_Code,
+    ReadBand_Code,
     ReadBand_Fail,
     ReadBand_Fmt29,
     ReadBand_Fail,
@@ -126,11 +168,12 @@ static unsigned char pack3_3[32];
 // 0x673170
 static unsigned short pack5_3[128];
 
-// 0x673270
-static unsigned char* AudioDecoder_scale0;
+// Decoding tables of prefix coded band formats indexed by format and next
+// `SOUND_DECODER_CODE_BITS` bits of the stream.
+static band_code band_codes[32][1 << SOUND_DECODER_CODE_BITS];
 
-// 0x673274
-static unsigned char* AudioDecoder_scale_tbl;
+// Number of bits which is enough to decode any code of given format.
+static int band_code_bits[32];
 
 // 0x4D3BB0
 static bool bytes_init(byte_reader* bytes, AudioDecoderReadFunc* read, void* data)
@@ -145,6 +188,8 @@ static bool bytes_init(byte_reader* bytes, AudioDecoderReadFunc* read, void* dat
 
     bytes->buf_size = SOUND_DECODER_IN_BUFFER_SIZE;
     bytes->buf_cnt = 0;
+    bytes->pos = 0;
+    bytes->eof = false;
 
     return true;
 }
@@ -156,8 +201,11 @@ static unsigned char ByteReaderFill(byte_reader* bytes)
     if (bytes->buf_cnt == 0) {
         memset(bytes->buf, 0, bytes->buf_size);
         bytes->buf_cnt = bytes->buf_size;
+        bytes->eof = true;
     }
 
+    bytes->pos += bytes->buf_cnt;
+
     bytes->buf_ptr = bytes->buf;
     bytes->buf_cnt -= 1;
     return *bytes->buf_ptr++;
@@ -212,9 +260,99 @@ static void init_pack_tables()
         }
     }
 
+    init_band_codes();
+
     inited = true;
 }
 
+// NOTE: Formats 17, 18, 20, 21, 23, 24, 26 and 27 were read by separate
+// functions testing code bits one by one. They are described by these tables
+// and read by `ReadBand_Code` now. In every format code with lowest bit unset
+// stands for one or two zero samples.
+static void init_band_codes()
+{
+    int v;
+
+    // 0 - two zeros, 01 - zero, x11 - +/-1.
+    band_code_bits[17] = 3;
+    set_band_code(17, 0x00, 1, 2, 0);
+    set_band_code(17, 0x01, 2, 1, 0);
+    set_band_code(17, 0x03, 3, 1, -1);
+    set_band_code(17, 0x07, 3, 1, 1);
+
+    // 0 - zero, x1 - +/-1.
+    band_code_bits[18] = 2;
+    set_band_code(18, 0x00, 1, 1, 0);
+    set_band_code(18, 0x01, 2, 1, -1);
+    set_band_code(18, 0x03, 2, 1, 1);
+
+    // 0 - two zeros, 01 - zero, xx11 - +/-1, +/-2.
+    band_code_bits[20] = 4;
+    set_band_code(20, 0x00, 1, 2, 0);
+    set_band_code(20, 0x01, 2, 1, 0);
+    set_band_code(20, 0x03, 4, 1, -2);
+    set_band_code(20, 0x07, 4, 1, -1);
+    set_band_code(20, 0x0B, 4, 1, 1);
+    set_band_code(20, 0x0F, 4, 1, 2);
+
+    // 0 - zero, xx1 - +/-1, +/-2.
+    band_code_bits[21] = 3;
+    set_band_code(21, 0x00, 1, 1, 0);
+    set_band_code(21, 0x01, 3, 1, -2);
+    set_band_code(21, 0x03, 3, 1, -1);
+    set_band_code(21, 0x05, 3, 1, 1);
+    set_band_code(21, 0x07, 3, 1, 2);
+
+    // 0 - two zeros, 01 - zero, x011 - +/-1, xx111 - +/-2, +/-3.
+    band_code_bits[23] = 5;
+    set_band_code(23, 0x00, 1, 2, 0);
+    set_band_code(23, 0x01, 2, 1, 0);
+    set_band_code(23, 0x03, 4, 1, -1);
+    set_band_code(23, 0x0B, 4, 1, 1);
+    set_band_code(23, 0x07, 5, 1, -3);
+    set_band_code(23, 0x0F, 5, 1, -2);
+    set_band_code(23, 0x17, 5, 1, 2);
+    set_band_code(23, 0x1F, 5, 1, 3);
+
+    // 0 - zero, x01 - +/-1, xx11 - +/-2, +/-3.
+    band_code_bits[24] = 4;
+    set_band_code(24, 0x00, 1, 1, 0);
+    set_band_code(24, 0x01, 3, 1, -1);
+    set_band_code(24, 0x05, 3, 1, 1);
+    set_band_code(24, 0x03, 4, 1, -3);
+    set_band_code(24, 0x07, 4, 1, -2);
+    set_band_code(24, 0x0B, 4, 1, 2);
+    set_band_code(24, 0x0F, 4, 1, 3);
+
+    // 0 - two zeros, 01 - zero, xxx11 - +/-1..4.
+    band_code_bits[26] = 5;
+    set_band_code(26, 0x00, 1, 2, 0);
+    set_band_code(26, 0x01, 2, 1, 0);
+    for (v = 0; v < 8; v++) {
+        set_band_code(26, 0x03 | (v << 2), 5, 1, v >= 4 ? v - 3 : v - 4);
+    }
+
+    // 0 - zero, xxx1 - +/-1..4.
+    band_code_bits[27] = 4;
+    set_band_code(27, 0x00, 1, 1, 0);
+    for (v = 0; v < 8; v++) {
+        set_band_code(27, 0x01 | (v << 1), 4, 1, v >= 4 ? v - 3 : v - 4);
+    }
+}
+
+// Sets code for every table entry which starts with `pattern` of `bits`
+// length.
+static void set_band_code(int fmt, int pattern, int bits, int count, int index)
+{
+    int entry;
+
+    for (entry = pattern; entry < (1 << SOUND_DECODER_CODE_BITS); entry += 1 << bits) {
+        band_codes[fmt][entry].bits = bits;
+        band_codes[fmt][entry].count = count;
+        band_codes[fmt][entry].index = index;
+    }
+}
+
 // 0x4BE62C
 static int ReadBand_Fail(AudioDecoder* ad, int subband, int n)
 {
@@ -243,7 +381,7 @@ static int ReadBand_Fmt3_16(AudioDecoder* ad, int subband, int n)
     int value;
     int v14;
 
-    short* base = (short*)AudioDecoder_scale0;
+    short* base = (short*)ad->scale0;
     base += UINT_MAX << (n - 1);
 
     int* p = (int*)ad->samples;
@@ -266,102 +404,41 @@ static int ReadBand_Fmt3_16(AudioDecoder* ad, int subband, int n)
     return 1;
 }
 
-// 0x4BE720
-static int ReadBand_Fmt17(AudioDecoder* ad, int subband, int n)
+static int ReadBand_Code(AudioDecoder* ad, int subband, int n)
 {
-    short* base = (short*)AudioDecoder_scale0;
+    short* base = (short*)ad->scale0;
+    band_code* codes = band_codes[n];
+    int bits = band_code_bits[n];
+    int mask = (1 << bits) - 1;
+    band_code* code;
 
     int* p = (int*)ad->samples;
     p += subband;
 
     int i = ad->samples_per_subband;
     while (i != 0) {
-        requireBits(ad, 3);
-
-        int value = ad->bits.data & 0xFF;
-        if (!(value & 0x01)) {
-            dropBits(ad, 1);
-
-            *p = 0;
-            p += ad->subbands;
+        requireBits(ad, bits);
+        code = &(codes[ad->bits.data & mask]);
+        dropBits(ad, code->bits);
 
-            if (--i == 0) {
-                break;
-            }
-
-            *p = 0;
-            p += ad->subbands;
-
-            if (--i == 0) {
-                break;
-            }
-        } else if (!(value & 0x02)) {
-            dropBits(ad, 2);
-
-            *p = 0;
-            p += ad->subbands;
-
-            if (--i == 0) {
-                break;
-            }
-        } else {
-            dropBits(ad, 3);
-
-            if (value & 0x04) {
-                *p = base[1];
-            } else {
-                *p = base[-1];
-            }
+        *p = base[code->index];
+        p += ad->subbands;
+        i--;
 
+        if (code->count == 2 && i != 0) {
+            *p = base[code->index];
             p += ad->subbands;
             i--;
         }
     }
-    return 1;
-}
 
-// 0x4BE828
-static int ReadBand_Fmt18(AudioDecoder* ad, int subband, int n)
-{
-    short* base = (short*)AudioDecoder_scale0;
-
-    int* p = (int*)ad->samples;
-    p += subband;
-
-    int i = ad->samples_per_subband;
-    while (i != 0) {
-        requireBits(ad, 2);
-
-        int value = ad->bits.data;
-        if (!(value & 0x01)) {
-            dropBits(ad, 1);
-
-            *p = 0;
-            p += ad->subbands;
-
-            if (--i == 0) {
-                return 1;
-            }
-        } else {
-            dropBits(ad, 2);
-
-            if (value & 0x02) {
-                *p = base[1];
-            } else {
-                *p = base[-1];
-            }
-
-            p += ad->subbands;
-            i--;
-        }
-    }
     return 1;
 }
 
 // 0x4BE8F8
 static int ReadBand_Fmt19(AudioDecoder* ad, int subband, int n)
 {
-    short* base = (short*)AudioDecoder_scale0;
+    short* base = (short*)ad->scale0;
     base -= 1;
 
     int* p = (int*)ad->samples;
@@ -396,120 +473,10 @@ static int ReadBand_Fmt19(AudioDecoder* ad, int subband, int n)
     return 1;
 }
 
-// 0x4BE9E8
-static int ReadBand_Fmt20(AudioDecoder* ad, int subband, int n)
-{
-    short* base = (short*)AudioDecoder_scale0;
-
-    int* p = (int*)ad->samples;
-    p += subband;
-
-    int i = ad->samples_per_subband;
-    while (i != 0) {
-        requireBits(ad, 4);
-
-        int value = ad->bits.data & 0xFF;
-        if (!(value & 0x01)) {
-            dropBits(ad, 1);
-
-            *p = 0;
-            p += ad->subbands;
-
-            if (--i == 0) {
-                break;
-            }
-
-            *p = 0;
-            p += ad->subbands;
-
-            if (--i == 0) {
-                break;
-            }
-        } else if (!(value & 0x02)) {
-            dropBits(ad, 2);
-
-            *p = 0;
-            p += ad->subbands;
-
-            if (--i == 0) {
-                break;
-            }
-        } else {
-            dropBits(ad, 4);
-
-            if (value & 0x08) {
-                if (value & 0x04) {
-                    *p = base[2];
-                } else {
-                    *p = base[1];
-                }
-            } else {
-                if (value & 0x04) {
-                    *p = base[-1];
-                } else {
-                    *p = base[-2];
-                }
-            }
-
-            p += ad->subbands;
-            i--;
-        }
-    }
-
-    return 1;
-}
-
-// 0x4BEAE4
-static int ReadBand_Fmt21(AudioDecoder* ad, int subband, int n)
-{
-    short* base = (short*)AudioDecoder_scale0;
-
-    int* p = (int*)ad->samples;
-    p += subband;
-
-    int i = ad->samples_per_subband;
-    while (i != 0) {
-        requireBits(ad, 3);
-
-        int value = ad->bits.data & 0xFF;
-        if (!(value & 0x01)) {
-            dropBits(ad, 1);
-
-            *p = 0;
-            p += ad->subbands;
-
-            if (--i == 0) {
-                break;
-            }
-        } else {
-            dropBits(ad, 3);
-
-            if (value & 0x04) {
-                if (value & 0x02) {
-                    *p = base[2];
-                } else {
-                    *p = base[1];
-                }
-            } else {
-                if (value & 0x02) {
-                    *p = base[-1];
-                } else {
-                    *p = base[-2];
-                }
-            }
-
-            p += ad->subbands;
-            i--;
-        }
-    }
-
-    return 1;
-}
-
 // 0x4BEBC8
 static int ReadBand_Fmt22(AudioDecoder* ad, int subband, int n)
 {
-    short* base = (short*)AudioDecoder_scale0;
+    short* base = (short*)ad->scale0;
     base -= 2;
 
     int* p = (int*)ad->samples;
@@ -548,229 +515,10 @@ static int ReadBand_Fmt22(AudioDecoder* ad, int subband, int n)
     return 1;
 }
 
-// 0x4BECC4
-static int ReadBand_Fmt23(AudioDecoder* ad, int subband, int n)
-{
-    short* base = (short*)AudioDecoder_scale0;
-
-    int* p = (int*)ad->samples;
-    p += subband;
-
-    int i = ad->samples_per_subband;
-    while (i != 0) {
-        requireBits(ad, 5);
-
-        int value = ad->bits.data;
-        if (!(value & 0x01)) {
-            dropBits(ad, 1);
-
-            *p = 0;
-            p += ad->subbands;
-
-            if (--i == 0) {
-                break;
-            }
-
-            *p = 0;
-            p += ad->subbands;
-
-            if (--i == 0) {
-                break;
-            }
-        } else if (!(value & 0x02)) {
-            dropBits(ad, 2);
-
-            *p = 0;
-            p += ad->subbands;
-
-            if (--i == 0) {
-                break;
-            }
-        } else if (!(value & 0x04)) {
-            dropBits(ad, 4);
-
-            if (value & 0x08) {
-                *p = base[1];
-            } else {
-                *p = base[-1];
-            }
-
-            p += ad->subbands;
-            if (--i == 0) {
-                break;
-            }
-        } else {
-            dropBits(ad, 5);
-
-            value >>= 3;
-            value &= 0x03;
-            if (value >= 2) {
-                value += 3;
-            }
-
-            *p = base[value - 3];
-            p += ad->subbands;
-            i--;
-        }
-    }
-
-    return 1;
-}
-
-// 0x4BEE14
-static int ReadBand_Fmt24(AudioDecoder* ad, int subband, int n)
-{
-    short* base = (short*)AudioDecoder_scale0;
-
-    int* p = (int*)ad->samples;
-    p += subband;
-
-    int i = ad->samples_per_subband;
-    while (i != 0) {
-        requireBits(ad, 4);
-
-        int value = ad->bits.data & 0xFF;
-        if (!(value & 0x01)) {
-            dropBits(ad, 1);
-
-            *p = 0;
-            p += ad->subbands;
-
-            if (--i == 0) {
-                break;
-            }
-        } else if (!(value & 0x02)) {
-            dropBits(ad, 3);
-
-            if (value & 0x04) {
-                *p = base[1];
-            } else {
-                *p = base[-1];
-            }
-
-            p += ad->subbands;
-
-            if (--i == 0) {
-                break;
-            }
-        } else {
-            dropBits(ad, 4);
-
-            value >>= 2;
-            value &= 0x03;
-            if (value >= 2) {
-                value += 3;
-            }
-
-            *p = base[value - 3];
-            p += ad->subbands;
-            i--;
-        }
-    }
-
-    return 1;
-}
-
-// 0x4BEF28
-static int ReadBand_Fmt26(AudioDecoder* ad, int subband, int n)
-{
-    short* base = (short*)AudioDecoder_scale0;
-
-    int* p = (int*)ad->samples;
-    p += subband;
-
-    int i = ad->samples_per_subband;
-    while (i != 0) {
-        requireBits(ad, 5);
-
-        int value = ad->bits.data;
-        if (!(value & 0x01)) {
-            dropBits(ad, 1);
-
-            *p = 0;
-            p += ad->subbands;
-
-            if (--i == 0) {
-                break;
-            }
-
-            *p = 0;
-            p += ad->subbands;
-
-            if (--i == 0) {
-                break;
-            }
-        } else if (!(value & 0x02)) {
-            dropBits(ad, 2);
-
-            *p = 0;
-            p += ad->subbands;
-
-            if (--i == 0) {
-                break;
-            }
-        } else {
-            dropBits(ad, 5);
-
-            value >>= 2;
-            value &= 0x07;
-            if (value >= 4) {
-                value += 1;
-            }
-
-            *p = base[value - 4];
-            p += ad->subbands;
-            i--;
-        }
-    }
-
-    return 1;
-}
-
-// 0x4BF034
-static int ReadBand_Fmt27(AudioDecoder* ad, int subband, int n)
-{
-    short* base = (short*)AudioDecoder_scale0;
-
-    int* p = (int*)ad->samples;
-    p += subband;
-
-    int i = ad->samples_per_subband;
-    while (i != 0) {
-        requireBits(ad, 4);
-
-        int value = ad->bits.data;
-        if (!(value & 0x01)) {
-            dropBits(ad, 1);
-
-            *p = 0;
-            p += ad->subbands;
-
-            if (--i == 0) {
-                break;
-            }
-        } else {
-            dropBits(ad, 4);
-
-            value >>= 1;
-            value &= 0x07;
-            if (value >= 4) {
-                value += 1;
-            }
-
-            *p = base[value - 4];
-            p += ad->subbands;
-            i--;
-        }
-    }
-
-    return 1;
-}
-
 // 0x4BF100
 static int ReadBand_Fmt29(AudioDecoder* ad, int subband, int n)
 {
-    short* base = (short*)AudioDecoder_scale0;
+    short* base = (short*)ad->scale0;
 
     int* p = (int*)ad->samples;
     p += subband;
@@ -820,7 +568,7 @@ static int ReadBands(AudioDecoder* ad)
 
     v17 = 1 << v9;
 
-    v18 = (unsigned short*)AudioDecoder_scale0;
+    v18 = (unsigned short*)ad->scale0;
     v19 = v17;
     v21 = 0;
     while (v19--) {
@@ -828,7 +576,7 @@ static int ReadBands(AudioDecoder* ad)
         v21 += v15;
     }
 
-    v18 = (unsigned short*)AudioDecoder_scale0;
+    v18 = (unsigned short*)ad->scale0;
     v19 = v17;
     v21 = -v15;
     while (v19--) {
@@ -837,8 +585,6 @@ static int ReadBands(AudioDecoder* ad)
         v21 -= v15;
     }
 
-    init_pack_tables();
-
     for (int index = 0; index < ad->subbands; index++) {
         requireBits(ad, 5);
         int bits = ad->bits.data & 0x1F;
@@ -1068,7 +814,11 @@ static void untransform_all(AudioDecoder* ad)
 
         v4 *= 2;
 
+#ifdef SOUND_DECODER_SSE2
+        untransform_subband0_sse2(ad->prev_samples, ptr, v3, v4);
+#else
         untransform_subband0(ad->prev_samples, ptr, v3, v4);
+#endif
 
         v5 = (int*)ptr;
         for (v6 = 0; v6 < v4; v6++) {
@@ -1083,7 +833,11 @@ static void untransform_all(AudioDecoder* ad)
             if (v3 == 0) {
                 break;
             }
+#ifdef SOUND_DECODER_SSE2
+            untransform_subband_sse2(j, ptr, v3, v4);
+#else
             untransform_subband(j, ptr, v3, v4);
+#endif
             j += 8 * v3;
         }
 
@@ -1092,9 +846,179 @@ static void untransform_all(AudioDecoder* ad)
     }
 }
 
+#ifdef SOUND_DECODER_SSE2
+// Same as `untransform_subband0`, but processes four adjacent columns at
+// once. Block shapes with special handling in the original (`count` of 2 and
+// odd number of row pairs) are passed to it as is.
+static void untransform_subband0_sse2(unsigned char* prv, unsigned char* buf, int step, int count)
+{
+    __m128i lo;
+    __m128i hi;
+    __m128i r0;
+    __m128i r1;
+    __m128i r2;
+    __m128i r3;
+    __m128i x;
+    __m128i mask;
+    int* column;
+    int* row;
+    int rows;
+    int col;
+
+    if (count == 2 || ((count >> 1) & 1) != 0 || step < 4) {
+        untransform_subband0(prv, buf, step, count);
+        return;
+    }
+
+    mask = _mm_set1_epi32(0xFFFF);
+
+    col = 0;
+    for (; col + 4 <= step; col += 4) {
+        column = (int*)buf + col;
+
+        // History is kept as a pair of 16-bit values per column.
+        x = _mm_loadu_si128((__m128i*)(prv + col * 4));
+        lo = _mm_srai_epi32(_mm_slli_epi32(x, 16), 16);
+        hi = _mm_srai_epi32(x, 16);
+
+        row = column;
+        for (rows = count >> 2; rows != 0; rows--) {
+            r0 = _mm_loadu_si128((__m128i*)row);
+            r1 = _mm_loadu_si128((__m128i*)(row + step));
+            r2 = _mm_loadu_si128((__m128i*)(row + step * 2));
+            r3 = _mm_loadu_si128((__m128i*)(row + step * 3));
+
+            _mm_storeu_si128((__m128i*)row, _mm_add_epi32(_mm_add_epi32(r0, _mm_slli_epi32(hi, 1)), lo));
+            _mm_storeu_si128((__m128i*)(row + step), _mm_sub_epi32(_mm_sub_epi32(_mm_slli_epi32(r0, 1), hi), r1));
+            _mm_storeu_si128((__m128i*)(row + step * 2), _mm_add_epi32(_mm_add_epi32(r2, _mm_slli_epi32(r1, 1)), r0));
+            _mm_storeu_si128((__m128i*)(row + step * 3), _mm_sub_epi32(_mm_sub_epi32(_mm_slli_epi32(r2, 1), r1), r3));
+
+            lo = r2;
+            hi = r3;
+            row += step * 4;
+        }
+
+        x = _mm_or_si128(_mm_and_si128(lo, mask), _mm_slli_epi32(hi, 16));
+        _mm_storeu_si128((__m128i*)(prv + col * 4), x);
+    }
+
+    for (; col < step; col++) {
+        int v20 = (int)*(short*)(prv + col * 4);
+        int v22 = *(int*)(prv + col * 4) >> 16;
+        int v24;
+        int v26;
+
+        row = (int*)buf + col;
+        for (rows = count >> 2; rows != 0; rows--) {
+            v24 = row[0];
+            row[0] += 2 * v22 + v20;
+
+            v26 = row[step];
+            row[step] = 2 * v24 - v22 - v26;
+
+            v20 = row[step * 2];
+            row[step * 2] += 2 * v26 + v24;
+
+            v22 = row[step * 3];
+            row[step * 3] = 2 * v20 - v26 - v22;
+
+            row += step * 4;
+        }
+
+        *(short*)(prv + col * 4) = v20 & 0xFFFF;
+        *(short*)(prv + col * 4 + 2) = v22 & 0xFFFF;
+    }
+}
+
+// Same as `untransform_subband`, but processes four adjacent columns at once.
+static void untransform_subband_sse2(unsigned char* prv, unsigned char* buf, int step, int count)
+{
+    __m128i lo;
+    __m128i hi;
+    __m128i r0;
+    __m128i r1;
+    __m128i r2;
+    __m128i r3;
+    __m128i x;
+    __m128i y;
+    int* history;
+    int* row;
+    int rows;
+    int col;
+
+    if (count == 4 || step < 4) {
+        untransform_subband(prv, buf, step, count);
+        return;
+    }
+
+    history = (int*)prv;
+
+    col = 0;
+    for (; col + 4 <= step; col += 4) {
+        // History is kept as a pair of values per column, split them into
+        // vectors of first and second values.
+        x = _mm_shuffle_epi32(_mm_loadu_si128((__m128i*)(history + col * 2)), _MM_SHUFFLE(3, 1, 2, 0));
+        y = _mm_shuffle_epi32(_mm_loadu_si128((__m128i*)(history + col * 2 + 4)), _MM_SHUFFLE(3, 1, 2, 0));
+        lo = _mm_unpacklo_epi64(x, y);
+        hi = _mm_unpackhi_epi64(x, y);
+
+        row = (int*)buf + col;
+        for (rows = count >> 2; rows != 0; rows--) {
+            r0 = _mm_loadu_si128((__m128i*)row);
+            r1 = _mm_loadu_si128((__m128i*)(row + step));
+            r2 = _mm_loadu_si128((__m128i*)(row + step * 2));
+            r3 = _mm_loadu_si128((__m128i*)(row + step * 3));
+
+            _mm_storeu_si128((__m128i*)row, _mm_add_epi32(_mm_add_epi32(r0, _mm_slli_epi32(hi, 1)), lo));
+            _mm_storeu_si128((__m128i*)(row + step), _mm_sub_epi32(_mm_sub_epi32(_mm_slli_epi32(r0, 1), hi), r1));
+            _mm_storeu_si128((__m128i*)(row + step * 2), _mm_add_epi32(_mm_add_epi32(r2, _mm_slli_epi32(r1, 1)), r0));
+            _mm_storeu_si128((__m128i*)(row + step * 3), _mm_sub_epi32(_mm_sub_epi32(_mm_slli_epi32(r2, 1), r1), r3));
+
+            lo = r2;
+            hi = r3;
+            row += step * 4;
+        }
+
+        _mm_storeu_si128((__m128i*)(history + col * 2), _mm_unpacklo_epi32(lo, hi));
+        _mm_storeu_si128((__m128i*)(history + col * 2 + 4), _mm_unpackhi_epi32(lo, hi));
+    }
+
+    for (; col < step; col++) {
+        int v15 = history[col * 2];
+        int v16 = history[col * 2 + 1];
+        int v17;
+        int v19;
+
+        row = (int*)buf + col;
+        for (rows = count >> 2; rows != 0; rows--) {
+            v17 = row[0];
+            row[0] += 2 * v16 + v15;
+
+            v19 = row[step];
+            row[step] = 2 * v17 - v16 - v19;
+
+            v15 = row[step * 2];
+            row[step * 2] += 2 * v19 + v17;
+
+            v16 = row[step * 3];
+            row[step * 3] = 2 * v15 - v19 - v16;
+
+            row += step * 4;
+        }
+
+        history[col * 2] = v15;
+        history[col * 2 + 1] = v16;
+    }
+}
+#endif
+
 // 0x4BF7E8
 static bool AudioDecoder_fill(AudioDecoder* ad)
 {
+    if (ad->seek != NULL) {
+        AudioDecoder_AddSeekPoint(ad);
+    }
+
     if (!ReadBands(ad)) {
         return false;
     }
@@ -1166,16 +1090,19 @@ void AudioDecoder_Close(AudioDecoder* ad)
         free(ad->samples);
     }
 
-    free(ad);
+    if (ad->seek_points != NULL) {
+        free(ad->seek_points);
+    }
 
-    AudioDecoder_cnt--;
+    if (ad->seek_point_samples != NULL) {
+        free(ad->seek_point_samples);
+    }
 
-    if (AudioDecoder_cnt == 0) {
-        if (AudioDecoder_scale_tbl != NULL) {
-            free(AudioDecoder_scale_tbl);
-            AudioDecoder_scale_tbl = NULL;
-        }
+    if (ad->scale_tbl != NULL) {
+        free(ad->scale_tbl);
     }
+
+    free(ad);
 }
 
 // 0x4BF938
@@ -1192,7 +1119,9 @@ AudioDecoder* Create_AudioDecoder(AudioDecoderReadFunc* reader, void* data, int*
 
     memset(ad, 0, sizeof(*ad));
 
-    AudioDecoder_cnt++;
+    // NOTE: Tables are shared by all decoders, build them here rather than in
+    // `ReadBands`, which can run on any thread.
+    init_pack_tables();
 
     if (!bits_init(&(ad->bits), reader, data)) {
         goto L66;
@@ -1207,7 +1136,7 @@ AudioDecoder* Create_AudioDecoder(AudioDecoderReadFunc* reader, void* data, int*
     }
 
     requireBits(ad, 8);
-    v20 = ad->bits.data;
+    v20 = ad->bits.data & 0xFF;
     dropBits(ad, 8);
 
     if (v20 != 1) {
@@ -1253,6 +1182,9 @@ AudioDecoder* Create_AudioDecoder(AudioDecoderReadFunc* reader, void* data, int*
 
     ad->block_total_samples = ad->block_samples_per_subband * ad->subbands;
 
+    ad->total_cnt = ad->file_cnt;
+    ad->prev_samples_size = sizeof(unsigned char*) * v73;
+
     if (v73 != 0) {
         ad->prev_samples = (unsigned char*)malloc(sizeof(unsigned char*) * v73);
         if (ad->prev_samples == NULL) {
@@ -1269,11 +1201,13 @@ AudioDecoder* Create_AudioDecoder(AudioDecoderReadFunc* reader, void* data, int*
 
     ad->samp_cnt = 0;
 
-    if (AudioDecoder_cnt == 1) {
-        AudioDecoder_scale_tbl = (unsigned char*)malloc(0x20000);
-        AudioDecoder_scale0 = AudioDecoder_scale_tbl + 0x10000;
+    ad->scale_tbl = (unsigned char*)calloc(1, 0x20000);
+    if (ad->scale_tbl == NULL) {
+        goto L66;
     }
 
+    ad->scale0 = ad->scale_tbl + 0x10000;
+
     *channels = ad->channels;
     *sampleRate = ad->rate;
     *sampleCount = ad->file_cnt;
@@ -1291,19 +1225,217 @@ L66:
     return 0;
 }
 
+// Enables seeking with `AudioDecoder_Seek`. `seek` should position the stream
+// `reader` works with at given offset relative to the position the stream was
+// at when decoder was created, and return 0 on success.
+//
+// Seek points are collected as blocks are decoded for the first time, so
+// seeking back into the part of the stream which has been played once costs
+// at most `SOUND_DECODER_SEEK_POINT_SAMPLES` samples of decoding. Must be
+// called before the first read.
+bool AudioDecoder_EnableSeek(AudioDecoder* ad, AudioDecoderSeekFunc* seek)
+{
+    if (ad->total_samples == 0 || ad->file_cnt != ad->total_cnt || ad->samp_cnt != 0) {
+        return false;
+    }
+
+    ad->seek = seek;
+    ad->seek_point_blocks = SOUND_DECODER_SEEK_POINT_SAMPLES / ad->total_samples;
+    if (ad->seek_point_blocks < 1) {
+        ad->seek_point_blocks = 1;
+    }
+
+    return true;
+}
+
+// Returns position of the next sample to be read.
+int AudioDecoder_Tell(AudioDecoder* ad)
+{
+    return ad->total_cnt - ad->file_cnt - ad->samp_cnt;
+}
+
+// Positions decoder at given sample. Returns false if decoder cannot seek,
+// in which case its state is undefined and it should be recreated.
+bool AudioDecoder_Seek(AudioDecoder* ad, int sample)
+{
+    int position;
+    int index;
+    int length;
+
+    if (ad->seek == NULL) {
+        return false;
+    }
+
+    if (sample < 0) {
+        sample = 0;
+    } else if (sample > ad->total_cnt) {
+        sample = ad->total_cnt;
+    }
+
+    position = AudioDecoder_Tell(ad);
+
+    if (ad->seek_points_cnt != 0) {
+        index = sample / (ad->total_samples * ad->seek_point_blocks);
+        if (index >= ad->seek_points_cnt) {
+            index = ad->seek_points_cnt - 1;
+        }
+
+        // Restore closest seek point unless we're already between it and
+        // the target.
+        if (sample < position || index * ad->seek_point_blocks * ad->total_samples > position) {
+            if (!AudioDecoder_RestoreSeekPoint(ad, index)) {
+                return false;
+            }
+
+            position = AudioDecoder_Tell(ad);
+        }
+    } else if (sample < position) {
+        return false;
+    }
+
+    // Decode forward to the target. Samples are skipped without conversion,
+    // and passed blocks extend seek index.
+    while (position < sample) {
+        if (ad->samp_cnt == 0) {
+            if (ad->file_cnt == 0) {
+                break;
+            }
+
+            if (!AudioDecoder_fill(ad)) {
+                break;
+            }
+        }
+
+        length = sample - position;
+        if (length > ad->samp_cnt) {
+            length = ad->samp_cnt;
+        }
+
+        ad->samp_ptr += length * 4;
+        ad->samp_cnt -= length;
+        position += length;
+    }
+
+    return position == sample;
+}
+
+// Remembers decoder state at the beginning of the block which is about to be
+// decoded, if it starts the next seek point.
+static void AudioDecoder_AddSeekPoint(AudioDecoder* ad)
+{
+    int block;
+    int capacity;
+    seek_point* seekPoints;
+    unsigned char* seekPointSamples;
+    seek_point* seekPoint;
+
+    // Offset is unknown once reader ran out of data.
+    if (ad->bits.bytes.eof) {
+        return;
+    }
+
+    block = (ad->total_cnt - ad->file_cnt) / ad->total_samples;
+    if (block % ad->seek_point_blocks != 0) {
+        return;
+    }
+
+    if (block / ad->seek_point_blocks != ad->seek_points_cnt) {
+        return;
+    }
+
+    if (ad->seek_points_cnt == ad->seek_points_capacity) {
+        capacity = ad->seek_points_capacity != 0 ? ad->seek_points_capacity * 2 : 16;
+
+        seekPoints = (seek_point*)realloc(ad->seek_points, sizeof(*seekPoints) * capacity);
+        if (seekPoints == NULL) {
+            return;
+        }
+        ad->seek_points = seekPoints;
+
+        if (ad->prev_samples_size != 0) {
+            seekPointSamples = (unsigned char*)realloc(ad->seek_point_samples, ad->prev_samples_size * capacity);
+            if (seekPointSamples == NULL) {
+                return;
+            }
+            ad->seek_point_samples = seekPointSamples;
+        }
+
+        ad->seek_points_capacity = capacity;
+    }
+
+    seekPoint = &(ad->seek_points[ad->seek_points_cnt]);
+    seekPoint->offset = ad->bits.bytes.pos - ad->bits.bytes.buf_cnt;
+    seekPoint->data = ad->bits.data;
+    seekPoint->bitcnt = ad->bits.bitcnt;
+
+    if (ad->prev_samples_size != 0) {
+        memcpy(ad->seek_point_samples + ad->prev_samples_size * ad->seek_points_cnt, ad->prev_samples, ad->prev_samples_size);
+    }
+
+    ad->seek_points_cnt++;
+}
+
+static bool AudioDecoder_RestoreSeekPoint(AudioDecoder* ad, int index)
+{
+    seek_point* seekPoint = &(ad->seek_points[index]);
+
+    if (ad->seek(ad->bits.bytes.data, seekPoint->offset) != 0) {
+        return false;
+    }
+
+    ad->bits.bytes.pos = seekPoint->offset;
+    ad->bits.bytes.buf_cnt = 0;
+    ad->bits.bytes.eof = false;
+    ad->bits.data = seekPoint->data;
+    ad->bits.bitcnt = seekPoint->bitcnt;
+
+    if (ad->prev_samples_size != 0) {
+        memcpy(ad->prev_samples, ad->seek_point_samples + ad->prev_samples_size * index, ad->prev_samples_size);
+    }
+
+    ad->file_cnt = ad->total_cnt - index * ad->seek_point_blocks * ad->total_samples;
+    ad->samp_ptr = ad->samples;
+    ad->samp_cnt = 0;
+
+    return true;
+}
+
 static inline void requireBits(AudioDecoder* ad, int n)
 {
-    while (ad->bits.bitcnt < n) {
-        ad->bits.bytes.buf_cnt--;
+    if (ad->bits.bitcnt < n) {
+        fillBits(&(ad->bits), n);
+    }
+}
+
+static void fillBits(bit_reader* bits, int n)
+{
+    byte_reader* bytes = &(bits->bytes);
+    unsigned long long word;
+    int count;
+
+    if (bytes->buf_cnt >= 8) {
+        // Top up accumulator with as many whole bytes as fit. Stream is
+        // little-endian, as are all targets.
+        count = (63 - bits->bitcnt) >> 3;
+        memcpy(&word, bytes->buf_ptr, sizeof(word));
+        bits->data |= (word & ((1ULL << (count * 8)) - 1)) << bits->bitcnt;
+        bits->bitcnt += count * 8;
+        bytes->buf_ptr += count;
+        bytes->buf_cnt -= count;
+        return;
+    }
+
+    while (bits->bitcnt < n) {
+        bytes->buf_cnt--;
 
         unsigned char ch;
-        if (ad->bits.bytes.buf_cnt < 0) {
-            ch = ByteReaderFill(&(ad->bits.bytes));
+        if (bytes->buf_cnt < 0) {
+            ch = ByteReaderFill(bytes);
         } else {
-            ch = *ad->bits.bytes.buf_ptr++;
+            ch = *bytes->buf_ptr++;
         }
-        ad->bits.data |= ch << ad->bits.bitcnt;
-        ad->bits.bitcnt += 8;
+        bits->data |= (unsigned long long)ch << bits->bitcnt;
+        bits->bitcnt += 8;
     }
 }
 
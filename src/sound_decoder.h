@@ -1,14 +1,19 @@
 #ifndef FALLOUT_SOUND_DECODER_H_
 #define FALLOUT_SOUND_DECODER_H_
 
+#include <stdbool.h>
 #include <stddef.h>
 
 typedef int(AudioDecoderReadFunc)(void* data, void* buffer, unsigned int size);
+typedef int(AudioDecoderSeekFunc)(void* data, int offset);
 
 typedef struct _AudioDecoder AudioDecoder;
 
 size_t AudioDecoder_Read(AudioDecoder* ad, void* buffer, size_t size);
 void AudioDecoder_Close(AudioDecoder* ad);
 AudioDecoder* Create_AudioDecoder(AudioDecoderReadFunc* reader, void* data, int* channels, int* sampleRate, int* sampleCount);
+bool AudioDecoder_EnableSeek(AudioDecoder* ad, AudioDecoderSeekFunc* seek);
+int AudioDecoder_Tell(AudioDecoder* ad);
+bool AudioDecoder_Seek(AudioDecoder* ad, int sample);
 
 #endif /* FALLOUT_SOUND_DECODER_H_ */